@@ -968,6 +968,20 @@ FDBFuture* fdb_transaction_get_key_v13(FDBTransaction* tr,
 	return fdb_transaction_get_key_impl(tr, key_name, key_name_length, or_equal, offset, false);
 }
 
+extern "C" DLLEXPORT FDBFuture* fdb_transaction_get_multi(FDBTransaction* tr,
+                                                          FDBKey const* keys,
+                                                          int key_count,
+                                                          fdb_bool_t snapshot) {
+	// The transaction copies the keys before this returns, so they can refer to the caller's memory
+	Arena arena;
+	VectorRef<KeyRef> k;
+	k.reserve(arena, key_count);
+	for (int i = 0; i < key_count; i++) {
+		k.push_back(arena, KeyRef(keys[i].key, keys[i].key_length));
+	}
+	return (FDBFuture*)(TXN(tr)->getMulti(k, snapshot).extractPtr());
+}
+
 extern "C" DLLEXPORT FDBFuture* fdb_transaction_get_addresses_for_key(FDBTransaction* tr,
                                                                       uint8_t const* key_name,
                                                                       int key_name_length) {
@@ -998,6 +1012,14 @@ FDBFuture* validate_and_update_parameters(int& limit,
 	    mode == FDB_STREAMING_MODE_EXACT)
 		return TSAV_ERROR(Standalone<RangeResultRef>, exact_mode_without_limits);
 
+	/* _STREAM batches hold whatever the stream has received, so the mode
+	   implies no byte limit */
+	if (mode == FDB_STREAMING_MODE_STREAM) {
+		if (g_api_version < ApiVersion::withRangeStream().version())
+			return TSAV_ERROR(Standalone<RangeResultRef>, client_invalid_operation);
+		return nullptr;
+	}
+
 	/* _ITERATOR mode maps to one of the known streaming modes
 	   depending on iteration */
 	const int mode_bytes_array[] = { GetRangeLimits::BYTE_LIMIT_UNLIMITED, 256, 1000, 4096, 80000 };
@@ -1050,15 +1072,16 @@ FDBFuture* fdb_transaction_get_range_impl(FDBTransaction* tr,
 	FDBFuture* r = validate_and_update_parameters(limit, target_bytes, mode, iteration, reverse);
 	if (r != nullptr)
 		return r;
-	return (
-	    FDBFuture*)(TXN(tr)
-	                    ->getRange(
-	                        KeySelectorRef(KeyRef(begin_key_name, begin_key_name_length), begin_or_equal, begin_offset),
-	                        KeySelectorRef(KeyRef(end_key_name, end_key_name_length), end_or_equal, end_offset),
-	                        GetRangeLimits(limit, target_bytes),
-	                        snapshot,
-	                        reverse)
-	                    .extractPtr());
+	KeySelectorRef begin(KeyRef(begin_key_name, begin_key_name_length), begin_or_equal, begin_offset);
+	KeySelectorRef end(KeyRef(end_key_name, end_key_name_length), end_or_equal, end_offset);
+	if (mode == FDB_STREAMING_MODE_STREAM) {
+		return (FDBFuture*)(TXN(tr)
+		                        ->getRangeStreamBatch(begin, end, GetRangeLimits(limit, target_bytes), snapshot, reverse)
+		                        .extractPtr());
+	}
+	return (FDBFuture*)(TXN(tr)
+	                        ->getRange(begin, end, GetRangeLimits(limit, target_bytes), snapshot, reverse)
+	                        .extractPtr());
 }
 
 extern "C" DLLEXPORT FDBFuture* fdb_transaction_get_mapped_range(FDBTransaction* tr,
@@ -1078,6 +1101,9 @@ extern "C" DLLEXPORT FDBFuture* fdb_transaction_get_mapped_range(FDBTransaction*
                                                                  int iteration,
                                                                  fdb_bool_t snapshot,
                                                                  fdb_bool_t reverse) {
+	/* Mapped ranges are not streamed */
+	if (mode == FDB_STREAMING_MODE_STREAM)
+		mode = FDB_STREAMING_MODE_SERIAL;
 	FDBFuture* r = validate_and_update_parameters(limit, target_bytes, mode, iteration, reverse);
 	if (r != nullptr)
 		return r;
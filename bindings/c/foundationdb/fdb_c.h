@@ -555,6 +555,13 @@ DLLEXPORT WARN_UNUSED_RESULT FDBFuture* fdb_transaction_get_key(FDBTransaction*
                                                                 fdb_bool_t snapshot);
 #endif
 
+/* Reads several keys at once. The result is read with fdb_future_get_keyvalue_array and holds one entry for each key
+ * that is present, in the order the keys were given; absent keys are left out. */
+DLLEXPORT WARN_UNUSED_RESULT FDBFuture* fdb_transaction_get_multi(FDBTransaction* tr,
+                                                                  FDBKey const* keys,
+                                                                  int key_count,
+                                                                  fdb_bool_t snapshot);
+
 DLLEXPORT WARN_UNUSED_RESULT FDBFuture* fdb_transaction_get_addresses_for_key(FDBTransaction* tr,
                                                                               uint8_t const* key_name,
                                                                               int key_name_length);
@@ -712,6 +712,16 @@ public:
 		return native::fdb_transaction_get(tr.get(), key.data(), intSize(key), snapshot);
 	}
 
+	// Result holds the keys that are present, in the order they were given
+	TypedFuture<future_var::KeyValueRefArray> getMulti(const std::vector<KeyRef>& keys, bool snapshot) {
+		std::vector<native::FDBKey> nativeKeys;
+		nativeKeys.reserve(keys.size());
+		for (const auto& key : keys) {
+			nativeKeys.push_back(native::FDBKey{ key.data(), intSize(key) });
+		}
+		return native::fdb_transaction_get_multi(tr.get(), nativeKeys.data(), intSize(nativeKeys), snapshot);
+	}
+
 	// Usage: tx.getRange(key_select::firstGreaterOrEqual(firstKey), key_select::lastLessThan(lastKey), ...)
 	// gets key-value pairs in key range [begin, end)
 	TypedFuture<future_var::KeyValueRefArray> getRange(KeySelector first,
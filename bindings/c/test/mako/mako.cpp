@@ -765,6 +765,10 @@ int workerProcessMain(Arguments const& args, int process_idx, shared_memory::Acc
 		if (args.transaction_timeout_db > 0 && args.mode == MODE_RUN) {
 			databases[i].setOption(FDB_DB_OPTION_TRANSACTION_TIMEOUT, args.transaction_timeout_db);
 		}
+		if (args.max_read_version_staleness > 0 && args.mode == MODE_RUN) {
+			databases[i].setOption(FDB_DB_OPTION_TRANSACTION_MAX_READ_VERSION_STALENESS,
+			                       args.max_read_version_staleness);
+		}
 	}
 
 	if (!args.async_xacts) {
@@ -884,6 +888,7 @@ Arguments::Arguments() {
 	distributed_tracer_client = 0;
 	transaction_timeout_db = 0;
 	transaction_timeout_tx = 0;
+	max_read_version_staleness = 0;
 	num_report_files = 0;
 }
 
@@ -1026,6 +1031,10 @@ int parseTransaction(Arguments& args, char const* optarg) {
 			op = OP_GETRANGE;
 			rangeop = 1;
 			ptr += 2;
+		} else if (strncmp(ptr, "gm", 2) == 0) {
+			op = OP_GETMULTI;
+			rangeop = 1;
+			ptr += 2;
 		} else if (strncmp(ptr, "g", 1) == 0) {
 			op = OP_GET;
 			ptr++;
@@ -1156,7 +1165,7 @@ void usage() {
 	printf("%-24s %s\n", "    --tps|--tpsmax=TPS", "Specify the target max TPS");
 	printf("%-24s %s\n", "    --tpsmin=TPS", "Specify the target min TPS");
 	printf("%-24s %s\n", "    --tpsinterval=SEC", "Specify the TPS change interval (Default: 10 seconds)");
-	printf("%-24s %s\n", "    --tpschange=<sin|square|pulse>", "Specify the TPS change type (Default: sin)");
+	printf("%-24s %s\n", "    --tpschange=<sin|square|pulse|sweep>", "Specify the TPS change type (Default: sin)");
 	printf("%-24s %s\n", "    --sampling=RATE", "Specify the sampling rate for latency stats");
 	printf("%-24s %s\n", "-m, --mode=MODE", "Specify the mode (build, run, clean, report)");
 	printf("%-24s %s\n", "-z, --zipf", "Use zipfian distribution instead of uniform distribution");
@@ -1174,7 +1183,7 @@ void usage() {
 	       "Specify the prefix of transaction tag - mako${txntagging_prefix} (Default: '')");
 	printf("%-24s %s\n", "    --knobs=KNOBS", "Set client knobs");
 	printf("%-24s %s\n", "    --flatbuffers", "Use flatbuffers");
-	printf("%-24s %s\n", "    --streaming", "Streaming mode: all (default), iterator, small, medium, large, serial");
+	printf("%-24s %s\n", "    --streaming", "Streaming mode: all (default), iterator, small, medium, large, serial, stream");
 	printf("%-24s %s\n", "    --disable_ryw", "Disable snapshot read-your-writes");
 	printf(
 	    "%-24s %s\n", "    --disable_client_bypass", "Disable client-bypass forcing mako to use multi-version client");
@@ -1205,6 +1214,9 @@ void usage() {
 	printf("%-24s %s\n",
 	       "    --transaction_timeout_tx=DURATION",
 	       "Duration in milliseconds after which a transaction times out in run mode. Set as transaction option");
+	printf("%-24s %s\n",
+	       "    --max_read_version_staleness=DURATION",
+	       "Let transactions start at a cached read version up to this many milliseconds old in run mode");
 }
 
 /* parse benchmark parameters */
@@ -1259,6 +1271,7 @@ int parseArguments(int argc, char* argv[], Arguments& args) {
 			{ "authorization_private_key_pem_file", required_argument, NULL, ARG_AUTHORIZATION_PRIVATE_KEY_PEM_FILE },
 			{ "transaction_timeout_tx", required_argument, NULL, ARG_TRANSACTION_TIMEOUT_TX },
 			{ "transaction_timeout_db", required_argument, NULL, ARG_TRANSACTION_TIMEOUT_DB },
+			{ "max_read_version_staleness", required_argument, NULL, ARG_MAX_READ_VERSION_STALENESS },
 			/* options which may or may not have an argument */
 			{ "json_report", optional_argument, NULL, ARG_JSON_REPORT },
 			{ "stats_export_path", optional_argument, NULL, ARG_EXPORT_PATH },
@@ -1398,8 +1411,10 @@ int parseArguments(int argc, char* argv[], Arguments& args) {
 				args.tpschange = TPS_SQUARE;
 			else if (strcmp(optarg, "pulse") == 0)
 				args.tpschange = TPS_PULSE;
+			else if (strcmp(optarg, "sweep") == 0)
+				args.tpschange = TPS_SWEEP;
 			else {
-				logr.error("--tpschange must be sin, square or pulse");
+				logr.error("--tpschange must be sin, square, pulse or sweep");
 				return -1;
 			}
 			break;
@@ -1455,6 +1470,8 @@ int parseArguments(int argc, char* argv[], Arguments& args) {
 				args.streaming_mode = FDB_STREAMING_MODE_LARGE;
 			} else if (strncmp(optarg, "serial", 6) == 0) {
 				args.streaming_mode = FDB_STREAMING_MODE_SERIAL;
+			} else if (strncmp(optarg, "stream", 6) == 0) {
+				args.streaming_mode = FDB_STREAMING_MODE_STREAM;
 			} else {
 				logr.error("Invalid streaming mode {}", optarg);
 				return -1;
@@ -1544,6 +1561,9 @@ int parseArguments(int argc, char* argv[], Arguments& args) {
 		case ARG_TRANSACTION_TIMEOUT_DB:
 			args.transaction_timeout_db = atoi(optarg);
 			break;
+		case ARG_MAX_READ_VERSION_STALENESS:
+			args.max_read_version_staleness = atoi(optarg);
+			break;
 		case ARG_ENABLE_TOKEN_BASED_AUTHORIZATION:
 			args.enable_token_based_authorization = true;
 			break;
@@ -1649,6 +1669,10 @@ int Arguments::validate() {
 			logr.error("--transaction_timeout_[tx|db] must be a non-negative integer");
 			return -1;
 		}
+		if (max_read_version_staleness < 0) {
+			logr.error("--max_read_version_staleness must be a non-negative integer");
+			return -1;
+		}
 	}
 
 	if (mode != MODE_RUN && (transaction_timeout_db != 0 || transaction_timeout_tx != 0)) {
@@ -1656,6 +1680,11 @@ int Arguments::validate() {
 		return -1;
 	}
 
+	if (mode != MODE_RUN && max_read_version_staleness != 0) {
+		logr.error("--max_read_version_staleness only supported in run mode");
+		return -1;
+	}
+
 	if (mode == MODE_RUN || mode == MODE_BUILD) {
 		if (tpsmax > 0) {
 			if (async_xacts > 0) {
@@ -2180,6 +2209,9 @@ void printReport(Arguments const& args,
 		case TPS_PULSE:
 			fmt::printf("%8s\n", "PULSE");
 			break;
+		case TPS_SWEEP:
+			fmt::printf("%8s\n", "SWEEP");
+			break;
 		}
 	}
 	const auto tps_f = final_worker_stats.getOpCount(OP_TRANSACTION) / duration_sec;
@@ -2382,6 +2414,7 @@ int statsProcessMain(Arguments const& args,
 		fmt::fprintf(fp, "\"disable_ryw\": %d,", args.disable_ryw);
 		fmt::fprintf(fp, "\"transaction_timeout_db\": %d,", args.transaction_timeout_db);
 		fmt::fprintf(fp, "\"transaction_timeout_tx\": %d,", args.transaction_timeout_tx);
+		fmt::fprintf(fp, "\"max_read_version_staleness\": %d,", args.max_read_version_staleness);
 		fmt::fprintf(fp, "\"json_output_path\": \"%s\"", args.json_output_path);
 		fmt::fprintf(fp, "},\"samples\": [");
 	}
@@ -2426,6 +2459,10 @@ int statsProcessMain(Arguments const& args,
 						throttle_factor = tpsmin / tpsmax;
 					}
 					break;
+				case TPS_SWEEP:
+					/* ramp from min to max over each interval */
+					throttle_factor = (tpsmin + (tpsmax - tpsmin) * pos / tpsinterval) / tpsmax;
+					break;
 				}
 			}
 
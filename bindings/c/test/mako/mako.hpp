@@ -91,6 +91,7 @@ enum ArgKind {
 	ARG_ENABLE_TOKEN_BASED_AUTHORIZATION,
 	ARG_TRANSACTION_TIMEOUT_TX,
 	ARG_TRANSACTION_TIMEOUT_DB,
+	ARG_MAX_READ_VERSION_STALENESS,
 };
 
 constexpr const int OP_COUNT = 0;
@@ -101,6 +102,7 @@ constexpr const int OP_REVERSE = 2;
 enum OpKind {
 	OP_GETREADVERSION,
 	OP_GET,
+	OP_GETMULTI,
 	OP_GETRANGE,
 	OP_SGET,
 	OP_SGETRANGE,
@@ -118,7 +120,7 @@ enum OpKind {
 	MAX_OP /* must be the last item */
 };
 
-enum TPSChangeTypes { TPS_SIN, TPS_SQUARE, TPS_PULSE };
+enum TPSChangeTypes { TPS_SIN, TPS_SQUARE, TPS_PULSE, TPS_SWEEP };
 
 enum DistributedTracerClient { DISABLED, NETWORK_LOSSY, LOG_FILE };
 
@@ -213,6 +215,7 @@ struct Arguments {
 	std::vector<int64_t> tenant_ids; // maps tenant index to tenant id for signing tokens
 	int transaction_timeout_db;
 	int transaction_timeout_tx;
+	int max_read_version_staleness;
 };
 
 // helper functions
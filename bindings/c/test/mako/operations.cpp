@@ -56,6 +56,27 @@ const std::array<Operation, MAX_OP> opTable{
 	        } } },
 	    1,
 	    false },
+	  { "GETMULTI",
+	    { { StepKind::READ,
+	        [](Transaction& tx, Arguments const& args, ByteString&, ByteString&, ByteString&) {
+	            // Reads OP_RANGE random keys with one call
+	            const auto count = args.txnspec.ops[OP_GETMULTI][OP_RANGE];
+	            std::vector<ByteString> keys(count, ByteString(args.key_length, '\0'));
+	            std::vector<KeyRef> keyRefs;
+	            keyRefs.reserve(count);
+	            for (auto& key : keys) {
+		            genKey(key.data(), KEY_PREFIX, args, nextKey(args));
+		            keyRefs.push_back(key);
+	            }
+	            return tx.getMulti(keyRefs, false /*snapshot*/).eraseType();
+	        },
+	        [](Future& f, Transaction&, Arguments const&, ByteString&, ByteString&, ByteString& val) {
+	            if (f && !f.error()) {
+		            f.get<future_var::KeyValueRefArray>();
+	            }
+	        } } },
+	    1,
+	    false },
 	  { "GETRANGE",
 	    { { StepKind::READ,
 	        [](Transaction& tx, Arguments const& args, ByteString& begin, ByteString& end, ByteString&) {
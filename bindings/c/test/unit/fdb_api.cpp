@@ -261,6 +261,15 @@ KeyFuture Transaction::get_key(const uint8_t* key_name,
 	return KeyFuture(fdb_transaction_get_key(tr_, key_name, key_name_length, or_equal, offset, snapshot));
 }
 
+KeyValueArrayFuture Transaction::get_multi(const std::vector<std::string>& keys, fdb_bool_t snapshot) {
+	std::vector<FDBKey> fdb_keys;
+	fdb_keys.reserve(keys.size());
+	for (const auto& k : keys) {
+		fdb_keys.push_back(FDBKey{ (const uint8_t*)k.data(), (int)k.size() });
+	}
+	return KeyValueArrayFuture(fdb_transaction_get_multi(tr_, fdb_keys.data(), fdb_keys.size(), snapshot));
+}
+
 StringArrayFuture Transaction::get_addresses_for_key(std::string_view key) {
 	return StringArrayFuture(fdb_transaction_get_addresses_for_key(tr_, (const uint8_t*)key.data(), key.size()));
 }
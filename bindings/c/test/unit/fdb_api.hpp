@@ -44,6 +44,7 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace fdb {
 
@@ -309,6 +310,10 @@ public:
 	                  int offset,
 	                  fdb_bool_t snapshot);
 
+	// Returns a future which will be set to an FDBKeyValue array holding the
+	// keys in `keys` that are present, in the order they were given.
+	KeyValueArrayFuture get_multi(const std::vector<std::string>& keys, fdb_bool_t snapshot);
+
 	// Returns a future which will be set to an array of strings.
 	StringArrayFuture get_addresses_for_key(std::string_view key);
 
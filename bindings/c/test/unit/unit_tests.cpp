@@ -592,6 +592,64 @@ TEST_CASE("fdb_future_get_keyvalue_array") {
 	}
 }
 
+TEST_CASE("fdb_transaction_get_multi") {
+	insert_data(db, create_data({ { "a", "1" }, { "b", "2" }, { "c", "3" }, { "d", "4" } }));
+
+	fdb::Transaction tr(db);
+	while (1) {
+		// Local writes must be seen: "b" is cleared and "e" is set in this transaction
+		tr.clear(key("b"));
+		tr.set(key("e"), "5");
+
+		std::vector<std::string> keys = { key("d"), key("missing"), key("b"), key("a"), key("e"), key("c") };
+		fdb::KeyValueArrayFuture f1 = tr.get_multi(keys, /* snapshot */ false);
+
+		fdb_error_t err = wait_future(f1);
+		if (err) {
+			fdb::EmptyFuture f2 = tr.on_error(err);
+			fdb_check(wait_future(f2));
+			continue;
+		}
+
+		FDBKeyValue const* out_kv;
+		int out_count;
+		int out_more;
+		fdb_check(f1.get(&out_kv, &out_count, &out_more));
+
+		std::vector<std::pair<std::string, std::string>> expected = {
+			{ key("d"), "4" }, { key("a"), "1" }, { key("e"), "5" }, { key("c"), "3" }
+		};
+		CHECK(out_count == (int)expected.size());
+		CHECK(!out_more);
+		for (int i = 0; i < out_count && i < (int)expected.size(); ++i) {
+			CHECK(std::string((const char*)out_kv[i].key, out_kv[i].key_length) == expected[i].first);
+			CHECK(std::string((const char*)out_kv[i].value, out_kv[i].value_length) == expected[i].second);
+		}
+		break;
+	}
+}
+
+TEST_CASE("fdb_transaction_get_multi empty") {
+	fdb::Transaction tr(db);
+	while (1) {
+		fdb::KeyValueArrayFuture f1 = tr.get_multi({}, /* snapshot */ true);
+
+		fdb_error_t err = wait_future(f1);
+		if (err) {
+			fdb::EmptyFuture f2 = tr.on_error(err);
+			fdb_check(wait_future(f2));
+			continue;
+		}
+
+		FDBKeyValue const* out_kv;
+		int out_count;
+		int out_more;
+		fdb_check(f1.get(&out_kv, &out_count, &out_more));
+		CHECK(out_count == 0);
+		break;
+	}
+}
+
 TEST_CASE("cannot read system key") {
 	fdb::Transaction tr(db);
 
@@ -334,7 +334,7 @@ func (o NetworkOptions) SetClientTmpDir(param string) error {
 	return o.setOpt(91, []byte(param))
 }
 
-// Set the size of the client location cache. Raising this value can boost performance in very large databases where clients access data in a near-random pattern. Defaults to 100000.
+// Set the size of the client location cache. Raising this value can boost performance in very large databases where clients access data in a near-random pattern. Defaults to 600000, or to 10000 when the client shares one location cache across the databases it has open to a cluster.
 //
 // Parameter: Max location cache entries
 func (o DatabaseOptions) SetLocationCacheSize(param int64) error {
@@ -422,6 +422,13 @@ func (o DatabaseOptions) SetTransactionAutomaticIdempotency() error {
 	return o.setOpt(506, nil)
 }
 
+// Allow each transaction created by this database to start at a cached read version that is up to this many milliseconds old. This sets the ``max_read_version_staleness`` option of each transaction created by this database. See the transaction option description for more information.
+//
+// Parameter: value in milliseconds of maximum staleness
+func (o DatabaseOptions) SetTransactionMaxReadVersionStaleness(param int64) error {
+	return o.setOpt(507, int64ToBytes(param))
+}
+
 // Allows ``get`` operations to read from sections of keyspace that have become unreadable because of versionstamp operations. This sets the ``bypass_unreadable`` option of each transaction created by this database. See the transaction option description for more information.
 func (o DatabaseOptions) SetTransactionBypassUnreadable() error {
 	return o.setOpt(700, nil)
@@ -709,6 +716,13 @@ func (o TransactionOptions) SetUseGrvCache() error {
 	return o.setOpt(1101, nil)
 }
 
+// Allows this transaction to start at a read version cached by the database that was obtained from the cluster up to this many milliseconds ago, instead of requesting a new one. Reads may then miss commits made by other clients during that time. Upon first usage, starts a background updater that keeps the cache at most this old for as long as transactions keep asking for it. Unlike use_grv_cache, this does not require the disable_client_bypass option. A value of 0 disables it. Ignored after the transaction has been retried.
+//
+// Parameter: value in milliseconds of maximum staleness
+func (o TransactionOptions) SetMaxReadVersionStaleness(param int64) error {
+	return o.setOpt(1103, int64ToBytes(param))
+}
+
 // Attach given authorization token to the transaction such that subsequent tenant-aware requests are authorized
 //
 // Parameter: A JSON Web Token authorized to access data belonging to one or more tenants, indicated by 'tenants' claim of the token's payload.
@@ -732,6 +746,15 @@ type StreamingMode int
 
 const (
 
+	// Client intends to iterate over the range in order, continuing each read
+	// from where the last one ended. The range is streamed from the storage
+	// servers in parallel fragments ahead of the client, and each read returns
+	// what has arrived once at least one row is available, so a batch may hold
+	// fewer rows than the limits allow. Reverse reads, and reads that do not
+	// continue the previous one, are served as with “SERIAL“. Requires API
+	// version 740 or later.
+	StreamingModeStream StreamingMode = -2
+
 	// Client intends to consume the entire range and would like it all
 	// transferred as early as possible.
 	StreamingModeWantAll StreamingMode = -1
@@ -1669,21 +1669,24 @@ JNIEXPORT jlong JNICALL Java_com_apple_foundationdb_FDBTransaction_Transaction_1
 	return (jlong)f;
 }
 
-JNIEXPORT void JNICALL Java_com_apple_foundationdb_FutureResults_FutureResults_1getDirect(JNIEnv* jenv,
-                                                                                          jobject,
-                                                                                          jlong future,
-                                                                                          jobject jbuffer,
-                                                                                          jint bufferCapacity) {
+// Copies the whole result into the direct buffer. Returns false, leaving the buffer untouched, if it does not fit: the
+// caller then takes the result through FutureResults_get rather than cutting it short, which would make the range query
+// read the rest of it from the cluster again.
+JNIEXPORT jboolean JNICALL Java_com_apple_foundationdb_FutureResults_FutureResults_1getDirect(JNIEnv* jenv,
+                                                                                              jobject,
+                                                                                              jlong future,
+                                                                                              jobject jbuffer,
+                                                                                              jint bufferCapacity) {
 	if (!future) {
 		throwParamNotNull(jenv);
-		return;
+		return JNI_FALSE;
 	}
 
 	uint8_t* buffer = (uint8_t*)jenv->GetDirectBufferAddress(jbuffer);
 	if (!buffer) {
 		if (!jenv->ExceptionOccurred())
 			throwRuntimeEx(jenv, "Error getting handle to native resources");
-		return;
+		return JNI_FALSE;
 	}
 
 	FDBFuture* f = (FDBFuture*)future;
@@ -1693,7 +1696,7 @@ JNIEXPORT void JNICALL Java_com_apple_foundationdb_FutureResults_FutureResults_1
 	fdb_error_t err = fdb_future_get_keyvalue_array(f, &kvs, &count, &more);
 	if (err) {
 		safeThrow(jenv, getThrowable(jenv, err));
-		return;
+		return JNI_FALSE;
 	}
 
 	// Capacity for Metadata+Keys+Values
@@ -1705,9 +1708,7 @@ JNIEXPORT void JNICALL Java_com_apple_foundationdb_FutureResults_FutureResults_1
 	for (int i = 0; i < count; i++) {
 		totalCapacityNeeded += kvs[i].key_length + kvs[i].value_length + 2 * sizeof(jint);
 		if (bufferCapacity < totalCapacityNeeded) {
-			count = i; /* Only fit first `i` K/V pairs */
-			more = true;
-			break;
+			return JNI_FALSE;
 		}
 	}
 
@@ -1731,6 +1732,7 @@ JNIEXPORT void JNICALL Java_com_apple_foundationdb_FutureResults_FutureResults_1
 		memcpy(buffer + offset, kvs[i].value, kvs[i].value_length);
 		offset += kvs[i].value_length;
 	}
+	return JNI_TRUE;
 }
 
 void memcpyStringInner(uint8_t* buffer, int& offset, const uint8_t* data, const int& length) {
@@ -1744,7 +1746,8 @@ void memcpyString(uint8_t* buffer, int& offset, const FDBKey& key) {
 	memcpyStringInner(buffer, offset, key.key, key.key_length);
 }
 
-JNIEXPORT void JNICALL
+// Like FutureResults_getDirect, copies the whole result or returns false
+JNIEXPORT jboolean JNICALL
 Java_com_apple_foundationdb_FutureMappedResults_FutureMappedResults_1getDirect(JNIEnv* jenv,
                                                                                jobject,
                                                                                jlong future,
@@ -1753,14 +1756,14 @@ Java_com_apple_foundationdb_FutureMappedResults_FutureMappedResults_1getDirect(J
 
 	if (!future) {
 		throwParamNotNull(jenv);
-		return;
+		return JNI_FALSE;
 	}
 
 	uint8_t* buffer = (uint8_t*)jenv->GetDirectBufferAddress(jbuffer);
 	if (!buffer) {
 		if (!jenv->ExceptionOccurred())
 			throwRuntimeEx(jenv, "Error getting handle to native resources");
-		return;
+		return JNI_FALSE;
 	}
 
 	FDBFuture* f = (FDBFuture*)future;
@@ -1770,7 +1773,7 @@ Java_com_apple_foundationdb_FutureMappedResults_FutureMappedResults_1getDirect(J
 	fdb_error_t err = fdb_future_get_mappedkeyvalue_array(f, &kvms, &count, &more);
 	if (err) {
 		safeThrow(jenv, getThrowable(jenv, err));
-		return;
+		return JNI_FALSE;
 	}
 
 	int totalCapacityNeeded = 2 * sizeof(jint);
@@ -1785,9 +1788,7 @@ Java_com_apple_foundationdb_FutureMappedResults_FutureMappedResults_1getDirect(J
 			totalCapacityNeeded += kv.key_length + kv.value_length + 2 * sizeof(jint);
 		}
 		if (bufferCapacity < totalCapacityNeeded) {
-			count = i; /* Only fit first `i` K/V pairs */
-			more = true;
-			break;
+			return JNI_FALSE;
 		}
 	}
 
@@ -1817,6 +1818,7 @@ Java_com_apple_foundationdb_FutureMappedResults_FutureMappedResults_1getDirect(J
 			memcpyStringInner(buffer, offset, kv.value, kv.value_length);
 		}
 	}
+	return JNI_TRUE;
 }
 
 JNIEXPORT jlong JNICALL
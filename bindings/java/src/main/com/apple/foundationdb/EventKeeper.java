@@ -147,6 +147,11 @@ public interface EventKeeper {
 		 * transfer data across the JNI boundary
 		 */
 		RANGE_QUERY_DIRECT_BUFFER_MISS,
+		/**
+		 * The number of times a range query chunk was too large for its DirectBuffer and was
+		 * transferred across the JNI boundary in arrays instead
+		 */
+		RANGE_QUERY_DIRECT_BUFFER_OVERFLOW,
 		/**
 		 * The number of direct fetches made during a range query
 		 */
@@ -68,13 +68,18 @@ class FutureMappedResults extends NativeFuture<MappedRangeResultInfo> {
 			if (buffer != null) {
 				try (MappedRangeResultDirectBufferIterator directIterator =
 				         new MappedRangeResultDirectBufferIterator(buffer)) {
-					FutureMappedResults_getDirect(getPtr(), directIterator.getBuffer(),
-					                              directIterator.getBuffer().capacity());
-					return new MappedRangeResult(directIterator);
+					if (FutureMappedResults_getDirect(getPtr(), directIterator.getBuffer(),
+					                                  directIterator.getBuffer().capacity())) {
+						return new MappedRangeResult(directIterator);
+					}
+				}
+				// Too large for the buffer: take all of it through arrays rather than only the part that fits
+				if (eventKeeper != null) {
+					eventKeeper.increment(Events.RANGE_QUERY_DIRECT_BUFFER_OVERFLOW);
+					eventKeeper.increment(Events.JNI_CALL);
 				}
-			} else {
-				return FutureMappedResults_get(getPtr());
 			}
+			return FutureMappedResults_get(getPtr());
 		} finally {
 			pointerReadLock.unlock();
 		}
@@ -83,5 +88,6 @@ class FutureMappedResults extends NativeFuture<MappedRangeResultInfo> {
 	private boolean enableDirectBufferQueries = false;
 
 	private native MappedRangeResult FutureMappedResults_get(long cPtr) throws FDBException;
-	private native void FutureMappedResults_getDirect(long cPtr, ByteBuffer buffer, int capacity) throws FDBException;
+	private native boolean FutureMappedResults_getDirect(long cPtr, ByteBuffer buffer, int capacity)
+		throws FDBException;
 }
@@ -67,12 +67,18 @@ class FutureResults extends NativeFuture<RangeResultInfo> {
 			pointerReadLock.lock();
 			if (buffer != null) {
 				try (RangeResultDirectBufferIterator directIterator = new RangeResultDirectBufferIterator(buffer)) {
-					FutureResults_getDirect(getPtr(), directIterator.getBuffer(), directIterator.getBuffer().capacity());
-					return new RangeResult(directIterator);
+					if (FutureResults_getDirect(getPtr(), directIterator.getBuffer(),
+					                            directIterator.getBuffer().capacity())) {
+						return new RangeResult(directIterator);
+					}
+				}
+				// Too large for the buffer: take all of it through arrays rather than only the part that fits
+				if (eventKeeper != null) {
+					eventKeeper.increment(Events.RANGE_QUERY_DIRECT_BUFFER_OVERFLOW);
+					eventKeeper.increment(Events.JNI_CALL);
 				}
-			} else {
-				return FutureResults_get(getPtr());
 			}
+			return FutureResults_get(getPtr());
 		} finally {
 			pointerReadLock.unlock();
 		}
@@ -81,6 +87,6 @@ class FutureResults extends NativeFuture<RangeResultInfo> {
 	private boolean enableDirectBufferQueries = false;
 
 	private native RangeResult FutureResults_get(long cPtr) throws FDBException;
-	private native void FutureResults_getDirect(long cPtr, ByteBuffer buffer, int capacity)
+	private native boolean FutureResults_getDirect(long cPtr, ByteBuffer buffer, int capacity)
 		throws FDBException;
 }
@@ -175,6 +175,10 @@ set(WITH_ROCKSDB ON CACHE BOOL "Build with experimental RocksDB support")
 set(PORTABLE_ROCKSDB 1 CACHE STRING "Minimum CPU arch to support (i.e. skylake, haswell, etc., or 0 = current CPU, 1 = baseline CPU)")
 set(ROCKSDB_TOOLS OFF CACHE BOOL "Compile RocksDB tools")
 set(WITH_LIBURING OFF CACHE BOOL "Build with liburing enabled") # Set this to ON to include liburing
+if(WITH_LIBURING)
+  # Also used outside RocksDB, by Net2's io_uring reactor and AsyncFileIOUring
+  find_package(uring REQUIRED)
+endif()
 
 ################################################################################
 # TOML11
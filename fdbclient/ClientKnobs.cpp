@@ -39,6 +39,7 @@ void ClientKnobs::initialize(Randomize randomize) {
 
 	init( SYSTEM_MONITOR_INTERVAL,                 5.0 );
 	init( NETWORK_BUSYNESS_MONITOR_INTERVAL,       1.0 );
+	init( NETWORK_BUSYNESS_TRACE_INTERVAL,        10.0 ); if( randomize && BUGGIFY ) NETWORK_BUSYNESS_TRACE_INTERVAL = 1.0;
 	init( TSS_METRICS_LOGGING_INTERVAL,          120.0 ); // 2 minutes by default
 
 	init( FAILURE_MAX_DELAY,                       5.0 );
@@ -87,19 +88,30 @@ void ClientKnobs::initialize(Randomize randomize) {
 	init( CHANGE_FEED_CACHE_FLUSH_BYTES,          10e6 ); if( randomize && BUGGIFY ) CHANGE_FEED_CACHE_FLUSH_BYTES = deterministicRandom()->randomInt64(1, 1e6);
 	init( CHANGE_FEED_CACHE_EXPIRE_TIME,          60.0 ); if( randomize && BUGGIFY ) CHANGE_FEED_CACHE_EXPIRE_TIME = 1.0;
 	init( CHANGE_FEED_CACHE_LIMIT_BYTES,        500000 ); if( randomize && BUGGIFY ) CHANGE_FEED_CACHE_LIMIT_BYTES = 50000;
+	init( COMMIT_COMPRESSION_ENABLED,            false ); if( randomize && BUGGIFY ) COMMIT_COMPRESSION_ENABLED = true;
+	init( COMMIT_COMPRESSION_MIN_BYTES,            1e5 ); if( randomize && BUGGIFY ) COMMIT_COMPRESSION_MIN_BYTES = 0;
+	init( COMMIT_COMPRESSION_BLOCK_BYTES,          1e6 ); if( randomize && BUGGIFY ) COMMIT_COMPRESSION_BLOCK_BYTES = deterministicRandom()->randomInt(1, 1e4);
 
 	init( MAX_BATCH_SIZE,                         1000 ); if( randomize && BUGGIFY ) MAX_BATCH_SIZE = 1;
 	init( GRV_BATCH_TIMEOUT,                     0.005 ); if( randomize && BUGGIFY ) GRV_BATCH_TIMEOUT = 0.1;
+	init( GRV_BATCH_ADAPTIVE,                    false ); if( randomize && BUGGIFY ) GRV_BATCH_ADAPTIVE = true;
+	init( GRV_BATCH_TARGET_LATENCY,              0.010 ); if( randomize && BUGGIFY ) GRV_BATCH_TARGET_LATENCY = deterministicRandom()->random01() * 0.1;
+	init( GRV_BATCH_ADAPTIVE_MAX_TIMEOUT,        0.050 ); if( randomize && BUGGIFY ) GRV_BATCH_ADAPTIVE_MAX_TIMEOUT = 0.005;
 	init( BROADCAST_BATCH_SIZE,                     20 ); if( randomize && BUGGIFY ) BROADCAST_BATCH_SIZE = 1;
 	init( TRANSACTION_TIMEOUT_DELAY_INTERVAL,     10.0 ); if( randomize && BUGGIFY ) TRANSACTION_TIMEOUT_DELAY_INTERVAL = 1.0;
 
 	init( LOCATION_CACHE_EVICTION_SIZE,         600000 );
 	init( LOCATION_CACHE_EVICTION_SIZE_SIM,         10 ); if( randomize && BUGGIFY ) LOCATION_CACHE_EVICTION_SIZE_SIM = 3;
+	init( LOCATION_CACHE_EVICTION_SIZE_SHARED,   10000 );
 	init( LOCATION_CACHE_ENDPOINT_FAILURE_GRACE_PERIOD,     60 );
 	init( LOCATION_CACHE_FAILED_ENDPOINT_RETRY_INTERVAL,    60 );
+	init( SHARED_LOCATION_CACHE,                  true ); if( randomize && BUGGIFY ) SHARED_LOCATION_CACHE = false;
+	init( SHARED_LOCATION_CACHE_MAX_BYTES,        100e6 ); if( randomize && BUGGIFY ) SHARED_LOCATION_CACHE_MAX_BYTES = deterministicRandom()->randomInt(1000, 100000);
 
 	init( GET_RANGE_SHARD_LIMIT,                     2 );
 	init( WARM_RANGE_SHARD_LIMIT,                  100 );
+	init( WARM_RANGE_BULK_SHARD_LIMIT,           10000 ); if( randomize && BUGGIFY ) WARM_RANGE_BULK_SHARD_LIMIT = deterministicRandom()->randomInt(1, 100);
+	init( GET_VALUES_MAX_KEYS_PER_REQUEST,        1000 ); if( randomize && BUGGIFY ) GET_VALUES_MAX_KEYS_PER_REQUEST = deterministicRandom()->randomInt(1, 10);
 	init( STORAGE_METRICS_SHARD_LIMIT,             100 ); if( randomize && BUGGIFY ) STORAGE_METRICS_SHARD_LIMIT = 10;
 	init( SHARD_COUNT_LIMIT,                        80 ); if( randomize && BUGGIFY ) SHARD_COUNT_LIMIT = 3;
 	init( STORAGE_METRICS_UNFAIR_SPLIT_LIMIT,  2.0/3.0 );
@@ -110,6 +122,7 @@ void ClientKnobs::initialize(Randomize randomize) {
 	init( TAG_ENCODE_KEY_SERVERS,                false ); if( randomize && BUGGIFY ) TAG_ENCODE_KEY_SERVERS = true;
 	init( RANGESTREAM_FRAGMENT_SIZE,               1e6 );
 	init( RANGESTREAM_BUFFERED_FRAGMENTS_LIMIT,     20 );
+	init( RANGESTREAM_BUFFERED_BYTES_LIMIT,        1e7 ); if( randomize && BUGGIFY ) RANGESTREAM_BUFFERED_BYTES_LIMIT = 1;
 	init( QUARANTINE_TSS_ON_MISMATCH,             true ); if( randomize && BUGGIFY ) QUARANTINE_TSS_ON_MISMATCH = false; // if true, a tss mismatch will put the offending tss in quarantine. If false, it will just be killed
 	init( CHANGE_FEED_EMPTY_BATCH_TIME,          0.005 );
 
@@ -129,6 +142,8 @@ void ClientKnobs::initialize(Randomize randomize) {
 	init( LOG_RANGE_BLOCK_SIZE, CORE_VERSIONSPERSECOND );
 	init( MUTATION_BLOCK_SIZE,	            	  10000);
 	init( MAX_VERSION_CACHE_LAG,                    0.1 );
+	init( MIN_VERSION_CACHE_LAG,                  0.005 );
+	init( VERSION_CACHE_LAG_WINDOW,                10.0 ); if( randomize && BUGGIFY ) VERSION_CACHE_LAG_WINDOW = 0.5;
 	init( MAX_PROXY_CONTACT_LAG,                    0.2 );
 	init( DEBUG_USE_GRV_CACHE_CHANCE,              -1.0 ); // For 100% chance at 1.0, this means 0.0 is not 0%. We don't want the default to be 0. 
 	init( FORCE_GRV_CACHE_OFF,                    false );
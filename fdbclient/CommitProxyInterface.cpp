@@ -1,6 +1,9 @@
 #include "fdbclient/CommitProxyInterface.h"
 #include "fdbclient/CoordinationInterface.h"
 #include "fdbclient/GetEncryptCipherKeys_impl.actor.h"
+#include "fdbclient/Knobs.h"
+#include "flow/CompressionUtils.h"
+#include "flow/UnitTest.h"
 
 // Instantiate ClientDBInfo related templates
 template class ReplyPromise<struct ClientDBInfo>;
@@ -12,4 +15,156 @@ template struct NetNotifiedQueue<OpenDatabaseCoordRequest, true>;
 
 // Instantiate GetKeyServerLocationsReply related templates
 template class ReplyPromise<GetKeyServerLocationsReply>;
-template struct NetSAV<GetKeyServerLocationsReply>;
\ No newline at end of file
+template struct NetSAV<GetKeyServerLocationsReply>;
+
+StringRef compressMutationBlock(VectorRef<MutationRef> mutations, Arena& arena, int64_t& serializedBytes) {
+	BinaryWriter writer(IncludeVersion());
+	writer << mutations;
+	serializedBytes += writer.getLength();
+	return CompressionUtils::compress(CompressionFilter::ZSTD,
+	                                  writer.toValue(),
+	                                  CompressionUtils::getDefaultCompressionLevel(CompressionFilter::ZSTD),
+	                                  arena);
+}
+
+int64_t maxDecompressedMutationBytes() {
+	// Serializing adds a type, two lengths and a checksum to each mutation, which the transaction size does not count
+	return CLIENT_KNOBS->TRANSACTION_SIZE_LIMIT + CLIENT_KNOBS->TRANSACTION_SIZE_LIMIT / 10;
+}
+
+int64_t decompressMutations(CommitTransactionRequest& req) {
+	ASSERT(req.hasCompressedMutations() && req.transaction.mutations.empty());
+
+	// The blocks come from the client, so check what each claims to decompress to before decompressing any of them
+	int64_t decompressedBytes = 0;
+	for (const auto& block : req.compressedMutations) {
+		Optional<int64_t> size = CompressionUtils::decompressedSize(CompressionFilter::ZSTD, block);
+		if (!size.present()) {
+			throw serialization_failed();
+		}
+		decompressedBytes += size.get();
+		if (size.get() > maxDecompressedMutationBytes() || decompressedBytes > maxDecompressedMutationBytes()) {
+			throw transaction_too_large();
+		}
+	}
+
+	int64_t compressedBytes = 0;
+	for (const auto& block : req.compressedMutations) {
+		StringRef data = CompressionUtils::decompress(CompressionFilter::ZSTD, block, req.arena);
+		if (data.size() < sizeof(uint64_t) + sizeof(uint32_t)) {
+			throw serialization_failed();
+		}
+		ArenaReader reader(req.arena, data, IncludeVersion());
+		// Each mutation takes at least a type and two lengths, so a count which would not fit in the block is corrupt,
+		// and is rejected before the reader sizes the vector for it
+		constexpr size_t minMutationBytes = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+		uint32_t count;
+		memcpy(&count, reader.peekBytes(sizeof(count)), sizeof(count));
+		if (count > (reader.remainingBytes() - sizeof(count)) / minMutationBytes) {
+			throw serialization_failed();
+		}
+		VectorRef<MutationRef> mutations;
+		reader >> mutations;
+		if (req.transaction.mutations.empty()) {
+			req.transaction.mutations = mutations;
+		} else {
+			req.transaction.mutations.append(req.arena, mutations.begin(), mutations.size());
+		}
+		compressedBytes += block.size();
+	}
+	req.compressedMutations = VectorRef<StringRef>();
+	req.flags &= ~CommitTransactionRequest::FLAG_COMPRESSED_MUTATIONS;
+	return compressedBytes;
+}
+
+void forceLinkCommitProxyInterfaceTests() {}
+
+TEST_CASE("/fdbclient/CommitProxyInterface/compressedMutations") {
+	if (!CompressionUtils::supportedFilters.contains(CompressionFilter::ZSTD)) {
+		return Void();
+	}
+
+	Arena arena;
+	VectorRef<MutationRef> mutations;
+	int count = deterministicRandom()->randomInt(1, 1000);
+	for (int i = 0; i < count; i++) {
+		Key key = Key(format("key%08d", i));
+		Value value = Value(std::string(deterministicRandom()->randomInt(0, 1000), 'v'));
+		mutations.push_back_deep(arena,
+		                         i % 10 == 0 ? MutationRef(MutationRef::ClearRange, key, keyAfter(key))
+		                                     : MutationRef(MutationRef::SetValue, key, value));
+	}
+
+	// Split into blocks as the client does, then decode them as the proxy does
+	CommitTransactionRequest req;
+	req.flags = CommitTransactionRequest::FLAG_COMPRESSED_MUTATIONS;
+	int blockSize = deterministicRandom()->randomInt(1, count + 1);
+	int64_t serializedBytes = 0;
+	for (int i = 0; i < count; i += blockSize) {
+		VectorRef<MutationRef> block(mutations.begin() + i, std::min(blockSize, count - i));
+		req.compressedMutations.push_back(req.arena, compressMutationBlock(block, req.arena, serializedBytes));
+	}
+	ASSERT(serializedBytes > mutations.expectedSize());
+
+	ASSERT(decompressMutations(req) > 0);
+	ASSERT(!req.hasCompressedMutations() && req.compressedMutations.empty());
+	ASSERT(req.transaction.mutations.size() == mutations.size());
+	for (int i = 0; i < mutations.size(); i++) {
+		ASSERT(req.transaction.mutations[i].type == mutations[i].type);
+		ASSERT(req.transaction.mutations[i].param1 == mutations[i].param1);
+		ASSERT(req.transaction.mutations[i].param2 == mutations[i].param2);
+	}
+	return Void();
+}
+
+namespace {
+
+// Returns a ZSTD frame which holds no data but whose header claims it decompresses to contentSize bytes, or leaves the
+// size out if contentSize is not present
+Standalone<StringRef> zstdFrameClaiming(Optional<uint64_t> contentSize) {
+	std::string frame("\x28\xb5\x2f\xfd", 4); // Magic number
+	frame += contentSize.present() ? '\xc0' : '\x00'; // Frame header descriptor: an 8 byte content size, or none
+	frame += '\x00'; // Window descriptor
+	if (contentSize.present()) {
+		uint64_t size = contentSize.get();
+		frame.append(reinterpret_cast<const char*>(&size), sizeof(size));
+	}
+	frame.append("\x01\x00\x00", 3); // The last block, raw and empty
+	return Standalone<StringRef>(frame);
+}
+
+// Returns the code of the error decompressMutations() throws for a commit holding blocks
+int decompressError(std::vector<Standalone<StringRef>> const& blocks) {
+	CommitTransactionRequest req;
+	req.flags = CommitTransactionRequest::FLAG_COMPRESSED_MUTATIONS;
+	for (const auto& block : blocks) {
+		req.compressedMutations.push_back_deep(req.arena, block);
+	}
+	try {
+		decompressMutations(req);
+	} catch (Error& e) {
+		return e.code();
+	}
+	return error_code_success;
+}
+
+} // namespace
+
+TEST_CASE("/fdbclient/CommitProxyInterface/malformedCompressedMutations") {
+	if (!CompressionUtils::supportedFilters.contains(CompressionFilter::ZSTD)) {
+		return Void();
+	}
+
+	Standalone<StringRef> garbage = makeString(deterministicRandom()->randomInt(1, 1000));
+	deterministicRandom()->randomBytes(mutateString(garbage), garbage.size());
+	ASSERT_EQ(decompressError({ garbage }), error_code_serialization_failed);
+	ASSERT_EQ(decompressError({ zstdFrameClaiming(Optional<uint64_t>()) }), error_code_serialization_failed);
+
+	// Frames claiming more than a proxy decompresses are rejected from their headers, before anything is allocated
+	ASSERT_EQ(decompressError({ zstdFrameClaiming(uint64_t(1) << 62) }), error_code_transaction_too_large);
+	ASSERT_EQ(decompressError({ zstdFrameClaiming(maxDecompressedMutationBytes() + 1) }),
+	          error_code_transaction_too_large);
+	Standalone<StringRef> half = zstdFrameClaiming(maxDecompressedMutationBytes() / 2 + 1);
+	ASSERT_EQ(decompressError({ half, half }), error_code_transaction_too_large);
+	return Void();
+}
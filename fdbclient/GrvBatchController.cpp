@@ -0,0 +1,175 @@
+/*
+ * GrvBatchController.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/GrvBatchController.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "fdbclient/Knobs.h"
+#include "flow/UnitTest.h"
+
+GrvBatchController::GrvBatchController()
+  : GrvBatchController(CLIENT_KNOBS->GRV_BATCH_ADAPTIVE,
+                       CLIENT_KNOBS->GRV_BATCH_TARGET_LATENCY,
+                       CLIENT_KNOBS->GRV_BATCH_ADAPTIVE_MAX_TIMEOUT,
+                       CLIENT_KNOBS->GRV_BATCH_TIMEOUT,
+                       CLIENT_KNOBS->MAX_BATCH_SIZE) {}
+
+GrvBatchController::GrvBatchController(bool adaptive,
+                                       double targetLatency,
+                                       double maxWindow,
+                                       double legacyMaxWindow,
+                                       int maxBatchSize)
+  : adaptive(adaptive), targetLatency(targetLatency), maxWindow(maxWindow), legacyMaxWindow(legacyMaxWindow),
+    maxBatchSize(maxBatchSize) {
+	replyLatencies.reserve(latencySamples);
+}
+
+void GrvBatchController::addArrival(double now) {
+	arrivalRate = getArrivalRate(now) + 1.0 / rateTimeConstant;
+	lastArrival = now;
+}
+
+double GrvBatchController::getArrivalRate(double now) const {
+	return arrivalRate * std::exp(-std::max(0.0, now - lastArrival) / rateTimeConstant);
+}
+
+void GrvBatchController::addReplyLatency(double latency) {
+	legacyWindow = std::min(0.1 * (latency * 0.5) + 0.9 * legacyWindow, legacyMaxWindow);
+
+	if (replyLatencies.size() < (size_t)latencySamples) {
+		replyLatencies.push_back(latency);
+	} else {
+		replyLatencies[nextLatency] = latency;
+	}
+	nextLatency = (nextLatency + 1) % latencySamples;
+
+	// Estimate often while the window is filling so the first batches do not go without a budget
+	if (++replyCount % recomputeInterval == 0 || replyCount < recomputeInterval) {
+		std::vector<double> sorted = replyLatencies;
+		auto p99 = sorted.begin() + std::max(0, (int)std::ceil(sorted.size() * 0.99) - 1);
+		std::nth_element(sorted.begin(), p99, sorted.end());
+		replyLatency99 = *p99;
+	}
+}
+
+double GrvBatchController::getWindow(double now) {
+	if (!adaptive || replyCount == 0) {
+		lastWindow = legacyWindow;
+		return lastWindow;
+	}
+
+	double budget = targetLatency - replyLatency99;
+	if (budget <= 0) {
+		++fallbackBatches;
+		lastWindow = legacyWindow;
+		return lastWindow;
+	}
+
+	double rate = getArrivalRate(now);
+	double window = std::min(budget, maxWindow);
+	if (rate > 0) {
+		window = std::min(window, maxBatchSize / rate);
+	}
+	if (rate * window < 1) {
+		++immediateBatches;
+		lastWindow = 0;
+	} else {
+		++budgetBatches;
+		lastWindow = window;
+	}
+	return lastWindow;
+}
+
+void GrvBatchController::logMetrics(TraceEvent& ev, double now) const {
+	ev.detail("Adaptive", adaptive)
+	    .detail("TargetLatency", targetLatency)
+	    .detail("Window", lastWindow)
+	    .detail("ReplyLatency99", replyLatency99)
+	    .detail("ArrivalRate", getArrivalRate(now))
+	    .detail("ImmediateBatches", immediateBatches)
+	    .detail("BudgetBatches", budgetBatches)
+	    .detail("FallbackBatches", fallbackBatches);
+}
+
+void forceLinkGrvBatchControllerTests() {}
+
+TEST_CASE("/fdbclient/GrvBatchController/legacy") {
+	GrvBatchController controller(false, 0.01, 0.05, 0.005, 1000);
+	ASSERT_EQ(controller.getWindow(0), 0.0);
+	for (int i = 0; i < 1000; ++i) {
+		controller.addReplyLatency(0.002);
+	}
+	// Half the reply latency once the average settles
+	ASSERT(std::abs(controller.getWindow(0) - 0.001) < 1e-6);
+	for (int i = 0; i < 1000; ++i) {
+		controller.addReplyLatency(1.0);
+	}
+	ASSERT_EQ(controller.getWindow(0), 0.005);
+	return Void();
+}
+
+TEST_CASE("/fdbclient/GrvBatchController/adaptive") {
+	GrvBatchController controller(true, 0.01, 0.05, 0.005, 1000);
+	double t = 0;
+
+	// Nothing known about reply latency yet
+	controller.addArrival(t);
+	ASSERT_EQ(controller.getWindow(t), 0.0);
+
+	// 99 fast replies and one slow one every hundred
+	for (int i = 0; i < 1000; ++i) {
+		controller.addReplyLatency(i % 100 == 0 ? 0.004 : 0.001);
+	}
+	ASSERT(controller.getReplyLatency99() >= 0.001 && controller.getReplyLatency99() <= 0.004);
+
+	// One request a second: no other request would join the batch, so it is sent at once
+	for (int i = 0; i < 10; ++i) {
+		t += 1.0;
+		controller.addArrival(t);
+	}
+	ASSERT_EQ(controller.getWindow(t), 0.0);
+
+	// Ten thousand requests a second: wait out the whole budget
+	for (int i = 0; i < 10000; ++i) {
+		t += 1e-4;
+		controller.addArrival(t);
+	}
+	ASSERT(std::abs(controller.getArrivalRate(t) - 1e4) < 1e3);
+	double window = controller.getWindow(t);
+	ASSERT(window > 0 && window <= 0.01 - controller.getReplyLatency99() + 1e-9);
+
+	// A million requests a second fill the batch long before the budget is used up
+	for (int i = 0; i < 100000; ++i) {
+		t += 1e-6;
+		controller.addArrival(t);
+	}
+	window = controller.getWindow(t);
+	ASSERT(window > 0 && window < 0.002);
+
+	// Replies alone miss the target: keep batching as the non-adaptive batcher would
+	for (int i = 0; i < GrvBatchController::latencySamples; ++i) {
+		controller.addReplyLatency(0.1);
+	}
+	ASSERT(controller.getReplyLatency99() == 0.1);
+	ASSERT(controller.getWindow(t) > 0 && controller.getWindow(t) <= 0.005);
+	return Void();
+}
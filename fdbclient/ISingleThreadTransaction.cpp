@@ -71,3 +71,28 @@ Reference<ISingleThreadTransaction> ISingleThreadTransaction::create(Type type,
 	result->construct(cx, tenant);
 	return result;
 }
+
+Future<RangeResult> ISingleThreadTransaction::getMulti(const Standalone<VectorRef<KeyRef>>& keys, Snapshot snapshot) {
+	std::vector<Future<Optional<Value>>> reads;
+	reads.reserve(keys.size());
+	for (const auto& key : keys) {
+		reads.push_back(get(Key(key, keys.arena()), snapshot));
+	}
+	return map(getAll(reads), [keys](std::vector<Optional<Value>> const& values) {
+		RangeResult result;
+		for (int i = 0; i < keys.size(); ++i) {
+			if (values[i].present()) {
+				result.push_back_deep(result.arena(), KeyValueRef(keys[i], values[i].get()));
+			}
+		}
+		return result;
+	});
+}
+
+Future<RangeResult> ISingleThreadTransaction::getRangeStreamBatch(KeySelector begin,
+                                                                  KeySelector end,
+                                                                  GetRangeLimits limits,
+                                                                  Snapshot snapshot,
+                                                                  Reverse reverse) {
+	return getRange(begin, end, limits, snapshot, reverse);
+}
@@ -117,6 +117,30 @@ ThreadFuture<Key> DLTransaction::getKey(const KeySelectorRef& key, bool snapshot
 	});
 }
 
+ThreadFuture<RangeResult> DLTransaction::getMulti(const VectorRef<KeyRef>& keys, bool snapshot) {
+	if (!api->transactionGetMulti) {
+		return unsupported_operation();
+	}
+
+	std::vector<FdbCApi::FDBKey> cKeys;
+	cKeys.reserve(keys.size());
+	for (const KeyRef& key : keys) {
+		cKeys.push_back(FdbCApi::FDBKey{ key.begin(), key.size() });
+	}
+
+	FdbCApi::FDBFuture* f = api->transactionGetMulti(tr, cKeys.data(), cKeys.size(), snapshot);
+	return toThreadFuture<RangeResult>(api, f, [](FdbCApi::FDBFuture* f, FdbCApi* api) {
+		const FdbCApi::FDBKeyValue* kvs;
+		int count;
+		FdbCApi::fdb_bool_t more;
+		FdbCApi::fdb_error_t error = api->futureGetKeyValueArray(f, &kvs, &count, &more);
+		ASSERT(!error);
+
+		// The memory for this is stored in the FDBFuture and is released when the future gets destroyed
+		return RangeResult(RangeResultRef(VectorRef<KeyValueRef>((KeyValueRef*)kvs, count), more), Arena());
+	});
+}
+
 ThreadFuture<RangeResult> DLTransaction::getRange(const KeySelectorRef& begin,
                                                   const KeySelectorRef& end,
                                                   int limit,
@@ -169,6 +193,44 @@ ThreadFuture<RangeResult> DLTransaction::getRange(const KeyRangeRef& keys,
 	return getRange(firstGreaterOrEqual(keys.begin), firstGreaterOrEqual(keys.end), limits, snapshot, reverse);
 }
 
+ThreadFuture<RangeResult> DLTransaction::getRangeStreamBatch(const KeySelectorRef& begin,
+                                                             const KeySelectorRef& end,
+                                                             GetRangeLimits limits,
+                                                             bool snapshot,
+                                                             bool reverse) {
+	// FDB_STREAMING_MODE_STREAM arrived in the same API version as fdb_transaction_get_multi, so older libraries are
+	// read as before
+	if (!api->transactionGetMulti) {
+		return getRange(begin, end, limits, snapshot, reverse);
+	}
+
+	FdbCApi::FDBFuture* f = api->transactionGetRange(tr,
+	                                                 begin.getKey().begin(),
+	                                                 begin.getKey().size(),
+	                                                 begin.orEqual,
+	                                                 begin.offset,
+	                                                 end.getKey().begin(),
+	                                                 end.getKey().size(),
+	                                                 end.orEqual,
+	                                                 end.offset,
+	                                                 limits.rows,
+	                                                 limits.bytes,
+	                                                 FDB_STREAMING_MODE_STREAM,
+	                                                 0,
+	                                                 snapshot,
+	                                                 reverse);
+	return toThreadFuture<RangeResult>(api, f, [](FdbCApi::FDBFuture* f, FdbCApi* api) {
+		const FdbCApi::FDBKeyValue* kvs;
+		int count;
+		FdbCApi::fdb_bool_t more;
+		FdbCApi::fdb_error_t error = api->futureGetKeyValueArray(f, &kvs, &count, &more);
+		ASSERT(!error);
+
+		// The memory for this is stored in the FDBFuture and is released when the future gets destroyed
+		return RangeResult(RangeResultRef(VectorRef<KeyValueRef>((KeyValueRef*)kvs, count), more), Arena());
+	});
+}
+
 ThreadFuture<MappedRangeResult> DLTransaction::getMappedRange(const KeySelectorRef& begin,
                                                               const KeySelectorRef& end,
                                                               const StringRef& mapper,
@@ -1112,6 +1174,11 @@ void DLApi::init() {
 	    &api->transactionGetReadVersion, lib, fdbCPath, "fdb_transaction_get_read_version", headerVersion >= 0);
 	loadClientFunction(&api->transactionGet, lib, fdbCPath, "fdb_transaction_get", headerVersion >= 0);
 	loadClientFunction(&api->transactionGetKey, lib, fdbCPath, "fdb_transaction_get_key", headerVersion >= 0);
+	loadClientFunction(&api->transactionGetMulti,
+	                   lib,
+	                   fdbCPath,
+	                   "fdb_transaction_get_multi",
+	                   headerVersion >= ApiVersion::withGetMulti().version());
 	loadClientFunction(&api->transactionGetAddressesForKey,
 	                   lib,
 	                   fdbCPath,
@@ -1476,6 +1543,10 @@ ThreadFuture<Key> MultiVersionTransaction::getKey(const KeySelectorRef& key, boo
 	return executeOperation(&ITransaction::getKey, key, std::forward<bool>(snapshot));
 }
 
+ThreadFuture<RangeResult> MultiVersionTransaction::getMulti(const VectorRef<KeyRef>& keys, bool snapshot) {
+	return executeOperation(&ITransaction::getMulti, keys, std::forward<bool>(snapshot));
+}
+
 ThreadFuture<RangeResult> MultiVersionTransaction::getRange(const KeySelectorRef& begin,
                                                             const KeySelectorRef& end,
                                                             int limit,
@@ -1539,6 +1610,19 @@ ThreadFuture<MappedRangeResult> MultiVersionTransaction::getMappedRange(const Ke
 	                        std::forward<bool>(reverse));
 }
 
+ThreadFuture<RangeResult> MultiVersionTransaction::getRangeStreamBatch(const KeySelectorRef& begin,
+                                                                       const KeySelectorRef& end,
+                                                                       GetRangeLimits limits,
+                                                                       bool snapshot,
+                                                                       bool reverse) {
+	return executeOperation(&ITransaction::getRangeStreamBatch,
+	                        begin,
+	                        end,
+	                        std::forward<GetRangeLimits>(limits),
+	                        std::forward<bool>(snapshot),
+	                        std::forward<bool>(reverse));
+}
+
 ThreadFuture<Standalone<StringRef>> MultiVersionTransaction::getVersionstamp() {
 	return executeOperation(&ITransaction::getVersionstamp);
 }
@@ -25,6 +25,7 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <regex>
 #include <string>
 #include <unordered_set>
@@ -81,6 +82,7 @@
 #include "fdbrpc/sim_validation.h"
 #include "flow/Arena.h"
 #include "flow/ActorCollection.h"
+#include "flow/CompressionUtils.h"
 #include "flow/DeterministicRandom.h"
 #include "flow/Error.h"
 #include "flow/FastRef.h"
@@ -193,6 +195,8 @@ void DatabaseContext::addTssMapping(StorageServerInterface const& ssi, StorageSe
 		                             TSSEndpointData(tssi.id(), tssi.getValue.getEndpoint(), metrics));
 		queueModel.updateTssEndpoint(ssi.getKey.getEndpoint().token.first(),
 		                             TSSEndpointData(tssi.id(), tssi.getKey.getEndpoint(), metrics));
+		queueModel.updateTssEndpoint(ssi.getValues.getEndpoint().token.first(),
+		                             TSSEndpointData(tssi.id(), tssi.getValues.getEndpoint(), metrics));
 		queueModel.updateTssEndpoint(ssi.getKeyValues.getEndpoint().token.first(),
 		                             TSSEndpointData(tssi.id(), tssi.getKeyValues.getEndpoint(), metrics));
 		queueModel.updateTssEndpoint(ssi.getMappedKeyValues.getEndpoint().token.first(),
@@ -227,6 +231,7 @@ void DatabaseContext::removeTssMapping(StorageServerInterface const& ssi) {
 		tssMapping.erase(result);
 		queueModel.removeTssEndpoint(ssi.getValue.getEndpoint().token.first());
 		queueModel.removeTssEndpoint(ssi.getKey.getEndpoint().token.first());
+		queueModel.removeTssEndpoint(ssi.getValues.getEndpoint().token.first());
 		queueModel.removeTssEndpoint(ssi.getKeyValues.getEndpoint().token.first());
 		queueModel.removeTssEndpoint(ssi.getMappedKeyValues.getEndpoint().token.first());
 		queueModel.removeTssEndpoint(ssi.getKeyValuesStream.getEndpoint().token.first());
@@ -307,7 +312,8 @@ void DatabaseContext::getLatestCommitVersions(const Reference<LocationInfo>& loc
 	}
 
 	if (info->readVersion() > ssVersionVectorCache.getMaxVersion()) {
-		if (!CLIENT_KNOBS->FORCE_GRV_CACHE_OFF && !info->options.skipGrvCache && info->options.useGrvCache) {
+		if (!CLIENT_KNOBS->FORCE_GRV_CACHE_OFF && !info->options.skipGrvCache &&
+		    (info->options.useGrvCache || info->options.maxReadVersionStaleness > 0)) {
 			return;
 		} else {
 			TraceEvent(SevError, "GetLatestCommitVersions")
@@ -385,6 +391,64 @@ void DatabaseContext::updateCachedReadVersion(double t, Version v) {
 	}
 }
 
+void GrvCacheLagBound::ask(double staleness, double t) {
+	staleness = std::max(staleness, CLIENT_KNOBS->MIN_VERSION_CACHE_LAG);
+	if (lag == 0 || staleness <= lag || t - askedTime > CLIENT_KNOBS->VERSION_CACHE_LAG_WINDOW) {
+		lag = staleness;
+		askedTime = t;
+	}
+}
+
+double GrvCacheLagBound::get(double t) const {
+	if (lag == 0 || t - askedTime > CLIENT_KNOBS->VERSION_CACHE_LAG_WINDOW) {
+		return CLIENT_KNOBS->MAX_VERSION_CACHE_LAG;
+	}
+	return std::min(lag, CLIENT_KNOBS->MAX_VERSION_CACHE_LAG);
+}
+
+TEST_CASE("/fdbclient/NativeAPI/GrvCacheLagBound") {
+	const double maxLag = CLIENT_KNOBS->MAX_VERSION_CACHE_LAG;
+	const double minLag = CLIENT_KNOBS->MIN_VERSION_CACHE_LAG;
+	const double window = CLIENT_KNOBS->VERSION_CACHE_LAG_WINDOW;
+	const double tight = std::max(minLag, maxLag / 4);
+	const double loose = std::max(minLag, maxLag / 2);
+	ASSERT(minLag <= tight && tight <= loose && loose <= maxLag);
+
+	GrvCacheLagBound bound;
+	ASSERT(bound.get(0) == maxLag);
+
+	// The tightest bound asked for within the window is kept
+	bound.ask(loose, 1);
+	ASSERT(bound.get(1) == loose);
+	bound.ask(tight, 2);
+	ASSERT(bound.get(2) == tight);
+	bound.ask(loose, 3);
+	ASSERT(bound.get(3) == tight);
+
+	// Bounds looser than MAX_VERSION_CACHE_LAG refresh no less often than usual, and tighter than
+	// MIN_VERSION_CACHE_LAG no more often than the floor
+	GrvCacheLagBound wide;
+	wide.ask(2 * maxLag, 0);
+	ASSERT(wide.get(0) == maxLag);
+	GrvCacheLagBound narrow;
+	narrow.ask(0, 0);
+	ASSERT(narrow.get(0) == minLag);
+
+	// Asking again for the tightest bound keeps it, even once the first ask is older than the window
+	bound.ask(tight, 2 + window);
+	ASSERT(bound.get(2 + window * 1.5) == tight);
+
+	// Once nobody asks for it, the updater returns to its usual cadence
+	const double lapsed = 2 + window * 2.5;
+	ASSERT(bound.get(lapsed) == maxLag);
+
+	// and a looser bound asked for after that takes over
+	bound.ask(loose, lapsed);
+	ASSERT(bound.get(lapsed) == loose);
+
+	return Void();
+}
+
 Version DatabaseContext::getCachedReadVersion() {
 	if (sharedStatePtr) {
 		MutexHolder mutex(sharedStatePtr->mutexLock);
@@ -674,6 +738,10 @@ ACTOR Future<Void> databaseLogger(DatabaseContext* cx) {
 			cx->cc.logToTraceEvent(ev);
 
 			ev.detail("LocationCacheEntryCount", cx->locationCache.size());
+			if (cx->sharedLocationCache) {
+				ev.detail("SharedLocationCacheShardCount", cx->sharedLocationCache->getShardCount())
+				    .detail("SharedLocationCacheBytes", cx->sharedLocationCache->getBytes());
+			}
 			ev.detail("MeanLatency", cx->latencies.mean())
 			    .detail("MedianLatency", cx->latencies.median())
 			    .detail("Latency90", cx->latencies.percentile(0.90))
@@ -684,6 +752,7 @@ ACTOR Future<Void> databaseLogger(DatabaseContext* cx) {
 			    .detail("MaxRowReadLatency", cx->readLatencies.max())
 			    .detail("MeanGRVLatency", cx->GRVLatencies.mean())
 			    .detail("MedianGRVLatency", cx->GRVLatencies.median())
+			    .detail("GRVLatency99", cx->GRVLatencies.percentile(0.99))
 			    .detail("MaxGRVLatency", cx->GRVLatencies.max())
 			    .detail("MeanCommitLatency", cx->commitLatencies.mean())
 			    .detail("MedianCommitLatency", cx->commitLatencies.median())
@@ -697,6 +766,16 @@ ACTOR Future<Void> databaseLogger(DatabaseContext* cx) {
 			    .detail("NumLocalityCacheEntries", cx->locationCache.size());
 		}
 
+		if (logTraces) {
+			for (const auto& [flags, batcher] : cx->versionBatcher) {
+				if (batcher.actor.isValid()) {
+					TraceEvent grvBatchEv("GrvBatcherMetrics", cx->dbId);
+					grvBatchEv.detail("Flags", flags);
+					batcher.controller.logMetrics(grvBatchEv, now());
+				}
+			}
+		}
+
 		if (cx->usedAnyChangeFeeds && logTraces) {
 			TraceEvent feedEv("ChangeFeedClientMetrics", cx->dbId);
 
@@ -1277,6 +1356,7 @@ ACTOR static Future<Void> backgroundGrvUpdater(DatabaseContext* cx) {
 			state double curTime = now();
 			state double lastTime = cx->getLastGrvTime();
 			state double lastProxyTime = cx->lastProxyRequestTime;
+			state double maxLag = cx->getGrvCacheLag();
 			TraceEvent(SevDebug, "BackgroundGrvUpdaterBefore")
 			    .detail("CurTime", curTime)
 			    .detail("LastTime", lastTime)
@@ -1284,8 +1364,8 @@ ACTOR static Future<Void> backgroundGrvUpdater(DatabaseContext* cx) {
 			    .detail("CachedReadVersion", cx->getCachedReadVersion())
 			    .detail("CachedTime", cx->getLastGrvTime())
 			    .detail("Gap", curTime - lastTime)
-			    .detail("Bound", CLIENT_KNOBS->MAX_VERSION_CACHE_LAG - grvDelay);
-			if (curTime - lastTime >= (CLIENT_KNOBS->MAX_VERSION_CACHE_LAG - grvDelay) ||
+			    .detail("Bound", maxLag - grvDelay);
+			if (curTime - lastTime >= (maxLag - grvDelay) ||
 			    curTime - lastProxyTime > CLIENT_KNOBS->MAX_PROXY_CONTACT_LAG) {
 				try {
 					tr.setOption(FDBTransactionOptions::SKIP_GRV_CACHE);
@@ -1306,7 +1386,7 @@ ACTOR static Future<Void> backgroundGrvUpdater(DatabaseContext* cx) {
 				wait(
 				    delay(std::max(0.001,
 				                   std::min(CLIENT_KNOBS->MAX_PROXY_CONTACT_LAG - (curTime - lastProxyTime),
-				                            (CLIENT_KNOBS->MAX_VERSION_CACHE_LAG - grvDelay) - (curTime - lastTime)))));
+				                            (maxLag - grvDelay) - (curTime - lastTime)))));
 			}
 		}
 	} catch (Error& e) {
@@ -1508,6 +1588,16 @@ ACTOR Future<UID> getClusterId(Database db) {
 	return db->clientInfo->get().clusterId;
 }
 
+// Databases share a location cache when they are connected to the same cluster. Simulated processes run in one real
+// process but must not see each other's caches, so there the name also includes the simulated address.
+static std::string sharedLocationCacheName(Reference<IClusterConnectionRecord> connRecord) {
+	std::string name = connRecord->getConnectionString().clusterKey().toString();
+	if (g_network->isSimulated()) {
+		name += "@" + g_network->getLocalAddress().toString();
+	}
+	return name;
+}
+
 void DatabaseContext::initializeSpecialCounters() {
 	specialCounter(cc, "OutstandingWatches", [this] { return outstandingWatches; });
 	specialCounter(cc, "WatchMapSize", [this] { return watchMap.size(); });
@@ -1538,10 +1628,12 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<IClusterConnection
     transactionBatchReadVersionsCompleted("BatchPriorityReadVersionsCompleted", cc),
     transactionDefaultReadVersionsCompleted("DefaultPriorityReadVersionsCompleted", cc),
     transactionImmediateReadVersionsCompleted("ImmediatePriorityReadVersionsCompleted", cc),
+    transactionReadVersionCacheHits("ReadVersionCacheHits", cc),
+    transactionReadVersionCacheMisses("ReadVersionCacheMisses", cc),
     transactionLogicalReads("LogicalUncachedReads", cc), transactionPhysicalReads("PhysicalReadRequests", cc),
     transactionPhysicalReadsCompleted("PhysicalReadRequestsCompleted", cc),
     transactionGetKeyRequests("GetKeyRequests", cc), transactionGetValueRequests("GetValueRequests", cc),
-    transactionGetRangeRequests("GetRangeRequests", cc),
+    transactionGetMultiRequests("GetMultiRequests", cc), transactionGetRangeRequests("GetRangeRequests", cc),
     transactionGetMappedRangeRequests("GetMappedRangeRequests", cc),
     transactionGetRangeStreamRequests("GetRangeStreamRequests", cc), transactionWatchRequests("WatchRequests", cc),
     transactionGetAddressesForKeyRequests("GetAddressesForKeyRequests", cc), transactionBytesRead("BytesRead", cc),
@@ -1550,8 +1642,13 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<IClusterConnection
     transactionCommittedMutationBytes("CommittedMutationBytes", cc), transactionSetMutations("SetMutations", cc),
     transactionClearMutations("ClearMutations", cc), transactionAtomicMutations("AtomicMutations", cc),
     transactionsCommitStarted("CommitStarted", cc), transactionsCommitCompleted("CommitCompleted", cc),
+    transactionCommitsCompressed("CommitsCompressed", cc),
+    transactionCommitCompressionBytesIn("CommitCompressionBytesIn", cc),
+    transactionCommitCompressionBytesOut("CommitCompressionBytesOut", cc),
+    transactionCommitCompressionMicros("CommitCompressionMicros", cc),
     transactionKeyServerLocationRequests("KeyServerLocationRequests", cc),
     transactionKeyServerLocationRequestsCompleted("KeyServerLocationRequestsCompleted", cc),
+    transactionSharedLocationCacheHits("SharedLocationCacheHits", cc),
     transactionBlobGranuleLocationRequests("BlobGranuleLocationRequests", cc),
     transactionBlobGranuleLocationRequestsCompleted("BlobGranuleLocationRequestsCompleted", cc),
     transactionStatusRequests("StatusRequests", cc), transactionTenantLookupRequests("TenantLookupRequests", cc),
@@ -1593,6 +1690,14 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<IClusterConnection
 	logger = databaseLogger(this) && tssLogger(this);
 	locationCacheSize = g_network->isSimulated() ? CLIENT_KNOBS->LOCATION_CACHE_EVICTION_SIZE_SIM
 	                                             : CLIENT_KNOBS->LOCATION_CACHE_EVICTION_SIZE;
+	if (CLIENT_KNOBS->SHARED_LOCATION_CACHE && connectionRecord && connectionRecord->get()) {
+		sharedLocationCache = SharedLocationCache::get(sharedLocationCacheName(connectionRecord->get()));
+		// Shards evicted from locationCache are restored from the shared cache without asking a proxy, so only the
+		// shards in use need a LocationInfo here
+		if (!g_network->isSimulated()) {
+			locationCacheSize = CLIENT_KNOBS->LOCATION_CACHE_EVICTION_SIZE_SHARED;
+		}
+	}
 
 	getValueSubmitted.init("NativeAPI.GetValueSubmitted"_sr);
 	getValueCompleted.init("NativeAPI.GetValueCompleted"_sr);
@@ -1852,10 +1957,12 @@ DatabaseContext::DatabaseContext(const Error& err)
     transactionBatchReadVersionsCompleted("BatchPriorityReadVersionsCompleted", cc),
     transactionDefaultReadVersionsCompleted("DefaultPriorityReadVersionsCompleted", cc),
     transactionImmediateReadVersionsCompleted("ImmediatePriorityReadVersionsCompleted", cc),
+    transactionReadVersionCacheHits("ReadVersionCacheHits", cc),
+    transactionReadVersionCacheMisses("ReadVersionCacheMisses", cc),
     transactionLogicalReads("LogicalUncachedReads", cc), transactionPhysicalReads("PhysicalReadRequests", cc),
     transactionPhysicalReadsCompleted("PhysicalReadRequestsCompleted", cc),
     transactionGetKeyRequests("GetKeyRequests", cc), transactionGetValueRequests("GetValueRequests", cc),
-    transactionGetRangeRequests("GetRangeRequests", cc),
+    transactionGetMultiRequests("GetMultiRequests", cc), transactionGetRangeRequests("GetRangeRequests", cc),
     transactionGetMappedRangeRequests("GetMappedRangeRequests", cc),
     transactionGetRangeStreamRequests("GetRangeStreamRequests", cc), transactionWatchRequests("WatchRequests", cc),
     transactionGetAddressesForKeyRequests("GetAddressesForKeyRequests", cc), transactionBytesRead("BytesRead", cc),
@@ -1864,8 +1971,13 @@ DatabaseContext::DatabaseContext(const Error& err)
     transactionCommittedMutationBytes("CommittedMutationBytes", cc), transactionSetMutations("SetMutations", cc),
     transactionClearMutations("ClearMutations", cc), transactionAtomicMutations("AtomicMutations", cc),
     transactionsCommitStarted("CommitStarted", cc), transactionsCommitCompleted("CommitCompleted", cc),
+    transactionCommitsCompressed("CommitsCompressed", cc),
+    transactionCommitCompressionBytesIn("CommitCompressionBytesIn", cc),
+    transactionCommitCompressionBytesOut("CommitCompressionBytesOut", cc),
+    transactionCommitCompressionMicros("CommitCompressionMicros", cc),
     transactionKeyServerLocationRequests("KeyServerLocationRequests", cc),
     transactionKeyServerLocationRequestsCompleted("KeyServerLocationRequestsCompleted", cc),
+    transactionSharedLocationCacheHits("SharedLocationCacheHits", cc),
     transactionBlobGranuleLocationRequests("BlobGranuleLocationRequests", cc),
     transactionBlobGranuleLocationRequestsCompleted("BlobGranuleLocationRequestsCompleted", cc),
     transactionStatusRequests("StatusRequests", cc), transactionTenantLookupRequests("TenantLookupRequests", cc),
@@ -1959,6 +2071,15 @@ Optional<KeyRangeLocationInfo> DatabaseContext::getCachedLocation(const TenantIn
 		return KeyRangeLocationInfo(toPrefixRelativeRange(range->range(), tenant.prefix), range->value());
 	}
 
+	if (sharedLocationCache) {
+		Optional<SharedLocationCache::Shard> shard = sharedLocationCache->lookup(resolvedKey, isBackward);
+		if (shard.present()) {
+			CODE_PROBE(true, "Location restored from the shared location cache");
+			return KeyRangeLocationInfo(toPrefixRelativeRange(shard.get().range, tenant.prefix),
+			                            restoreSharedLocation(shard.get()));
+		}
+	}
+
 	return Optional<KeyRangeLocationInfo>();
 }
 
@@ -1983,9 +2104,29 @@ bool DatabaseContext::getCachedLocations(const TenantInfo& tenant,
 	loop {
 		auto r = reverse ? end : begin;
 		if (!r->value()) {
-			CODE_PROBE(result.size(), "had some but not all cached locations");
-			result.clear();
-			return false;
+			Optional<SharedLocationCache::Shard> shard;
+			if (sharedLocationCache) {
+				shard = reverse
+				            ? sharedLocationCache->lookup(std::min(r->range().end, resolvedRange.end), Reverse::True)
+				            : sharedLocationCache->lookup(std::max(r->range().begin, resolvedRange.begin));
+			}
+			if (!shard.present()) {
+				CODE_PROBE(result.size(), "had some but not all cached locations");
+				result.clear();
+				return false;
+			}
+
+			// Restoring the shard changes locationCache, so the iterators are looked up again
+			CODE_PROBE(true, "Location range gap filled from the shared location cache");
+			restoreSharedLocation(shard.get());
+			if (reverse) {
+				begin = locationCache.rangeContaining(resolvedRange.begin);
+				end = locationCache.rangeContainingKeyBefore(std::min(shard.get().range.end, resolvedRange.end));
+			} else {
+				begin = locationCache.rangeContaining(std::max(shard.get().range.begin, resolvedRange.begin));
+				end = locationCache.rangeContainingKeyBefore(resolvedRange.end);
+			}
+			continue;
 		}
 		result.emplace_back(toPrefixRelativeRange(r->range() & resolvedRange, tenant.prefix), r->value());
 		if (result.size() == limit || begin == end) {
@@ -2022,6 +2163,57 @@ Reference<LocationInfo> DatabaseContext::setCachedLocation(const KeyRangeRef& ab
 	return loc;
 }
 
+void DatabaseContext::shareLocations(const GetKeyServerLocationsReply& reply) {
+	if (!sharedLocationCache) {
+		return;
+	}
+
+	std::unordered_map<UID, StorageServerInterface> tss(reply.resultsTssMapping.begin(), reply.resultsTssMapping.end());
+	std::unordered_map<UID, Tag> tags(reply.resultsTagMapping.begin(), reply.resultsTagMapping.end());
+	std::vector<SharedLocationCache::Server> servers;
+	for (int shard = 0; shard < reply.shardCount(); shard++) {
+		servers.clear();
+		for (const auto& ssi : reply.shardServers(shard)) {
+			SharedLocationCache::Server& server = servers.emplace_back(SharedLocationCache::Server{ ssi, {}, {} });
+			if (auto it = tss.find(ssi.id()); it != tss.end()) {
+				server.tss = it->second;
+			}
+			if (auto it = tags.find(ssi.id()); it != tags.end()) {
+				server.tag = it->second;
+			}
+		}
+		sharedLocationCache->insert(reply.shardRange(shard), servers);
+	}
+}
+
+Reference<LocationInfo> DatabaseContext::restoreSharedLocation(const SharedLocationCache::Shard& shard) {
+	++transactionSharedLocationCacheHits;
+	std::vector<StorageServerInterface> servers;
+	servers.reserve(shard.servers.size());
+	for (const auto& server : shard.servers) {
+		servers.push_back(server.interf);
+		const UID id = server.interf.id();
+		if (server.tss.present()) {
+			if (!tssMapping.count(id)) {
+				sharedTssMapping[id] = server.tss.get().id();
+			}
+			addTssMapping(server.interf, server.tss.get());
+		} else if (auto it = sharedTssMapping.find(id); it != sharedTssMapping.end()) {
+			// A shared entry may be older than the reply a mapping came from, so only a mapping added from the
+			// shared cache is removed because of one
+			auto mapping = tssMapping.find(id);
+			if (mapping != tssMapping.end() && mapping->second.id() == it->second) {
+				removeTssMapping(server.interf);
+			}
+			sharedTssMapping.erase(it);
+		}
+		if (server.tag.present()) {
+			addSSIdTagMapping(id, server.tag.get());
+		}
+	}
+	return setCachedLocation(shard.range, servers);
+}
+
 void DatabaseContext::invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRef& key, Reverse isBackward) {
 	Arena arena;
 	KeyRef resolvedKey = key;
@@ -2035,6 +2227,9 @@ void DatabaseContext::invalidateCache(const Optional<KeyRef>& tenantPrefix, cons
 	} else {
 		locationCache.rangeContaining(resolvedKey)->value() = Reference<LocationInfo>();
 	}
+	if (sharedLocationCache) {
+		sharedLocationCache->invalidate(resolvedKey, isBackward);
+	}
 }
 
 void DatabaseContext::invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRangeRef& keys) {
@@ -2049,6 +2244,9 @@ void DatabaseContext::invalidateCache(const Optional<KeyRef>& tenantPrefix, cons
 	Key begin = rs.begin().begin(),
 	    end = rs.end().begin(); // insert invalidates rs, so can't be passed a mere reference into it
 	locationCache.insert(KeyRangeRef(begin, end), Reference<LocationInfo>());
+	if (sharedLocationCache) {
+		sharedLocationCache->invalidate(resolvedKeys);
+	}
 }
 
 void DatabaseContext::setFailedEndpointOnHealthyServer(const Endpoint& endpoint) {
@@ -2205,6 +2403,8 @@ ACTOR static Future<Void> switchConnectionRecordImpl(Reference<IClusterConnectio
 	self->commitProxies.clear();
 	self->grvProxies.clear();
 	self->minAcceptableReadVersion = std::numeric_limits<Version>::max();
+	// The shared location cache still serves other databases connected to the former cluster
+	self->sharedLocationCache.clear();
 	self->invalidateCache({}, allKeys);
 
 	self->ssVersionVectorCache.clear();
@@ -2215,6 +2415,9 @@ ACTOR static Future<Void> switchConnectionRecordImpl(Reference<IClusterConnectio
 	clearedClientInfo.id = deterministicRandom()->randomUniqueID();
 	self->clientInfo->set(clearedClientInfo);
 	self->connectionRecord->set(connRecord);
+	if (CLIENT_KNOBS->SHARED_LOCATION_CACHE) {
+		self->sharedLocationCache = SharedLocationCache::get(sharedLocationCacheName(connRecord));
+	}
 
 	state Database db(Reference<DatabaseContext>::addRef(self));
 	state Transaction tr(db);
@@ -2652,9 +2855,14 @@ void setNetworkOption(FDBNetworkOptions::Option option, Optional<StringRef> valu
 	}
 }
 
-// update the network busyness on a 1s cadence
+// update the network busyness on a 1s cadence, and trace it every NETWORK_BUSYNESS_TRACE_INTERVAL. Every network thread
+// runs its own monitor, so with several client threads each one reports its own busyness, told apart by ThreadID.
 ACTOR Future<Void> monitorNetworkBusyness() {
 	state double prevTime = now();
+	state double lastTrace = now();
+	state double busynessSum = 0;
+	state double maxBusyness = 0;
+	state int samples = 0;
 	loop {
 		wait(delay(CLIENT_KNOBS->NETWORK_BUSYNESS_MONITOR_INTERVAL, TaskPriority::FlushTrace));
 		double elapsed = now() - prevTime; // get elapsed time from last execution
@@ -2685,10 +2893,27 @@ ACTOR Future<Void> monitorNetworkBusyness() {
 			                                       CLIENT_KNOBS->BUSYNESS_SPIKE_START_THRESHOLD));
 		}
 
-		g_network->networkInfo.metrics.networkBusyness = std::max(busyFraction, burstiness);
+		double busyness = std::max(busyFraction, burstiness);
+		g_network->networkInfo.metrics.networkBusyness = busyness;
 
 		tracker.duration = 0;
 		tracker.maxDuration = 0;
+
+		busynessSum += busyness;
+		maxBusyness = std::max(maxBusyness, busyness);
+		++samples;
+		if (CLIENT_KNOBS->NETWORK_BUSYNESS_TRACE_INTERVAL > 0 &&
+		    now() - lastTrace >= CLIENT_KNOBS->NETWORK_BUSYNESS_TRACE_INTERVAL) {
+			TraceEvent("NetworkBusyness")
+			    .detail("Busyness", busyness)
+			    .detail("MeanBusyness", busynessSum / samples)
+			    .detail("MaxBusyness", maxBusyness)
+			    .detail("Elapsed", now() - lastTrace);
+			lastTrace = now();
+			busynessSum = 0;
+			maxBusyness = 0;
+			samples = 0;
+		}
 	}
 }
 
@@ -2992,17 +3217,22 @@ void updateTssMappings(Database cx, const GetKeyServerLocationsReply& reply) {
 			ssiById[ssi.id()] = &ssi;
 		}
 	}
+	for (auto& ssi : reply.servers) {
+		ssiById[ssi.id()] = &ssi;
+	}
 
 	for (const auto& mapping : reply.resultsTssMapping) {
 		auto ssi = ssiById.find(mapping.first);
 		ASSERT(ssi != ssiById.end());
 		cx->addTssMapping(*ssi->second, mapping.second);
+		cx->sharedTssMapping.erase(mapping.first);
 		ssiById.erase(mapping.first);
 	}
 
 	// if SS didn't have a mapping above, it's still in the ssiById map, so remove its tss mapping
 	for (const auto& it : ssiById) {
 		cx->removeTssMapping(*it.second);
+		cx->sharedTssMapping.erase(it.first);
 	}
 }
 
@@ -3054,6 +3284,7 @@ ACTOR Future<KeyRangeLocationInfo> getKeyLocation_internal(Database cx,
 					auto locationInfo = cx->setCachedLocation(rep.results[0].first, rep.results[0].second);
 					updateTssMappings(cx, rep);
 					updateTagMappings(cx, rep);
+					cx->shareLocations(rep);
 
 					cx->updateBackoff(success());
 					return KeyRangeLocationInfo(
@@ -3226,6 +3457,7 @@ ACTOR Future<std::vector<KeyRangeLocationInfo>> getKeyRangeLocations_internal(
 					}
 					updateTssMappings(cx, rep);
 					updateTagMappings(cx, rep);
+					cx->shareLocations(rep);
 
 					cx->updateBackoff(success());
 					return results;
@@ -3424,6 +3656,74 @@ Future<std::vector<std::pair<KeyRange, UID>>> getBlobGranuleLocations(Reference<
 	    more);
 }
 
+// Fetches the locations of up to WARM_RANGE_BULK_SHARD_LIMIT shards starting at keys.begin in a single compact reply.
+// Every shard goes into the shared location cache, and into locationCache while it has room. Returns the end of the
+// last shard fetched.
+ACTOR Future<Key> prefetchKeyRangeLocations(Database cx,
+                                            TenantInfo tenant,
+                                            KeyRange keys,
+                                            SpanContext spanContext,
+                                            Optional<UID> debugID,
+                                            UseProvisionalProxies useProvisionalProxies,
+                                            Version version) {
+	state Span span("NAPI:prefetchKeyRangeLocations"_loc, spanContext);
+	if (debugID.present())
+		g_traceBatch.addEvent("TransactionDebug", debugID.get().first(), "NativeAPI.prefetchKeyRangeLocations.Before");
+
+	loop {
+		try {
+			wait(cx->getBackoff());
+			++cx->transactionKeyServerLocationRequests;
+			choose {
+				when(wait(cx->onProxiesChanged())) {}
+				when(GetKeyServerLocationsReply _rep = wait(basicLoadBalance(
+				         cx->getCommitProxies(useProvisionalProxies),
+				         &CommitProxyInterface::getKeyServersLocations,
+				         GetKeyServerLocationsRequest(span.context,
+				                                      tenant,
+				                                      keys.begin,
+				                                      keys.end,
+				                                      CLIENT_KNOBS->WARM_RANGE_BULK_SHARD_LIMIT,
+				                                      false,
+				                                      version,
+				                                      keys.arena(),
+				                                      true),
+				         TaskPriority::DefaultPromiseEndpoint))) {
+					++cx->transactionKeyServerLocationRequestsCompleted;
+					state GetKeyServerLocationsReply rep = _rep;
+					if (debugID.present())
+						g_traceBatch.addEvent(
+						    "TransactionDebug", debugID.get().first(), "NativeAPI.prefetchKeyRangeLocations.After");
+					ASSERT(rep.shardCount());
+
+					updateTssMappings(cx, rep);
+					updateTagMappings(cx, rep);
+					cx->shareLocations(rep);
+
+					state int shard = 0;
+					for (; shard < rep.shardCount() && cx->locationCache.size() < cx->locationCacheSize; shard++) {
+						cx->setCachedLocation(rep.shardRange(shard), rep.shardServers(shard));
+						wait(yield());
+					}
+
+					cx->updateBackoff(success());
+					return Key(
+					    (toPrefixRelativeRange(rep.shardRange(rep.shardCount() - 1), tenant.prefix) & keys).end);
+				}
+			}
+		} catch (Error& e) {
+			if (e.code() == error_code_commit_proxy_memory_limit_exceeded) {
+				// Eats commit_proxy_memory_limit_exceeded error from commit proxies
+				TraceEvent(SevWarnAlways, "CommitProxyOverloadedForRangeLocation").suppressFor(5);
+				cx->updateBackoff(e);
+				continue;
+			}
+
+			throw;
+		}
+	}
+}
+
 ACTOR Future<Void> warmRange_impl(Reference<TransactionState> trState, KeyRange keys) {
 	state int totalRanges = 0;
 	state int totalRequests = 0;
@@ -3431,23 +3731,40 @@ ACTOR Future<Void> warmRange_impl(Reference<TransactionState> trState, KeyRange
 	wait(trState->startTransaction());
 
 	loop {
-		std::vector<KeyRangeLocationInfo> locations = wait(getKeyRangeLocations_internal(
-		    trState->cx,
-		    trState->getTenantInfo(),
-		    keys,
-		    CLIENT_KNOBS->WARM_RANGE_SHARD_LIMIT,
-		    Reverse::False,
-		    trState->spanContext,
-		    trState->readOptions.present() ? trState->readOptions.get().debugID : Optional<UID>(),
-		    trState->useProvisionalProxies,
-		    trState->readVersion()));
-		totalRanges += CLIENT_KNOBS->WARM_RANGE_SHARD_LIMIT;
-		totalRequests++;
-		if (locations.size() == 0 || totalRanges >= trState->cx->locationCacheSize ||
-		    locations[locations.size() - 1].range.end >= keys.end)
-			break;
+		if (trState->cx->sharedLocationCache) {
+			// The shared location cache is sized in bytes rather than entries, so the whole range is fetched
+			Key end = wait(prefetchKeyRangeLocations(
+			    trState->cx,
+			    trState->getTenantInfo(),
+			    keys,
+			    trState->spanContext,
+			    trState->readOptions.present() ? trState->readOptions.get().debugID : Optional<UID>(),
+			    trState->useProvisionalProxies,
+			    trState->readVersion()));
+			totalRequests++;
+			if (end >= keys.end)
+				break;
+
+			keys = KeyRangeRef(end, keys.end);
+		} else {
+			std::vector<KeyRangeLocationInfo> locations = wait(getKeyRangeLocations_internal(
+			    trState->cx,
+			    trState->getTenantInfo(),
+			    keys,
+			    CLIENT_KNOBS->WARM_RANGE_SHARD_LIMIT,
+			    Reverse::False,
+			    trState->spanContext,
+			    trState->readOptions.present() ? trState->readOptions.get().debugID : Optional<UID>(),
+			    trState->useProvisionalProxies,
+			    trState->readVersion()));
+			totalRanges += CLIENT_KNOBS->WARM_RANGE_SHARD_LIMIT;
+			totalRequests++;
+			if (locations.size() == 0 || totalRanges >= trState->cx->locationCacheSize ||
+			    locations[locations.size() - 1].range.end >= keys.end)
+				break;
 
-		keys = KeyRangeRef(locations[locations.size() - 1].range.end, keys.end);
+			keys = KeyRangeRef(locations[locations.size() - 1].range.end, keys.end);
+		}
 
 		if (totalRequests % 20 == 0) {
 			// To avoid blocking the proxies from starting other transactions, occasionally get a read version.
@@ -3777,6 +4094,166 @@ ACTOR Future<Optional<Value>> getValue(Reference<TransactionState> trState,
 	}
 }
 
+// Sends one GetValuesRequest for keys which are all held by the storage servers in locations, storing the value of
+// keys[i] in (*values)[indexes[i]]. Returns false if the location cache was wrong and the keys must be located again.
+ACTOR Future<bool> getValuesFromTeam(Reference<TransactionState> trState,
+                                     Reference<LocationInfo> locations,
+                                     Standalone<VectorRef<KeyRef>> keys,
+                                     std::vector<int> indexes,
+                                     std::vector<Optional<Value>>* values,
+                                     UseTenant useTenant,
+                                     SpanContext spanContext) {
+	state VersionVector ssLatestCommitVersions;
+	state double startTime = now();
+	trState->cx->getLatestCommitVersions(locations, trState, ssLatestCommitVersions);
+
+	++trState->cx->transactionPhysicalReads;
+	state GetValuesReply reply;
+	try {
+		if (CLIENT_BUGGIFY_WITH_PROB(.01)) {
+			throw deterministicRandom()->randomChoice(std::vector<Error>{ transaction_too_old(), future_version() });
+		}
+		choose {
+			when(wait(trState->cx->connectionFileChanged())) {
+				throw transaction_too_old();
+			}
+			when(GetValuesReply _reply = wait(loadBalance(
+			         trState->cx.getPtr(),
+			         locations,
+			         &StorageServerInterface::getValues,
+			         GetValuesRequest(spanContext,
+			                          useTenant ? trState->getTenantInfo() : TenantInfo(),
+			                          keys,
+			                          trState->readVersion(),
+			                          trState->cx->sampleReadTags() ? trState->options.readTags : Optional<TagSet>(),
+			                          trState->readOptions,
+			                          ssLatestCommitVersions),
+			         TaskPriority::DefaultPromiseEndpoint,
+			         AtMostOnce::False,
+			         trState->cx->enableLocalityLoadBalance ? &trState->cx->queueModel : nullptr,
+			         trState->options.enableReplicaConsistencyCheck,
+			         trState->options.requiredReplicas))) {
+				reply = _reply;
+			}
+		}
+		++trState->cx->transactionPhysicalReadsCompleted;
+	} catch (Error& e) {
+		++trState->cx->transactionPhysicalReadsCompleted;
+		if (e.code() == error_code_wrong_shard_server || e.code() == error_code_all_alternatives_failed) {
+			for (const auto& key : keys) {
+				trState->cx->invalidateCache(useTenant ? trState->tenant().mapRef(&Tenant::prefix) : Optional<KeyRef>(),
+				                             key);
+			}
+			return false;
+		}
+		throw;
+	}
+
+	trState->cx->readLatencies.addSample(now() - startTime);
+
+	// The reply holds the keys that have values in request order, so match them up with one pass
+	int next = 0;
+	for (int i = 0; i < keys.size(); ++i) {
+		int64_t bytes = keys[i].size();
+		if (next < reply.data.size() && reply.data[next].key == keys[i]) {
+			(*values)[indexes[i]] = Value(reply.data[next].value, reply.arena);
+			bytes += reply.data[next].value.size();
+			trState->cx->transactionBytesRead += reply.data[next].value.size();
+			++next;
+		}
+		trState->totalCost += getReadOperationCost(bytes);
+		++trState->cx->transactionKeysRead;
+	}
+	ASSERT(next == reply.data.size());
+
+	return true;
+}
+
+ACTOR Future<RangeResult> getValues(Reference<TransactionState> trState,
+                                    Standalone<VectorRef<KeyRef>> keys,
+                                    UseTenant useTenant) {
+	wait(trState->startTransaction());
+
+	CODE_PROBE(trState->hasTenant(), "NativeAPI getValues has tenant");
+
+	state Span span("NAPI:getValues"_loc, trState->spanContext);
+	trState->cx->validateVersion(trState->readVersion());
+
+	state std::vector<Optional<Value>> values(keys.size());
+	state std::vector<int> pending(keys.size());
+	std::iota(pending.begin(), pending.end(), 0);
+
+	loop {
+		state std::vector<Future<KeyRangeLocationInfo>> locationFutures;
+		locationFutures.reserve(pending.size());
+		for (int i : pending) {
+			locationFutures.push_back(
+			    getKeyLocation(trState, keys[i], &StorageServerInterface::getValues, Reverse::False, useTenant));
+		}
+		wait(waitForAll(locationFutures));
+
+		// Group the keys by the set of storage servers holding them, since neighbouring shards are often on the same
+		// team, and split groups which are too large for one request
+		state std::vector<Future<bool>> batches;
+		state std::vector<std::vector<int>> batchIndexes;
+		{
+			std::map<std::vector<UID>, std::vector<int>> teams;
+			std::map<std::vector<UID>, Reference<LocationInfo>> teamLocations;
+			for (int j = 0; j < pending.size(); ++j) {
+				const Reference<LocationInfo>& locations = locationFutures[j].get().locations;
+				std::vector<UID> team;
+				team.reserve(locations->size());
+				for (int s = 0; s < locations->size(); ++s) {
+					team.push_back(locations->getId(s));
+				}
+				std::sort(team.begin(), team.end());
+				teams[team].push_back(pending[j]);
+				teamLocations.try_emplace(team, locations);
+			}
+
+			for (auto& [team, indexes] : teams) {
+				for (int begin = 0; begin < indexes.size(); begin += CLIENT_KNOBS->GET_VALUES_MAX_KEYS_PER_REQUEST) {
+					int end = std::min<int>(indexes.size(), begin + CLIENT_KNOBS->GET_VALUES_MAX_KEYS_PER_REQUEST);
+					Standalone<VectorRef<KeyRef>> batchKeys;
+					batchKeys.arena().dependsOn(keys.arena());
+					batchKeys.reserve(batchKeys.arena(), end - begin);
+					for (int k = begin; k < end; ++k) {
+						batchKeys.push_back(batchKeys.arena(), keys[indexes[k]]);
+					}
+					batchIndexes.emplace_back(indexes.begin() + begin, indexes.begin() + end);
+					batches.push_back(getValuesFromTeam(trState,
+					                                    teamLocations[team],
+					                                    batchKeys,
+					                                    batchIndexes.back(),
+					                                    &values,
+					                                    useTenant,
+					                                    span.context));
+				}
+			}
+		}
+		wait(waitForAll(batches));
+
+		pending.clear();
+		for (int b = 0; b < batches.size(); ++b) {
+			if (!batches[b].get()) {
+				pending.insert(pending.end(), batchIndexes[b].begin(), batchIndexes[b].end());
+			}
+		}
+		if (pending.empty()) {
+			break;
+		}
+		wait(delay(CLIENT_KNOBS->WRONG_SHARD_SERVER_DELAY, trState->taskID));
+	}
+
+	RangeResult result;
+	for (int i = 0; i < keys.size(); ++i) {
+		if (values[i].present()) {
+			result.push_back_deep(result.arena(), KeyValueRef(keys[i], values[i].get()));
+		}
+	}
+	return result;
+}
+
 ACTOR Future<Key> getKey(Reference<TransactionState> trState, KeySelector k, UseTenant useTenant = UseTenant::True) {
 	CODE_PROBE(!useTenant, "Get key ignoring tenant");
 	wait(trState->startTransaction());
@@ -5231,7 +5708,7 @@ ACTOR Future<Void> getRangeStreamFragment(Reference<TransactionState> trState,
 
 				state bool breakAgain = false;
 				loop {
-					wait(results->onEmpty());
+					wait(results->onCredit());
 					try {
 						choose {
 							when(wait(trState->cx->connectionFileChanged())) {
@@ -5418,7 +5895,8 @@ ACTOR Future<Void> getRangeStream(Reference<TransactionState> trState,
                                   Promise<std::pair<Key, Key>> conflictRange,
                                   Snapshot snapshot,
                                   Reverse reverse) {
-	state ParallelStream<RangeResult> results(_results, CLIENT_KNOBS->RANGESTREAM_BUFFERED_FRAGMENTS_LIMIT);
+	state ParallelStream<RangeResult> results(
+	    _results, CLIENT_KNOBS->RANGESTREAM_BUFFERED_FRAGMENTS_LIMIT, CLIENT_KNOBS->RANGESTREAM_BUFFERED_BYTES_LIMIT);
 
 	// FIXME: better handling to disable row limits
 	ASSERT(!limits.hasRowLimit());
@@ -5556,6 +6034,7 @@ void Transaction::operator=(Transaction&& r) noexcept {
 	extraConflictRanges = std::move(r.extraConflictRanges);
 	commitResult = std::move(r.commitResult);
 	committing = std::move(r.committing);
+	rangeStreamCursor = std::move(r.rangeStreamCursor);
 	backoff = r.backoff;
 	watches = r.watches;
 }
@@ -5644,6 +6123,54 @@ Future<Optional<Value>> Transaction::get(const Key& key, Snapshot snapshot) {
 	return getValue(trState, key, useTenant);
 }
 
+Future<RangeResult> Transaction::getMulti(const Standalone<VectorRef<KeyRef>>& keys, Snapshot snapshot) {
+	++trState->cx->transactionGetMultiRequests;
+
+	// The metadata version key has its own cache and tenant handling in get(), so read it that way
+	Standalone<VectorRef<KeyRef>> batchKeys;
+	batchKeys.arena().dependsOn(keys.arena());
+	std::vector<Future<Optional<Value>>> metadataVersionReads;
+	for (const auto& key : keys) {
+		if (key == metadataVersionKey) {
+			metadataVersionReads.push_back(get(key, snapshot));
+			continue;
+		}
+		// There are no keys in the database with size greater than the max key size
+		if (key.size() > getMaxReadKeySize(key)) {
+			continue;
+		}
+		++trState->cx->transactionLogicalReads;
+		if (!snapshot) {
+			tr.transaction.read_conflict_ranges.push_back(tr.arena, singleKeyRange(key, tr.arena));
+		}
+		batchKeys.push_back(batchKeys.arena(), key);
+	}
+
+	Future<RangeResult> batch =
+	    batchKeys.empty() ? Future<RangeResult>(RangeResult()) : getValues(trState, batchKeys, UseTenant::True);
+	if (metadataVersionReads.empty() && batchKeys.size() == keys.size()) {
+		return batch;
+	}
+
+	// Merge the separately read keys back in, in request order
+	return map(waitForAll(metadataVersionReads) && batch, [=](Void) {
+		RangeResult fromBatch = batch.get();
+		RangeResult result;
+		int nextBatch = 0, nextMetadataVersion = 0;
+		for (const auto& key : keys) {
+			if (key == metadataVersionKey) {
+				const Optional<Value>& v = metadataVersionReads[nextMetadataVersion++].get();
+				if (v.present()) {
+					result.push_back_deep(result.arena(), KeyValueRef(key, v.get()));
+				}
+			} else if (nextBatch < fromBatch.size() && fromBatch[nextBatch].key == key) {
+				result.push_back_deep(result.arena(), fromBatch[nextBatch++]);
+			}
+		}
+		return result;
+	});
+}
+
 void Watch::setWatch(Future<Void> watchFuture) {
 	this->watchFuture = watchFuture;
 
@@ -5985,6 +6512,106 @@ Future<Void> Transaction::getRangeStream(PromiseStream<RangeResult>& results,
 	return getRangeStream(results, begin, end, GetRangeLimits(limit), snapshot, reverse);
 }
 
+ACTOR static Future<RangeResult> nextRangeStreamBatch(Reference<RangeStreamCursor> cursor,
+                                                      GetRangeLimits limits,
+                                                      Promise<std::pair<Key, Key>> conflictRange) {
+	state RangeResult output;
+	state Key begin = cursor->nextBegin;
+
+	cursor->reading = true;
+	try {
+		loop {
+			if (cursor->pendingIndex < cursor->pending.size()) {
+				output.arena().dependsOn(cursor->pending.arena());
+			}
+			while (cursor->pendingIndex < cursor->pending.size() && !limits.isReached()) {
+				KeyValueRef kv = cursor->pending[cursor->pendingIndex++];
+				output.push_back(output.arena(), kv);
+				limits.decrement(kv);
+			}
+			if (cursor->pendingIndex == cursor->pending.size()) {
+				cursor->pending = RangeResult();
+				cursor->pendingIndex = 0;
+			}
+
+			// Hand back what has arrived rather than wait for the next fragment
+			if (limits.isReached() || cursor->exhausted ||
+			    (!output.empty() && !cursor->results.getFuture().isReady())) {
+				break;
+			}
+
+			try {
+				RangeResult next = waitNext(cursor->results.getFuture());
+				cursor->pending = next;
+			} catch (Error& e) {
+				if (e.code() != error_code_end_of_stream) {
+					throw;
+				}
+				cursor->exhausted = true;
+			}
+		}
+	} catch (Error& e) {
+		cursor->reading = false;
+		cursor->failed = true;
+		// Nothing was returned, so there is nothing to conflict on. Left unset, the promise would break and fail the
+		// commit with broken_promise.
+		if (conflictRange.canBeSet()) {
+			conflictRange.send(std::make_pair(Key(), Key()));
+		}
+		throw;
+	}
+	cursor->reading = false;
+
+	output.more = !cursor->exhausted || cursor->pendingIndex < cursor->pending.size();
+	cursor->nextBegin = output.more ? keyAfter(output.back().key) : cursor->end;
+	if (conflictRange.canBeSet()) {
+		conflictRange.send(std::make_pair(begin, cursor->nextBegin));
+	}
+	return output;
+}
+
+Future<RangeResult> Transaction::getRangeStreamBatch(const KeySelector& begin,
+                                                     const KeySelector& end,
+                                                     GetRangeLimits limits,
+                                                     Snapshot snapshot,
+                                                     Reverse reverse) {
+	KeySelector b = begin;
+	if (b.orEqual) {
+		b.removeOrEqual(b.arena());
+	}
+
+	KeySelector e = end;
+	if (e.orEqual) {
+		e.removeOrEqual(e.arena());
+	}
+
+	// The stream is read from one cursor at a time, so a read that overlaps an outstanding one is read normally
+	if (reverse || !b.isFirstGreaterOrEqual() || !e.isFirstGreaterOrEqual() || b.getKey() >= e.getKey() ||
+	    limits.isReached() || !limits.isValid() || (rangeStreamCursor && rangeStreamCursor->reading)) {
+		return getRange(begin, end, limits, snapshot, reverse);
+	}
+
+	if (!rangeStreamCursor || rangeStreamCursor->failed || rangeStreamCursor->nextBegin != b.getKey() ||
+	    rangeStreamCursor->end != e.getKey()) {
+		CODE_PROBE(rangeStreamCursor.isValid(), "Range stream cursor replaced");
+		rangeStreamCursor = makeReference<RangeStreamCursor>();
+		rangeStreamCursor->nextBegin = b.getKey();
+		rangeStreamCursor->end = e.getKey();
+		// The conflict range of each batch is added as it is returned, so that a caller which stops early only
+		// conflicts on what it read
+		rangeStreamCursor->stream =
+		    getRangeStream(rangeStreamCursor->results, b, e, GetRangeLimits(), Snapshot::True, Reverse::False);
+	} else {
+		CODE_PROBE(true, "Range stream cursor continued");
+	}
+
+	Promise<std::pair<Key, Key>> conflictRange;
+	if (!snapshot) {
+		extraConflictRanges.push_back(conflictRange.getFuture());
+	}
+	return nextRangeStreamBatch(rangeStreamCursor, limits, conflictRange);
+}
+
 void Transaction::addReadConflictRange(KeyRangeRef const& keys) {
 	ASSERT(!keys.empty());
 
@@ -6198,6 +6825,7 @@ TransactionOptions::TransactionOptions(Database const& cx) {
 
 void TransactionOptions::clear() {
 	maxBackoff = CLIENT_KNOBS->DEFAULT_MAX_BACKOFF;
+	maxReadVersionStaleness = 0;
 	getReadVersionFlags = 0;
 	sizeLimit = CLIENT_KNOBS->TRANSACTION_SIZE_LIMIT;
 	maxTransactionLoggingFieldLength = 0;
@@ -6241,6 +6869,7 @@ void Transaction::resetImpl(bool generateNewSpan) {
 	extraConflictRanges.clear();
 	commitResult = Promise<Void>();
 	committing = Future<Void>();
+	rangeStreamCursor.clear();
 	cancelWatches();
 }
 
@@ -6637,6 +7266,89 @@ void applyTenantPrefix(CommitTransactionRequest& req, Key tenantPrefix) {
 	req.transaction.write_conflict_ranges = updatedWriteConflictRanges;
 }
 
+// Whether the mutations of req are worth compressing and every commit proxy currently known can decode them
+static bool shouldCompressCommit(Reference<TransactionState> const& trState, CommitTransactionRequest const& req) {
+	if (!CLIENT_KNOBS->COMMIT_COMPRESSION_ENABLED ||
+	    req.transaction.mutations.expectedSize() < CLIENT_KNOBS->COMMIT_COMPRESSION_MIN_BYTES ||
+	    !CompressionUtils::supportedFilters.contains(CompressionFilter::ZSTD)) {
+		return false;
+	}
+	for (const auto& proxy : trState->cx->clientInfo->get().commitProxies) {
+		if (!proxy.acceptsCompressedMutations) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Compresses mutations in blocks of COMMIT_COMPRESSION_BLOCK_BYTES, yielding the network thread between blocks so that
+// compressing a large commit does not hold up everything else running on it. Returns no blocks, so that the commit is
+// sent uncompressed, if the mutations serialize to more than the commit proxies will decompress.
+ACTOR static Future<Standalone<VectorRef<StringRef>>> compressCommitMutations(
+    Database cx,
+    Standalone<VectorRef<MutationRef>> mutations) {
+	state Standalone<VectorRef<StringRef>> blocks;
+	state int begin = 0;
+	state int64_t compressedBytes = 0;
+	state int64_t serializedBytes = 0;
+	state double compressTime = 0;
+	while (begin < mutations.size()) {
+		int end = begin;
+		int bytes = 0;
+		while (end < mutations.size() && bytes < CLIENT_KNOBS->COMMIT_COMPRESSION_BLOCK_BYTES) {
+			bytes += mutations[end++].expectedSize();
+		}
+		double start = timer_monotonic();
+		StringRef block = compressMutationBlock(
+		    VectorRef<MutationRef>(mutations.begin() + begin, end - begin), blocks.arena(), serializedBytes);
+		compressTime += timer_monotonic() - start;
+		if (serializedBytes > maxDecompressedMutationBytes()) {
+			CODE_PROBE(true, "Commit mutations too large to send compressed");
+			return Standalone<VectorRef<StringRef>>();
+		}
+		blocks.push_back(blocks.arena(), block);
+		compressedBytes += block.size();
+		begin = end;
+		if (begin < mutations.size()) {
+			wait(yield());
+		}
+	}
+
+	++cx->transactionCommitsCompressed;
+	cx->transactionCommitCompressionBytesIn += mutations.expectedSize();
+	cx->transactionCommitCompressionBytesOut += compressedBytes;
+	cx->transactionCommitCompressionMicros += int64_t(compressTime * 1e6);
+	return blocks;
+}
+
+// Returns the request to send for req: with the compressed mutations if there are any and the proxies it goes to
+// accept them, and req itself otherwise
+static CommitTransactionRequest commitRequestFor(CommitTransactionRequest const& req,
+                                                 Future<Standalone<VectorRef<StringRef>>> const& compressedMutations,
+                                                 bool proxiesAcceptCompression) {
+	if (!compressedMutations.isValid() || compressedMutations.get().empty() || !proxiesAcceptCompression) {
+		return req;
+	}
+	CommitTransactionRequest compressed = req;
+	compressed.arena.dependsOn(compressedMutations.get().arena());
+	compressed.transaction.mutations = VectorRef<MutationRef>();
+	compressed.compressedMutations = compressedMutations.get();
+	compressed.flags |= CommitTransactionRequest::FLAG_COMPRESSED_MUTATIONS;
+	return compressed;
+}
+
+static bool acceptCompressedMutations(Reference<CommitProxyInfo> const& proxies) {
+	if (!proxies) {
+		return false;
+	}
+	for (int i = 0; i < proxies->size(); i++) {
+		if (!proxies->getInterface(i).acceptsCompressedMutations) {
+			return false;
+		}
+	}
+	return true;
+}
+
 ACTOR static Future<Void> tryCommit(Reference<TransactionState> trState, CommitTransactionRequest req) {
 	state TraceInterval interval("TransactionCommit");
 	state double startTime = now();
@@ -6662,6 +7374,14 @@ ACTOR static Future<Void> tryCommit(Reference<TransactionState> trState, CommitT
 			                                                              commit_unknown_result() });
 		}
 
+		// Mutations which need no tenant prefix are compressed while waiting for the read version
+		state bool compressCommit = shouldCompressCommit(trState, req);
+		state Future<Standalone<VectorRef<StringRef>>> compressedMutations;
+		if (compressCommit && !(trState->hasTenant() && !trState->skipApplyTenantPrefix)) {
+			compressedMutations = compressCommitMutations(
+			    trState->cx, Standalone<VectorRef<MutationRef>>(req.transaction.mutations, req.arena));
+		}
+
 		if (req.tagSet.present() && trState->options.priority < TransactionPriority::IMMEDIATE) {
 			state Future<Optional<ClientTrCommitCostEstimation>> commitCostFuture =
 			    estimateCommitCosts(trState, &req.transaction);
@@ -6681,6 +7401,13 @@ ACTOR static Future<Void> tryCommit(Reference<TransactionState> trState, CommitT
 			tenantPrefixPrepended = TenantPrefixPrepended::True;
 			tenantPrefix = trState->tenant().get()->prefix();
 		}
+		if (compressCommit && !compressedMutations.isValid()) {
+			compressedMutations = compressCommitMutations(
+			    trState->cx, Standalone<VectorRef<MutationRef>>(req.transaction.mutations, req.arena));
+		}
+		if (compressedMutations.isValid()) {
+			wait(success(compressedMutations));
+		}
 		CODE_PROBE(trState->skipApplyTenantPrefix, "Tenant prefix prepend skipped for dummy transaction");
 		req.tenantInfo = trState->getTenantInfo();
 		startTime = now();
@@ -6702,18 +7429,21 @@ ACTOR static Future<Void> tryCommit(Reference<TransactionState> trState, CommitT
 
 		if (trState->options.commitOnFirstProxy) {
 			if (trState->cx->clientInfo->get().firstCommitProxy.present()) {
-				reply = throwErrorOr(brokenPromiseToMaybeDelivered(
-				    trState->cx->clientInfo->get().firstCommitProxy.get().commit.tryGetReply(req)));
+				const CommitProxyInterface& proxy = trState->cx->clientInfo->get().firstCommitProxy.get();
+				reply = throwErrorOr(brokenPromiseToMaybeDelivered(proxy.commit.tryGetReply(
+				    commitRequestFor(req, compressedMutations, proxy.acceptsCompressedMutations))));
 			} else {
 				const std::vector<CommitProxyInterface>& proxies = trState->cx->clientInfo->get().commitProxies;
-				reply = proxies.size() ? throwErrorOr(brokenPromiseToMaybeDelivered(proxies[0].commit.tryGetReply(req)))
-				                       : Never();
+				reply = proxies.size()
+				            ? throwErrorOr(brokenPromiseToMaybeDelivered(proxies[0].commit.tryGetReply(commitRequestFor(
+				                  req, compressedMutations, proxies[0].acceptsCompressedMutations))))
+				            : Never();
 			}
 		} else {
 			proxiesUsed = trState->cx->getCommitProxies(trState->useProvisionalProxies);
 			reply = basicLoadBalance(proxiesUsed,
 			                         &CommitProxyInterface::commit,
-			                         req,
+			                         commitRequestFor(req, compressedMutations, acceptCompressedMutations(proxiesUsed)),
 			                         TaskPriority::DefaultPromiseEndpoint,
 			                         AtMostOnce::True,
 			                         &alternativeChosen);
@@ -7238,6 +7968,14 @@ void Transaction::setOption(FDBTransactionOptions::Option option, Optional<Strin
 		validateOptionValueNotPresent(value);
 		trState->options.skipGrvCache = true;
 		break;
+
+	case FDBTransactionOptions::MAX_READ_VERSION_STALENESS:
+		validateOptionValuePresent(value);
+		if (trState->numErrors == 0) {
+			trState->options.maxReadVersionStaleness =
+			    extractIntOption(value, 0, std::numeric_limits<int>::max()) / 1000.0;
+		}
+		break;
 	case FDBTransactionOptions::READ_SYSTEM_KEYS:
 	case FDBTransactionOptions::ACCESS_SYSTEM_KEYS:
 	case FDBTransactionOptions::RAW_ACCESS:
@@ -7397,6 +8135,7 @@ ACTOR Future<GetReadVersionReply> getConsistentReadVersion(SpanContext parentSpa
 
 ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
                                       FutureStream<DatabaseContext::VersionRequest> versionStream,
+                                      GrvBatchController* controller,
                                       TransactionPriority priority,
                                       uint32_t flags) {
 	state std::vector<Promise<GetReadVersionReply>> requests;
@@ -7421,7 +8160,6 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 
 	// dynamic batching
 	state PromiseStream<double> replyTimes;
-	state double batchTime = 0;
 	state Span span("NAPI:readVersionBatcher"_loc);
 	loop {
 		send_batch = false;
@@ -7435,6 +8173,7 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 				}
 				span.addLink(req.spanContext);
 				requests.push_back(req.reply);
+				controller->addArrival(now());
 				for (auto tag : req.tags) {
 					++tags[tag];
 				}
@@ -7443,7 +8182,7 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 					send_batch = true;
 					++cx->transactionGrvFullBatches;
 				} else if (!timeout.isValid()) {
-					timeout = delay(batchTime, TaskPriority::GetConsistentReadVersion);
+					timeout = delay(controller->getWindow(now()), TaskPriority::GetConsistentReadVersion);
 				}
 			}
 			when(wait(timeout.isValid() ? timeout : Never())) {
@@ -7452,8 +8191,7 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 			}
 			// dynamic batching monitors reply latencies
 			when(double reply_latency = waitNext(replyTimes.getFuture())) {
-				double target_latency = reply_latency * 0.5;
-				batchTime = std::min(0.1 * target_latency + 0.9 * batchTime, CLIENT_KNOBS->GRV_BATCH_TIMEOUT);
+				controller->addReplyLatency(reply_latency);
 				grvReplyLatencyDist->sampleSeconds(reply_latency);
 			}
 			when(wait(collection)) {} // for errors
@@ -7593,8 +8331,16 @@ Future<Version> TransactionState::getReadVersion(uint32_t flags) {
 	ASSERT(!readVersionFuture.isValid());
 
 	if (!CLIENT_KNOBS->FORCE_GRV_CACHE_OFF && !options.skipGrvCache &&
-	    (deterministicRandom()->random01() <= CLIENT_KNOBS->DEBUG_USE_GRV_CACHE_CHANCE || options.useGrvCache) &&
+	    (deterministicRandom()->random01() <= CLIENT_KNOBS->DEBUG_USE_GRV_CACHE_CHANCE || options.useGrvCache ||
+	     options.maxReadVersionStaleness > 0) &&
 	    rkThrottlingCooledDown(cx.getPtr(), options.priority)) {
+		double maxStaleness = CLIENT_KNOBS->MAX_VERSION_CACHE_LAG;
+		if (options.maxReadVersionStaleness > 0) {
+			maxStaleness = options.useGrvCache ? std::max(maxStaleness, options.maxReadVersionStaleness)
+			                                   : options.maxReadVersionStaleness;
+			// Keep the cache fresh enough for the tightest bound asked for recently
+			cx->grvCacheLag.ask(options.maxReadVersionStaleness, now());
+		}
 		// Upon our first request to use cached RVs, start the background updater
 		if (!cx->grvUpdateHandler.isValid()) {
 			cx->grvUpdateHandler = backgroundGrvUpdater(cx.getPtr());
@@ -7602,10 +8348,12 @@ Future<Version> TransactionState::getReadVersion(uint32_t flags) {
 		Version rv = cx->getCachedReadVersion();
 		double lastTime = cx->getLastGrvTime();
 		double requestTime = now();
-		if (requestTime - lastTime <= CLIENT_KNOBS->MAX_VERSION_CACHE_LAG && rv != Version(0)) {
+		if (requestTime - lastTime <= maxStaleness && rv != Version(0)) {
 			ASSERT(!debug_checkVersionTime(rv, requestTime, "CheckStaleness"));
+			++cx->transactionReadVersionCacheHits;
 			return rv;
 		} // else go through regular GRV path
+		++cx->transactionReadVersionCacheMisses;
 	}
 	++cx->transactionReadVersions;
 	flags |= options.getReadVersionFlags;
@@ -7661,7 +8409,8 @@ Future<Version> TransactionState::getReadVersion(uint32_t flags) {
 
 	auto& batcher = cx->versionBatcher[flags];
 	if (!batcher.actor.isValid()) {
-		batcher.actor = readVersionBatcher(cx.getPtr(), batcher.stream.getFuture(), options.priority, flags);
+		batcher.actor = readVersionBatcher(
+		    cx.getPtr(), batcher.stream.getFuture(), &batcher.controller, options.priority, flags);
 	}
 
 	Location location = "NAPI:getReadVersion"_loc;
@@ -35,6 +35,7 @@ struct TestValue {
 ACTOR static Future<Void> produce(ParallelStream<ParallelStreamTest::TestValue>::Fragment* fragment,
                                   ParallelStreamTest::TestValue value) {
 	wait(delay(deterministicRandom()->random01()));
+	wait(fragment->onCredit());
 	fragment->send(value);
 	wait(delay(deterministicRandom()->random01()));
 	fragment->finish();
@@ -61,10 +62,16 @@ TEST_CASE("/fdbclient/ParallelStream") {
 	state PromiseStream<ParallelStreamTest::TestValue> results;
 	state size_t bufferLimit = deterministicRandom()->randomInt(0, 21);
 	state size_t numProducers = deterministicRandom()->randomInt(1, 1001);
-	state ParallelStream<ParallelStreamTest::TestValue> parallelStream(results, bufferLimit);
+	state int64_t bytesLimit = deterministicRandom()->coinflip()
+	                               ? std::numeric_limits<int64_t>::max()
+	                               : deterministicRandom()->randomInt(1, 10) * sizeof(int);
+	state ParallelStream<ParallelStreamTest::TestValue> parallelStream(results, bufferLimit, bytesLimit);
 	state Future<Void> consumer = ParallelStreamTest::consume(results.getFuture(), numProducers);
 	state std::vector<Future<Void>> producers;
-	TraceEvent("StartingParallelStreamTest").detail("BufferLimit", bufferLimit).detail("NumProducers", numProducers);
+	TraceEvent("StartingParallelStreamTest")
+	    .detail("BufferLimit", bufferLimit)
+	    .detail("BytesLimit", bytesLimit)
+	    .detail("NumProducers", numProducers);
 	state int i = 0;
 	for (; i < numProducers; ++i) {
 		ParallelStream<ParallelStreamTest::TestValue>::Fragment* fragment = wait(parallelStream.createFragment());
@@ -629,6 +629,38 @@ TEST_CASE("/fdbclient/WriteMap/addValue") {
 	return Void();
 }
 
+TEST_CASE("/fdbclient/WriteMap/appendRun") {
+	Arena arena = Arena();
+	WriteMap writes = WriteMap(&arena);
+	writes.clear(KeyRangeRef("b"_sr, "d"_sr), true);
+
+	// Runs of increasing keys in an unmodified range and in a cleared one, then a key out of order
+	writes.mutate("a1"_sr, MutationRef::SetValue, "1"_sr, false);
+	writes.mutate("a2"_sr, MutationRef::AddValue, "2"_sr, false);
+	writes.mutate("b1"_sr, MutationRef::AddValue, "3"_sr, true);
+	writes.mutate("b2"_sr, MutationRef::SetValue, "4"_sr, false);
+	writes.mutate("a1"_sr, MutationRef::SetValue, "5"_sr, false);
+	writes.mutate("e"_sr, MutationRef::SetValue, "6"_sr, false);
+
+	WriteMap::iterator it(&writes);
+	it.skip("a1"_sr);
+	ASSERT(it.is_operation() && !it.is_conflict_range());
+	ASSERT(it.op().size() == 1 && it.op().top().value.get() == "5"_sr);
+	it.skip("a2"_sr);
+	ASSERT(it.is_operation() && it.type() == WriteMap::iterator::DEPENDENT_WRITE);
+	it.skip("b1"_sr);
+	ASSERT(it.is_operation() && it.is_independent() && it.is_conflict_range());
+	it.skip("b2"_sr);
+	ASSERT(it.is_operation() && it.is_conflict_range());
+	++it;
+	ASSERT(it.is_cleared_range() && it.endKey() == "d"_sr);
+	it.skip("e"_sr);
+	ASSERT(it.is_operation() && !it.is_conflict_range());
+	ASSERT(getWriteMapCount(&writes) == 13);
+
+	return Void();
+}
+
 TEST_CASE("/fdbclient/WriteMap/random") {
 	Arena arena = Arena();
 	WriteMap writes = WriteMap(&arena);
@@ -639,6 +671,7 @@ TEST_CASE("/fdbclient/WriteMap/random") {
 	KeyRangeMap<bool> conflictMap;
 	KeyRangeMap<bool> clearMap;
 	KeyRangeMap<bool> unreadableMap;
+	KeyRef lastSetKey;
 
 	for (int i = 0; i < 100; i++) {
 		int r = deterministicRandom()->randomInt(0, 10);
@@ -717,7 +750,10 @@ TEST_CASE("/fdbclient/WriteMap/random") {
 			TraceEvent("RWMT_And").detail("Key", key).detail("Value", value.size()).detail("AddConflict", addConflict);
 		} else {
 			bool addConflict = deterministicRandom()->random01() < 0.5;
-			KeyRef key = RandomTestImpl::getRandomKey(arena);
+			// Half of the sets follow the last one, as a bulk load writes them
+			KeyRef key = lastSetKey.size() && deterministicRandom()->coinflip() ? keyAfter(lastSetKey, arena)
+			                                                                   : RandomTestImpl::getRandomKey(arena);
+			lastSetKey = key;
 			ValueRef value = RandomTestImpl::getRandomValue(arena);
 			writes.mutate(key, MutationRef::SetValue, value, addConflict);
 			if (unreadableMap[key])
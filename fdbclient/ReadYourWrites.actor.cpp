@@ -1281,6 +1281,115 @@ public:
 		triggerWatches(ryw, singleKeyRange(key), val, valueKnown);
 	}
 
+	// Reads every key the snapshot cache and write map cannot answer with one batched read through the underlying
+	// transaction and caches the results, then serves each key through get() so conflict ranges, dependent writes and
+	// special keys are handled exactly as for single reads. With read-your-writes disabled the batch goes straight to
+	// the underlying transaction.
+	ACTOR static Future<RangeResult> getMulti(ReadYourWritesTransaction* ryw,
+	                                          Standalone<VectorRef<KeyRef>> keys,
+	                                          Snapshot snapshot) {
+		if (ryw->options.readYourWritesDisabled) {
+			// Without read-your-writes the underlying transaction can serve the whole batch, unless it includes keys
+			// get() handles specially
+			if (std::all_of(
+			        keys.begin(), keys.end(), [ryw](const KeyRef& key) { return key < ryw->getMaxReadKey(); })) {
+				choose {
+					when(RangeResult result = wait(ryw->tr.getMulti(keys, snapshot))) {
+						return result;
+					}
+					when(wait(ryw->resetPromise.getFuture())) {
+						throw internal_error();
+					}
+				}
+			}
+		} else {
+			state Standalone<VectorRef<KeyRef>> uncached;
+			uncached.arena().dependsOn(keys.arena());
+			{
+				RYWIterator it(&ryw->cache, &ryw->writes);
+				if (ryw->options.bypassUnreadable) {
+					it.bypassUnreadableProtection();
+				}
+				for (const auto& key : keys) {
+					if (key >= ryw->getMaxReadKey() || key == metadataVersionKey ||
+					    key.size() > getMaxReadKeySize(key)) {
+						continue;
+					}
+					it.skip(key);
+					if ((ryw->options.bypassUnreadable || !it.is_unreadable()) && it.is_unknown_range()) {
+						uncached.push_back(uncached.arena(), key);
+					}
+				}
+			}
+
+			if (!uncached.empty()) {
+				choose {
+					when(RangeResult fetched = wait(ryw->tr.getMulti(uncached, Snapshot::True))) {
+						int next = 0;
+						for (const auto& key : uncached) {
+							KeyRef k(ryw->arena, key);
+							if (next < fetched.size() && fetched[next].key == key) {
+								if (ryw->cache.insert(k, fetched[next].value)) {
+									ryw->arena.dependsOn(fetched.arena());
+								}
+								++next;
+							} else {
+								ryw->cache.insert(k, Optional<ValueRef>());
+							}
+						}
+					}
+					when(wait(ryw->resetPromise.getFuture())) {
+						throw internal_error();
+					}
+				}
+			}
+		}
+
+		state std::vector<Future<Optional<Value>>> reads;
+		reads.reserve(keys.size());
+		for (const auto& key : keys) {
+			reads.push_back(ryw->get(Key(key, keys.arena()), snapshot));
+		}
+		std::vector<Optional<Value>> values = wait(getAll(reads));
+
+		RangeResult result;
+		for (int i = 0; i < keys.size(); ++i) {
+			if (values[i].present()) {
+				result.push_back_deep(result.arena(), KeyValueRef(keys[i], values[i].get()));
+			}
+		}
+		return result;
+	}
+
+	// Reads a batch of a streamed range straight from the underlying transaction, which the caller only does when the
+	// write map cannot change the result. Both selectors are firstGreaterOrEqual, so the range the batch read is
+	// known without resolving anything, and its conflict range is added as for any other read.
+	ACTOR static Future<RangeResult> getRangeStreamBatch(ReadYourWritesTransaction* ryw,
+	                                                     KeySelector begin,
+	                                                     KeySelector end,
+	                                                     GetRangeLimits limits,
+	                                                     Snapshot snapshot) {
+		state RangeResult result;
+		choose {
+			when(RangeResult r = wait(ryw->tr.getRangeStreamBatch(
+			         begin, end, limits, ryw->options.readYourWritesDisabled ? snapshot : Snapshot::True))) {
+				result = r;
+			}
+			when(wait(ryw->resetPromise.getFuture())) {
+				throw internal_error();
+			}
+		}
+
+		if (!snapshot && !ryw->options.readYourWritesDisabled) {
+			KeyRangeRef readRange(ryw->arena,
+			                      KeyRangeRef(begin.getKey(), result.more ? result.getReadThrough() : end.getKey()));
+			WriteMap::iterator it(&ryw->writes);
+			it.skip(readRange.begin);
+			updateConflictMap(ryw, readRange, it);
+		}
+		return result;
+	}
+
 	ACTOR static Future<Void> watch(ReadYourWritesTransaction* ryw, Key key) {
 		state Future<Optional<Value>> val;
 		state Future<Void> watchFuture;
@@ -1692,6 +1801,21 @@ Future<Optional<Value>> ReadYourWritesTransaction::get(const Key& key, Snapshot
 	return result;
 }
 
+Future<RangeResult> ReadYourWritesTransaction::getMulti(const Standalone<VectorRef<KeyRef>>& keys, Snapshot snapshot) {
+	CODE_PROBE(true, "ReadYourWritesTransaction::getMulti");
+
+	if (checkUsedDuringCommit()) {
+		return used_during_commit();
+	}
+
+	if (resetPromise.isSet())
+		return resetPromise.getFuture().getError();
+
+	Future<RangeResult> result = RYWImpl::getMulti(this, keys, snapshot);
+	reading.add(success(result));
+	return result;
+}
+
 Future<Key> ReadYourWritesTransaction::getKey(const KeySelector& key, Snapshot snapshot) {
 	if (checkUsedDuringCommit()) {
 		return used_during_commit();
@@ -1776,6 +1900,39 @@ Future<RangeResult> ReadYourWritesTransaction::getRange(const KeySelector& begin
 	return getRange(begin, end, GetRangeLimits(limit), snapshot, reverse);
 }
 
+Future<RangeResult> ReadYourWritesTransaction::getRangeStreamBatch(KeySelector begin,
+                                                                   KeySelector end,
+                                                                   GetRangeLimits limits,
+                                                                   Snapshot snapshot,
+                                                                   Reverse reverse) {
+	if (begin.orEqual)
+		begin.removeOrEqual(begin.arena());
+
+	if (end.orEqual)
+		end.removeOrEqual(end.arena());
+
+	// Streamed batches are not merged with the write map or cached, so reads those could change go through getRange,
+	// as do special keys and reads getRange would reject
+	bool writesVisible =
+	    !options.readYourWritesDisabled && !(snapshot && options.snapshotRywEnabled <= 0) && !writes.empty();
+	if (reverse || writesVisible || !begin.isFirstGreaterOrEqual() || !end.isFirstGreaterOrEqual() ||
+	    begin.getKey() > getMaxReadKey() || end.getKey() > getMaxReadKey() || limits.isReached() ||
+	    !limits.isValid() || begin.getKey() >= end.getKey()) {
+		return getRange(begin, end, limits, snapshot, reverse);
+	}
+
+	if (checkUsedDuringCommit()) {
+		return used_during_commit();
+	}
+
+	if (resetPromise.isSet())
+		return resetPromise.getFuture().getError();
+
+	Future<RangeResult> result = RYWImpl::getRangeStreamBatch(this, begin, end, limits, snapshot);
+	reading.add(success(result));
+	return result;
+}
+
 Future<MappedRangeResult> ReadYourWritesTransaction::getMappedRange(KeySelector begin,
                                                                     KeySelector end,
                                                                     Key mapper,
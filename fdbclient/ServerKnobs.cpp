@@ -117,6 +117,7 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( ENABLE_DETAILED_TLOG_POP_TRACE,                      false ); if ( randomize && BUGGIFY ) ENABLE_DETAILED_TLOG_POP_TRACE = true;
 	init( PEEK_BATCHING_EMPTY_MSG,                              true ); if ( randomize && BUGGIFY ) PEEK_BATCHING_EMPTY_MSG = false;
 	init( PEEK_BATCHING_EMPTY_MSG_INTERVAL,                    0.005 ); if ( randomize && BUGGIFY ) PEEK_BATCHING_EMPTY_MSG_INTERVAL = 0.01;
+	init( TLOG_PEEK_REFERENCE_MESSAGE_BLOCKS,                   true ); if ( randomize && BUGGIFY ) TLOG_PEEK_REFERENCE_MESSAGE_BLOCKS = false;
 	init( POP_FROM_LOG_DELAY,                                      1 ); if ( randomize && BUGGIFY ) POP_FROM_LOG_DELAY = 0;
 	init( TLOG_PULL_ASYNC_DATA_WARNING_TIMEOUT_SECS,             120 );
 
@@ -742,6 +743,10 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( SAMPLE_EXPIRATION_TIME,                                1.0 );
 	init( SAMPLE_POLL_TIME,                                      0.1 );
 	init( RESOLVER_STATE_MEMORY_LIMIT,                           1e6 );
+	init( RESOLVER_CONFLICT_SET_ENGINE,                   "skiplist" ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_SET_ENGINE = deterministicRandom()->coinflip() ? "packedbtree" : "art";
+	init( RESOLVER_CONFLICT_SET_THREADS,                           1 ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_SET_THREADS = deterministicRandom()->randomInt(2, 5);
+	init( RESOLVER_PARTITION_REBALANCE_WRITES,                 10000 ); if( randomize && BUGGIFY ) RESOLVER_PARTITION_REBALANCE_WRITES = 100;
+	init( RESOLVER_PARTITION_MAX_IMBALANCE,                      1.5 );
 	init( LAST_LIMITED_RATIO,                                    2.0 );
 
 	// Backup Worker
@@ -1086,6 +1091,8 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( PHYSICAL_SHARD_MOVE_LOG_SEVERITY,                        1 );
 	init( FETCH_SHARD_BUFFER_BYTE_LIMIT,                        20e6 ); if( randomize && BUGGIFY ) FETCH_SHARD_BUFFER_BYTE_LIMIT = 1;
 	init( FETCH_SHARD_UPDATES_BYTE_LIMIT,                    2500000 ); if( randomize && BUGGIFY ) FETCH_SHARD_UPDATES_BYTE_LIMIT = 100;
+	init( STORAGE_BATCH_PTREE_SETS,                             true ); if( randomize && BUGGIFY ) STORAGE_BATCH_PTREE_SETS = false;
+	init( STORAGE_VERSIONED_MAP_TYPE,                        "ptree" ); if( randomize && BUGGIFY ) STORAGE_VERSIONED_MAP_TYPE = "btree";
 
 	//Wait Failure
 	init( MAX_OUTSTANDING_WAIT_FAILURE_REQUESTS,                 250 ); if( randomize && BUGGIFY ) MAX_OUTSTANDING_WAIT_FAILURE_REQUESTS = 2;
@@ -1220,6 +1227,9 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( REDWOOD_HISTOGRAM_INTERVAL,                           30.0 );
 	init( REDWOOD_EVICT_UPDATED_PAGES,                          true ); if( randomize && BUGGIFY ) { REDWOOD_EVICT_UPDATED_PAGES = false; }
 	init( REDWOOD_DECODECACHE_REUSE_MIN_HEIGHT,                    2 ); if( randomize && BUGGIFY ) { REDWOOD_DECODECACHE_REUSE_MIN_HEIGHT = deterministicRandom()->randomInt(1, 7); }
+	init( REDWOOD_SEARCH_INDEX,                                false ); if( randomize && BUGGIFY ) { REDWOOD_SEARCH_INDEX = true; }
+	init( REDWOOD_PAGE_CACHE_WINDOW_FRACTION,                   0.01 ); if( randomize && BUGGIFY ) { REDWOOD_PAGE_CACHE_WINDOW_FRACTION = deterministicRandom()->coinflip() ? 1.0 : deterministicRandom()->random01(); }
+	init( REDWOOD_PAGE_CACHE_PROTECTED_FRACTION,                 0.8 ); if( randomize && BUGGIFY ) { REDWOOD_PAGE_CACHE_PROTECTED_FRACTION = deterministicRandom()->random01(); }
 	init( REDWOOD_NODE_MAX_UNBALANCE,                              2 );
 	init( REDWOOD_IO_PRIORITIES,                       "32,32,32,32" );
 
@@ -0,0 +1,537 @@
+/*
+ * SharedLocationCache.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/SharedLocationCache.h"
+
+#include "fdbclient/Knobs.h"
+#include "fdbclient/SystemData.h"
+#include "flow/UnitTest.h"
+
+namespace {
+
+// Caches that are in use, by cluster. A cache removes itself when the last DatabaseContext using it lets go.
+std::map<std::string, SharedLocationCache*>& liveCaches() {
+	static std::map<std::string, SharedLocationCache*> caches;
+	return caches;
+}
+
+void appendVarint(std::string& out, uint32_t v) {
+	while (v >= 0x80) {
+		out.push_back(static_cast<char>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<char>(v));
+}
+
+uint32_t readVarint(const uint8_t*& p) {
+	uint32_t v = 0;
+	int shift = 0;
+	while (*p & 0x80) {
+		v |= uint32_t(*p++ & 0x7f) << shift;
+		shift += 7;
+	}
+	return v | (uint32_t(*p++) << shift);
+}
+
+} // namespace
+
+Reference<SharedLocationCache> SharedLocationCache::get(const std::string& cluster) {
+	auto it = liveCaches().find(cluster);
+	if (it != liveCaches().end()) {
+		return Reference<SharedLocationCache>::addRef(it->second);
+	}
+	return makeReference<SharedLocationCache>(cluster, CLIENT_KNOBS->SHARED_LOCATION_CACHE_MAX_BYTES);
+}
+
+SharedLocationCache::SharedLocationCache(std::string cluster, int64_t maxBytes)
+  : cluster(std::move(cluster)), maxBytes(maxBytes), teams(1) {
+	Block all;
+	all.teams.push_back(0);
+	blockBytes += sizeOf(Key(), all);
+	blocks.emplace(Key(), std::move(all));
+	if (!this->cluster.empty()) {
+		ASSERT(liveCaches().emplace(this->cluster, this).second);
+	}
+}
+
+SharedLocationCache::~SharedLocationCache() {
+	if (!cluster.empty()) {
+		liveCaches().erase(cluster);
+	}
+}
+
+int64_t SharedLocationCache::getBytes() const {
+	// The server and team indexes are approximated by their node sizes
+	return blockBytes + teamIndex.size() * (sizeof(Team) + 64) + serverIndex.size() * (sizeof(ServerEntry) + 32);
+}
+
+int64_t SharedLocationCache::sizeOf(const Key& first, const Block& block) {
+	// A std::map node costs about four pointers besides its contents
+	return 4 * sizeof(void*) + sizeof(Key) + sizeof(Block) + first.size() + block.encoded.size() +
+	       block.teams.size() * sizeof(uint32_t);
+}
+
+void SharedLocationCache::decode(const Key& first, const Block& block, Arena& arena, Entries& out) {
+	KeyRef prev(arena, first);
+	out.emplace_back(prev, block.teams[0]);
+
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(block.encoded.data());
+	for (int i = 1; i < block.teams.size(); ++i) {
+		uint32_t shared = readVarint(p);
+		uint32_t suffix = readVarint(p);
+		uint8_t* key = new (arena) uint8_t[shared + suffix];
+		memcpy(key, prev.begin(), shared);
+		memcpy(key + shared, p, suffix);
+		p += suffix;
+		prev = KeyRef(key, shared + suffix);
+		out.emplace_back(prev, block.teams[i]);
+	}
+	ASSERT(p == reinterpret_cast<const uint8_t*>(block.encoded.data() + block.encoded.size()));
+}
+
+SharedLocationCache::Block SharedLocationCache::encode(Entries::const_iterator begin, Entries::const_iterator end) {
+	Block block;
+	block.teams.reserve(end - begin);
+	block.teams.push_back(begin->second);
+	for (auto prev = begin++; begin != end; prev = begin++) {
+		int shared = commonPrefixLength(prev->first, begin->first);
+		appendVarint(block.encoded, shared);
+		appendVarint(block.encoded, begin->first.size() - shared);
+		block.encoded.append(reinterpret_cast<const char*>(begin->first.begin()) + shared,
+		                     begin->first.size() - shared);
+		block.teams.push_back(begin->second);
+	}
+	return block;
+}
+
+std::map<Key, SharedLocationCache::Block>::const_iterator SharedLocationCache::blockContaining(KeyRef key,
+                                                                                            Reverse isBackward) const {
+	auto it = isBackward ? blocks.lower_bound(key) : blocks.upper_bound(key);
+	ASSERT(it != blocks.begin());
+	return std::prev(it);
+}
+
+KeyRef SharedLocationCache::blockEnd(std::map<Key, Block>::const_iterator block) const {
+	auto next = std::next(block);
+	return next == blocks.end() ? allKeys.end : KeyRef(next->first);
+}
+
+KeyRange SharedLocationCache::shardRange(KeyRef key, Reverse isBackward, uint32_t* team) const {
+	auto block = blockContaining(key, isBackward);
+	Arena arena;
+	Entries entries;
+	decode(block->first, block->second, arena, entries);
+
+	// The block was chosen so that its first boundary qualifies
+	int i = entries.size() - 1;
+	while (isBackward ? entries[i].first >= key : entries[i].first > key) {
+		--i;
+	}
+	*team = entries[i].second;
+	return KeyRange(KeyRangeRef(entries[i].first, i + 1 < entries.size() ? entries[i + 1].first : blockEnd(block)));
+}
+
+Optional<SharedLocationCache::Shard> SharedLocationCache::lookup(KeyRef key, Reverse isBackward) const {
+	if (isBackward && key.empty()) {
+		return Optional<Shard>();
+	}
+	uint32_t team;
+	KeyRange range = shardRange(key, isBackward, &team);
+	if (team == 0) {
+		return Optional<Shard>();
+	}
+
+	Shard shard;
+	shard.range = range;
+	shard.servers.reserve(teams[team].servers.size());
+	for (uint32_t server : teams[team].servers) {
+		shard.servers.push_back(servers[server].server);
+	}
+	return shard;
+}
+
+void SharedLocationCache::insert(KeyRangeRef keys, const std::vector<Server>& members) {
+	if (keys.empty()) {
+		return;
+	}
+	assign(keys, members.empty() ? 0 : internTeam(members));
+	evict(keys);
+}
+
+void SharedLocationCache::invalidate(KeyRef key, Reverse isBackward) {
+	if (isBackward && key.empty()) {
+		return;
+	}
+	uint32_t team;
+	KeyRange range = shardRange(key, isBackward, &team);
+	if (team != 0) {
+		assign(range, 0);
+	}
+}
+
+void SharedLocationCache::invalidate(KeyRangeRef keys) {
+	if (keys.empty()) {
+		return;
+	}
+	// Whole shards are forgotten, since a shard with only part of its range cached would look like a smaller shard
+	uint32_t team;
+	KeyRange first = shardRange(keys.begin, Reverse::False, &team);
+	KeyRange last = shardRange(keys.end, Reverse::True, &team);
+	assign(KeyRangeRef(first.begin, last.end), 0);
+}
+
+void SharedLocationCache::assign(KeyRangeRef keys, uint32_t team) {
+	ASSERT(keys.begin < keys.end && keys.end <= allKeys.end);
+
+	// Decode every block from the one holding keys.begin through the one holding keys.end, since that one may need a
+	// boundary added at keys.end
+	auto first = blocks.upper_bound(keys.begin);
+	--first;
+	auto stop = blocks.upper_bound(keys.end);
+
+	Arena arena;
+	Entries old;
+	old.reserve(std::distance(first, stop) * blockEntries);
+	for (auto it = first; it != stop; ++it) {
+		decode(it->first, it->second, arena, old);
+	}
+
+	// The team in effect at keys.end before the change continues after it
+	uint32_t endTeam = 0;
+	bool endIsBoundary = false;
+	for (const auto& [key, t] : old) {
+		if (key > keys.end) {
+			break;
+		}
+		endTeam = t;
+		endIsBoundary = key == keys.end;
+	}
+
+	Entries updated;
+	updated.reserve(old.size() + 2);
+	auto addEntry = [&updated](KeyRef key, uint32_t t) {
+		// Adjacent unknown ranges are merged; known ones are kept apart so shard boundaries survive
+		if (t == 0 && !updated.empty() && updated.back().second == 0) {
+			return;
+		}
+		updated.emplace_back(key, t);
+	};
+	for (const auto& [key, t] : old) {
+		if (key < keys.begin) {
+			addEntry(key, t);
+		}
+	}
+	addEntry(KeyRef(arena, keys.begin), team);
+	if (keys.end != allKeys.end && !endIsBoundary) {
+		addEntry(KeyRef(arena, keys.end), endTeam);
+	}
+	for (const auto& [key, t] : old) {
+		if (key >= keys.end) {
+			addEntry(key, t);
+		}
+	}
+	ASSERT(updated[0].first == old[0].first);
+
+	// Count the new references before dropping the old ones so a team used on both sides is not freed in between
+	for (const auto& entry : updated) {
+		refTeam(entry.second);
+		knownShards += entry.second != 0;
+	}
+	for (const auto& entry : old) {
+		unrefTeam(entry.second);
+		knownShards -= entry.second != 0;
+	}
+
+	for (auto it = first; it != stop;) {
+		blockBytes -= sizeOf(it->first, it->second);
+		it = blocks.erase(it);
+	}
+	// Spread the entries evenly over as few blocks as possible, so that a block which grows by one entry does not
+	// leave a one entry block behind
+	int blockCount = (updated.size() + blockEntries - 1) / blockEntries;
+	int perBlock = (updated.size() + blockCount - 1) / blockCount;
+	for (int i = 0; i < updated.size(); i += perBlock) {
+		auto end = updated.begin() + std::min<int>(updated.size(), i + perBlock);
+		Key key(updated[i].first);
+		Block block = encode(updated.begin() + i, end);
+		blockBytes += sizeOf(key, block);
+		blocks.emplace_hint(stop, std::move(key), std::move(block));
+	}
+}
+
+void SharedLocationCache::evict(KeyRangeRef keep) {
+	// Forget whole blocks in key order, starting where the last eviction stopped, until the cache fits
+	for (int attempts = 0; getBytes() > maxBytes && attempts < 100; ++attempts) {
+		auto block = blocks.upper_bound(evictCursor);
+		if (block == blocks.end()) {
+			block = blocks.begin();
+		}
+		KeyRange range(KeyRangeRef(block->first, blockEnd(block)));
+		evictCursor = range.begin;
+		if (!range.intersects(keep)) {
+			CODE_PROBE(true, "Shared location cache evicted a block");
+			assign(range, 0);
+		}
+	}
+}
+
+uint32_t SharedLocationCache::internTeam(const std::vector<Server>& members) {
+	std::vector<UID> ids;
+	ids.reserve(members.size());
+	for (const auto& member : members) {
+		ids.push_back(member.interf.id());
+	}
+
+	auto existing = teamIndex.find(ids);
+	if (existing != teamIndex.end()) {
+		// Servers keep their IDs across restarts but not their endpoints, so the newest interface wins
+		for (const auto& member : members) {
+			servers[serverIndex[member.interf.id()]].server = member;
+		}
+		return existing->second;
+	}
+
+	Team team;
+	team.servers.reserve(members.size());
+	for (const auto& member : members) {
+		team.servers.push_back(internServer(member));
+	}
+
+	uint32_t index;
+	if (!freeTeams.empty()) {
+		index = freeTeams.back();
+		freeTeams.pop_back();
+		teams[index] = std::move(team);
+	} else {
+		index = teams.size();
+		teams.push_back(std::move(team));
+	}
+	teamIndex.emplace(std::move(ids), index);
+	return index;
+}
+
+void SharedLocationCache::refTeam(uint32_t team) {
+	if (team != 0) {
+		++teams[team].refs;
+	}
+}
+
+void SharedLocationCache::unrefTeam(uint32_t team) {
+	if (team == 0 || --teams[team].refs > 0) {
+		return;
+	}
+
+	std::vector<UID> ids;
+	ids.reserve(teams[team].servers.size());
+	for (uint32_t server : teams[team].servers) {
+		ids.push_back(servers[server].server.interf.id());
+		unrefServer(server);
+	}
+	teamIndex.erase(ids);
+	teams[team] = Team();
+	freeTeams.push_back(team);
+}
+
+uint32_t SharedLocationCache::internServer(const Server& server) {
+	auto existing = serverIndex.find(server.interf.id());
+	if (existing != serverIndex.end()) {
+		servers[existing->second].server = server;
+		++servers[existing->second].refs;
+		return existing->second;
+	}
+
+	uint32_t index;
+	if (!freeServers.empty()) {
+		index = freeServers.back();
+		freeServers.pop_back();
+	} else {
+		index = servers.size();
+		servers.emplace_back();
+	}
+	servers[index].server = server;
+	servers[index].refs = 1;
+	serverIndex.emplace(server.interf.id(), index);
+	return index;
+}
+
+void SharedLocationCache::unrefServer(uint32_t server) {
+	if (--servers[server].refs == 0) {
+		serverIndex.erase(servers[server].server.interf.id());
+		servers[server] = ServerEntry();
+		freeServers.push_back(server);
+	}
+}
+
+void forceLinkSharedLocationCacheTests() {}
+
+namespace {
+
+std::vector<SharedLocationCache::Server> makeTeam(const std::vector<UID>& ids) {
+	std::vector<SharedLocationCache::Server> team;
+	for (const auto& id : ids) {
+		team.push_back(SharedLocationCache::Server{ StorageServerInterface(id), {}, {} });
+	}
+	return team;
+}
+
+std::vector<UID> teamIds(const SharedLocationCache::Shard& shard) {
+	std::vector<UID> ids;
+	for (const auto& server : shard.servers) {
+		ids.push_back(server.interf.id());
+	}
+	return ids;
+}
+
+} // namespace
+
+TEST_CASE("/fdbclient/SharedLocationCache/basic") {
+	SharedLocationCache cache("", std::numeric_limits<int64_t>::max());
+	std::vector<UID> a = { UID(1, 1), UID(2, 2), UID(3, 3) };
+	std::vector<UID> b = { UID(4, 4), UID(5, 5), UID(6, 6) };
+
+	ASSERT(!cache.lookup("a"_sr).present());
+
+	cache.insert(KeyRangeRef("b"_sr, "d"_sr), makeTeam(a));
+	cache.insert(KeyRangeRef("d"_sr, "f"_sr), makeTeam(b));
+	cache.insert(KeyRangeRef("f"_sr, "g"_sr), makeTeam(a));
+	ASSERT_EQ(cache.getShardCount(), 3);
+	ASSERT_EQ(cache.getTeamCount(), 2);
+	ASSERT_EQ(cache.getServerCount(), 6);
+
+	auto shard = cache.lookup("c"_sr);
+	ASSERT(shard.present() && shard.get().range == KeyRangeRef("b"_sr, "d"_sr) && teamIds(shard.get()) == a);
+	shard = cache.lookup("d"_sr);
+	ASSERT(shard.present() && shard.get().range == KeyRangeRef("d"_sr, "f"_sr) && teamIds(shard.get()) == b);
+	shard = cache.lookup("d"_sr, Reverse::True);
+	ASSERT(shard.present() && shard.get().range == KeyRangeRef("b"_sr, "d"_sr));
+	// Shards on the same team stay apart
+	shard = cache.lookup("f"_sr);
+	ASSERT(shard.present() && shard.get().range == KeyRangeRef("f"_sr, "g"_sr) && teamIds(shard.get()) == a);
+	ASSERT(!cache.lookup("g"_sr).present());
+
+	cache.invalidate("e"_sr);
+	ASSERT(!cache.lookup("d"_sr).present());
+	ASSERT_EQ(cache.getTeamCount(), 1);
+	ASSERT_EQ(cache.getServerCount(), 3);
+
+	// A range invalidation drops every shard it touches in full
+	cache.invalidate(KeyRangeRef("c"_sr, "c1"_sr));
+	ASSERT(!cache.lookup("b"_sr).present());
+	ASSERT(cache.lookup("f"_sr).present());
+
+	cache.invalidate(allKeys);
+	ASSERT_EQ(cache.getShardCount(), 0);
+	ASSERT_EQ(cache.getTeamCount(), 0);
+	ASSERT_EQ(cache.getServerCount(), 0);
+	return Void();
+}
+
+TEST_CASE("/fdbclient/SharedLocationCache/randomized") {
+	SharedLocationCache cache("", std::numeric_limits<int64_t>::max());
+	// Reference model: the team in effect from each boundary on, -1 for unknown
+	std::map<Key, int> model;
+	model[Key()] = -1;
+	std::vector<std::vector<UID>> teams;
+	for (int i = 0; i < 8; ++i) {
+		teams.push_back({ deterministicRandom()->randomUniqueID(), deterministicRandom()->randomUniqueID() });
+	}
+
+	auto randomKey = []() {
+		return Key(format("k%04d", deterministicRandom()->randomInt(0, 2000)));
+	};
+	auto modelAssign = [&model](KeyRangeRef keys, int team) {
+		auto end = model.upper_bound(keys.end);
+		int endTeam = std::prev(end)->second;
+		model.erase(model.lower_bound(keys.begin), end);
+		model[keys.begin] = team;
+		if (keys.end != allKeys.end && !model.count(keys.end)) {
+			model[keys.end] = endTeam;
+		}
+	};
+
+	for (int op = 0; op < 20000; ++op) {
+		Key begin = randomKey(), end = randomKey();
+		if (begin == end) {
+			continue;
+		}
+		if (end < begin) {
+			std::swap(begin, end);
+		}
+		if (deterministicRandom()->random01() < 0.9) {
+			int team = deterministicRandom()->randomInt(0, teams.size());
+			cache.insert(KeyRangeRef(begin, end), makeTeam(teams[team]));
+			modelAssign(KeyRangeRef(begin, end), team);
+		} else {
+			// Expand to the shards the model knows, matching the cache's whole shard invalidation
+			Key first = std::prev(model.upper_bound(begin))->first;
+			auto last = model.lower_bound(end);
+			Key lastEnd = last == model.end() ? Key(allKeys.end) : last->first;
+			cache.invalidate(KeyRangeRef(begin, end));
+			modelAssign(KeyRangeRef(first, lastEnd), -1);
+		}
+
+		Key probe = randomKey();
+		auto shard = cache.lookup(probe);
+		auto it = std::prev(model.upper_bound(probe));
+		if (it->second < 0) {
+			ASSERT(!shard.present());
+		} else {
+			auto next = std::next(it);
+			ASSERT(shard.present());
+			ASSERT(teamIds(shard.get()) == teams[it->second]);
+			ASSERT(shard.get().range.begin == it->first);
+			ASSERT(shard.get().range.end == (next == model.end() ? allKeys.end : next->first));
+		}
+	}
+	return Void();
+}
+
+TEST_CASE("/fdbclient/SharedLocationCache/compact") {
+	SharedLocationCache cache("", std::numeric_limits<int64_t>::max());
+	std::vector<std::vector<UID>> teams;
+	for (int i = 0; i < 100; ++i) {
+		teams.push_back({ deterministicRandom()->randomUniqueID(),
+		                  deterministicRandom()->randomUniqueID(),
+		                  deterministicRandom()->randomUniqueID() });
+	}
+
+	const int shards = 100000;
+	for (int i = 0; i < shards; ++i) {
+		cache.insert(KeyRangeRef(Key(format("/tenant/%08d", i)), Key(format("/tenant/%08d", i + 1))),
+		             makeTeam(teams[deterministicRandom()->randomInt(0, teams.size())]));
+	}
+	ASSERT_EQ(cache.getShardCount(), shards);
+
+	// Teams and servers are stored once, and sorted boundaries mostly share their prefix with the one before
+	int64_t bytesPerShard = (cache.getBytes() - cache.getServerCount() * sizeof(StorageServerInterface)) / shards;
+	fmt::print(
+	    "SharedLocationCache: {} shards, {} bytes, {} bytes per shard\n", shards, cache.getBytes(), bytesPerShard);
+	ASSERT_LT(bytesPerShard, 32);
+
+	// Eviction keeps the cache within its limit
+	SharedLocationCache small("", 64 << 10);
+	for (int i = 0; i < shards; ++i) {
+		small.insert(KeyRangeRef(Key(format("/tenant/%08d", i)), Key(format("/tenant/%08d", i + 1))),
+		             makeTeam(teams[i % teams.size()]));
+	}
+	ASSERT_LE(small.getBytes(), 64 << 10);
+	ASSERT(small.lookup(Key(format("/tenant/%08d", shards - 1))).present());
+	return Void();
+}
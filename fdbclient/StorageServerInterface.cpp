@@ -58,6 +58,39 @@ void TSS_traceMismatch(TraceEvent& event,
 	            tss.value.present() ? traceChecksumValue(tss.value.get()) : "missing");
 }
 
+// batched point reads
+template <>
+bool TSS_doCompare(const GetValuesReply& src, const GetValuesReply& tss) {
+	return src.data == tss.data;
+}
+
+template <>
+const char* LB_mismatchTraceName(const GetValuesRequest& req, const ComparisonType& type) {
+	return type == TSS_COMPARISON ? "TSSMismatchGetValues" : "ReplicaMismatchGetValues";
+}
+
+template <>
+void TSS_traceMismatch(TraceEvent& event,
+                       const GetValuesRequest& req,
+                       const GetValuesReply& src,
+                       const GetValuesReply& tss,
+                       const ComparisonType& type) {
+	event.detail("KeyCount", req.keys.size())
+	    .detail("FirstKey", req.keys.empty() ? KeyRef() : req.keys.front())
+	    .detail("Tenant", req.tenantInfo.tenantId)
+	    .detail("Version", req.version)
+	    .detail(type == TSS_COMPARISON ? "SSReplySize" : "SourceSSReplySize", src.data.size())
+	    .detail(type == TSS_COMPARISON ? "TSSReplySize" : "ReplicaSSReplySize", tss.data.size());
+	for (int i = 0; i < std::min(src.data.size(), tss.data.size()); ++i) {
+		if (src.data[i] != tss.data[i]) {
+			event.detail("MismatchKey", src.data[i].key)
+			    .detail(type == TSS_COMPARISON ? "SSReply" : "SourceSSReply", traceChecksumValue(src.data[i].value))
+			    .detail(type == TSS_COMPARISON ? "TSSReply" : "ReplicaSSReply", traceChecksumValue(tss.data[i].value));
+			break;
+		}
+	}
+}
+
 // key selector reads
 template <>
 bool TSS_doCompare(const GetKeyReply& src, const GetKeyReply& tss) {
@@ -449,6 +482,9 @@ void TSSMetrics::recordLatency(const GetValueRequest& req, double ssLatency, dou
 	TSSgetValueLatency.addSample(tssLatency);
 }
 
+template <>
+void TSSMetrics::recordLatency(const GetValuesRequest& req, double ssLatency, double tssLatency) {}
+
 template <>
 void TSSMetrics::recordLatency(const GetKeyRequest& req, double ssLatency, double tssLatency) {
 	SSgetKeyLatency.addSample(ssLatency);
@@ -443,6 +443,17 @@ ThreadFuture<Key> ThreadSafeTransaction::getKey(const KeySelectorRef& key, bool
 	});
 }
 
+ThreadFuture<RangeResult> ThreadSafeTransaction::getMulti(const VectorRef<KeyRef>& keys, bool snapshot) {
+	Standalone<VectorRef<KeyRef>> k;
+	k.append_deep(k.arena(), keys.begin(), keys.size());
+
+	ISingleThreadTransaction* tr = this->tr;
+	return onMainThread([tr, k, snapshot]() -> Future<RangeResult> {
+		tr->checkDeferredError();
+		return tr->getMulti(k, Snapshot{ snapshot });
+	});
+}
+
 ThreadFuture<int64_t> ThreadSafeTransaction::getEstimatedRangeSizeBytes(const KeyRangeRef& keys) {
 	KeyRange r = keys;
 
@@ -494,6 +505,21 @@ ThreadFuture<RangeResult> ThreadSafeTransaction::getRange(const KeySelectorRef&
 	});
 }
 
+ThreadFuture<RangeResult> ThreadSafeTransaction::getRangeStreamBatch(const KeySelectorRef& begin,
+                                                                     const KeySelectorRef& end,
+                                                                     GetRangeLimits limits,
+                                                                     bool snapshot,
+                                                                     bool reverse) {
+	KeySelector b = begin;
+	KeySelector e = end;
+
+	ISingleThreadTransaction* tr = this->tr;
+	return onMainThread([tr, b, e, limits, snapshot, reverse]() -> Future<RangeResult> {
+		tr->checkDeferredError();
+		return tr->getRangeStreamBatch(b, e, limits, Snapshot{ snapshot }, Reverse{ reverse });
+	});
+}
+
 ThreadFuture<MappedRangeResult> ThreadSafeTransaction::getMappedRange(const KeySelectorRef& begin,
                                                                       const KeySelectorRef& end,
                                                                       const StringRef& mapper,
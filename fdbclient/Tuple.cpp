@@ -38,13 +38,39 @@ static double bigEndianDouble(double orig) {
 	return *(double*)&big;
 }
 
+// Returns the offset of the \x00 ending the string which starts at offset, skipping the escaped \x00\xff within it.
+// memchr checks many bytes at a time with vector instructions, so strings are scanned with it rather than byte by byte.
 static size_t findStringTerminator(const StringRef data, size_t offset) {
-	size_t i = offset;
-	while (i < data.size() - 1 && !(data[i] == '\x00' && data[i + 1] != (uint8_t)'\xff')) {
-		i += (data[i] == '\x00' ? 2 : 1);
+	const uint8_t* p = data.begin() + offset;
+	while (p < data.end()) {
+		const uint8_t* zero = (const uint8_t*)memchr(p, '\x00', data.end() - p);
+		if (!zero) {
+			return data.size() - 1;
+		}
+		if (zero + 1 == data.end() || zero[1] != (uint8_t)'\xff') {
+			return zero - data.begin();
+		}
+		p = zero + 2;
 	}
 
-	return i;
+	return data.size();
+}
+
+// Appends the unescaped contents of the encoded string [begin, end) to out, which has room for them, and returns the
+// end of what was written
+static uint8_t* unescapeString(const uint8_t* begin, const uint8_t* end, uint8_t* out) {
+	while (const uint8_t* zero = (const uint8_t*)memchr(begin, '\x00', end - begin)) {
+		memcpy(out, begin, zero - begin);
+		out += zero - begin;
+		if (zero + 1 == end) {
+			// The terminator
+			return out;
+		}
+		*out++ = '\x00';
+		begin = zero + 2;
+	}
+	memcpy(out, begin, end - begin);
+	return out + (end - begin);
 }
 
 // If encoding and the sign bit is 1 (the number is negative), flip all the bits.
@@ -61,15 +87,21 @@ static void adjustFloatingPoint(uint8_t* bytes, size_t size, bool encode) {
 	}
 }
 
-Tuple::Tuple(StringRef const& str, bool exclude_incomplete, bool include_user_type) {
-	data.append(data.arena(), str.begin(), str.size());
+static bool isUserTypeCode(uint8_t code) {
+	return code >= USER_TYPE_START && code <= USER_TYPE_END;
+}
 
+// Records the offset of each element of the packed tuple data
+static void findOffsets(StringRef data,
+                        std::vector<size_t>& offsets,
+                        bool exclude_incomplete,
+                        bool include_user_type) {
 	size_t i = 0;
 	while (i < data.size()) {
 		offsets.push_back(i);
 
 		if (data[i] == '\x01' || data[i] == '\x02') {
-			i = findStringTerminator(str, i + 1) + 1;
+			i = findStringTerminator(data, i + 1) + 1;
 		} else if (data[i] >= '\x0c' && data[i] <= '\x1c') {
 			i += abs(data[i] - '\x14') + 1;
 		} else if (data[i] == 0x20) {
@@ -82,7 +114,7 @@ Tuple::Tuple(StringRef const& str, bool exclude_incomplete, bool include_user_ty
 			i += 1;
 		} else if (data[i] == VERSIONSTAMP_96_CODE) {
 			i += VERSIONSTAMP_TUPLE_SIZE + 1;
-		} else if (include_user_type && isUserType(data[i])) {
+		} else if (include_user_type && isUserTypeCode(data[i])) {
 			// User defined codes must come at the end of a Tuple and are not delimited.
 			i = data.size();
 		} else {
@@ -95,6 +127,35 @@ Tuple::Tuple(StringRef const& str, bool exclude_incomplete, bool include_user_ty
 		offsets.pop_back();
 }
 
+static Tuple::ElementType elementType(uint8_t code) {
+	if (code == '\x00') {
+		return Tuple::ElementType::NULL_TYPE;
+	} else if (code == '\x01') {
+		return Tuple::ElementType::BYTES;
+	} else if (code == '\x02') {
+		return Tuple::ElementType::UTF8;
+	} else if (code >= '\x0c' && code <= '\x1c') {
+		return Tuple::ElementType::INT;
+	} else if (code == 0x20) {
+		return Tuple::ElementType::FLOAT;
+	} else if (code == 0x21) {
+		return Tuple::ElementType::DOUBLE;
+	} else if (code == 0x26 || code == 0x27) {
+		return Tuple::ElementType::BOOL;
+	} else if (code == VERSIONSTAMP_96_CODE) {
+		return Tuple::ElementType::VERSIONSTAMP;
+	} else if (isUserTypeCode(code)) {
+		return Tuple::ElementType::USER_TYPE;
+	} else {
+		throw invalid_tuple_data_type();
+	}
+}
+
+Tuple::Tuple(StringRef const& str, bool exclude_incomplete, bool include_user_type) {
+	data.append(data.arena(), str.begin(), str.size());
+	findOffsets(StringRef(data.begin(), data.size()), offsets, exclude_incomplete, include_user_type);
+}
+
 Tuple Tuple::unpack(StringRef const& str, bool exclude_incomplete) {
 	return Tuple(str, exclude_incomplete);
 }
@@ -146,7 +207,7 @@ Tuple Tuple::unpackUserType(StringRef const& str, bool exclude_incomplete) {
 }
 
 bool Tuple::isUserType(uint8_t code) const {
-	return code >= USER_TYPE_START && code <= USER_TYPE_END;
+	return isUserTypeCode(code);
 }
 
 Tuple& Tuple::append(Tuple const& tuple) {
@@ -171,20 +232,20 @@ Tuple& Tuple::append(TupleVersionstamp const& vs) {
 Tuple& Tuple::append(StringRef const& str, bool utf8) {
 	offsets.push_back(data.size());
 
+	// Room for the type code, the string and its terminator when there is nothing to escape
+	data.reserve(data.arena(), data.size() + str.size() + 2);
 	const uint8_t utfChar = uint8_t(utf8 ? '\x02' : '\x01');
-	data.append(data.arena(), &utfChar, 1);
-
-	size_t lastPos = 0;
-	for (size_t pos = 0; pos < str.size(); ++pos) {
-		if (str[pos] == '\x00') {
-			data.append(data.arena(), str.begin() + lastPos, pos - lastPos);
-			data.push_back(data.arena(), (uint8_t)'\x00');
-			data.push_back(data.arena(), (uint8_t)'\xff');
-			lastPos = pos + 1;
-		}
+	data.push_back(data.arena(), utfChar);
+
+	const uint8_t* p = str.begin();
+	while (const uint8_t* zero = (const uint8_t*)memchr(p, '\x00', str.end() - p)) {
+		data.append(data.arena(), p, zero - p);
+		data.push_back(data.arena(), (uint8_t)'\x00');
+		data.push_back(data.arena(), (uint8_t)'\xff');
+		p = zero + 1;
 	}
 
-	data.append(data.arena(), str.begin() + lastPos, str.size() - lastPos);
+	data.append(data.arena(), p, str.end() - p);
 	data.push_back(data.arena(), (uint8_t)'\x00');
 
 	return *this;
@@ -287,29 +348,7 @@ Tuple::ElementType Tuple::getType(size_t index) const {
 		throw invalid_tuple_index();
 	}
 
-	uint8_t code = data[offsets[index]];
-
-	if (code == '\x00') {
-		return ElementType::NULL_TYPE;
-	} else if (code == '\x01') {
-		return ElementType::BYTES;
-	} else if (code == '\x02') {
-		return ElementType::UTF8;
-	} else if (code >= '\x0c' && code <= '\x1c') {
-		return ElementType::INT;
-	} else if (code == 0x20) {
-		return ElementType::FLOAT;
-	} else if (code == 0x21) {
-		return ElementType::DOUBLE;
-	} else if (code == 0x26 || code == 0x27) {
-		return ElementType::BOOL;
-	} else if (code == VERSIONSTAMP_96_CODE) {
-		return ElementType::VERSIONSTAMP;
-	} else if (isUserType(code)) {
-		return ElementType::USER_TYPE;
-	} else {
-		throw invalid_tuple_data_type();
-	}
+	return elementType(data[offsets[index]]);
 }
 
 Standalone<StringRef> Tuple::getString(size_t index) const {
@@ -330,26 +369,17 @@ Standalone<StringRef> Tuple::getString(size_t index) const {
 		e = data.size();
 	}
 
-	Standalone<StringRef> result;
-	VectorRef<uint8_t> staging;
-
-	for (size_t i = b; i < e; ++i) {
-		if (data[i] == '\x00') {
-			staging.append(result.arena(), data.begin() + b, i - b);
-			++i;
-			b = i + 1;
-
-			if (i < e) {
-				staging.push_back(result.arena(), '\x00');
-			}
-		}
+	// Without escaped \x00 bytes the string is returned in place, sharing the tuple's arena
+	const uint8_t* zero = (const uint8_t*)memchr(data.begin() + b, '\x00', e - b);
+	if (!zero || zero + 1 == data.begin() + e) {
+		return Standalone<StringRef>(StringRef(data.begin() + b, (zero ? zero : data.begin() + e) - (data.begin() + b)),
+		                             data.arena());
 	}
 
-	if (b < e) {
-		staging.append(result.arena(), data.begin() + b, e - b);
-	}
-
-	result.StringRef::operator=(StringRef(staging.begin(), staging.size()));
+	Standalone<StringRef> result;
+	uint8_t* out = new (result.arena()) uint8_t[e - b];
+	uint8_t* end = unescapeString(data.begin() + b, data.begin() + e, out);
+	result.contents() = StringRef(out, end - out);
 	return result;
 }
 
@@ -529,6 +559,30 @@ StringRef Tuple::subTupleRawString(size_t index) const {
 	return StringRef(data.begin() + offsets[index], endPos - offsets[index]);
 }
 
+TupleView TupleView::unpack(StringRef const& str, bool exclude_incomplete) {
+	TupleView view;
+	view.data = str;
+	findOffsets(str, view.offsets, exclude_incomplete, false);
+	return view;
+}
+
+StringRef TupleView::subTupleRawString(size_t index) const {
+	if (index >= offsets.size()) {
+		return StringRef();
+	}
+	size_t end = index + 1;
+	size_t endPos = end < offsets.size() ? offsets[end] : data.size();
+	return data.substr(offsets[index], endPos - offsets[index]);
+}
+
+Tuple::ElementType TupleView::getType(size_t index) const {
+	if (index >= offsets.size()) {
+		throw invalid_tuple_index();
+	}
+
+	return elementType(data[offsets[index]]);
+}
+
 TEST_CASE("/fdbclient/Tuple/makeTuple") {
 	Tuple t1 = Tuple::makeTuple(1,
 	                            1.0f,
@@ -601,3 +655,81 @@ TEST_CASE("/fdbclient/Tuple/unpack") {
 
 	return Void();
 }
+
+TEST_CASE("/fdbclient/Tuple/escapedStrings") {
+	const std::vector<StringRef> strings = { ""_sr,           "z"_sr,     "\x00"_sr,         "\x00\x00"_sr, "\xff"_sr,
+		                                     "\x00\xff"_sr, "z\x00z"_sr, "\x00zz\x00"_sr, "xyz"_sr,      "\xff\x00"_sr };
+
+	Tuple t;
+	for (const auto& str : strings) {
+		t.append(str);
+	}
+	Standalone<StringRef> packed = t.pack();
+	ASSERT(packed.substr(0, 5) == "\x01\x00\x01z\x00"_sr);
+	ASSERT(Tuple::makeTuple("\x00\xff"_sr).pack() == "\x01\x00\xff\xff\x00"_sr);
+
+	Tuple unpacked = Tuple::unpack(packed);
+	TupleView view = TupleView::unpack(packed);
+	ASSERT(unpacked.size() == strings.size());
+	ASSERT(view.size() == strings.size());
+	for (size_t i = 0; i < strings.size(); ++i) {
+		ASSERT(t.getString(i) == strings[i]);
+		ASSERT(unpacked.getString(i) == strings[i]);
+		ASSERT(view.getType(i) == Tuple::BYTES);
+		ASSERT(view.subTupleRawString(i) == unpacked.subTupleRawString(i));
+		ASSERT(view.subTupleRawString(i) == Tuple::makeTuple(strings[i]).pack());
+	}
+
+	// A string without a terminator runs to the end of the data
+	ASSERT(Tuple::unpack("\x01zy\x00\xffx"_sr).getString(0) == "zy\x00x"_sr);
+	ASSERT(Tuple::unpack("\x01zy"_sr).getString(0) == "zy"_sr);
+
+	// Random strings, mostly of zeros and 0xff
+	for (int i = 0; i < 1000; ++i) {
+		std::string str(deterministicRandom()->randomInt(0, 20), '\x00');
+		for (auto& c : str) {
+			int r = deterministicRandom()->randomInt(0, 4);
+			c = r == 0 ? '\x00' : r == 1 ? '\xff' : (char)deterministicRandom()->randomInt(0, 256);
+		}
+		Tuple random = Tuple::makeTuple(StringRef(str), 1, StringRef(str));
+		Tuple randomUnpacked = Tuple::unpack(random.pack());
+		ASSERT(randomUnpacked.size() == 3);
+		ASSERT(randomUnpacked.getString(0) == StringRef(str));
+		ASSERT(randomUnpacked.getInt(1) == 1);
+		ASSERT(randomUnpacked.getString(2) == StringRef(str));
+		ASSERT(TupleView::unpack(random.pack()).subTupleRawString(2) == randomUnpacked.subTupleRawString(2));
+	}
+
+	return Void();
+}
+
+TEST_CASE("/fdbclient/Tuple/view") {
+	Tuple t = Tuple::makeTuple(1, 1.0f, 1.0, false, "byteStr"_sr, Tuple::UnicodeStr("str"_sr), nullptr, -300);
+	Standalone<StringRef> packed = t.pack();
+	TupleView view = TupleView::unpack(packed);
+	ASSERT(view.size() == t.size());
+	for (size_t i = 0; i < t.size(); ++i) {
+		ASSERT(view.getType(i) == t.getType(i));
+		ASSERT(view.subTupleRawString(i) == t.subTupleRawString(i));
+		// Views point into the data they were unpacked from
+		ASSERT(view.subTupleRawString(i).begin() >= packed.begin() && view.subTupleRawString(i).end() <= packed.end());
+	}
+	ASSERT(view.subTupleRawString(t.size()) == StringRef());
+
+	// Same handling of incomplete trailing elements as Tuple
+	StringRef incomplete = packed.substr(0, packed.size() - 1);
+	ASSERT(TupleView::unpack(incomplete).size() == t.size());
+	ASSERT(TupleView::unpack(incomplete, true).size() == t.size() - 1);
+	ASSERT(Tuple::unpack(incomplete, true).size() == t.size() - 1);
+
+	try {
+		TupleView::unpack("\x03"_sr);
+		ASSERT(false);
+	} catch (Error& e) {
+		if (e.code() != error_code_invalid_tuple_data_type) {
+			throw e;
+		}
+	}
+
+	return Void();
+}
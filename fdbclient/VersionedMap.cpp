@@ -19,12 +19,15 @@
  */
 
 #include "fdbclient/VersionedMap.h"
+#include "fdbclient/VersionedBTreeMap.h"
 #include "flow/TreeBenchmark.h"
 #include "flow/UnitTest.h"
 
-template <typename K>
+#include <map>
+
+template <typename K, typename Map = VersionedMap<K, int>>
 struct VersionedMapHarness {
-	using map = VersionedMap<K, int>;
+	using map = Map;
 	using key_type = K;
 
 	struct result {
@@ -74,4 +77,267 @@ TEST_CASE("performance/map/StringRef/VersionedMap") {
 	return Void();
 }
 
+TEST_CASE("performance/map/int/VersionedBTreeMap") {
+	VersionedMapHarness<int, VersionedBTreeMap<int, int>> tree;
+
+	treeBenchmark(tree, *randomInt);
+
+	return Void();
+}
+
+TEST_CASE("performance/map/StringRef/VersionedBTreeMap") {
+	Arena arena;
+	VersionedMapHarness<StringRef, VersionedBTreeMap<StringRef, int>> tree;
+
+	treeBenchmark(tree, [&arena]() { return randomStr(arena); });
+
+	return Void();
+}
+
+TEST_CASE("/fdbclient/VersionedMap/insertSorted") {
+	// Inserting runs of sorted keys must give the same map at every version as inserting the keys one at a time
+	VersionedMap<int, int> batched, single;
+	std::map<Version, std::map<int, int>> expected;
+	std::map<int, int> contents;
+	const int keySpace = deterministicRandom()->randomInt(10, 10000);
+	for (Version v = 1; v <= 100; v++) {
+		batched.createNewVersion(v);
+		single.createNewVersion(v);
+		std::map<int, int> run;
+		int runSize = deterministicRandom()->randomInt(0, deterministicRandom()->coinflip() ? 10 : 1000);
+		for (int i = 0; i < runSize; i++) {
+			run[deterministicRandom()->randomInt(0, keySpace)] = deterministicRandom()->randomInt(0, 1000);
+		}
+		batched.insertSorted(run.begin(), run.end());
+		for (const auto& [k, value] : run) {
+			single.insert(k, value);
+			contents[k] = value;
+		}
+		if (deterministicRandom()->random01() < 0.2 && !contents.empty()) {
+			int k = contents.begin()->first;
+			batched.erase(k);
+			single.erase(k);
+			contents.erase(k);
+		}
+		expected[v] = contents;
+	}
+
+	for (const auto& [v, entries] : expected) {
+		for (VersionedMap<int, int>* m : { &batched, &single }) {
+			auto view = m->at(v);
+			auto i = view.begin();
+			for (const auto& [k, value] : entries) {
+				ASSERT(i != view.end());
+				ASSERT_EQ(i.key(), k);
+				ASSERT_EQ(*i, value);
+				++i;
+			}
+			ASSERT(i == view.end());
+			view.validate();
+		}
+	}
+
+	return Void();
+}
+
+TEST_CASE("/fdbclient/VersionedMap/BTree") {
+	// Small nodes, so that a few thousand keys make a tree several levels deep
+	typedef VersionedBTreeMap<int, int, 256> BTreeMap;
+	BTreeMap btree;
+	VersionedMap<int, int> ptree;
+	std::map<Version, std::map<int, int>> expected;
+	std::map<int, int> contents;
+	const int keySpace = deterministicRandom()->randomInt(10, 5000);
+	const int versions = 300;
+	const int window = deterministicRandom()->randomInt(1, versions);
+	std::vector<Future<Void>> cleanups;
+
+	auto checkView = [&](auto const& view, auto const& pview, std::map<int, int> const& entries) {
+		auto i = view.begin();
+		for (const auto& [k, value] : entries) {
+			ASSERT(i != view.end());
+			ASSERT_EQ(i.key(), k);
+			ASSERT_EQ(*i, value);
+			++i;
+		}
+		ASSERT(i == view.end());
+		if (!entries.empty()) {
+			--i;
+			ASSERT_EQ(i.key(), entries.rbegin()->first);
+		}
+		for (int j = 0; j < 20; j++) {
+			int k = deterministicRandom()->randomInt(-1, keySpace + 1);
+			auto lower = view.lower_bound(k);
+			auto upper = view.upper_bound(k);
+			auto less = view.lastLess(k);
+			auto lessOrEqual = view.lastLessOrEqual(k);
+			auto plower = pview.lower_bound(k);
+			ASSERT_EQ(bool(lower), bool(plower));
+			ASSERT(!lower || lower.key() == plower.key());
+			auto pupper = pview.upper_bound(k);
+			ASSERT_EQ(bool(upper), bool(pupper));
+			ASSERT(!upper || upper.key() == pupper.key());
+			auto pless = pview.lastLess(k);
+			ASSERT_EQ(bool(less), bool(pless));
+			ASSERT(!less || less.key() == pless.key());
+			auto plessOrEqual = pview.lastLessOrEqual(k);
+			ASSERT_EQ(bool(lessOrEqual), bool(plessOrEqual));
+			ASSERT(!lessOrEqual || lessOrEqual.key() == plessOrEqual.key());
+			ASSERT_EQ(bool(view.find(k)), entries.count(k) > 0);
+			if (lower && lower != view.begin()) {
+				auto before = lower;
+				--before;
+				++before;
+				ASSERT(before == lower);
+			}
+		}
+	};
+
+	for (Version v = 1; v <= versions; v++) {
+		btree.createNewVersion(v);
+		ptree.createNewVersion(v);
+		int operations = deterministicRandom()->randomInt(0, deterministicRandom()->coinflip() ? 10 : 300);
+		for (int o = 0; o < operations; o++) {
+			int k = deterministicRandom()->randomInt(0, keySpace);
+			double op = deterministicRandom()->random01();
+			if (op < 0.6) {
+				int value = deterministicRandom()->randomInt(0, 1000);
+				btree.insert(k, value);
+				ptree.insert(k, value);
+				contents[k] = value;
+			} else if (op < 0.7) {
+				std::map<int, int> run;
+				for (int i = deterministicRandom()->randomInt(0, 200); i > 0; i--) {
+					run[k + i] = deterministicRandom()->randomInt(0, 1000);
+				}
+				btree.insertSorted(run.begin(), run.end());
+				ptree.insertSorted(run.begin(), run.end());
+				for (const auto& [rk, value] : run) {
+					contents[rk] = value;
+				}
+			} else if (op < 0.9) {
+				if (contents.count(k)) {
+					btree.erase(k);
+					ptree.erase(k);
+					contents.erase(k);
+				}
+			} else {
+				int end = k + deterministicRandom()->randomInt(0, deterministicRandom()->coinflip() ? 10 : keySpace / 2);
+				btree.erase(k, end);
+				ptree.erase(k, end);
+				contents.erase(contents.lower_bound(k), contents.lower_bound(end));
+			}
+		}
+		btree.atLatest().validate();
+		expected[v] = contents;
+
+		if (v > window) {
+			Version oldest = v - window;
+			if (deterministicRandom()->coinflip()) {
+				btree.forgetVersionsBefore(oldest);
+			} else {
+				cleanups.push_back(btree.forgetVersionsBeforeAsync(oldest));
+			}
+			ptree.forgetVersionsBefore(oldest);
+			expected.erase(expected.begin(), expected.lower_bound(oldest));
+		}
+		for (const auto& [ev, entries] : expected) {
+			if (deterministicRandom()->random01() < 0.05 || ev == v) {
+				checkView(btree.at(ev), ptree.at(ev), entries);
+			}
+		}
+	}
+
+	// Iterators erase from the latest version like keys do
+	while (btree.atLatest().begin()) {
+		auto i = btree.atLatest().lower_bound(deterministicRandom()->randomInt(0, keySpace));
+		if (!i) {
+			--i;
+		}
+		btree.erase(i);
+	}
+
+	return Void();
+}
+
+TEST_CASE("/fdbclient/VersionedMap/BTree/freedKeys") {
+	// Like the storage server, gives every key written its own memory, and frees it once the key has been erased or
+	// overwritten and the versions that could still read it are forgotten. The freed keys are overwritten first, so
+	// that a separator still referring to one sends lookups the wrong way or fails validate().
+	typedef VersionedBTreeMap<KeyRef, int, 256> BTreeMap;
+	BTreeMap btree;
+	std::map<int, std::pair<Standalone<StringRef>, int>> live;
+	std::map<Version, std::vector<Standalone<StringRef>>> retired;
+	const int keySpace = deterministicRandom()->randomInt(10, 3000);
+	const int versions = 300;
+	const int window = deterministicRandom()->randomInt(1, 20);
+
+	auto newKey = [](int k) {
+		std::string s = format("%08d", k);
+		return Standalone<StringRef>(StringRef(s));
+	};
+	auto retire = [&](Version v, int k) {
+		auto i = live.find(k);
+		if (i != live.end()) {
+			retired[v].push_back(i->second.first);
+			live.erase(i);
+		}
+	};
+
+	for (Version v = 1; v <= versions; v++) {
+		btree.createNewVersion(v);
+		int operations = deterministicRandom()->randomInt(0, deterministicRandom()->coinflip() ? 10 : 300);
+		for (int o = 0; o < operations; o++) {
+			int k = deterministicRandom()->randomInt(0, keySpace);
+			double op = deterministicRandom()->random01();
+			if (op < 0.6) {
+				Standalone<StringRef> key = newKey(k);
+				int value = deterministicRandom()->randomInt(0, 1000);
+				btree.insert(key, value);
+				retire(v, k);
+				live[k] = std::make_pair(key, value);
+			} else if (op < 0.9) {
+				if (live.count(k)) {
+					btree.erase(live[k].first);
+					retire(v, k);
+				}
+			} else {
+				int end = k + deterministicRandom()->randomInt(0, deterministicRandom()->coinflip() ? 10 : keySpace / 2);
+				btree.erase(newKey(k), newKey(end));
+				while (live.lower_bound(k) != live.end() && live.lower_bound(k)->first < end) {
+					retire(v, live.lower_bound(k)->first);
+				}
+			}
+		}
+		btree.atLatest().validate();
+
+		if (v > window) {
+			Version oldest = v - window;
+			btree.forgetVersionsBefore(oldest);
+			btree.at(oldest).validate();
+			// No retained version can read a key erased at or before the oldest one
+			for (auto r = retired.begin(); r != retired.end() && r->first <= oldest; r = retired.erase(r)) {
+				for (auto& key : r->second) {
+					memset(mutateString(key), 0xff, key.size());
+				}
+			}
+		}
+
+		auto i = btree.atLatest().begin();
+		for (const auto& [k, entry] : live) {
+			ASSERT(i != btree.atLatest().end());
+			ASSERT(i.key() == entry.first);
+			ASSERT_EQ(*i, entry.second);
+			++i;
+		}
+		ASSERT(i == btree.atLatest().end());
+		for (int j = 0; j < 20; j++) {
+			int k = deterministicRandom()->randomInt(0, keySpace);
+			ASSERT_EQ(bool(btree.atLatest().find(newKey(k))), live.count(k) > 0);
+		}
+	}
+
+	return Void();
+}
+
 void forceLinkVersionedMapTests() {}
@@ -81,11 +81,60 @@ WriteMap& WriteMap::operator=(WriteMap&& r) noexcept {
 	ver = r.ver;
 	scratch_iterator = std::move(r.scratch_iterator);
 	arena = r.arena;
+	pending = std::move(r.pending);
+	pendingEnd = r.pendingEnd;
+	pendingCleared = r.pendingCleared;
+	pendingConflict = r.pendingConflict;
+	pendingUnreadable = r.pendingUnreadable;
 	return *this;
 }
 
+void WriteMap::flushPending() {
+	if (pending.empty()) {
+		return;
+	}
+	PTreeImpl::insertSorted(writes, ver, pending.begin(), pending.end());
+	pending.clear();
+}
+
+WriteMapEntry WriteMap::newEntry(KeyRef key,
+                                 MutationRef::Type operation,
+                                 ValueRef param,
+                                 bool addConflict,
+                                 bool cleared,
+                                 bool conflict,
+                                 bool unreadable) {
+	bool is_unreadable = unreadable || operation == MutationRef::SetVersionstampedValue ||
+	                     operation == MutationRef::SetVersionstampedKey;
+	bool is_dependent = operation != MutationRef::SetValue && operation != MutationRef::SetVersionstampedValue &&
+	                    operation != MutationRef::SetVersionstampedKey;
+
+	if (cleared && is_dependent) {
+		OperationStack op(RYWMutation(Optional<StringRef>(), MutationRef::SetValue));
+		coalesceOver(op, RYWMutation(param, operation), *arena);
+		return WriteMapEntry(key, std::move(op), true, conflict, addConflict || conflict, unreadable, is_unreadable);
+	}
+	return WriteMapEntry(key,
+	                     OperationStack(RYWMutation(param, operation)),
+	                     cleared,
+	                     conflict,
+	                     addConflict || conflict,
+	                     unreadable,
+	                     is_unreadable);
+}
+
 void WriteMap::mutate(KeyRef key, MutationRef::Type operation, ValueRef param, bool addConflict) {
 	writeMapEmpty = false;
+	if (!pending.empty()) {
+		// Every key in the pending range after the last pending write is in the same kind of range it was
+		if (pending.back().key < key && key < pendingEnd) {
+			pending.push_back(
+			    newEntry(key, operation, param, addConflict, pendingCleared, pendingConflict, pendingUnreadable));
+			return;
+		}
+		flushPending();
+	}
+
 	auto& it = scratch_iterator;
 	it.reset(writes, ver);
 	it.skip(key);
@@ -100,27 +149,14 @@ void WriteMap::mutate(KeyRef key, MutationRef::Type operation, ValueRef param, b
 	                    operation != MutationRef::SetVersionstampedKey;
 
 	if (it.entry().key != key) {
-		if (it.is_cleared_range() && is_dependent) {
-			it.tree.clear();
-			OperationStack op(RYWMutation(Optional<StringRef>(), MutationRef::SetValue));
-			coalesceOver(op, RYWMutation(param, operation), *arena);
-			PTreeImpl::insert(
-			    writes,
-			    ver,
-			    WriteMapEntry(
-			        key, std::move(op), true, following_conflict, is_conflict, following_unreadable, is_unreadable));
-		} else {
-			it.tree.clear();
-			PTreeImpl::insert(writes,
-			                  ver,
-			                  WriteMapEntry(key,
-			                                OperationStack(RYWMutation(param, operation)),
-			                                is_cleared,
-			                                following_conflict,
-			                                is_conflict,
-			                                following_unreadable,
-			                                is_unreadable));
-		}
+		// key is in the range following entry(), so start a pending run there
+		pendingEnd = it.nextEntry().key;
+		pendingCleared = is_cleared;
+		pendingConflict = following_conflict;
+		pendingUnreadable = following_unreadable;
+		it.tree.clear();
+		pending.push_back(
+		    newEntry(key, operation, param, addConflict, pendingCleared, pendingConflict, pendingUnreadable));
 	} else {
 		if (!it.is_unreadable() &&
 		    (operation == MutationRef::SetValue || operation == MutationRef::SetVersionstampedValue)) {
@@ -159,6 +195,7 @@ void WriteMap::mutate(KeyRef key, MutationRef::Type operation, ValueRef param, b
 
 void WriteMap::clear(KeyRangeRef keys, bool addConflict) {
 	writeMapEmpty = false;
+	flushPending();
 	if (!addConflict) {
 		clearNoConflict(keys);
 		return;
@@ -203,6 +240,7 @@ void WriteMap::clear(KeyRangeRef keys, bool addConflict) {
 }
 
 void WriteMap::addUnmodifiedAndUnreadableRange(KeyRangeRef keys) {
+	flushPending();
 	auto& it = scratch_iterator;
 	it.reset(writes, ver);
 	it.skip(keys.begin);
@@ -243,6 +281,7 @@ void WriteMap::addUnmodifiedAndUnreadableRange(KeyRangeRef keys) {
 
 void WriteMap::addConflictRange(KeyRangeRef keys) {
 	writeMapEmpty = false;
+	flushPending();
 	auto& it = scratch_iterator;
 	it.reset(writes, ver);
 	it.skip(keys.begin);
@@ -525,6 +564,7 @@ void WriteMap::dump() {
 }
 
 void WriteMap::clearNoConflict(KeyRangeRef keys) {
+	flushPending();
 	auto& it = scratch_iterator;
 	it.reset(writes, ver);
 
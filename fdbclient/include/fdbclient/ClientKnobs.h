@@ -35,6 +35,7 @@ public:
 
 	double SYSTEM_MONITOR_INTERVAL;
 	double NETWORK_BUSYNESS_MONITOR_INTERVAL; // The interval in which we should update the network busyness metric
+	double NETWORK_BUSYNESS_TRACE_INTERVAL; // The interval at which each network thread traces its busyness, 0 to disable
 	double TSS_METRICS_LOGGING_INTERVAL;
 
 	double FAILURE_MAX_DELAY;
@@ -83,20 +84,36 @@ public:
 	int64_t CHANGE_FEED_CACHE_FLUSH_BYTES;
 	double CHANGE_FEED_CACHE_EXPIRE_TIME;
 	int64_t CHANGE_FEED_CACHE_LIMIT_BYTES;
+	bool COMMIT_COMPRESSION_ENABLED; // Send the mutations of large commits ZSTD compressed to proxies which accept that
+	int COMMIT_COMPRESSION_MIN_BYTES; // Commits with fewer mutation bytes are sent uncompressed
+	int COMMIT_COMPRESSION_BLOCK_BYTES; // Mutation bytes compressed at a time, with the network thread yielded between
 
 	int MAX_BATCH_SIZE;
 	double GRV_BATCH_TIMEOUT;
+	// When set, readVersionBatcher sizes its batching window from the arrival rate and the p99 GRV reply latency so
+	// that batching delay plus reply latency stays under GRV_BATCH_TARGET_LATENCY
+	bool GRV_BATCH_ADAPTIVE;
+	double GRV_BATCH_TARGET_LATENCY;
+	double GRV_BATCH_ADAPTIVE_MAX_TIMEOUT;
 	int BROADCAST_BATCH_SIZE;
 	double TRANSACTION_TIMEOUT_DELAY_INTERVAL;
 
 	// When locationCache in DatabaseContext gets to be this size, items will be evicted
 	int LOCATION_CACHE_EVICTION_SIZE;
 	int LOCATION_CACHE_EVICTION_SIZE_SIM;
+	// Used instead of LOCATION_CACHE_EVICTION_SIZE when the shared location cache backs locationCache, which then only
+	// has to hold the shards the database is using
+	int LOCATION_CACHE_EVICTION_SIZE_SHARED;
 	double LOCATION_CACHE_ENDPOINT_FAILURE_GRACE_PERIOD;
 	double LOCATION_CACHE_FAILED_ENDPOINT_RETRY_INTERVAL;
+	// Every DatabaseContext connected to the same cluster backs its location cache with one process-wide cache
+	bool SHARED_LOCATION_CACHE;
+	int64_t SHARED_LOCATION_CACHE_MAX_BYTES;
 
 	int GET_RANGE_SHARD_LIMIT;
 	int WARM_RANGE_SHARD_LIMIT;
+	int WARM_RANGE_BULK_SHARD_LIMIT; // Shards per request when warmRange() fills the shared location cache
+	int GET_VALUES_MAX_KEYS_PER_REQUEST; // Larger getMulti() batches for one storage team are split into several requests
 	int STORAGE_METRICS_SHARD_LIMIT;
 	int SHARD_COUNT_LIMIT;
 	double STORAGE_METRICS_UNFAIR_SPLIT_LIMIT;
@@ -107,6 +124,7 @@ public:
 	bool TAG_ENCODE_KEY_SERVERS;
 	int64_t RANGESTREAM_FRAGMENT_SIZE;
 	int RANGESTREAM_BUFFERED_FRAGMENTS_LIMIT;
+	int64_t RANGESTREAM_BUFFERED_BYTES_LIMIT; // Results fetched ahead by all fragments of a range stream
 	bool QUARANTINE_TSS_ON_MISMATCH;
 	double CHANGE_FEED_EMPTY_BATCH_TIME;
 
@@ -129,6 +147,8 @@ public:
 	int LOG_RANGE_BLOCK_SIZE;
 	int MUTATION_BLOCK_SIZE;
 	double MAX_VERSION_CACHE_LAG; // The upper bound in seconds for OK amount of staleness when using a cached RV
+	double MIN_VERSION_CACHE_LAG; // The shortest interval at which max_read_version_staleness makes the cache refresh
+	double VERSION_CACHE_LAG_WINDOW; // How long a max_read_version_staleness bound keeps the cache refreshing for it
 	double MAX_PROXY_CONTACT_LAG; // The upper bound in seconds for how often we want a response from the GRV proxies
 	double DEBUG_USE_GRV_CACHE_CHANCE; // Debug setting to change the chance for a regular GRV request to use the cache
 	bool FORCE_GRV_CACHE_OFF; // Panic button to turn off cache. Holds priority over other options.
@@ -46,6 +46,9 @@ struct CommitProxyInterface {
 
 	Optional<Key> processId;
 	bool provisional;
+	// Whether the proxy decompresses commits sent with CommitTransactionRequest::FLAG_COMPRESSED_MUTATIONS. Clients
+	// only compress a commit when every proxy it may go to says so, which keeps them working with older proxies.
+	bool acceptsCompressedMutations = false;
 	PublicRequestStream<struct CommitTransactionRequest> commit;
 	PublicRequestStream<struct GetReadVersionRequest>
 	    getConsistentReadVersion; // Returns a version which (1) is committed, and (2) is >= the latest version reported
@@ -76,7 +79,7 @@ struct CommitProxyInterface {
 
 	template <class Archive>
 	void serialize(Archive& ar) {
-		serializer(ar, processId, provisional, commit);
+		serializer(ar, processId, provisional, commit, acceptsCompressedMutations);
 		if (Archive::isDeserializing) {
 			getConsistentReadVersion =
 			    PublicRequestStream<struct GetReadVersionRequest>(commit.getEndpoint().getAdjustedEndpoint(1));
@@ -211,11 +214,17 @@ struct CommitID {
 
 struct CommitTransactionRequest : TimedRequest {
 	constexpr static FileIdentifier file_identifier = 93948;
-	enum { FLAG_IS_LOCK_AWARE = 0x1, FLAG_FIRST_IN_BATCH = 0x2, FLAG_BYPASS_STORAGE_QUOTA = 0x4 };
+	enum {
+		FLAG_IS_LOCK_AWARE = 0x1,
+		FLAG_FIRST_IN_BATCH = 0x2,
+		FLAG_BYPASS_STORAGE_QUOTA = 0x4,
+		FLAG_COMPRESSED_MUTATIONS = 0x8
+	};
 
 	bool isLockAware() const { return (flags & FLAG_IS_LOCK_AWARE) != 0; }
 	bool firstInBatch() const { return (flags & FLAG_FIRST_IN_BATCH) != 0; }
 	bool bypassStorageQuota() const { return (flags & FLAG_BYPASS_STORAGE_QUOTA) != 0; }
+	bool hasCompressedMutations() const { return (flags & FLAG_COMPRESSED_MUTATIONS) != 0; }
 
 	Arena arena;
 	SpanContext spanContext;
@@ -229,6 +238,10 @@ struct CommitTransactionRequest : TimedRequest {
 
 	TenantInfo tenantInfo;
 
+	// With FLAG_COMPRESSED_MUTATIONS, transaction.mutations is sent empty and these hold it instead, in ZSTD compressed
+	// blocks made by compressMutationBlock(). The commit proxy decodes them with decompressMutations().
+	VectorRef<StringRef> compressedMutations;
+
 	CommitTransactionRequest() : CommitTransactionRequest(SpanContext()) {}
 	CommitTransactionRequest(SpanContext const& context) : spanContext(context), flags(0) {}
 
@@ -246,10 +259,25 @@ struct CommitTransactionRequest : TimedRequest {
 		           spanContext,
 		           tenantInfo,
 		           idempotencyId,
+		           compressedMutations,
 		           arena);
 	}
 };
 
+// Returns mutations serialized and ZSTD compressed, allocated in arena. Adds the size of the serialized mutations to
+// serializedBytes.
+StringRef compressMutationBlock(VectorRef<MutationRef> mutations, Arena& arena, int64_t& serializedBytes);
+
+// The most serialized mutation bytes a commit proxy decompresses for one commit. Clients send commits whose mutations
+// serialize to more uncompressed.
+int64_t maxDecompressedMutationBytes();
+
+// Decodes the compressed mutations of req into req.transaction.mutations and clears FLAG_COMPRESSED_MUTATIONS.
+// Returns the number of compressed bytes decoded. Throws transaction_too_large() if they would decompress to more than
+// maxDecompressedMutationBytes(), and serialization_failed() if a block is not a frame made by compressMutationBlock(),
+// in both cases before allocating anything for them.
+int64_t decompressMutations(CommitTransactionRequest& req);
+
 static inline int getBytes(CommitTransactionRequest const& r) {
 	// SOMEDAY: Optimize
 	// return r.arena.getSize(); // NOT correct because arena can be shared!
@@ -429,9 +457,34 @@ struct GetKeyServerLocationsReply {
 	// versions of storage servers, identifies storage servers by their tags).
 	std::vector<std::pair<UID, Tag>> resultsTagMapping;
 
+	// Filled instead of results when the request sets compactReply. Shard i is [boundaries[i], boundaries[i+1]) and
+	// is served by teams[shardTeams[i]], whose members index into servers, so each interface is sent once.
+	VectorRef<KeyRef> boundaries;
+	std::vector<int> shardTeams;
+	std::vector<std::vector<int>> teams;
+	std::vector<StorageServerInterface> servers;
+
+	// Read either form of the reply
+	int shardCount() const { return boundaries.empty() ? results.size() : shardTeams.size(); }
+	KeyRangeRef shardRange(int shard) const {
+		return boundaries.empty() ? results[shard].first : KeyRangeRef(boundaries[shard], boundaries[shard + 1]);
+	}
+	std::vector<StorageServerInterface> shardServers(int shard) const {
+		if (boundaries.empty()) {
+			return results[shard].second;
+		}
+		std::vector<StorageServerInterface> ssis;
+		ssis.reserve(teams[shardTeams[shard]].size());
+		for (int server : teams[shardTeams[shard]]) {
+			ssis.push_back(servers[server]);
+		}
+		return ssis;
+	}
+
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, results, resultsTssMapping, resultsTagMapping, arena);
+		serializer(
+		    ar, results, resultsTssMapping, resultsTagMapping, boundaries, shardTeams, teams, servers, arena);
 	}
 };
 
@@ -456,6 +509,9 @@ struct GetKeyServerLocationsRequest {
 	// updates from other proxies before answering.
 	Version minTenantVersion;
 
+	// Asks for the compact form of the reply. Only honored for forward range requests; older proxies ignore it.
+	bool compactReply = false;
+
 	GetKeyServerLocationsRequest() : limit(0), reverse(false), minTenantVersion(latestVersion) {}
 	GetKeyServerLocationsRequest(SpanContext spanContext,
 	                             TenantInfo const& tenant,
@@ -464,15 +520,16 @@ struct GetKeyServerLocationsRequest {
 	                             int limit,
 	                             bool reverse,
 	                             Version minTenantVersion,
-	                             Arena const& arena)
+	                             Arena const& arena,
+	                             bool compactReply = false)
 	  : arena(arena), spanContext(spanContext), tenant(tenant), begin(begin), end(end), limit(limit), reverse(reverse),
-	    minTenantVersion(minTenantVersion) {}
+	    minTenantVersion(minTenantVersion), compactReply(compactReply) {}
 
 	bool verify() const { return tenant.isAuthorized(); }
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, begin, end, limit, reverse, reply, spanContext, tenant, minTenantVersion, arena);
+		serializer(ar, begin, end, limit, reverse, reply, spanContext, tenant, minTenantVersion, compactReply, arena);
 	}
 };
 
@@ -36,6 +36,8 @@
 #include "fdbclient/NativeAPI.actor.h"
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbclient/CommitProxyInterface.h"
+#include "fdbclient/GrvBatchController.h"
+#include "fdbclient/SharedLocationCache.h"
 #include "fdbclient/SpecialKeySpace.actor.h"
 #include "fdbclient/VersionVector.h"
 #include "fdbclient/IKeyValueStore.actor.h"
@@ -203,6 +205,17 @@ struct EndpointFailureInfo {
 	double lastRefreshTime = 0;
 };
 
+// How stale the background GRV updater lets the read version cache get: the tightest max_read_version_staleness
+// asked for within the last VERSION_CACHE_LAG_WINDOW seconds, but no less than MIN_VERSION_CACHE_LAG. Once no
+// transaction has asked for a bound within the window, the updater goes back to MAX_VERSION_CACHE_LAG.
+struct GrvCacheLagBound {
+	double lag = 0; // 0 if no bound has been asked for
+	double askedTime = 0; // When lag was last asked for
+
+	void ask(double staleness, double t);
+	double get(double t) const;
+};
+
 struct KeyRangeLocationInfo {
 	KeyRange range;
 	Reference<LocationInfo> locations;
@@ -308,6 +321,10 @@ public:
 	Reference<LocationInfo> setCachedLocation(const KeyRangeRef&, const std::vector<struct StorageServerInterface>&);
 	void invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRef& key, Reverse isBackward = Reverse::False);
 	void invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRangeRef& keys);
+	// Adds the shards in a location reply to the shared location cache, if there is one
+	void shareLocations(const GetKeyServerLocationsReply& reply);
+	// Copies a shard found in the shared location cache into locationCache
+	Reference<LocationInfo> restoreSharedLocation(const SharedLocationCache::Shard& shard);
 
 	// Records that `endpoint` is failed on a healthy server.
 	void setFailedEndpointOnHealthyServer(const Endpoint& endpoint);
@@ -520,6 +537,7 @@ public:
 	// Transaction start request batching
 	struct VersionBatcher {
 		PromiseStream<VersionRequest> stream;
+		GrvBatchController controller;
 		Future<Void> actor;
 	};
 	std::map<uint32_t, VersionBatcher> versionBatcher;
@@ -543,6 +561,8 @@ public:
 	// Cache of location information
 	int locationCacheSize;
 	CoalescedKeyRangeMap<Reference<LocationInfo>> locationCache;
+	// Shared by every DatabaseContext in the process connected to the same cluster; consulted on locationCache misses
+	Reference<SharedLocationCache> sharedLocationCache;
 	std::unordered_map<Endpoint, EndpointFailureInfo> failedEndpointsOnHealthyServersInfo;
 
 	std::map<UID, StorageServerInfo*> server_interf;
@@ -552,6 +572,9 @@ public:
 	std::unordered_map<UID, StorageServerInterface> tssMapping;
 	// map from tssid -> metrics for that tss pair
 	std::unordered_map<UID, Reference<TSSMetrics>> tssMetrics;
+	// map from ssid -> tssid for the entries of tssMapping added from sharedLocationCache, which a proxy has not
+	// confirmed since
+	std::unordered_map<UID, UID> sharedTssMapping;
 	// map from changeFeedId -> changeFeedRange
 	std::unordered_map<Key, KeyRange> changeFeedCache;
 	std::unordered_map<UID, ChangeFeedStorageData*> changeFeedUpdaters;
@@ -594,11 +617,14 @@ public:
 	Counter transactionBatchReadVersionsCompleted;
 	Counter transactionDefaultReadVersionsCompleted;
 	Counter transactionImmediateReadVersionsCompleted;
+	Counter transactionReadVersionCacheHits;
+	Counter transactionReadVersionCacheMisses;
 	Counter transactionLogicalReads;
 	Counter transactionPhysicalReads;
 	Counter transactionPhysicalReadsCompleted;
 	Counter transactionGetKeyRequests;
 	Counter transactionGetValueRequests;
+	Counter transactionGetMultiRequests;
 	Counter transactionGetRangeRequests;
 	Counter transactionGetMappedRangeRequests;
 	Counter transactionGetRangeStreamRequests;
@@ -614,8 +640,15 @@ public:
 	Counter transactionAtomicMutations;
 	Counter transactionsCommitStarted;
 	Counter transactionsCommitCompleted;
+	// Commits sent with compressed mutations, the mutation bytes before and after compressing them, and the
+	// microseconds spent compressing
+	Counter transactionCommitsCompressed;
+	Counter transactionCommitCompressionBytesIn;
+	Counter transactionCommitCompressionBytesOut;
+	Counter transactionCommitCompressionMicros;
 	Counter transactionKeyServerLocationRequests;
 	Counter transactionKeyServerLocationRequestsCompleted;
+	Counter transactionSharedLocationCacheHits;
 	Counter transactionBlobGranuleLocationRequests;
 	Counter transactionBlobGranuleLocationRequestsCompleted;
 	Counter transactionStatusRequests;
@@ -672,6 +705,9 @@ public:
 	void updateCachedReadVersion(double t, Version v);
 	Version getCachedReadVersion();
 	double getLastGrvTime();
+	// Longest the background updater lets the cache go without a refresh
+	GrvCacheLagBound grvCacheLag;
+	double getGrvCacheLag() const { return grvCacheLag.get(now()); }
 	double lastRkBatchThrottleTime;
 	double lastRkDefaultThrottleTime;
 	// Cached RVs can be updated through commits, and using cached RVs avoids the proxies altogether
@@ -0,0 +1,91 @@
+/*
+ * GrvBatchController.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_GRV_BATCH_CONTROLLER_H
+#define FDBCLIENT_GRV_BATCH_CONTROLLER_H
+#pragma once
+
+#include <vector>
+
+#include "flow/Trace.h"
+
+// Decides how long readVersionBatcher keeps a batch of read version requests open before sending it.
+//
+// Without GRV_BATCH_ADAPTIVE the window follows half of the smoothed GRV reply latency, capped at GRV_BATCH_TIMEOUT.
+//
+// With GRV_BATCH_ADAPTIVE the window is the part of GRV_BATCH_TARGET_LATENCY left over once the p99 reply latency of
+// recent GRV requests is taken out, so that a transaction waiting out a whole window still gets its read version within
+// the target. The window is then shortened to the time MAX_BATCH_SIZE requests take to arrive, and dropped entirely if
+// fewer than one more request is expected to arrive during it, since waiting would add latency without saving a
+// request. When the reply latency alone is over the target, the window falls back to the non-adaptive one rather than
+// sending every request on its own and loading the proxies further.
+//
+// Only used from the network thread.
+class GrvBatchController {
+public:
+	static constexpr int latencySamples = 256; // Reply latencies the p99 is estimated from
+	static constexpr int recomputeInterval = 32; // Reply latencies between p99 estimates
+	static constexpr double rateTimeConstant = 0.1; // Seconds over which the arrival rate is averaged
+
+	GrvBatchController();
+	GrvBatchController(bool adaptive, double targetLatency, double maxWindow, double legacyMaxWindow, int maxBatchSize);
+
+	// Records that a request joined the batcher at time now
+	void addArrival(double now);
+
+	// Records the round trip of a GRV request sent by the batcher
+	void addReplyLatency(double latency);
+
+	// Returns how long a batch opened at time now should wait for more requests
+	double getWindow(double now);
+
+	// Requests per second, decayed to time now
+	double getArrivalRate(double now) const;
+	double getReplyLatency99() const { return replyLatency99; }
+	double getLastWindow() const { return lastWindow; }
+	bool isAdaptive() const { return adaptive; }
+
+	void logMetrics(TraceEvent& ev, double now) const;
+
+private:
+	bool adaptive;
+	double targetLatency;
+	double maxWindow;
+	double legacyMaxWindow;
+	int maxBatchSize;
+
+	double arrivalRate = 0;
+	double lastArrival = 0;
+
+	std::vector<double> replyLatencies; // Ring buffer of the last latencySamples reply latencies
+	int nextLatency = 0;
+	int64_t replyCount = 0;
+	double replyLatency99 = 0;
+
+	double legacyWindow = 0;
+	double lastWindow = 0;
+
+	// Batches opened with the window at zero, at the target budget, and at the non-adaptive fallback
+	int64_t immediateBatches = 0;
+	int64_t budgetBatches = 0;
+	int64_t fallbackBatches = 0;
+};
+
+#endif
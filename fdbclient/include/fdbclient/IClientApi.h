@@ -46,6 +46,8 @@ public:
 	// until the ThreadFuture's ThreadSingleAssignmentVar has its memory released or it is destroyed.
 	virtual ThreadFuture<Optional<Value>> get(const KeyRef& key, bool snapshot = false) = 0;
 	virtual ThreadFuture<Key> getKey(const KeySelectorRef& key, bool snapshot = false) = 0;
+	// Values of the given keys that are present, in the order the keys were given
+	virtual ThreadFuture<RangeResult> getMulti(const VectorRef<KeyRef>& keys, bool snapshot = false) = 0;
 	virtual ThreadFuture<RangeResult> getRange(const KeySelectorRef& begin,
 	                                           const KeySelectorRef& end,
 	                                           int limit,
@@ -70,6 +72,14 @@ public:
 	                                                       GetRangeLimits limits,
 	                                                       bool snapshot = false,
 	                                                       bool reverse = false) = 0;
+	// One batch of a range read that is continued from where each batch ends, as the range iterators of the bindings
+	// do. The batch may be served from a stream that reads ahead of the caller, and may hold fewer rows than the
+	// limits allow.
+	virtual ThreadFuture<RangeResult> getRangeStreamBatch(const KeySelectorRef& begin,
+	                                                      const KeySelectorRef& end,
+	                                                      GetRangeLimits limits,
+	                                                      bool snapshot = false,
+	                                                      bool reverse = false) = 0;
 	virtual ThreadFuture<Standalone<VectorRef<const char*>>> getAddressesForKey(const KeyRef& key) = 0;
 	virtual ThreadFuture<Standalone<StringRef>> getVersionstamp() = 0;
 
@@ -59,6 +59,8 @@ public:
 	virtual Future<Version> getReadVersion() = 0;
 	virtual Optional<Version> getCachedReadVersion() const = 0;
 	virtual Future<Optional<Value>> get(const Key& key, Snapshot = Snapshot::False) = 0;
+	// Returns the keys which have values, in request order. By default this is one get() per key.
+	virtual Future<RangeResult> getMulti(const Standalone<VectorRef<KeyRef>>& keys, Snapshot = Snapshot::False);
 	virtual Future<Key> getKey(const KeySelector& key, Snapshot = Snapshot::False) = 0;
 	virtual Future<RangeResult> getRange(const KeySelector& begin,
 	                                     const KeySelector& end,
@@ -76,6 +78,13 @@ public:
 	                                                 GetRangeLimits limits,
 	                                                 Snapshot = Snapshot::False,
 	                                                 Reverse = Reverse::False) = 0;
+	// One batch of a range read that the caller continues from where each batch ends. Transactions that can serve
+	// such a series from one range stream do; by default this is getRange.
+	virtual Future<RangeResult> getRangeStreamBatch(KeySelector begin,
+	                                                KeySelector end,
+	                                                GetRangeLimits limits,
+	                                                Snapshot = Snapshot::False,
+	                                                Reverse = Reverse::False);
 	virtual Future<Standalone<VectorRef<const char*>>> getAddressesForKey(Key const& key) = 0;
 	virtual Future<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(KeyRange const& range, int64_t chunkSize) = 0;
 	virtual Future<int64_t> getEstimatedRangeSizeBytes(KeyRange const& keys) = 0;
@@ -292,6 +292,7 @@ struct FdbCApi : public ThreadSafeReferenceCounted<FdbCApi> {
 	FDBFuture* (*transactionGetReadVersion)(FDBTransaction* tr);
 
 	FDBFuture* (*transactionGet)(FDBTransaction* tr, uint8_t const* keyName, int keyNameLength, fdb_bool_t snapshot);
+	FDBFuture* (*transactionGetMulti)(FDBTransaction* tr, FDBKey const* keys, int keyCount, fdb_bool_t snapshot);
 	FDBFuture* (*transactionGetKey)(FDBTransaction* tr,
 	                                uint8_t const* keyName,
 	                                int keyNameLength,
@@ -469,6 +470,7 @@ public:
 
 	ThreadFuture<Optional<Value>> get(const KeyRef& key, bool snapshot = false) override;
 	ThreadFuture<Key> getKey(const KeySelectorRef& key, bool snapshot = false) override;
+	ThreadFuture<RangeResult> getMulti(const VectorRef<KeyRef>& keys, bool snapshot = false) override;
 	ThreadFuture<RangeResult> getRange(const KeySelectorRef& begin,
 	                                   const KeySelectorRef& end,
 	                                   int limit,
@@ -493,6 +495,11 @@ public:
 	                                               GetRangeLimits limits,
 	                                               bool snapshot,
 	                                               bool reverse) override;
+	ThreadFuture<RangeResult> getRangeStreamBatch(const KeySelectorRef& begin,
+	                                              const KeySelectorRef& end,
+	                                              GetRangeLimits limits,
+	                                              bool snapshot = false,
+	                                              bool reverse = false) override;
 	ThreadFuture<Standalone<VectorRef<const char*>>> getAddressesForKey(const KeyRef& key) override;
 	ThreadFuture<Standalone<StringRef>> getVersionstamp() override;
 	ThreadFuture<int64_t> getEstimatedRangeSizeBytes(const KeyRangeRef& keys) override;
@@ -707,6 +714,7 @@ public:
 
 	ThreadFuture<Optional<Value>> get(const KeyRef& key, bool snapshot = false) override;
 	ThreadFuture<Key> getKey(const KeySelectorRef& key, bool snapshot = false) override;
+	ThreadFuture<RangeResult> getMulti(const VectorRef<KeyRef>& keys, bool snapshot = false) override;
 	ThreadFuture<RangeResult> getRange(const KeySelectorRef& begin,
 	                                   const KeySelectorRef& end,
 	                                   int limit,
@@ -731,6 +739,11 @@ public:
 	                                               GetRangeLimits limits,
 	                                               bool snapshot,
 	                                               bool reverse) override;
+	ThreadFuture<RangeResult> getRangeStreamBatch(const KeySelectorRef& begin,
+	                                              const KeySelectorRef& end,
+	                                              GetRangeLimits limits,
+	                                              bool snapshot = false,
+	                                              bool reverse = false) override;
 	ThreadFuture<Standalone<VectorRef<const char*>>> getAddressesForKey(const KeyRef& key) override;
 	ThreadFuture<Standalone<StringRef>> getVersionstamp() override;
 
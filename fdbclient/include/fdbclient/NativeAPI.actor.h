@@ -152,6 +152,7 @@ struct StorageMetrics;
 
 struct TransactionOptions {
 	double maxBackoff;
+	double maxReadVersionStaleness; // Seconds; a cached read version at most this old may be used when positive
 	uint32_t getReadVersionFlags;
 	uint32_t sizeLimit;
 	int maxTransactionLoggingFieldLength;
@@ -351,6 +352,20 @@ private:
 	bool tenantSet;
 };
 
+// The range stream behind Transaction::getRangeStreamBatch. Batches are cut from it in order for as long as each read
+// begins where the last one ended.
+struct RangeStreamCursor : ReferenceCounted<RangeStreamCursor> {
+	Key nextBegin; // The first key not yet returned
+	Key end;
+	PromiseStream<RangeResult> results;
+	RangeResult pending; // Received from the stream but not yet returned
+	int pendingIndex = 0;
+	bool exhausted = false;
+	bool reading = false;
+	bool failed = false; // A batch was lost to an error or cancellation, so the stream cannot be continued
+	Future<Void> stream;
+};
+
 class Transaction : NonCopyable {
 public:
 	explicit Transaction(Database const& cx, Optional<Reference<Tenant>> const& tenant = Optional<Reference<Tenant>>());
@@ -367,6 +382,9 @@ public:
 	Optional<Version> getCachedReadVersion() const;
 
 	[[nodiscard]] Future<Optional<Value>> get(const Key& key, Snapshot = Snapshot::False);
+	// Reads many keys with one request per storage server team instead of one per key. The result holds the keys
+	// which have values, in the order they were requested.
+	[[nodiscard]] Future<RangeResult> getMulti(const Standalone<VectorRef<KeyRef>>& keys, Snapshot = Snapshot::False);
 	[[nodiscard]] Future<Void> watch(Reference<Watch> watch);
 	[[nodiscard]] Future<Key> getKey(const KeySelector& key, Snapshot = Snapshot::False);
 	// Future< Optional<KeyValue> > get( const KeySelectorRef& key );
@@ -457,6 +475,16 @@ public:
 		                      reverse);
 	}
 
+	// Reads a range like getRange, but a series of calls that each begin where the last one ended is served from one
+	// range stream, which fetches the range from storage servers in parallel fragments ahead of the caller. A batch
+	// holds whatever has arrived once at least one row is available, so it may be smaller than the limits allow.
+	// Reverse reads and ranges not bounded by firstGreaterOrEqual selectors (after removing orEqual) use getRange.
+	[[nodiscard]] Future<RangeResult> getRangeStreamBatch(const KeySelector& begin,
+	                                                      const KeySelector& end,
+	                                                      GetRangeLimits limits,
+	                                                      Snapshot = Snapshot::False,
+	                                                      Reverse = Reverse::False);
+
 	[[nodiscard]] Future<Standalone<VectorRef<const char*>>> getAddressesForKey(const Key& key);
 
 	void enableCheckWrites();
@@ -579,6 +607,7 @@ private:
 	std::vector<Future<std::pair<Key, Key>>> extraConflictRanges;
 	Promise<Void> commitResult;
 	Future<Void> committing;
+	Reference<RangeStreamCursor> rangeStreamCursor;
 };
 
 template <std::invocable<Transaction*> Fun>
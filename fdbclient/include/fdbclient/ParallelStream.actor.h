@@ -32,7 +32,7 @@
 #include "flow/actorcompiler.h" // must be last include
 
 // ParallelStream is used to fetch data from multiple streams in parallel and then merge them back into a single stream
-// in order.
+// in order. T must have expectedSize(), which is what the byte limit on buffered results counts.
 template <class T>
 class ParallelStream {
 	Reference<BoundedFlowLock> semaphore;
@@ -40,19 +40,34 @@ class ParallelStream {
 		explicit FragmentConstructorTag() = default;
 	};
 
+	// Bytes sent by fragments that have not yet reached the main output stream
+	struct BufferedBytes : ReferenceCounted<BufferedBytes> {
+		int64_t bytes = 0;
+		const int64_t limit;
+		const void* head = nullptr; // The fragment being flushed, which never waits for credit
+		AsyncTrigger released;
+
+		explicit BufferedBytes(int64_t limit) : limit(limit) {}
+	};
+
 public:
 	// A Fragment is a single stream that will get results to be merged back into the main output stream
 	class Fragment : public ReferenceCounted<Fragment> {
 		Reference<BoundedFlowLock> semaphore;
+		Reference<BufferedBytes> buffered;
 		PromiseStream<T> stream;
 		BoundedFlowLock::Releaser releaser;
 		friend class ParallelStream;
 
 	public:
-		Fragment(Reference<BoundedFlowLock> semaphore, int64_t permitNumber, FragmentConstructorTag)
-		  : semaphore(semaphore), releaser(semaphore.getPtr(), permitNumber) {}
+		Fragment(Reference<BoundedFlowLock> semaphore,
+		         Reference<BufferedBytes> buffered,
+		         int64_t permitNumber,
+		         FragmentConstructorTag)
+		  : semaphore(semaphore), buffered(buffered), releaser(semaphore.getPtr(), permitNumber) {}
 		template <class U>
 		void send(U&& value) {
+			buffered->bytes += value.expectedSize();
 			stream.send(std::forward<U>(value));
 		}
 		void sendError(Error e) { stream.sendError(e); }
@@ -61,14 +76,28 @@ public:
 			stream.sendError(end_of_stream());
 		}
 		Future<Void> onEmpty() { return stream.onEmpty(); }
+		// Ready once results buffered across all fragments are under the byte limit, or this fragment is the one being
+		// flushed and has nothing buffered. Waiting on this before reading more lets fragments fetch ahead without
+		// letting the ones further along hold up the one the output is waiting for.
+		Future<Void> onCredit() { return waitForCredit(Reference<Fragment>::addRef(this)); }
 	};
 
 private:
 	PromiseStream<Reference<Fragment>> fragments;
 	size_t fragmentsProcessed{ 0 };
 	PromiseStream<T> results;
+	Reference<BufferedBytes> buffered;
 	Future<Void> flusher;
 
+	ACTOR static Future<Void> waitForCredit(Reference<Fragment> fragment) {
+		state Reference<BufferedBytes> buffered = fragment->buffered;
+		while (buffered->bytes >= buffered->limit &&
+		       (buffered->head != fragment.getPtr() || !fragment->stream.getFuture().isEmpty())) {
+			wait(buffered->released.onTrigger());
+		}
+		return Void();
+	}
+
 public:
 	// A background actor which take results from the oldest fragment and sends them to the main output stream
 	ACTOR static Future<Void> flushToClient(ParallelStream<T>* self) {
@@ -77,10 +106,14 @@ public:
 		try {
 			loop {
 				state Reference<Fragment> fragment = waitNext(self->fragments.getFuture());
+				self->buffered->head = fragment.getPtr();
+				self->buffered->released.trigger();
 				loop {
 					try {
 						wait(self->results.onEmpty());
 						T value = waitNext(fragment->stream.getFuture());
+						self->buffered->bytes -= value.expectedSize();
+						self->buffered->released.trigger();
 						self->results.send(value);
 						if (++messagesSinceYield == messagesBetweenYields) {
 							wait(yield());
@@ -88,6 +121,7 @@ public:
 						}
 					} catch (Error& e) {
 						if (e.code() == error_code_end_of_stream) {
+							self->buffered->head = nullptr;
 							fragment.clear();
 							break;
 						} else {
@@ -105,7 +139,12 @@ public:
 		}
 	}
 
-	ParallelStream(PromiseStream<T> results, size_t bufferLimit) : results(results) {
+	// At most bufferLimit fragments are open at once. bytesLimit bounds the results they buffer; it is exceeded by at
+	// most one result per fragment.
+	ParallelStream(PromiseStream<T> results,
+	               size_t bufferLimit,
+	               int64_t bytesLimit = std::numeric_limits<int64_t>::max())
+	  : results(results), buffered(makeReference<BufferedBytes>(bytesLimit)) {
 		semaphore = makeReference<BoundedFlowLock>(1, bufferLimit);
 		flusher = flushToClient(this);
 	}
@@ -113,7 +152,8 @@ public:
 	// Creates a fragment to get merged into the main output stream
 	ACTOR static Future<Fragment*> createFragmentImpl(ParallelStream<T>* self) {
 		int64_t permitNumber = wait(self->semaphore->take());
-		auto fragment = makeReference<Fragment>(self->semaphore, permitNumber, FragmentConstructorTag());
+		auto fragment =
+		    makeReference<Fragment>(self->semaphore, self->buffered, permitNumber, FragmentConstructorTag());
 		self->fragments.send(fragment);
 		return fragment.getPtr();
 	}
@@ -80,6 +80,7 @@ public:
 	Future<Version> getReadVersion() override;
 	Optional<Version> getCachedReadVersion() const override { return tr.getCachedReadVersion(); }
 	Future<Optional<Value>> get(const Key& key, Snapshot = Snapshot::False) override;
+	Future<RangeResult> getMulti(const Standalone<VectorRef<KeyRef>>& keys, Snapshot = Snapshot::False) override;
 	Future<Key> getKey(const KeySelector& key, Snapshot = Snapshot::False) override;
 	Future<RangeResult> getRange(const KeySelector& begin,
 	                             const KeySelector& end,
@@ -117,6 +118,11 @@ public:
 	                                         GetRangeLimits limits,
 	                                         Snapshot = Snapshot::False,
 	                                         Reverse = Reverse::False) override;
+	Future<RangeResult> getRangeStreamBatch(KeySelector begin,
+	                                        KeySelector end,
+	                                        GetRangeLimits limits,
+	                                        Snapshot = Snapshot::False,
+	                                        Reverse = Reverse::False) override;
 
 	[[nodiscard]] Future<Standalone<VectorRef<const char*>>> getAddressesForKey(const Key& key) override;
 	Future<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(const KeyRange& range, int64_t chunkSize) override;
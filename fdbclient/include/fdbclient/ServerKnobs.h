@@ -112,6 +112,7 @@ public:
 	double BLOCKING_PEEK_TIMEOUT;
 	bool PEEK_BATCHING_EMPTY_MSG;
 	double PEEK_BATCHING_EMPTY_MSG_INTERVAL;
+	bool TLOG_PEEK_REFERENCE_MESSAGE_BLOCKS; // Peek replies refer to in-memory messages instead of copying them
 	double POP_FROM_LOG_DELAY;
 	double TLOG_PULL_ASYNC_DATA_WARNING_TIMEOUT_SECS;
 
@@ -703,6 +704,10 @@ public:
 	double SAMPLE_EXPIRATION_TIME;
 	double SAMPLE_POLL_TIME;
 	int64_t RESOLVER_STATE_MEMORY_LIMIT;
+	std::string RESOLVER_CONFLICT_SET_ENGINE; // "skiplist", "packedbtree" or "art"
+	int RESOLVER_CONFLICT_SET_THREADS; // Threads a resolver checks conflicts on, each owning a partition of its keys
+	int RESOLVER_PARTITION_REBALANCE_WRITES; // Write ranges between checks of how evenly partitions are loaded
+	double RESOLVER_PARTITION_MAX_IMBALANCE; // Repartition when the busiest partition exceeds this multiple of the mean
 
 	// Backup Worker
 	double BACKUP_TIMEOUT; // master's reaction time for backup failure
@@ -1112,6 +1117,8 @@ public:
 	int PHYSICAL_SHARD_MOVE_LOG_SEVERITY;
 	int FETCH_SHARD_BUFFER_BYTE_LIMIT;
 	int FETCH_SHARD_UPDATES_BYTE_LIMIT;
+	bool STORAGE_BATCH_PTREE_SETS; // Insert runs of sets to increasing keys into the storage server's PTree together
+	std::string STORAGE_VERSIONED_MAP_TYPE; // "ptree" or "btree": the index of the storage server's in-memory versions
 
 	// Wait Failure
 	int MAX_OUTSTANDING_WAIT_FAILURE_REQUESTS;
@@ -1282,6 +1289,9 @@ public:
 	double REDWOOD_HISTOGRAM_INTERVAL;
 	bool REDWOOD_EVICT_UPDATED_PAGES; // Whether to prioritize eviction of updated pages from cache.
 	int REDWOOD_DECODECACHE_REUSE_MIN_HEIGHT; // Minimum height for which to keep and reuse page decode caches
+	bool REDWOOD_SEARCH_INDEX; // Build a search index for seeks in each reused page decode cache
+	double REDWOOD_PAGE_CACHE_WINDOW_FRACTION; // Fraction of the page cache given to the admission window, 1.0 is plain LRU
+	double REDWOOD_PAGE_CACHE_PROTECTED_FRACTION; // Fraction of the page cache outside the window kept for pages hit twice
 	int REDWOOD_NODE_MAX_UNBALANCE; // Maximum imbalance in a node before it should be rebuilt instead of updated
 
 	std::string REDWOOD_IO_PRIORITIES;
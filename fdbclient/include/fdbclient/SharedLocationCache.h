@@ -0,0 +1,140 @@
+/*
+ * SharedLocationCache.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_SHARED_LOCATION_CACHE_H
+#define FDBCLIENT_SHARED_LOCATION_CACHE_H
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fdbclient/ClientBooleanParams.h"
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/StorageServerInterface.h"
+#include "flow/FastRef.h"
+
+// Maps key ranges to the storage servers responsible for them, for every DatabaseContext in the process that is
+// connected to the same cluster. Each DatabaseContext still has its own location cache holding the LocationInfo objects
+// that load balancing works with; this cache sits behind those, so that an entry a DatabaseContext has never seen or
+// has evicted can be restored without a GetKeyServerLocationsRequest.
+//
+// It is laid out to stay small with millions of shards:
+//   - Shard boundaries are kept in sorted blocks of up to blockEntries keys. Within a block each key is stored as the
+//     length of the prefix it shares with the key before it and the bytes that follow.
+//   - Each boundary names its team with a 32 bit index. Teams are interned, as are the servers they are made of, so an
+//     interface is stored once however many shards it holds.
+//
+// Only used from the network thread.
+class SharedLocationCache : public ReferenceCounted<SharedLocationCache>, NonCopyable {
+public:
+	struct Server {
+		StorageServerInterface interf;
+		Optional<StorageServerInterface> tss;
+		Optional<Tag> tag;
+	};
+
+	struct Shard {
+		KeyRange range;
+		std::vector<Server> servers;
+	};
+
+	static constexpr int blockEntries = 64;
+
+	// Returns the cache for cluster, creating it if nothing in the process is using one
+	static Reference<SharedLocationCache> get(const std::string& cluster);
+
+	SharedLocationCache(std::string cluster, int64_t maxBytes);
+	~SharedLocationCache();
+
+	// Returns the shard containing key or, if isBackward, the shard containing the key before it
+	Optional<Shard> lookup(KeyRef key, Reverse isBackward = Reverse::False) const;
+
+	// Records that servers are responsible for keys
+	void insert(KeyRangeRef keys, const std::vector<Server>& servers);
+
+	// Forgets the servers of the shard containing key (or the key before it), or of every shard intersecting keys
+	void invalidate(KeyRef key, Reverse isBackward = Reverse::False);
+	void invalidate(KeyRangeRef keys);
+
+	int64_t getShardCount() const { return knownShards; }
+	int64_t getTeamCount() const { return teamIndex.size(); }
+	int64_t getServerCount() const { return serverIndex.size(); }
+	int64_t getBytes() const;
+
+private:
+	struct Block {
+		// Every boundary after the first, as varint shared prefix length, varint suffix length and suffix
+		std::string encoded;
+		// Team of each boundary in the block, starting with the one the block is keyed by
+		std::vector<uint32_t> teams;
+	};
+
+	struct Team {
+		std::vector<uint32_t> servers;
+		int64_t refs = 0;
+	};
+
+	struct ServerEntry {
+		Server server;
+		int64_t refs = 0;
+	};
+
+	using Entries = std::vector<std::pair<KeyRef, uint32_t>>;
+
+	std::string cluster;
+	int64_t maxBytes;
+
+	// Keyed by the first boundary in each block; the first block is always keyed by the empty key, so the blocks cover
+	// the whole key space. Team 0 stands for "not known".
+	std::map<Key, Block> blocks;
+	int64_t blockBytes = 0;
+	int64_t knownShards = 0;
+	Key evictCursor;
+
+	std::vector<Team> teams;
+	std::vector<uint32_t> freeTeams;
+	std::map<std::vector<UID>, uint32_t> teamIndex;
+
+	std::vector<ServerEntry> servers;
+	std::vector<uint32_t> freeServers;
+	std::unordered_map<UID, uint32_t> serverIndex;
+
+	static int64_t sizeOf(const Key& first, const Block& block);
+	static void decode(const Key& first, const Block& block, Arena& arena, Entries& out);
+	static Block encode(Entries::const_iterator begin, Entries::const_iterator end);
+
+	std::map<Key, Block>::const_iterator blockContaining(KeyRef key, Reverse isBackward) const;
+	KeyRef blockEnd(std::map<Key, Block>::const_iterator block) const;
+	KeyRange shardRange(KeyRef key, Reverse isBackward, uint32_t* team) const;
+
+	// Sets the team of every key in keys, rewriting the blocks that hold them
+	void assign(KeyRangeRef keys, uint32_t team);
+	void evict(KeyRangeRef keep);
+
+	uint32_t internTeam(const std::vector<Server>& members);
+	void refTeam(uint32_t team);
+	void unrefTeam(uint32_t team);
+	uint32_t internServer(const Server& server);
+	void unrefServer(uint32_t server);
+};
+
+#endif
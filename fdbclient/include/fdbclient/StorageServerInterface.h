@@ -125,6 +125,8 @@ struct StorageServerInterface {
 	RequestStream<struct AuditStorageRequest> auditStorage;
 	RequestStream<struct GetHotShardsRequest> getHotShards;
 	RequestStream<struct GetStorageCheckSumRequest> getCheckSum;
+	// Reads many keys at one version; each key is handled as by getValue
+	PublicRequestStream<struct GetValuesRequest> getValues;
 
 private:
 	bool acceptingRequests;
@@ -194,6 +196,7 @@ public:
 			getHotShards = RequestStream<struct GetHotShardsRequest>(getValue.getEndpoint().getAdjustedEndpoint(24));
 			getCheckSum =
 			    RequestStream<struct GetStorageCheckSumRequest>(getValue.getEndpoint().getAdjustedEndpoint(25));
+			getValues = PublicRequestStream<struct GetValuesRequest>(getValue.getEndpoint().getAdjustedEndpoint(26));
 		}
 	}
 	bool operator==(StorageServerInterface const& s) const { return uniqueID == s.uniqueID; }
@@ -226,6 +229,7 @@ public:
 		streams.push_back(auditStorage.getReceiver());
 		streams.push_back(getHotShards.getReceiver());
 		streams.push_back(getCheckSum.getReceiver());
+		streams.push_back(getValues.getReceiver(TaskPriority::LoadBalancedEndpoint));
 		FlowTransport::transport().addEndpoints(streams);
 	}
 };
@@ -309,6 +313,54 @@ struct GetValueRequest : TimedRequest {
 	}
 };
 
+struct GetValuesReply : public LoadBalancedReply {
+	constexpr static FileIdentifier file_identifier = 5619323;
+	Arena arena;
+	// The requested keys which have values, in the order they were requested
+	VectorRef<KeyValueRef, VecSerStrategy::String> data;
+	bool cached = false;
+
+	GetValuesReply() = default;
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, data, cached, arena);
+	}
+};
+
+struct GetValuesRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 2938447;
+	SpanContext spanContext;
+	Arena arena;
+	TenantInfo tenantInfo;
+	VectorRef<KeyRef> keys;
+	Version version;
+	Optional<TagSet> tags;
+	ReplyPromise<GetValuesReply> reply;
+	Optional<ReadOptions> options;
+	VersionVector ssLatestCommitVersions; // includes the latest commit versions, as known
+	                                      // to this client, of all storage replicas that
+	                                      // serve the given keys
+	GetValuesRequest() {}
+
+	bool verify() const { return tenantInfo.isAuthorized(); }
+
+	GetValuesRequest(SpanContext spanContext,
+	                 const TenantInfo& tenantInfo,
+	                 const Standalone<VectorRef<KeyRef>>& keys,
+	                 Version ver,
+	                 Optional<TagSet> tags,
+	                 Optional<ReadOptions> options,
+	                 VersionVector latestCommitVersions)
+	  : spanContext(spanContext), arena(keys.arena()), tenantInfo(tenantInfo), keys(keys), version(ver), tags(tags),
+	    options(options), ssLatestCommitVersions(latestCommitVersions) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, keys, version, tags, reply, spanContext, tenantInfo, options, ssLatestCommitVersions, arena);
+	}
+};
+
 struct WatchValueReply {
 	constexpr static FileIdentifier file_identifier = 3;
 
@@ -126,4 +126,22 @@ private:
 	std::vector<size_t> offsets;
 };
 
+// Element offsets into packed tuple data which the caller keeps alive. Unlike Tuple::unpack(), nothing is copied, so
+// it suits callers that only need the raw elements of a key or value they already hold.
+struct TupleView {
+	TupleView() {}
+
+	static TupleView unpack(StringRef const& str, bool exclude_incomplete = false);
+
+	// this is number of elements, not length of data
+	size_t size() const { return offsets.size(); }
+	// Return a Tuple encoded raw string.
+	StringRef subTupleRawString(size_t index) const;
+	Tuple::ElementType getType(size_t index) const;
+
+private:
+	StringRef data;
+	std::vector<size_t> offsets;
+};
+
 #endif /* FDBCLIENT_TUPLE_H */
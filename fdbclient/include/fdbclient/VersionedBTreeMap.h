@@ -0,0 +1,1021 @@
+/*
+ * VersionedBTreeMap.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_VERSIONEDBTREEMAP_H
+#define FDBCLIENT_VERSIONEDBTREEMAP_H
+#pragma once
+
+#include "fdbclient/VersionedMap.h"
+
+#include <algorithm>
+#include <variant>
+#include <vector>
+
+// VersionedBTreeMap has the interface of VersionedMap, but keeps its entries in a copy-on-write B+tree. A leaf holds
+// NodeBytes worth of keys and values in two sorted arrays, so a range read walks contiguous memory and the map needs
+// one allocation per few dozen keys instead of one or more per key.
+//
+// Every version has its own root. A node is created at the latest version and is modified in place only until a newer
+// version is created; after that a change copies the node and the path above it. Sets to neighbouring keys at one
+// version therefore share their copies.
+template <class K, class T, int NodeBytes = 512>
+class VersionedBTreeMap : NonCopyable {
+public:
+	// The value, and the version at which it was inserted
+	typedef std::pair<T, Version> Value;
+
+	struct Node;
+	typedef Reference<Node> Tree;
+
+	struct Node : NonCopyable {
+		// The version this node was created at. Only nodes created at the latest version are modified in place.
+		Version version;
+		mutable int32_t referenceCount;
+		int16_t count;
+		bool leaf;
+
+		Node(Version version, bool leaf) : version(version), referenceCount(1), count(0), leaf(leaf) {}
+
+		void addref() const { ++referenceCount; }
+		void delref() const;
+		bool isSoleOwner() const { return referenceCount == 1; }
+
+		// Moves the children only this node refers to into toFree, so that freeing a tree can be spread out
+		void releaseSoleOwnedChildren(std::vector<Tree>& toFree);
+	};
+
+	static constexpr int HeaderBytes = sizeof(Node);
+	static constexpr int LeafCapacity = std::max<int>(4, (NodeBytes - HeaderBytes) / (sizeof(K) + sizeof(Value)));
+	static constexpr int InternalCapacity = std::max<int>(4, (NodeBytes - HeaderBytes) / (sizeof(K) + sizeof(Tree)));
+	// Erasing merges or rebalances nodes with fewer entries than these
+	static constexpr int LeafMinimum = std::max<int>(1, LeafCapacity / 4);
+	static constexpr int InternalMinimum = std::max<int>(2, InternalCapacity / 4);
+	static constexpr int MaxHeight = 16;
+
+	struct Leaf : Node, FastAllocated<Leaf> {
+		K keys[LeafCapacity];
+		Value values[LeafCapacity];
+
+		explicit Leaf(Version version) : Node(version, true) {}
+	};
+
+	// children[i] holds the keys in [keys[i], keys[i + 1]). keys[0] is not used. Each separator keys[i] is a copy of the
+	// first key of children[i], so when K refers to memory it shares it with that leaf key, and any change that can
+	// change the first key of a child rewrites the separator. A separator never outlives the key it was copied from,
+	// and the storage server can free a key's memory once the key is erased and the versions before are forgotten.
+	struct Internal : Node, FastAllocated<Internal> {
+		K keys[InternalCapacity];
+		Tree children[InternalCapacity];
+
+		explicit Internal(Version version) : Node(version, false) {}
+	};
+
+	static Leaf* asLeaf(Node* n) { return static_cast<Leaf*>(n); }
+	static Leaf const* asLeaf(Node const* n) { return static_cast<Leaf const*>(n); }
+	static Internal* asInternal(Node* n) { return static_cast<Internal*>(n); }
+	static Internal const* asInternal(Node const* n) { return static_cast<Internal const*>(n); }
+
+	// Returns the index of the child of n which holds x
+	template <class X>
+	static int childIndex(Internal const* n, const X& x) {
+		return std::upper_bound(n->keys + 1, n->keys + n->count, x) - n->keys - 1;
+	}
+
+	template <class X>
+	static int leafLowerBound(Leaf const* n, const X& x) {
+		return std::lower_bound(n->keys, n->keys + n->count, x) - n->keys;
+	}
+
+	template <class X>
+	static int leafUpperBound(Leaf const* n, const X& x) {
+		return std::upper_bound(n->keys, n->keys + n->count, x) - n->keys;
+	}
+
+	Version oldestVersion, latestVersion;
+
+	// The root of every version, in increasing version order
+	std::deque<std::pair<Version, Tree>> roots;
+
+	struct rootsComparator {
+		bool operator()(const std::pair<Version, Tree>& value, const Version& key) { return (value.first < key); }
+		bool operator()(const Version& key, const std::pair<Version, Tree>& value) { return (key < value.first); }
+	};
+
+	Tree const& getRoot(Version v) const {
+		auto r = upper_bound(roots.begin(), roots.end(), v, rootsComparator());
+		--r;
+		return r->second;
+	}
+
+	struct iterator;
+
+	VersionedBTreeMap() : oldestVersion(0), latestVersion(0) { roots.emplace_back(0, Tree()); }
+	VersionedBTreeMap(VersionedBTreeMap&& v) noexcept
+	  : oldestVersion(v.oldestVersion), latestVersion(v.latestVersion), roots(std::move(v.roots)) {}
+	void operator=(VersionedBTreeMap&& v) noexcept {
+		oldestVersion = v.oldestVersion;
+		latestVersion = v.latestVersion;
+		roots = std::move(v.roots);
+	}
+
+	Version getLatestVersion() const { return latestVersion; }
+	Version getOldestVersion() const { return oldestVersion; }
+
+	void forgetVersionsBefore(Version newOldestVersion) {
+		ASSERT(newOldestVersion <= latestVersion);
+		auto r = upper_bound(roots.begin(), roots.end(), newOldestVersion, rootsComparator());
+		auto upper = r;
+		--r;
+		if (r->first != newOldestVersion) {
+			r = roots.emplace(upper, newOldestVersion, getRoot(newOldestVersion));
+		}
+
+		UNSTOPPABLE_ASSERT(r->first == newOldestVersion);
+		roots.erase(roots.begin(), r);
+		oldestVersion = newOldestVersion;
+	}
+
+	Future<Void> forgetVersionsBeforeAsync(Version newOldestVersion, TaskPriority taskID = TaskPriority::DefaultYield) {
+		ASSERT_LE(newOldestVersion, latestVersion);
+		auto r = upper_bound(roots.begin(), roots.end(), newOldestVersion, rootsComparator());
+		auto upper = r;
+		--r;
+		if (r->first != newOldestVersion) {
+			r = roots.emplace(upper, newOldestVersion, getRoot(newOldestVersion));
+		}
+
+		UNSTOPPABLE_ASSERT(r->first == newOldestVersion);
+
+		std::vector<Tree> toFree;
+		auto newBegin = r;
+		Tree* lastRoot = nullptr;
+		for (auto root = roots.begin(); root != newBegin; ++root) {
+			if (root->second) {
+				if (lastRoot != nullptr && root->second == *lastRoot) {
+					(*lastRoot).clear();
+				}
+				if (root->second->isSoleOwner()) {
+					toFree.push_back(root->second);
+				}
+				lastRoot = &root->second;
+			}
+		}
+
+		roots.erase(roots.begin(), newBegin);
+		oldestVersion = newOldestVersion;
+		return deferredNodeCleanupActor(toFree, taskID);
+	}
+
+	// Following sets and erases are into the given version, which may now be passed to at(). Must be called in
+	// monotonically increasing order.
+	void createNewVersion(Version version) {
+		if (version > latestVersion) {
+			latestVersion = version;
+			Tree r = getRoot(version);
+			roots.emplace_back(version, r);
+		} else
+			ASSERT(version == latestVersion);
+	}
+
+	// insert() and erase() invalidate atLatest() and all iterators into it
+	void insert(const K& k, const T& t) { insert(k, t, latestVersion); }
+	void insert(const K& k, const T& t, Version insertAt) {
+		Tree& root = roots.back().second;
+		if (!root) {
+			root = Tree(new Leaf(latestVersion));
+		}
+		K splitKey;
+		Tree sibling;
+		if (insertInto(root, k, Value(t, insertAt), splitKey, sibling)) {
+			Internal* r = new Internal(latestVersion);
+			r->count = 2;
+			r->keys[1] = splitKey;
+			r->children[0] = std::move(root);
+			r->children[1] = std::move(sibling);
+			root = Tree(r);
+		}
+	}
+	// Inserts the (key, value) pairs [begin, end) at the latest version. The keys must be in strictly increasing order.
+	// Neighbouring keys land in leaves already copied at the latest version, so a sorted run copies each node once.
+	template <class It>
+	void insertSorted(It begin, It end) {
+		for (; begin != end; ++begin) {
+			insert(begin->first, begin->second);
+		}
+	}
+	void erase(const K& begin, const K& end) {
+		Tree& root = roots.back().second;
+		if (!root || !(begin < end) || !hasKeyIn(root.getPtr(), begin, end)) {
+			return;
+		}
+		eraseRange(root, begin, end);
+		shrinkRoot(root);
+	}
+	void erase(const K& key) { // key must be present
+		Tree& root = roots.back().second;
+		if (!root || !atLatest().find(key)) {
+			return;
+		}
+		eraseKey(root, key);
+		shrinkRoot(root);
+	}
+	void erase(iterator const& item) { // iterator must be in latest version!
+		K key = item.key();
+		erase(key);
+	}
+
+	struct iterator {
+		explicit iterator(Tree const& root) : root(root), height(0) {}
+
+		K const& key() const { return leaf()->keys[path[height - 1].index]; }
+		// Returns the version at which the current item was inserted
+		Version insertVersion() const { return leaf()->values[path[height - 1].index].second; }
+		operator bool() const { return height != 0; }
+		bool operator<(const K& key) const { return this->key() < key; }
+
+		T const& operator*() const { return leaf()->values[path[height - 1].index].first; }
+		T const* operator->() const { return &leaf()->values[path[height - 1].index].first; }
+		void operator++() {
+			if (!height) {
+				if (root)
+					descend<false>(root.getPtr());
+				return;
+			}
+			Step& s = path[height - 1];
+			if (++s.index < s.node->count)
+				return;
+			while (--height > 0) {
+				Step& p = path[height - 1];
+				if (++p.index < p.node->count) {
+					descend<false>(asInternal(p.node)->children[p.index].getPtr());
+					return;
+				}
+			}
+		}
+		void operator--() {
+			if (!height) {
+				if (root)
+					descend<true>(root.getPtr());
+				return;
+			}
+			Step& s = path[height - 1];
+			if (s.index-- > 0)
+				return;
+			while (--height > 0) {
+				Step& p = path[height - 1];
+				if (p.index-- > 0) {
+					descend<true>(asInternal(p.node)->children[p.index].getPtr());
+					return;
+				}
+			}
+		}
+		bool operator==(const iterator& r) const {
+			if (height && r.height)
+				return leaf() == r.leaf() && path[height - 1].index == r.path[r.height - 1].index;
+			else
+				return height == r.height;
+		}
+		bool operator!=(const iterator& r) const { return !(*this == r); }
+
+	private:
+		friend class VersionedBTreeMap;
+
+		struct Step {
+			Node const* node;
+			int index;
+		};
+
+		Leaf const* leaf() const { return asLeaf(path[height - 1].node); }
+
+		void push(Node const* n, int index) {
+			ASSERT(height < MaxHeight);
+			path[height++] = Step{ n, index };
+		}
+
+		// Moves to the first (or last) entry under n
+		template <bool last>
+		void descend(Node const* n) {
+			while (!n->leaf) {
+				int i = last ? n->count - 1 : 0;
+				push(n, i);
+				n = asInternal(n)->children[i].getPtr();
+			}
+			push(n, last ? n->count - 1 : 0);
+		}
+
+		// Moves to the first entry not less than x (or, if upper, greater than x), or to end()
+		template <bool upper, class X>
+		void seek(const X& x) {
+			height = 0;
+			if (!root)
+				return;
+			Node const* n = root.getPtr();
+			while (!n->leaf) {
+				int i = childIndex(asInternal(n), x);
+				push(n, i);
+				n = asInternal(n)->children[i].getPtr();
+			}
+			int i = upper ? leafUpperBound(asLeaf(n), x) : leafLowerBound(asLeaf(n), x);
+			if (i < n->count) {
+				push(n, i);
+			} else {
+				push(n, n->count - 1);
+				++*this;
+			}
+		}
+
+		Tree root;
+		int height;
+		Step path[MaxHeight];
+	};
+
+	class ViewAtVersion {
+	public:
+		explicit ViewAtVersion(Tree const& root) : root(root) {}
+
+		iterator begin() const {
+			iterator i(root);
+			++i;
+			return i;
+		}
+		iterator end() const { return iterator(root); }
+
+		// Returns x such that key==*x, or end()
+		template <class X>
+		iterator find(const X& key) const {
+			iterator i(root);
+			i.template seek<false>(key);
+			if (i && i.key() == key)
+				return i;
+			else
+				return end();
+		}
+
+		// Returns the smallest x such that *x>=key, or end()
+		template <class X>
+		iterator lower_bound(const X& key) const {
+			iterator i(root);
+			i.template seek<false>(key);
+			return i;
+		}
+
+		// Returns the smallest x such that *x>key, or end()
+		template <class X>
+		iterator upper_bound(const X& key) const {
+			iterator i(root);
+			i.template seek<true>(key);
+			return i;
+		}
+
+		// Returns the largest x such that *x<=key, or end()
+		template <class X>
+		iterator lastLessOrEqual(const X& key) const {
+			iterator i = upper_bound(key);
+			--i;
+			return i;
+		}
+
+		// Returns the largest x such that *x<key, or end()
+		template <class X>
+		iterator lastLess(const X& key) const {
+			iterator i = lower_bound(key);
+			--i;
+			return i;
+		}
+
+		void validate() {
+			if (root) {
+				int leafDepth = -1;
+				validateNode(root.getPtr(), nullptr, nullptr, 0, leafDepth);
+			}
+		}
+
+	private:
+		Tree root;
+	};
+
+	ViewAtVersion at(Version v) const {
+		if (v == ::latestVersion) {
+			return atLatest();
+		}
+
+		return ViewAtVersion(getRoot(v));
+	}
+	ViewAtVersion atLatest() const { return ViewAtVersion(roots.back().second); }
+
+	bool isClearContaining(ViewAtVersion const& view, KeyRef key) {
+		auto i = view.lastLessOrEqual(key);
+		return i && i->isClearTo() && i->getEndKey() > key;
+	}
+
+private:
+	// Returns the node in slot, first copying it if it was created before the latest version
+	Node* mutate(Tree& slot) {
+		if (slot->version != latestVersion) {
+			slot = copy(slot.getPtr());
+		}
+		return slot.getPtr();
+	}
+
+	Tree copy(Node const* n) const {
+		if (n->leaf) {
+			Leaf const* from = asLeaf(n);
+			Leaf* to = new Leaf(latestVersion);
+			to->count = from->count;
+			std::copy(from->keys, from->keys + from->count, to->keys);
+			std::copy(from->values, from->values + from->count, to->values);
+			return Tree(to);
+		}
+		Internal const* from = asInternal(n);
+		Internal* to = new Internal(latestVersion);
+		to->count = from->count;
+		std::copy(from->keys, from->keys + from->count, to->keys);
+		std::copy(from->children, from->children + from->count, to->children);
+		return Tree(to);
+	}
+
+	// Inserts k under slot. If the node had to be split, returns true with the new right half in sibling and its
+	// smallest key in splitKey.
+	bool insertInto(Tree& slot, const K& k, const Value& v, K& splitKey, Tree& sibling) {
+		Node* n = mutate(slot);
+		if (n->leaf) {
+			Leaf* l = asLeaf(n);
+			int i = leafLowerBound(l, k);
+			if (i < l->count && l->keys[i] == k) {
+				// The new key replaces the old one, whose memory may be freed once this version is the oldest
+				l->keys[i] = k;
+				l->values[i] = v;
+				return false;
+			}
+			if (l->count < LeafCapacity) {
+				insertAt(l, i, k, v);
+				return false;
+			}
+			// A key appended to a full leaf starts a new one, so that keys inserted in order fill their leaves
+			int half = i == l->count ? l->count : l->count / 2;
+			Leaf* right = new Leaf(latestVersion);
+			moveTail(l, right, half);
+			if (i < half)
+				insertAt(l, i, k, v);
+			else
+				insertAt(right, i - half, k, v);
+			splitKey = right->keys[0];
+			sibling = Tree(right);
+			return true;
+		}
+
+		Internal* in = asInternal(n);
+		int i = childIndex(in, k);
+		K childSplitKey;
+		Tree childSibling;
+		bool split = insertInto(in->children[i], k, v, childSplitKey, childSibling);
+		if (i > 0 && !(in->keys[i] < k)) {
+			// k replaced the child's first key
+			in->keys[i] = k;
+		}
+		if (!split) {
+			return false;
+		}
+		if (in->count < InternalCapacity) {
+			insertAt(in, i + 1, childSplitKey, std::move(childSibling));
+			return false;
+		}
+		// keys[half] moves to right->keys[0], where it is the lower bound of the right half
+		int half = i + 1 == in->count ? in->count : in->count / 2;
+		Internal* right = new Internal(latestVersion);
+		moveTail(in, right, half);
+		if (i + 1 < half)
+			insertAt(in, i + 1, childSplitKey, std::move(childSibling));
+		else
+			insertAt(right, i + 1 - half, childSplitKey, std::move(childSibling));
+		splitKey = right->keys[0];
+		sibling = Tree(right);
+		return true;
+	}
+
+	static void insertAt(Leaf* l, int i, const K& k, const Value& v) {
+		std::move_backward(l->keys + i, l->keys + l->count, l->keys + l->count + 1);
+		std::move_backward(l->values + i, l->values + l->count, l->values + l->count + 1);
+		l->keys[i] = k;
+		l->values[i] = v;
+		++l->count;
+	}
+
+	static void insertAt(Internal* in, int i, const K& k, Tree&& child) {
+		std::move_backward(in->keys + i, in->keys + in->count, in->keys + in->count + 1);
+		std::move_backward(in->children + i, in->children + in->count, in->children + in->count + 1);
+		in->keys[i] = k;
+		in->children[i] = std::move(child);
+		++in->count;
+	}
+
+	// Moves the entries of from at and after index to the empty node to
+	static void moveTail(Leaf* from, Leaf* to, int index) {
+		std::move(from->keys + index, from->keys + from->count, to->keys);
+		std::move(from->values + index, from->values + from->count, to->values);
+		to->count = from->count - index;
+		from->count = index;
+	}
+
+	static void moveTail(Internal* from, Internal* to, int index) {
+		std::move(from->keys + index, from->keys + from->count, to->keys);
+		std::move(from->children + index, from->children + from->count, to->children);
+		to->count = from->count - index;
+		from->count = index;
+	}
+
+	static void removeAt(Internal* in, int begin, int end) {
+		std::move(in->keys + end, in->keys + in->count, in->keys + begin);
+		std::move(in->children + end, in->children + in->count, in->children + begin);
+		for (int i = in->count - (end - begin); i < in->count; i++) {
+			in->children[i].clear();
+		}
+		in->count -= end - begin;
+	}
+
+	static K const& firstKey(Node const* n) {
+		while (!n->leaf) {
+			n = asInternal(n)->children[0].getPtr();
+		}
+		return asLeaf(n)->keys[0];
+	}
+
+	// Copies each child's first key into its separator. Erasing can remove the key a separator was copied from, and
+	// fixUnderflow() moves separators between nodes, so it must only see separators which are still in the tree.
+	static void refreshSeparators(Internal* in) {
+		for (int i = 1; i < in->count; i++) {
+			in->keys[i] = firstKey(in->children[i].getPtr());
+		}
+	}
+
+	// Returns true if some key under n is in [begin, end)
+	static bool hasKeyIn(Node const* n, const K& begin, const K& end) {
+		if (n->leaf) {
+			int i = leafLowerBound(asLeaf(n), begin);
+			return i < n->count && asLeaf(n)->keys[i] < end;
+		}
+		Internal const* in = asInternal(n);
+		int i = childIndex(in, begin);
+		return hasKeyIn(in->children[i].getPtr(), begin, end) ||
+		       (i + 1 < in->count && firstKey(in->children[i + 1].getPtr()) < end);
+	}
+
+	// Erases [begin, end) under slot, which must hold at least one key in the range. Leaves the node empty, or
+	// possibly below its minimum size, for the caller to fix.
+	void eraseRange(Tree& slot, const K& begin, const K& end) {
+		Node* n = mutate(slot);
+		if (n->leaf) {
+			Leaf* l = asLeaf(n);
+			int i = leafLowerBound(l, begin);
+			int j = leafLowerBound(l, end);
+			std::move(l->keys + j, l->keys + l->count, l->keys + i);
+			std::move(l->values + j, l->values + l->count, l->values + i);
+			l->count -= j - i;
+			return;
+		}
+
+		Internal* in = asInternal(n);
+		int first = childIndex(in, begin);
+		int last = childIndex(in, end);
+		// The children strictly between first and last hold only keys in [begin, end)
+		if (last > first && hasKeyIn(in->children[last].getPtr(), begin, end)) {
+			eraseRange(in->children[last], begin, end);
+		}
+		if (last > first && in->children[last]->count == 0) {
+			removeAt(in, last, last + 1);
+		}
+		if (last > first + 1) {
+			removeAt(in, first + 1, last);
+		}
+		if (hasKeyIn(in->children[first].getPtr(), begin, end)) {
+			eraseRange(in->children[first], begin, end);
+		}
+		if (in->children[first]->count == 0) {
+			removeAt(in, first, first + 1);
+			first = std::max(0, first - 1);
+		}
+		refreshSeparators(in);
+		fixUnderflow(in, first);
+		fixUnderflow(in, first + 1);
+	}
+
+	void eraseKey(Tree& slot, const K& key) {
+		Node* n = mutate(slot);
+		if (n->leaf) {
+			Leaf* l = asLeaf(n);
+			int i = leafLowerBound(l, key);
+			std::move(l->keys + i + 1, l->keys + l->count, l->keys + i);
+			std::move(l->values + i + 1, l->values + l->count, l->values + i);
+			--l->count;
+			return;
+		}
+
+		Internal* in = asInternal(n);
+		int i = childIndex(in, key);
+		eraseKey(in->children[i], key);
+		if (in->children[i]->count == 0) {
+			removeAt(in, i, i + 1);
+			refreshSeparators(in);
+		} else {
+			refreshSeparators(in);
+			fixUnderflow(in, i);
+		}
+	}
+
+	// If the child i of in is below its minimum size, merges it with a neighbour or evens out their sizes
+	void fixUnderflow(Internal* in, int i) {
+		if (i >= in->count || in->count < 2) {
+			return;
+		}
+		Node const* child = in->children[i].getPtr();
+		if (child->count >= (child->leaf ? LeafMinimum : InternalMinimum)) {
+			return;
+		}
+		int left = i + 1 < in->count ? i : i - 1;
+		if (in->children[left]->leaf) {
+			rebalance<Leaf>(in, left);
+		} else {
+			rebalance<Internal>(in, left);
+		}
+	}
+
+	// Merges the children left and left + 1 of in if they fit in one node, and otherwise gives them the same size
+	template <class N>
+	void rebalance(Internal* in, int left) {
+		N* a = static_cast<N*>(mutate(in->children[left]));
+		N const* b = static_cast<N const*>(in->children[left + 1].getPtr());
+		K& separator = in->keys[left + 1];
+		if (a->count + b->count <= capacity(a)) {
+			appendHead(a, b, b->count, separator);
+			removeAt(in, left + 1, left + 2);
+			return;
+		}
+		N* c = static_cast<N*>(mutate(in->children[left + 1]));
+		int target = (a->count + c->count) / 2;
+		if (a->count < target) {
+			int moved = target - a->count;
+			appendHead(a, c, moved, separator);
+			separator = c->keys[moved];
+			removeHead(c, moved);
+		} else {
+			prependTail(c, a, target, separator);
+			separator = c->keys[0];
+		}
+	}
+
+	static int capacity(Leaf const*) { return LeafCapacity; }
+	static int capacity(Internal const*) { return InternalCapacity; }
+
+	// Appends the first count entries of b to a. separator is the lower bound of b.
+	static void appendHead(Leaf* a, Leaf const* b, int count, const K&) {
+		std::copy(b->keys, b->keys + count, a->keys + a->count);
+		std::copy(b->values, b->values + count, a->values + a->count);
+		a->count += count;
+	}
+
+	static void appendHead(Internal* a, Internal const* b, int count, const K& separator) {
+		std::copy(b->keys + 1, b->keys + count, a->keys + a->count + 1);
+		std::copy(b->children, b->children + count, a->children + a->count);
+		a->keys[a->count] = separator;
+		a->count += count;
+	}
+
+	static void removeHead(Leaf* n, int count) {
+		std::move(n->keys + count, n->keys + n->count, n->keys);
+		std::move(n->values + count, n->values + n->count, n->values);
+		n->count -= count;
+	}
+
+	static void removeHead(Internal* n, int count) { removeAt(n, 0, count); }
+
+	// Moves the entries of b at and after index to the front of c. separator is the lower bound of c.
+	static void prependTail(Leaf* c, Leaf* b, int index, const K&) {
+		int count = b->count - index;
+		std::move_backward(c->keys, c->keys + c->count, c->keys + c->count + count);
+		std::move_backward(c->values, c->values + c->count, c->values + c->count + count);
+		std::move(b->keys + index, b->keys + b->count, c->keys);
+		std::move(b->values + index, b->values + b->count, c->values);
+		c->count += count;
+		b->count = index;
+	}
+
+	static void prependTail(Internal* c, Internal* b, int index, const K& separator) {
+		int count = b->count - index;
+		std::move_backward(c->keys, c->keys + c->count, c->keys + c->count + count);
+		std::move_backward(c->children, c->children + c->count, c->children + c->count + count);
+		c->keys[count] = separator;
+		std::move(b->keys + index, b->keys + b->count, c->keys);
+		std::move(b->children + index, b->children + b->count, c->children);
+		c->count += count;
+		b->count = index;
+	}
+
+	// Removes empty roots and roots with a single child
+	void shrinkRoot(Tree& root) {
+		while (root) {
+			if (root->count == 0) {
+				root.clear();
+			} else if (!root->leaf && root->count == 1) {
+				Tree child = asInternal(root.getPtr())->children[0];
+				root = std::move(child);
+			} else {
+				break;
+			}
+		}
+	}
+
+	static void validateNode(Node const* n, K const* lower, K const* upper, int depth, int& leafDepth) {
+		ASSERT(n->count > 0);
+		if (n->leaf) {
+			if (leafDepth == -1)
+				leafDepth = depth;
+			ASSERT_EQ(depth, leafDepth);
+			Leaf const* l = asLeaf(n);
+			for (int i = 0; i < l->count; i++) {
+				ASSERT(i == 0 || l->keys[i - 1] < l->keys[i]);
+				ASSERT(!lower || !(l->keys[i] < *lower));
+				ASSERT(!upper || l->keys[i] < *upper);
+			}
+			return;
+		}
+		ASSERT(depth < MaxHeight);
+		Internal const* in = asInternal(n);
+		for (int i = 0; i < in->count; i++) {
+			ASSERT(i < 2 || in->keys[i - 1] < in->keys[i]);
+			if (i > 0) {
+				K const& first = firstKey(in->children[i].getPtr());
+				ASSERT(!(in->keys[i] < first) && !(first < in->keys[i]));
+			}
+			validateNode(in->children[i].getPtr(),
+			             i ? &in->keys[i] : lower,
+			             i + 1 < in->count ? &in->keys[i + 1] : upper,
+			             depth + 1,
+			             leafDepth);
+		}
+	}
+};
+
+template <class K, class T, int NodeBytes>
+void VersionedBTreeMap<K, T, NodeBytes>::Node::delref() const {
+	if (--referenceCount == 0) {
+		if (leaf)
+			delete static_cast<Leaf*>(const_cast<Node*>(this));
+		else
+			delete static_cast<Internal*>(const_cast<Node*>(this));
+	}
+}
+
+template <class K, class T, int NodeBytes>
+void VersionedBTreeMap<K, T, NodeBytes>::Node::releaseSoleOwnedChildren(std::vector<Tree>& toFree) {
+	if (!leaf) {
+		Internal* in = static_cast<Internal*>(this);
+		for (int i = 0; i < count; i++) {
+			if (in->children[i]->isSoleOwner()) {
+				toFree.push_back(std::move(in->children[i]));
+			}
+		}
+	}
+}
+
+enum class VersionedMapType { PTree, BTree };
+
+// The storage server's window of versions: a VersionedMap or a VersionedBTreeMap, chosen when constructed, behind the
+// interface they share.
+template <class K, class T>
+class SelectableVersionedMap : NonCopyable {
+public:
+	typedef VersionedMap<K, T> PTreeMap;
+	typedef VersionedBTreeMap<K, T> BTreeMap;
+
+	class iterator {
+	public:
+		iterator(typename PTreeMap::iterator const& i) : i(i) {}
+		iterator(typename BTreeMap::iterator const& i) : i(i) {}
+		iterator(typename PTreeMap::iterator&& i) : i(std::in_place_index<0>, std::move(i)) {}
+		iterator(typename BTreeMap::iterator&& i) : i(std::in_place_index<1>, std::move(i)) {}
+
+		K const& key() const {
+			return visit([](auto const& i) -> K const& { return i.key(); });
+		}
+		Version insertVersion() const {
+			return visit([](auto const& i) { return i.insertVersion(); });
+		}
+		operator bool() const {
+			return visit([](auto const& i) { return bool(i); });
+		}
+		bool operator<(const K& key) const { return this->key() < key; }
+
+		T const& operator*() const {
+			return visit([](auto const& i) -> T const& { return *i; });
+		}
+		T const* operator->() const { return &**this; }
+		void operator++() {
+			visit([](auto& i) { ++i; });
+		}
+		void operator--() {
+			visit([](auto& i) { --i; });
+		}
+		bool operator==(const iterator& r) const {
+			if (i.index() == 0)
+				return *std::get_if<0>(&i) == *std::get_if<0>(&r.i);
+			return *std::get_if<1>(&i) == *std::get_if<1>(&r.i);
+		}
+		bool operator!=(const iterator& r) const {
+			if (i.index() == 0)
+				return *std::get_if<0>(&i) != *std::get_if<0>(&r.i);
+			return *std::get_if<1>(&i) != *std::get_if<1>(&r.i);
+		}
+
+		// Calls f with the iterator of the map in use. A loop over many entries belongs inside f, where it runs on
+		// that iterator's own type instead of choosing between the two on every step.
+		template <class F>
+		decltype(auto) visit(F&& f) const {
+			if (i.index() == 0)
+				return f(*std::get_if<0>(&i));
+			return f(*std::get_if<1>(&i));
+		}
+		template <class F>
+		decltype(auto) visit(F&& f) {
+			if (i.index() == 0)
+				return f(*std::get_if<0>(&i));
+			return f(*std::get_if<1>(&i));
+		}
+
+	private:
+		friend class SelectableVersionedMap;
+
+		std::variant<typename PTreeMap::iterator, typename BTreeMap::iterator> i;
+	};
+
+	class ViewAtVersion {
+	public:
+		ViewAtVersion(typename PTreeMap::ViewAtVersion const& v) : v(v) {}
+		ViewAtVersion(typename BTreeMap::ViewAtVersion const& v) : v(v) {}
+
+		iterator begin() const {
+			return visit([](auto const& v) { return iterator(v.begin()); });
+		}
+		iterator end() const {
+			return visit([](auto const& v) { return iterator(v.end()); });
+		}
+		template <class X>
+		iterator find(const X& key) const {
+			return visit([&](auto const& v) { return iterator(v.find(key)); });
+		}
+		template <class X>
+		iterator lower_bound(const X& key) const {
+			return visit([&](auto const& v) { return iterator(v.lower_bound(key)); });
+		}
+		template <class X>
+		iterator upper_bound(const X& key) const {
+			return visit([&](auto const& v) { return iterator(v.upper_bound(key)); });
+		}
+		template <class X>
+		iterator lastLessOrEqual(const X& key) const {
+			return visit([&](auto const& v) { return iterator(v.lastLessOrEqual(key)); });
+		}
+		template <class X>
+		iterator lastLess(const X& key) const {
+			return visit([&](auto const& v) { return iterator(v.lastLess(key)); });
+		}
+		void validate() {
+			if (v.index() == 0)
+				std::get<0>(v).validate();
+			else
+				std::get<1>(v).validate();
+		}
+
+		// Calls f with the view of the map in use
+		template <class F>
+		decltype(auto) visit(F&& f) const {
+			if (v.index() == 0)
+				return f(*std::get_if<0>(&v));
+			return f(*std::get_if<1>(&v));
+		}
+
+	private:
+		std::variant<typename PTreeMap::ViewAtVersion, typename BTreeMap::ViewAtVersion> v;
+	};
+
+	explicit SelectableVersionedMap(VersionedMapType type = VersionedMapType::PTree) : type(type) {}
+
+	VersionedMapType getType() const { return type; }
+
+	Version getLatestVersion() const {
+		return type == VersionedMapType::BTree ? btree.getLatestVersion() : ptree.getLatestVersion();
+	}
+	Version getOldestVersion() const {
+		return type == VersionedMapType::BTree ? btree.getOldestVersion() : ptree.getOldestVersion();
+	}
+
+	void forgetVersionsBefore(Version newOldestVersion) {
+		if (type == VersionedMapType::BTree)
+			btree.forgetVersionsBefore(newOldestVersion);
+		else
+			ptree.forgetVersionsBefore(newOldestVersion);
+	}
+	Future<Void> forgetVersionsBeforeAsync(Version newOldestVersion, TaskPriority taskID = TaskPriority::DefaultYield) {
+		if (type == VersionedMapType::BTree)
+			return btree.forgetVersionsBeforeAsync(newOldestVersion, taskID);
+		return ptree.forgetVersionsBeforeAsync(newOldestVersion, taskID);
+	}
+	void createNewVersion(Version version) {
+		if (type == VersionedMapType::BTree)
+			btree.createNewVersion(version);
+		else
+			ptree.createNewVersion(version);
+	}
+
+	void insert(const K& k, const T& t) {
+		if (type == VersionedMapType::BTree)
+			btree.insert(k, t);
+		else
+			ptree.insert(k, t);
+	}
+	void insert(const K& k, const T& t, Version insertAt) {
+		if (type == VersionedMapType::BTree)
+			btree.insert(k, t, insertAt);
+		else
+			ptree.insert(k, t, insertAt);
+	}
+	template <class It>
+	void insertSorted(It begin, It end) {
+		if (type == VersionedMapType::BTree)
+			btree.insertSorted(begin, end);
+		else
+			ptree.insertSorted(begin, end);
+	}
+	void erase(const K& begin, const K& end) {
+		if (type == VersionedMapType::BTree)
+			btree.erase(begin, end);
+		else
+			ptree.erase(begin, end);
+	}
+	void erase(const K& key) {
+		if (type == VersionedMapType::BTree)
+			btree.erase(key);
+		else
+			ptree.erase(key);
+	}
+	void erase(iterator const& item) {
+		if (type == VersionedMapType::BTree)
+			btree.erase(std::get<1>(item.i));
+		else
+			ptree.erase(std::get<0>(item.i));
+	}
+
+	ViewAtVersion at(Version v) const {
+		if (type == VersionedMapType::BTree)
+			return btree.at(v);
+		return ptree.at(v);
+	}
+	ViewAtVersion atLatest() const {
+		if (type == VersionedMapType::BTree)
+			return btree.atLatest();
+		return ptree.atLatest();
+	}
+
+	bool isClearContaining(ViewAtVersion const& view, KeyRef key) {
+		auto i = view.lastLessOrEqual(key);
+		return i && i->isClearTo() && i->getEndKey() > key;
+	}
+
+	// Calls f with the map in use. Work made of many tree operations belongs inside f, where it runs on that map's own
+	// type, so that each mode pays for the choice once instead of on every operation.
+	template <class F>
+	decltype(auto) visit(F&& f) {
+		if (type == VersionedMapType::BTree)
+			return f(btree);
+		return f(ptree);
+	}
+	template <class F>
+	decltype(auto) visit(F&& f) const {
+		if (type == VersionedMapType::BTree)
+			return f(btree);
+		return f(ptree);
+	}
+
+private:
+	VersionedMapType type;
+	PTreeMap ptree;
+	BTreeMap btree;
+};
+
+#endif
@@ -50,5 +50,21 @@ Future<Void> deferredCleanupActor(std::vector<Tree> toFree, TaskPriority taskID
 	return Void();
 }
 
+// Like deferredCleanupActor, for trees whose nodes can move their children into toFree themselves
+ACTOR template <class Tree>
+Future<Void> deferredNodeCleanupActor(std::vector<Tree> toFree, TaskPriority taskID = TaskPriority::DefaultYield) {
+	state int freeCount = 0;
+	while (!toFree.empty()) {
+		Tree a = std::move(toFree.back());
+		toFree.pop_back();
+		a->releaseSoleOwnedChildren(toFree);
+
+		if (++freeCount % 100 == 0)
+			wait(yield(taskID));
+	}
+
+	return Void();
+}
+
 #include "flow/unactorcompiler.h"
 #endif
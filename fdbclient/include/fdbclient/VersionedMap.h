@@ -299,6 +299,105 @@ void insert(Reference<PTree<T>>& p, Version at, const T& x) {
 	}
 }
 
+// Returns a PTree of the entries [begin, end), which must be in strictly increasing order, built at version at in
+// linear time by keeping the right spine of the tree built so far.
+template <class T, class It>
+Reference<PTree<T>> buildSorted(It begin, It end, Version at) {
+	Reference<PTree<T>> root;
+	std::vector<PTree<T>*> spine;
+	for (; begin != end; ++begin) {
+		auto n = makeReference<PTree<T>>(*begin, at);
+		while (!spine.empty() && spine.back()->priority < n->priority) {
+			spine.pop_back();
+		}
+		// The spine nodes of lower priority become n's left subtree
+		if (spine.empty()) {
+			n->pointer[0] = std::move(root);
+			root = n;
+		} else {
+			n->pointer[0] = std::move(spine.back()->pointer[1]);
+			spine.back()->pointer[1] = n;
+		}
+		spine.push_back(n.getPtr());
+	}
+	return root;
+}
+
+// Splits p into the entries less than x, the entry equal to x if there is one, and the entries greater than x
+template <class T, class X>
+void split(Reference<PTree<T>> p,
+           const X& x,
+           Reference<PTree<T>>& left,
+           Reference<PTree<T>>& equal,
+           Reference<PTree<T>>& right,
+           Version at) {
+	if (!p) {
+		left = Reference<PTree<T>>();
+		equal = Reference<PTree<T>>();
+		right = Reference<PTree<T>>();
+		return;
+	}
+
+	int c = ::compare(p->data, x);
+	if (c < 0) {
+		left = p;
+		Reference<PTree<T>> lr = left->right(at);
+		split(lr, x, lr, equal, right, at);
+		left = update(left, 1, lr, at);
+	} else if (c > 0) {
+		right = p;
+		Reference<PTree<T>> rl = right->left(at);
+		split(rl, x, left, equal, rl, at);
+		right = update(right, 0, rl, at);
+	} else {
+		left = p->left(at);
+		right = p->right(at);
+		equal = p;
+	}
+}
+
+// Modifies p to point to a PTree with every entry of q inserted, where q is a PTree built at version at, for example
+// by buildSorted(). Each node of p is visited at most once, so inserting a run of neighbouring entries copies the
+// path above them once rather than once per entry.
+template <class T>
+void insertTree(Reference<PTree<T>>& p, Reference<PTree<T>> q, Version at) {
+	if (!q) {
+		return;
+	}
+	if (!p) {
+		p = q;
+		return;
+	}
+
+	Reference<PTree<T>> left, equal, right;
+	if (p->priority >= q->priority) {
+		split(q, p->data, left, equal, right, at);
+		if (equal) {
+			p = makeReference<PTree<T>>(p->priority, equal->data, p->left(at), p->right(at), at);
+		}
+		Reference<PTree<T>> child = p->left(at);
+		insertTree(child, left, at);
+		p = update(p, 0, child, at);
+		child = p->right(at);
+		insertTree(child, right, at);
+		p = update(p, 1, child, at);
+	} else {
+		// An entry of p equal to q's root is replaced by it
+		split(p, q->data, left, equal, right, at);
+		insertTree(left, q->left(at), at);
+		insertTree(right, q->right(at), at);
+		q = update(q, 0, left, at);
+		p = update(q, 1, right, at);
+	}
+}
+
+// Modifies p to point to a PTree with the entries [begin, end) inserted. The entries must be in strictly increasing
+// order.
+template <class T, class It>
+void insertSorted(Reference<PTree<T>>& p, Version at, It begin, It end) {
+	insertTree(p, buildSorted<T>(begin, end, at), at);
+}
+
 template <class T>
 Reference<PTree<T>> firstNode(const Reference<PTree<T>>& p, Version at) {
 	if (!p)
@@ -637,6 +736,7 @@ void compact(Reference<PTree<T>>& p, Version newOldestVersion) {
 
 class ValueOrClearToRef {
 public:
+	ValueOrClearToRef() : isClear(false) {}
 	static ValueOrClearToRef value(ValueRef const& v) { return ValueOrClearToRef(v, false); }
 	static ValueOrClearToRef clearTo(KeyRef const& k) { return ValueOrClearToRef(k, true); }
 
@@ -773,6 +873,27 @@ public:
 		PTreeImpl::insert(
 		    roots.back().second, latestVersion, MapPair<K, std::pair<T, Version>>(k, std::make_pair(t, insertAt)));
 	}
+	// Inserts the (key, value) pairs [begin, end) at the latest version in one pass over the tree. The keys must be in
+	// strictly increasing order.
+	template <class It>
+	void insertSorted(It begin, It end) {
+		struct Entry {
+			It it;
+			Version insertAt;
+			Entry& operator++() {
+				++it;
+				return *this;
+			}
+			bool operator!=(const Entry& r) const { return it != r.it; }
+			MapPair<K, std::pair<T, Version>> operator*() const {
+				return MapPair<K, std::pair<T, Version>>(it->first, std::make_pair(it->second, insertAt));
+			}
+		};
+		PTreeImpl::insertSorted(roots.back().second,
+		                        latestVersion,
+		                        Entry{ begin, latestVersion },
+		                        Entry{ end, latestVersion });
+	}
 	void erase(const K& begin, const K& end) { PTreeImpl::remove(roots.back().second, latestVersion, begin, end); }
 	void erase(const K& key) { // key must be present
 		PTreeImpl::remove(roots.back().second, latestVersion, key);
@@ -809,8 +930,8 @@ public:
 		operator bool() const { return finger.size() != 0; }
 		bool operator<(const K& key) const { return this->key() < key; }
 
-		T const& operator*() { return finger.back()->data.value.first; }
-		T const* operator->() { return &finger.back()->data.value.first; }
+		T const& operator*() const { return finger.back()->data.value.first; }
+		T const* operator->() const { return &finger.back()->data.value.first; }
 		void operator++() {
 			if (finger.size())
 				PTreeImpl::next(at, finger);
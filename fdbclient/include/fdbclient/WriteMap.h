@@ -136,6 +136,8 @@ public:
 
 	WriteMap(WriteMap&& r) noexcept
 	  : arena(r.arena), writeMapEmpty(r.writeMapEmpty), writes(std::move(r.writes)), ver(r.ver),
+	    pending(std::move(r.pending)), pendingEnd(r.pendingEnd), pendingCleared(r.pendingCleared),
+	    pendingConflict(r.pendingConflict), pendingUnreadable(r.pendingUnreadable),
 	    scratch_iterator(std::move(r.scratch_iterator)) {}
 
 	WriteMap& operator=(WriteMap&& r) noexcept;
@@ -155,7 +157,7 @@ public:
 		// regardless of the snapshot value) Every key will belong to exactly one segment.  The first segment begins at
 		// "" and the last segment ends at \xff\xff.
 
-		explicit iterator(WriteMap* map) : tree(map->writes), at(map->ver), offset(false) { ++map->ver; }
+		explicit iterator(WriteMap* map) : tree(map->flushedWrites()), at(map->ver), offset(false) { ++map->ver; }
 		// Creates an iterator which is conceptually before the beginning of map (you may essentially only call skip()
 		// or ++ on it) This iterator also represents a snapshot (will be unaffected by future writes)
 
@@ -219,7 +221,31 @@ private:
 	// incremented after reads, so that consecutive writes have the same version and those separated by
 	// reads have different versions.
 	Version ver;
-	iterator scratch_iterator; // Avoid unnecessary memory allocation in write operations
+	// Writes of new keys in increasing order that all fall in the same unmodified or cleared range, as a bulk load
+	// makes them, are appended here instead of being inserted into writes one at a time. flushPending() inserts them
+	// together, building them into a tree in linear time and copying the path above them once. Everything that reads
+	// or changes writes flushes first.
+	std::vector<WriteMapEntry> pending;
+	KeyRef pendingEnd; // The end of the range the pending writes fall in
+	bool pendingCleared = false; // Whether that range is cleared, conflicting and unreadable
+	bool pendingConflict = false;
+	bool pendingUnreadable = false;
+	// Avoid unnecessary memory allocation in write operations. Declared after pending, which constructing it flushes.
+	iterator scratch_iterator;
+
+	void flushPending();
+	Tree const& flushedWrites() {
+		flushPending();
+		return writes;
+	}
+	// The entry for a write to a key without one, in a range with the given properties
+	WriteMapEntry newEntry(KeyRef key,
+	                       MutationRef::Type operation,
+	                       ValueRef param,
+	                       bool addConflict,
+	                       bool cleared,
+	                       bool conflict,
+	                       bool unreadable);
 
 	void dump();
 
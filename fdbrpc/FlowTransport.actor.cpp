@@ -35,6 +35,7 @@
 
 #include <boost/unordered_map.hpp>
 
+#include "crc32/crc32c.h"
 #include "fdbrpc/TokenSign.h"
 #include "fdbrpc/fdbrpc.h"
 #include "fdbrpc/FailureMonitor.h"
@@ -72,6 +73,9 @@ Future<Void> g_currentDeliveryPeerDisconnect;
 } // namespace
 
 constexpr int PACKET_LEN_WIDTH = sizeof(uint32_t);
+// Set in the length of a packet whose checksum is a CRC32C rather than an XXH3 hash. Packet lengths are limited to
+// PACKET_LIMIT, so the bit is otherwise never set.
+constexpr uint32_t PACKET_LEN_CRC32C = 1u << 31;
 const uint64_t TOKEN_STREAM_FLAG = 1;
 
 FDB_BOOLEAN_PARAM(InReadSocket);
@@ -492,6 +496,7 @@ ACTOR Future<Void> pingLatencyLogger(TransportData* self) {
 				    .detail("Count", peer->pingLatencies.getPopulationSize())
 				    .detail("BytesReceived", peer->bytesReceived - peer->lastLoggedBytesReceived)
 				    .detail("BytesSent", peer->bytesSent - peer->lastLoggedBytesSent)
+				    .detail("WriteCalls", peer->writeCalls - peer->lastLoggedWriteCalls)
 				    .detail("TimeoutCount", peer->timeoutCount)
 				    .detail("ConnectOutgoingCount", peer->connectOutgoingCount)
 				    .detail("ConnectIncomingCount", peer->connectIncomingCount)
@@ -509,6 +514,7 @@ ACTOR Future<Void> pingLatencyLogger(TransportData* self) {
 				peer->connectLatencies.clear();
 				peer->lastLoggedBytesReceived = peer->bytesReceived;
 				peer->lastLoggedBytesSent = peer->bytesSent;
+				peer->lastLoggedWriteCalls = peer->writeCalls;
 				peer->timeoutCount = 0;
 				wait(delay(FLOW_KNOBS->PING_LOGGING_INTERVAL));
 			} else if (it == self->orderedAddresses.begin()) {
@@ -547,7 +553,9 @@ struct ConnectPacket {
 	// IP Address to reconnect to the originating process. Only one of these must be populated.
 	uint32_t canonicalRemoteIp4 = 0;
 
-	enum ConnectPacketFlags { FLAG_IPV6 = 1 };
+	// FLAG_CRC32C: the sender can verify packets checksummed with CRC32C. Older processes ignore it, and so are never
+	// sent such packets.
+	enum ConnectPacketFlags { FLAG_IPV6 = 1, FLAG_CRC32C = 2 };
 	uint16_t flags = 0;
 	uint8_t canonicalRemoteIp6[16] = { 0 };
 
@@ -707,7 +715,11 @@ ACTOR Future<Void> connectionWriter(Reference<Peer> self, Reference<IConnection>
 		loop {
 			lastWriteTime = now();
 
-			int sent = conn->write(self->unsent.getUnsent(), /* limit= */ FLOW_KNOBS->MAX_PACKET_SEND_BYTES);
+			// With a burst size set, the whole queue of packet buffers (up to that size) goes out in one write
+			int limit = FLOW_KNOBS->NETWORK_SEND_BURST_BYTES > 0 ? FLOW_KNOBS->NETWORK_SEND_BURST_BYTES
+			                                                     : FLOW_KNOBS->MAX_PACKET_SEND_BYTES;
+			int sent = conn->write(self->unsent.getUnsent(), limit);
+			++self->writeCalls;
 			if (sent) {
 				self->bytesSent += sent;
 				self->transport->bytesSent += sent;
@@ -883,6 +895,7 @@ ACTOR Future<Void> connectionKeeper(Reference<Peer> self,
 			}
 		} catch (Error& e) {
 			self->connected = false;
+			self->crc32cChecksum = false;
 			delayedHealthUpdateF.cancel();
 			if (now() - self->lastConnectTime > FLOW_KNOBS->RECONNECTION_RESET_TIME) {
 				self->reconnectionDelay = FLOW_KNOBS->INITIAL_RECONNECTION_TIME;
@@ -1009,11 +1022,11 @@ ACTOR Future<Void> connectionKeeper(Reference<Peer> self,
 }
 
 Peer::Peer(TransportData* transport, NetworkAddress const& destination)
-  : transport(transport), destination(destination), compatible(true), connected(false), outgoingConnectionIdle(true),
-    lastConnectTime(0.0), reconnectionDelay(FLOW_KNOBS->INITIAL_RECONNECTION_TIME), peerReferences(-1),
-    bytesReceived(0), bytesSent(0), lastDataPacketSentTime(now()), outstandingReplies(0),
-    pingLatencies(destination.isPublic() ? FLOW_KNOBS->PING_SKETCH_ACCURACY : 0.1), lastLoggedTime(0.0),
-    lastLoggedBytesReceived(0), lastLoggedBytesSent(0), timeoutCount(0),
+  : transport(transport), destination(destination), compatible(true), crc32cChecksum(false), connected(false),
+    outgoingConnectionIdle(true), lastConnectTime(0.0), reconnectionDelay(FLOW_KNOBS->INITIAL_RECONNECTION_TIME),
+    peerReferences(-1), bytesReceived(0), bytesSent(0), writeCalls(0), lastDataPacketSentTime(now()),
+    outstandingReplies(0), pingLatencies(destination.isPublic() ? FLOW_KNOBS->PING_SKETCH_ACCURACY : 0.1),
+    lastLoggedTime(0.0), lastLoggedBytesReceived(0), lastLoggedBytesSent(0), lastLoggedWriteCalls(0), timeoutCount(0),
     protocolVersion(Reference<AsyncVar<Optional<ProtocolVersion>>>(new AsyncVar<Optional<ProtocolVersion>>())),
     connectOutgoingCount(0), connectIncomingCount(0), connectFailedCount(0),
     connectLatencies(destination.isPublic() ? FLOW_KNOBS->PING_SKETCH_ACCURACY : 0.1) {
@@ -1047,6 +1060,7 @@ void Peer::prependConnectPacket() {
 	pkt.protocolVersion = g_network->protocolVersion();
 	pkt.protocolVersion.addObjectSerializerFlag();
 	pkt.connectionId = transport->transportId;
+	pkt.flags |= ConnectPacket::FLAG_CRC32C;
 
 	PacketBuffer *pb_first = PacketBuffer::create(), *pb_end = nullptr;
 	PacketWriter wr(pb_first, nullptr, Unversioned());
@@ -1064,6 +1078,42 @@ void Peer::prependConnectPacket() {
 	unsent.prependWriteBuffer(pb_first, pb_end);
 }
 
+// Reads the packet lengths of the back to back packets starting at the beginning of first, and checks that none of
+// them is checksummed with CRC32C. Reliable packets are resent as they were framed, to a peer which may reconnect
+// without the capability, so they must always carry XXH3 checksums.
+static void checkResentPacketChecksums(PacketBuffer* first, bool checksumEnabled) {
+	const int checksumSize = checksumEnabled ? sizeof(XXH64_hash_t) : 0;
+	PacketBuffer* pb = first;
+	int offset = 0;
+	while (pb) {
+		uint32_t packetLen = 0;
+		for (int i = 0; i < PACKET_LEN_WIDTH; i++) {
+			while (pb && offset == pb->bytes_written) {
+				pb = pb->nextPacketBuffer();
+				offset = 0;
+			}
+			ASSERT(pb || i == 0);
+			if (!pb) {
+				return;
+			}
+			reinterpret_cast<uint8_t*>(&packetLen)[i] = pb->data()[offset++];
+		}
+		ASSERT(!(packetLen & PACKET_LEN_CRC32C));
+
+		int64_t skip = int64_t(packetLen) + checksumSize;
+		while (skip > 0) {
+			ASSERT(pb);
+			const int64_t n = std::min<int64_t>(skip, pb->bytes_written - offset);
+			skip -= n;
+			offset += n;
+			if (skip > 0) {
+				pb = pb->nextPacketBuffer();
+				offset = 0;
+			}
+		}
+	}
+}
+
 void Peer::discardUnreliablePackets() {
 	// Throw away the current unsent list, dropping the reference count on each PacketBuffer that accounts for presence
 	// in the unsent list
@@ -1071,9 +1121,12 @@ void Peer::discardUnreliablePackets() {
 
 	// If there are reliable packets, compact reliable packets into a new unsent range
 	if (!reliable.empty()) {
-		PacketBuffer* pb = unsent.getWriteBuffer();
-		pb = reliable.compact(pb, nullptr);
+		PacketBuffer* first = unsent.getWriteBuffer();
+		PacketBuffer* pb = reliable.compact(first, nullptr);
 		unsent.setWriteBuffer(pb);
+		if (g_network->isSimulated()) {
+			checkResentPacketChecksums(first, !destination.isTLS());
+		}
 	}
 }
 
@@ -1248,6 +1301,10 @@ static void scanPackets(TransportData* transport,
 			break;
 		packetLen = *(uint32_t*)p;
 		p += PACKET_LEN_WIDTH;
+		const bool crc32c = checksumEnabled && (packetLen & PACKET_LEN_CRC32C);
+		if (crc32c) {
+			packetLen &= ~PACKET_LEN_CRC32C;
+		}
 
 		// Read checksum if present
 		if (checksumEnabled) {
@@ -1305,7 +1362,7 @@ static void scanPackets(TransportData* transport,
 				}
 			}
 
-			XXH64_hash_t calculatedChecksum = XXH3_64bits(p, packetLen);
+			XXH64_hash_t calculatedChecksum = crc32c ? crc32c_append(0, p, packetLen) : XXH3_64bits(p, packetLen);
 			if (calculatedChecksum != packetChecksum) {
 				if (isBuggifyEnabled) {
 					TraceEvent(SevInfo, "ChecksumMismatchExp")
@@ -1380,7 +1437,10 @@ static int getNewBufferSize(const uint8_t* begin,
 	if (len < PACKET_LEN_WIDTH) {
 		return FLOW_KNOBS->MIN_PACKET_BUFFER_BYTES;
 	}
-	const uint32_t packetLen = *(uint32_t*)begin;
+	uint32_t packetLen = *(uint32_t*)begin;
+	if (!peerAddress.isTLS()) {
+		packetLen &= ~PACKET_LEN_CRC32C;
+	}
 	if (packetLen > FLOW_KNOBS->PACKET_LIMIT) {
 		TraceEvent(SevError, "PacketLimitExceeded")
 		    .detail("FromPeer", peerAddress.toString())
@@ -1531,6 +1591,7 @@ ACTOR static Future<Void> connectionReader(TransportData* transport,
 							    .detail("PeerAddress",
 							            NetworkAddress(pkt.canonicalRemoteIp(), pkt.canonicalRemotePort));
 							peer->compatible = compatible;
+							peer->crc32cChecksum = compatible && (pkt.flags & ConnectPacket::FLAG_CRC32C);
 							if (!compatible) {
 								peer->transport->numIncompatibleConnections++;
 								incompatiblePeerCounted = true;
@@ -1548,6 +1609,7 @@ ACTOR static Future<Void> connectionReader(TransportData* transport,
 							}
 							peer = transport->getOrOpenPeer(peerAddress, false);
 							peer->compatible = compatible;
+							peer->crc32cChecksum = compatible && (pkt.flags & ConnectPacket::FLAG_CRC32C);
 							if (!compatible) {
 								peer->transport->numIncompatibleConnections++;
 								incompatiblePeerCounted = true;
@@ -1929,6 +1991,9 @@ static ReliablePacket* sendPacket(TransportData* self,
 	}
 
 	bool firstUnsent = peer->unsent.empty();
+	// Reliable packets are resent byte for byte after a reconnect, possibly to a peer that no longer accepts CRC32C (for
+	// example an older process restarted at the same address), so they always use XXH3
+	const bool crc32c = !reliable && checksumEnabled && FLOW_KNOBS->PACKET_CHECKSUM_CRC32C && peer->crc32cChecksum;
 
 	PacketBuffer* pb = peer->unsent.getWriteBuffer();
 	ReliablePacket* rp = reliable ? new ReliablePacket : 0;
@@ -1950,6 +2015,8 @@ static ReliablePacket* sendPacket(TransportData* self,
 	// Checksum will be calculated with buffer API if contiguous, else using stream API.  Mode is tracked here.
 	bool checksumStream = false;
 	XXH64_hash_t checksum;
+	// CRC32C needs no state beyond the value so far
+	uint32_t crc = 0;
 
 	int packetInfoSize = PACKET_LEN_WIDTH;
 	if (checksumEnabled) {
@@ -1976,9 +2043,10 @@ static ReliablePacket* sendPacket(TransportData* self,
 			uint32_t processLength =
 			    std::min(checksumUnprocessedLength, (uint32_t)(checksumPb->bytes_written - prevBytesWritten));
 
-			// If not in checksum stream mode yet
-			if (!checksumStream) {
-				// If there is nothing left to process then calculate checksum directly
+			if (crc32c) {
+				crc = crc32c_append(crc, checksumPb->data() + prevBytesWritten, processLength);
+			} else if (!checksumStream) {
+				// Not in checksum stream mode yet. If there is nothing left to process then calculate checksum directly
 				if (processLength == checksumUnprocessedLength) {
 					checksum = XXH3_64bits(checksumPb->data() + prevBytesWritten, processLength);
 				} else {
@@ -2003,14 +2071,17 @@ static ReliablePacket* sendPacket(TransportData* self,
 			prevBytesWritten = 0;
 		}
 
-		// If in checksum stream mode, get the final checksum
-		if (checksumStream) {
+		// CRC32C is complete as is. If in checksum stream mode, get the final checksum
+		if (crc32c) {
+			checksum = crc;
+		} else if (checksumStream) {
 			checksum = XXH3_64bits_digest(&checksumState);
 		}
 	}
 
 	// Write packet length and checksum into packet buffer
-	packetInfoBuffer.write(&len, sizeof(len));
+	uint32_t packetLen = crc32c ? len | PACKET_LEN_CRC32C : len;
+	packetInfoBuffer.write(&packetLen, sizeof(packetLen));
 	if (checksumEnabled) {
 		packetInfoBuffer.write(&checksum, sizeof(checksum), sizeof(len));
 	}
@@ -41,6 +41,7 @@
 #include "fdbrpc/AsyncFileEncrypted.h"
 #include "fdbrpc/AsyncFileWinASIO.actor.h"
 #include "fdbrpc/AsyncFileKAIO.actor.h"
+#include "fdbrpc/AsyncFileIOUring.actor.h"
 #include "flow/AsioReactor.h"
 #include "flow/Platform.h"
 #include "fdbrpc/AsyncFileWriteChecker.actor.h"
@@ -70,11 +71,16 @@ Future<Reference<class IAsyncFile>> Net2FileSystem::open(const std::string& file
 	// don’t properly support kernel async I/O without O_DIRECT or AIO at all. In such
 	// cases, DISABLE_POSIX_KERNEL_AIO knob can be enabled to fallback to EIO instead
 	// of Kernel AIO. And EIO_USE_ODIRECT can be used to turn on or off O_DIRECT within
-	// EIO.
+	// EIO. USE_IO_URING_FOR_FILES replaces Kernel AIO with io_uring where it is available.
 	if ((flags & IAsyncFile::OPEN_UNBUFFERED) && !(flags & IAsyncFile::OPEN_NO_AIO) &&
-	    !FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO)
-		f = AsyncFileKAIO::open(filename, flags, mode, nullptr);
-	else
+	    !FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO) {
+#ifdef WITH_LIBURING
+		if (AsyncFileIOUring::isEnabled())
+			f = AsyncFileIOUring::open(filename, flags, mode, nullptr);
+		else
+#endif
+			f = AsyncFileKAIO::open(filename, flags, mode, nullptr);
+	} else
 #endif
 		f = Net2AsyncFile::open(
 		    filename,
@@ -117,8 +123,17 @@ void Net2FileSystem::newFileSystem(double ioTimeout, const std::string& fileSyst
 Net2FileSystem::Net2FileSystem(double ioTimeout, const std::string& fileSystemPath) {
 	Net2AsyncFile::init();
 #ifdef __linux__
-	if (!FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO)
-		AsyncFileKAIO::init(Reference<IEventFD>(N2::ASIOReactor::getEventFD()), ioTimeout);
+	if (!FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO) {
+		// Only one of io_uring and Kernel AIO can own the network's eventfd and run cycle hook
+		Reference<IEventFD> ev(N2::ASIOReactor::getEventFD());
+		bool useIOUring = false;
+#ifdef WITH_LIBURING
+		if (FLOW_KNOBS->USE_IO_URING_FOR_FILES)
+			useIOUring = AsyncFileIOUring::init(ev, ioTimeout);
+#endif
+		if (!useIOUring)
+			AsyncFileKAIO::init(ev, ioTimeout);
+	}
 
 	if (fileSystemPath.empty()) {
 		checkFileSystem = false;
@@ -0,0 +1,720 @@
+/*
+ * AsyncFileIOUring.actor.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "flow/config.h"
+#if defined(__linux__) && defined(WITH_LIBURING)
+
+// When actually compiled (NO_INTELLISENSE), include the generated version of this file.  In intellisense use the source
+// version.
+#if defined(NO_INTELLISENSE) && !defined(FLOW_ASYNCFILEIOURING_ACTOR_G_H)
+#define FLOW_ASYNCFILEIOURING_ACTOR_G_H
+#include "fdbrpc/AsyncFileIOUring.actor.g.h"
+#elif !defined(FLOW_ASYNCFILEIOURING_ACTOR_H)
+#define FLOW_ASYNCFILEIOURING_ACTOR_H
+
+#include "flow/IAsyncFile.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <liburing.h>
+#include "flow/Knobs.h"
+#include "fdbrpc/Stats.h"
+#include "flow/UnitTest.h"
+#include "flow/genericactors.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// An IAsyncFile for unbuffered (O_DIRECT) files that submits its I/O through one io_uring shared by the process.
+//
+// It takes the place of AsyncFileKAIO when USE_IO_URING_FOR_FILES is set and the kernel supports io_uring:
+//   - Requests are queued by priority and submitted in one batch per run loop iteration (enRunCycleFunc), so a burst
+//     of reads costs one io_uring_enter() instead of one io_submit() per batch plus an fdatasync thread handoff.
+//   - Completions are signalled on the network's eventfd, registered with the ring, and reaped by a poll actor.
+//   - Files are registered in a fixed file table when a slot is free, saving the kernel an fget/fput per request.
+//   - With IO_URING_SQPOLL a kernel thread polls the submission queue, so submission usually needs no syscall.
+//   - sync() is an IORING_OP_FSYNC with IORING_FSYNC_DATASYNC rather than an fdatasync() on an EIO thread.
+class AsyncFileIOUring final : public IAsyncFile, public ReferenceCounted<AsyncFileIOUring> {
+public:
+	virtual StringRef getClassName() override { return "AsyncFileIOUring"_sr; }
+
+	struct AsyncFileIOUringMetrics {
+		LatencySample readLatencySample = { "AsyncFileIOUringReadLatency",
+			                                UID(),
+			                                FLOW_KNOBS->KAIO_LATENCY_LOGGING_INTERVAL,
+			                                FLOW_KNOBS->KAIO_LATENCY_SKETCH_ACCURACY };
+		LatencySample writeLatencySample = { "AsyncFileIOUringWriteLatency",
+			                                 UID(),
+			                                 FLOW_KNOBS->KAIO_LATENCY_LOGGING_INTERVAL,
+			                                 FLOW_KNOBS->KAIO_LATENCY_SKETCH_ACCURACY };
+		LatencySample syncLatencySample = { "AsyncFileIOUringSyncLatency",
+			                                UID(),
+			                                FLOW_KNOBS->KAIO_LATENCY_LOGGING_INTERVAL,
+			                                FLOW_KNOBS->KAIO_LATENCY_SKETCH_ACCURACY };
+	};
+
+	static AsyncFileIOUringMetrics& getMetrics() {
+		static AsyncFileIOUringMetrics metrics;
+		return metrics;
+	}
+
+	// True once init() has set up the ring, in which case open() may be used
+	static bool isEnabled() { return ctx.initialized; }
+
+	static Future<Reference<IAsyncFile>> open(std::string filename, int flags, int mode, void* ignore) {
+		ASSERT(isEnabled());
+		ASSERT(flags & OPEN_UNBUFFERED);
+
+		if (flags & OPEN_LOCK)
+			mode |= 02000; // Enable mandatory locking for this file if it is supported by the filesystem
+
+		std::string open_filename = filename;
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE) {
+			ASSERT((flags & OPEN_CREATE) && (flags & OPEN_READWRITE) && !(flags & OPEN_EXCLUSIVE));
+			open_filename = filename + ".part";
+		}
+
+		int fd = ::open(open_filename.c_str(), openFlags(flags), mode);
+		if (fd < 0) {
+			Error e = errno == ENOENT ? file_not_found() : io_error();
+			TraceEvent("AsyncFileIOUringOpenFailed")
+			    .error(e)
+			    .detail("Filename", filename)
+			    .detailf("Flags", "%x", flags)
+			    .detailf("OSFlags", "%x", openFlags(flags))
+			    .detailf("Mode", "0%o", mode)
+			    .GetLastError();
+			return e;
+		}
+
+		Reference<AsyncFileIOUring> r(new AsyncFileIOUring(fd, flags, filename));
+		TraceEvent("AsyncFileIOUringOpen")
+		    .detail("Filename", filename)
+		    .detail("Flags", flags)
+		    .detail("Mode", mode)
+		    .detail("Fd", fd)
+		    .detail("FixedFileSlot", r->fixedSlot);
+
+		if (flags & OPEN_LOCK) {
+			// Acquire a "write" lock for the entire file
+			flock lockDesc;
+			lockDesc.l_type = F_WRLCK;
+			lockDesc.l_whence = SEEK_SET;
+			lockDesc.l_start = 0;
+			lockDesc.l_len = 0;
+			lockDesc.l_pid = 0;
+			if (fcntl(fd, F_SETLK, &lockDesc) == -1) {
+				TraceEvent(SevWarn, "UnableToLockFile").detail("Filename", filename).GetLastError();
+				return lock_file_failure();
+			}
+		}
+
+		struct stat buf;
+		if (fstat(fd, &buf)) {
+			TraceEvent("AsyncFileIOUringFStatError").detail("Fd", fd).detail("Filename", filename).GetLastError();
+			return io_error();
+		}
+
+		r->lastFileSize = r->nextFileSize = buf.st_size;
+		return Reference<IAsyncFile>(std::move(r));
+	}
+
+	// Sets up the process-wide ring and registers it with the run loop. Returns false, leaving the caller to fall back
+	// to kernel AIO, if the kernel does not support io_uring.
+	static bool init(Reference<IEventFD> ev, double ioTimeout) {
+		ASSERT(!ctx.initialized);
+
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		if (FLOW_KNOBS->IO_URING_SQPOLL) {
+			params.flags |= IORING_SETUP_SQPOLL;
+			params.sq_thread_idle = FLOW_KNOBS->IO_URING_SQPOLL_IDLE_MS;
+		}
+
+		int rc = io_uring_queue_init_params(FLOW_KNOBS->IO_URING_QUEUE_DEPTH, &ctx.ring, &params);
+		if (rc < 0 && FLOW_KNOBS->IO_URING_SQPOLL) {
+			// SQPOLL needs CAP_SYS_NICE on older kernels, so retry without it
+			TraceEvent(SevWarnAlways, "AsyncFileIOUringSQPollUnavailable").detail("Error", strerror(-rc));
+			memset(&params, 0, sizeof(params));
+			rc = io_uring_queue_init_params(FLOW_KNOBS->IO_URING_QUEUE_DEPTH, &ctx.ring, &params);
+		}
+		if (rc < 0) {
+			TraceEvent(SevWarnAlways, "AsyncFileIOUringSetupError").detail("Error", strerror(-rc));
+			return false;
+		}
+		ctx.sqPoll = params.flags & IORING_SETUP_SQPOLL;
+		ctx.queueDepth = params.sq_entries;
+
+		ctx.evfd = ev->getFD();
+		rc = io_uring_register_eventfd(&ctx.ring, ctx.evfd);
+		if (rc < 0) {
+			TraceEvent(SevWarnAlways, "AsyncFileIOUringRegisterEventFDError").detail("Error", strerror(-rc));
+			io_uring_queue_exit(&ctx.ring);
+			return false;
+		}
+
+		// A table of empty slots which files are swapped into as they are opened
+		if (FLOW_KNOBS->IO_URING_FIXED_FILES > 0) {
+			std::vector<int> empty(FLOW_KNOBS->IO_URING_FIXED_FILES, -1);
+			rc = io_uring_register_files(&ctx.ring, empty.data(), empty.size());
+			if (rc < 0) {
+				TraceEvent(SevWarn, "AsyncFileIOUringRegisterFilesError").detail("Error", strerror(-rc));
+			} else {
+				for (int i = empty.size() - 1; i >= 0; --i) {
+					ctx.freeFixedSlots.push_back(i);
+				}
+			}
+		}
+
+		if (!g_network->isSimulated()) {
+			ctx.countSubmit.init("AsyncFile.CountIOUringSubmit"_sr);
+			ctx.countSubmitSyscall.init("AsyncFile.CountIOUringSubmitSyscall"_sr);
+			ctx.countCollect.init("AsyncFile.CountIOUringCollect"_sr);
+			ctx.countFixedFileOps.init("AsyncFile.CountIOUringFixedFileOps"_sr);
+		}
+
+		ctx.initialized = true;
+		setTimeout(ioTimeout);
+		poll(ev);
+
+		g_network->setGlobal(INetwork::enRunCycleFunc, (flowGlobalType)&AsyncFileIOUring::launch);
+
+		TraceEvent("AsyncFileIOUringInit")
+		    .detail("QueueDepth", ctx.queueDepth)
+		    .detail("SQPoll", ctx.sqPoll)
+		    .detail("FixedFiles", ctx.freeFixedSlots.size());
+		return true;
+	}
+
+	static void setTimeout(double ioTimeout) { ctx.setIOTimeout(ioTimeout); }
+
+	void addref() override { ReferenceCounted<AsyncFileIOUring>::addref(); }
+	void delref() override { ReferenceCounted<AsyncFileIOUring>::delref(); }
+
+	Future<int> read(void* data, int length, int64_t offset) override {
+		++countFileLogicalReads;
+		++countLogicalReads;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		IOBlock* io = new IOBlock(IORING_OP_READ, this);
+		io->buf = data;
+		io->nbytes = length;
+		io->offset = offset;
+
+		enqueue(io);
+		return io->result.getFuture();
+	}
+
+	Future<Void> write(void const* data, int length, int64_t offset) override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		IOBlock* io = new IOBlock(IORING_OP_WRITE, this);
+		io->buf = (void*)data;
+		io->nbytes = length;
+		io->offset = offset;
+
+		nextFileSize = std::max(nextFileSize, offset + length);
+
+		enqueue(io);
+		return success(io->result.getFuture());
+	}
+
+#ifndef FALLOC_FL_ZERO_RANGE
+#define FALLOC_FL_ZERO_RANGE 0x10
+#endif
+	Future<Void> zeroRange(int64_t offset, int64_t length) override {
+		bool success = false;
+		if (ctx.fallocateZeroSupported) {
+			int rc = fallocate(fd, FALLOC_FL_ZERO_RANGE, offset, length);
+			if (rc == EOPNOTSUPP) {
+				ctx.fallocateZeroSupported = false;
+			}
+			if (rc == 0) {
+				success = true;
+			}
+		}
+		return success ? Void() : IAsyncFile::zeroRange(offset, length);
+	}
+
+	Future<Void> truncate(int64_t size) override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		int result = -1;
+		bool completed = false;
+		if (ctx.fallocateSupported && size >= lastFileSize) {
+			result = fallocate(fd, 0, 0, size);
+			if (result != 0) {
+				int fallocateErrCode = errno;
+				TraceEvent("AsyncFileIOUringAllocateError")
+				    .detail("Fd", fd)
+				    .detail("Filename", filename)
+				    .detail("Size", size)
+				    .GetLastError();
+				if (fallocateErrCode == EOPNOTSUPP) {
+					// Mark fallocate as unsupported. Try again with truncate.
+					ctx.fallocateSupported = false;
+				} else {
+					return io_error();
+				}
+			} else {
+				completed = true;
+			}
+		}
+		if (!completed)
+			result = ftruncate(fd, size);
+
+		if (result != 0) {
+			TraceEvent("AsyncFileIOUringTruncateError").detail("Fd", fd).detail("Filename", filename).GetLastError();
+			return io_error();
+		}
+
+		lastFileSize = nextFileSize = size;
+
+		return Void();
+	}
+
+	ACTOR static Future<Void> throwErrorIfFailed(Reference<AsyncFileIOUring> self, Future<Void> sync) {
+		wait(sync);
+		if (self->failed) {
+			throw io_timeout();
+		}
+		return Void();
+	}
+
+	Future<Void> sync() override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		IOBlock* io = new IOBlock(IORING_OP_FSYNC, this);
+		enqueue(io);
+
+		// The IOBlock holds a reference to this file, so it is not closed until the fsync is done
+		Future<Void> fsync =
+		    throwErrorIfFailed(Reference<AsyncFileIOUring>::addRef(this), success(io->result.getFuture()));
+
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE) {
+			flags &= ~OPEN_ATOMIC_WRITE_AND_CREATE;
+
+			return AsyncFileEIO::waitAndAtomicRename(fsync, filename + ".part", filename);
+		}
+
+		return fsync;
+	}
+
+	Future<int64_t> size() const override { return nextFileSize; }
+	int64_t debugFD() const override { return fd; }
+	std::string getFilename() const override { return filename; }
+
+	~AsyncFileIOUring() override {
+		if (fixedSlot >= 0) {
+			int empty = -1;
+			io_uring_register_files_update(&ctx.ring, fixedSlot, &empty, 1);
+			ctx.freeFixedSlots.push_back(fixedSlot);
+		}
+		close(fd);
+	}
+
+	// Called by the run loop once per iteration. Moves as many queued requests as the submission queue has room for
+	// into it and submits them together.
+	static void launch() {
+		if (ctx.queue.empty() || ctx.outstanding >= ctx.queueDepth) {
+			return;
+		}
+
+		double begin = timer_monotonic();
+		if (!ctx.outstanding)
+			ctx.ioStallBegin = begin;
+
+		double start = timer();
+		int n = 0;
+		while (!ctx.queue.empty() && ctx.outstanding + n < ctx.queueDepth) {
+			io_uring_sqe* sqe = io_uring_get_sqe(&ctx.ring);
+			if (sqe == nullptr) {
+				break;
+			}
+
+			IOBlock* io = ctx.queue.top();
+			ctx.queue.pop();
+			io->prep(sqe);
+			io->startTime = start;
+			if (ctx.ioTimeout > 0) {
+				ctx.appendToRequestList(io);
+			}
+			++n;
+		}
+
+		// With SQPOLL the kernel thread picks up new entries itself and io_uring_submit() only enters the kernel to
+		// wake it if it has gone idle.
+		int rc;
+		do {
+			rc = io_uring_submit(&ctx.ring);
+		} while (rc == -EINTR);
+		++ctx.countSubmit;
+		if (!ctx.sqPoll || io_uring_sq_ready(&ctx.ring) == 0) {
+			++ctx.countSubmitSyscall;
+		}
+
+		double elapsed = timer_monotonic() - begin;
+		g_network->networkInfo.metrics.secSquaredSubmit += elapsed * elapsed / 2;
+
+		if (rc < 0 && rc != -EAGAIN && rc != -EBUSY) {
+			TraceEvent(SevError, "AsyncFileIOUringSubmitError").detail("Error", strerror(-rc));
+			throw io_error();
+		}
+		// Entries that were not consumed stay in the submission queue and are submitted on the next call
+		ctx.outstanding += n;
+	}
+
+	bool failed;
+
+private:
+	int fd, fixedSlot, flags;
+	int64_t lastFileSize, nextFileSize;
+	std::string filename;
+	Int64MetricHandle countFileLogicalWrites;
+	Int64MetricHandle countFileLogicalReads;
+
+	Int64MetricHandle countLogicalWrites;
+	Int64MetricHandle countLogicalReads;
+
+	struct IOBlock : FastAllocated<IOBlock> {
+		Promise<int> result;
+		Reference<AsyncFileIOUring> owner;
+		uint8_t opcode;
+		void* buf;
+		int nbytes;
+		int64_t offset;
+		int64_t prio;
+		IOBlock* prev;
+		IOBlock* next;
+		double startTime;
+
+		struct indirect_order_by_priority {
+			bool operator()(IOBlock* a, IOBlock* b) { return a->prio < b->prio; }
+		};
+
+		IOBlock(uint8_t opcode, AsyncFileIOUring* owner)
+		  : owner(Reference<AsyncFileIOUring>::addRef(owner)), opcode(opcode), buf(nullptr), nbytes(0), offset(0),
+		    prio(0), prev(nullptr), next(nullptr), startTime(0) {}
+
+		TaskPriority getTask() const { return static_cast<TaskPriority>((prio >> 32) + 1); }
+
+		void prep(io_uring_sqe* sqe) {
+			int target = owner->fixedSlot >= 0 ? owner->fixedSlot : owner->fd;
+			switch (opcode) {
+			case IORING_OP_READ:
+				io_uring_prep_read(sqe, target, buf, nbytes, offset);
+				break;
+			case IORING_OP_WRITE:
+				io_uring_prep_write(sqe, target, buf, nbytes, offset);
+				break;
+			case IORING_OP_FSYNC:
+				io_uring_prep_fsync(sqe, target, IORING_FSYNC_DATASYNC);
+				break;
+			default:
+				UNREACHABLE();
+			}
+			if (owner->fixedSlot >= 0) {
+				sqe->flags |= IOSQE_FIXED_FILE;
+				++ctx.countFixedFileOps;
+			}
+			io_uring_sqe_set_data(sqe, this);
+		}
+
+		ACTOR static void deliver(Promise<int> result, bool failed, int r, TaskPriority task) {
+			wait(delay(0, task));
+			if (failed)
+				result.sendError(io_timeout());
+			else if (r < 0)
+				result.sendError(io_error());
+			else
+				result.send(r);
+		}
+
+		void setResult(int r) {
+			if (r < 0) {
+				errno = -r;
+				TraceEvent("AsyncFileIOUringIOError")
+				    .GetLastError()
+				    .detail("Fd", owner->fd)
+				    .detail("Op", (int)opcode)
+				    .detail("Nbytes", nbytes)
+				    .detail("Offset", offset)
+				    .detail("Ptr", int64_t(buf))
+				    .detail("Filename", owner->filename);
+			}
+			deliver(result, owner->failed, r, getTask());
+			delete this;
+		}
+
+		void timeout(bool warnOnly) {
+			TraceEvent(SevWarnAlways, "AsyncFileIOUringTimeout")
+			    .detail("Fd", owner->fd)
+			    .detail("Op", (int)opcode)
+			    .detail("Nbytes", nbytes)
+			    .detail("Offset", offset)
+			    .detail("Ptr", int64_t(buf))
+			    .detail("Filename", owner->filename);
+			g_network->setGlobal(INetwork::enASIOTimedOut, (flowGlobalType) true);
+
+			if (!warnOnly)
+				owner->failed = true;
+		}
+	};
+
+	struct Context {
+		io_uring ring;
+		bool initialized;
+		bool sqPoll;
+		int queueDepth;
+		int evfd;
+		int outstanding;
+		double ioStallBegin;
+		bool fallocateSupported;
+		bool fallocateZeroSupported;
+		std::vector<int> freeFixedSlots;
+		std::priority_queue<IOBlock*, std::vector<IOBlock*>, IOBlock::indirect_order_by_priority> queue;
+		Int64MetricHandle countSubmit;
+		Int64MetricHandle countSubmitSyscall;
+		Int64MetricHandle countCollect;
+		Int64MetricHandle countFixedFileOps;
+
+		double ioTimeout;
+		bool timeoutWarnOnly;
+		IOBlock* submittedRequestList;
+
+		uint32_t opsIssued;
+		Context()
+		  : initialized(false), sqPoll(false), queueDepth(0), evfd(-1), outstanding(0), ioStallBegin(0),
+		    fallocateSupported(true), fallocateZeroSupported(true), submittedRequestList(nullptr), opsIssued(0) {
+			setIOTimeout(0);
+		}
+
+		void setIOTimeout(double timeout) {
+			ioTimeout = fabs(timeout);
+			timeoutWarnOnly = timeout < 0;
+		}
+
+		void appendToRequestList(IOBlock* io) {
+			ASSERT(!io->next && !io->prev);
+
+			if (submittedRequestList) {
+				io->prev = submittedRequestList->prev;
+				io->prev->next = io;
+
+				submittedRequestList->prev = io;
+				io->next = submittedRequestList;
+			} else {
+				submittedRequestList = io;
+				io->next = io->prev = io;
+			}
+		}
+
+		void removeFromRequestList(IOBlock* io) {
+			if (io->next == nullptr) {
+				ASSERT(io->prev == nullptr);
+				return;
+			}
+
+			ASSERT(io->prev != nullptr);
+
+			if (io == io->next) {
+				ASSERT(io == submittedRequestList && io == io->prev);
+				submittedRequestList = nullptr;
+			} else {
+				io->next->prev = io->prev;
+				io->prev->next = io->next;
+
+				if (submittedRequestList == io) {
+					submittedRequestList = io->next;
+				}
+			}
+
+			io->next = io->prev = nullptr;
+		}
+	};
+	static Context ctx;
+
+	explicit AsyncFileIOUring(int fd, int flags, std::string const& filename)
+	  : failed(false), fd(fd), fixedSlot(-1), flags(flags), filename(filename) {
+		ASSERT(isEnabled());
+		if (!g_network->isSimulated()) {
+			countFileLogicalWrites.init("AsyncFile.CountFileLogicalWrites"_sr, filename);
+			countFileLogicalReads.init("AsyncFile.CountFileLogicalReads"_sr, filename);
+			countLogicalWrites.init("AsyncFile.CountLogicalWrites"_sr);
+			countLogicalReads.init("AsyncFile.CountLogicalReads"_sr);
+		}
+
+		if (!ctx.freeFixedSlots.empty()) {
+			int slot = ctx.freeFixedSlots.back();
+			if (io_uring_register_files_update(&ctx.ring, slot, &fd, 1) == 1) {
+				ctx.freeFixedSlots.pop_back();
+				fixedSlot = slot;
+			}
+		}
+	}
+
+	void enqueue(IOBlock* io) {
+		ASSERT(io->opcode == IORING_OP_FSYNC ||
+		       (int64_t(io->buf) % 4096 == 0 && io->offset % 4096 == 0 && io->nbytes % 4096 == 0));
+
+		io->prio = (int64_t(g_network->getCurrentTask()) << 32) - (++ctx.opsIssued);
+		ctx.queue.push(io);
+	}
+
+	static int openFlags(int flags) {
+		int oflags = O_DIRECT | O_CLOEXEC;
+		ASSERT(bool(flags & OPEN_READONLY) != bool(flags & OPEN_READWRITE)); // readonly xor readwrite
+		if (flags & OPEN_EXCLUSIVE)
+			oflags |= O_EXCL;
+		if (flags & OPEN_CREATE)
+			oflags |= O_CREAT;
+		if (flags & OPEN_READONLY)
+			oflags |= O_RDONLY;
+		if (flags & OPEN_READWRITE)
+			oflags |= O_RDWR;
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE)
+			oflags |= O_TRUNC;
+		return oflags;
+	}
+
+	ACTOR static void poll(Reference<IEventFD> ev) {
+		loop {
+			wait(success(ev->read()));
+
+			wait(delay(0, TaskPriority::DiskIOComplete));
+
+			io_uring_cqe* cqes[ctx.queueDepth];
+			int n = io_uring_peek_batch_cqe(&ctx.ring, cqes, ctx.queueDepth);
+
+			double currentTime = timer();
+			++ctx.countCollect;
+
+			if (n) {
+				double t = timer_monotonic();
+				double elapsed = t - ctx.ioStallBegin;
+				ctx.ioStallBegin = t;
+				g_network->networkInfo.metrics.secSquaredDiskStall += elapsed * elapsed / 2;
+			}
+
+			ctx.outstanding -= n;
+
+			if (ctx.ioTimeout > 0) {
+				while (ctx.submittedRequestList && currentTime - ctx.submittedRequestList->startTime > ctx.ioTimeout) {
+					ctx.submittedRequestList->timeout(ctx.timeoutWarnOnly);
+					ctx.removeFromRequestList(ctx.submittedRequestList);
+				}
+			}
+
+			for (int i = 0; i < n; i++) {
+				IOBlock* iob = static_cast<IOBlock*>(io_uring_cqe_get_data(cqes[i]));
+				int res = cqes[i]->res;
+
+				if (ctx.ioTimeout > 0) {
+					ctx.removeFromRequestList(iob);
+				}
+
+				switch (iob->opcode) {
+				case IORING_OP_READ:
+					getMetrics().readLatencySample.addMeasurement(currentTime - iob->startTime);
+					break;
+				case IORING_OP_WRITE:
+					getMetrics().writeLatencySample.addMeasurement(currentTime - iob->startTime);
+					break;
+				case IORING_OP_FSYNC:
+					getMetrics().syncLatencySample.addMeasurement(currentTime - iob->startTime);
+					break;
+				}
+
+				iob->setResult(res);
+			}
+			io_uring_cq_advance(&ctx.ring, n);
+		}
+	}
+};
+
+TEST_CASE("/fdbrpc/AsyncFileIOUring/ReadWrite") {
+	// This test does nothing in simulation, or unless the process was started with USE_IO_URING_FOR_FILES
+	if (!g_network->isSimulated() && AsyncFileIOUring::isEnabled()) {
+		state Reference<IAsyncFile> f;
+		state std::string filename = "/tmp/__IOURING_TEST_FILE__";
+		state void* writeBuf = FastAllocator<4096>::allocate();
+		state void* readBuf = FastAllocator<4096>::allocate();
+		try {
+			Reference<IAsyncFile> f_ = wait(AsyncFileIOUring::open(filename,
+			                                                        IAsyncFile::OPEN_UNBUFFERED |
+			                                                            IAsyncFile::OPEN_READWRITE |
+			                                                            IAsyncFile::OPEN_CREATE,
+			                                                        0666,
+			                                                        nullptr));
+			f = f_;
+			state int pages = 256;
+			wait(f->truncate(pages * 4096));
+
+			state int i = 0;
+			for (; i < 100; ++i) {
+				state int page = deterministicRandom()->randomInt(0, pages);
+				memset(writeBuf, i, 4096);
+				wait(f->write(writeBuf, 4096, page * 4096));
+				wait(f->sync());
+				int n = wait(f->read(readBuf, 4096, page * 4096));
+				ASSERT(n == 4096);
+				ASSERT(memcmp(writeBuf, readBuf, 4096) == 0);
+			}
+			ASSERT(!((AsyncFileIOUring*)f.getPtr())->failed);
+		} catch (Error& e) {
+			state Error err = e;
+			FastAllocator<4096>::release(writeBuf);
+			FastAllocator<4096>::release(readBuf);
+			if (f) {
+				wait(AsyncFileEIO::deleteFile(f->getFilename(), true));
+			}
+			throw err;
+		}
+
+		FastAllocator<4096>::release(writeBuf);
+		FastAllocator<4096>::release(readBuf);
+		wait(AsyncFileEIO::deleteFile(f->getFilename(), true));
+	}
+
+	return Void();
+}
+
+AsyncFileIOUring::Context AsyncFileIOUring::ctx;
+
+#include "flow/unactorcompiler.h"
+#endif
+#endif
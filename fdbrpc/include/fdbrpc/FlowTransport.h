@@ -154,6 +154,7 @@ struct Peer : public ReferenceCounted<Peer> {
 	AsyncTrigger resetPing;
 	AsyncTrigger resetConnection;
 	bool compatible;
+	bool crc32cChecksum; // The peer's ConnectPacket says it can verify packets checksummed with CRC32C
 	bool connected;
 	bool outgoingConnectionIdle; // We don't actually have a connection open and aren't trying to open one because we
 	                             // don't have anything to send
@@ -162,12 +163,14 @@ struct Peer : public ReferenceCounted<Peer> {
 	int peerReferences;
 	int64_t bytesReceived;
 	int64_t bytesSent;
+	int64_t writeCalls; // Calls to IConnection::write, including ones that found the socket full
 	double lastDataPacketSentTime;
 	int outstandingReplies;
 	DDSketch<double> pingLatencies;
 	double lastLoggedTime;
 	int64_t lastLoggedBytesReceived;
 	int64_t lastLoggedBytesSent;
+	int64_t lastLoggedWriteCalls;
 	int timeoutCount;
 
 	Reference<AsyncVar<Optional<ProtocolVersion>>> protocolVersion;
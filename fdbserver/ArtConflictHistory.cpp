@@ -0,0 +1,361 @@
+/*
+ * ArtConflictHistory.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+
+#include "flow/Arena.h"
+#include "fdbserver/IConflictHistory.h"
+#include "fdbserver/art.h"
+
+// A conflict history kept in the adaptive radix tree used by Redwood's mutation buffer. Finding a key walks one
+// byte per level with no key comparisons, so long shared prefixes such as tuple encoded tenant and directory keys
+// cost nothing extra. The tree's leaves are linked in key order, and each leaf's value points to an Entry holding the
+// version at which the range from its key to the next key was last written.
+//
+// The leaves are also split into runs of consecutive keys, each of which keeps the greatest version written to any
+// of its leaves. A read range skips every run whose greatest version is not after the read, so checking it costs
+// one step per run plus one per leaf in the runs written since the read, rather than one per key in the range. The
+// greatest version of a run is not lowered when its newest leaf is erased, which only costs extra steps until reads
+// are newer than that write.
+//
+// The tree allocates from an arena and never frees, so once more keys have been erased than are left, the live
+// keys are copied into a new tree and the old arena is released. The copy is spread over calls to removeBefore(),
+// each copying no more keys than that call may visit. Until it is done, reads use the old tree only, and writes and
+// erasures of keys already copied are made to both trees.
+
+namespace {
+
+// Erasures below which the tree is never rebuilt
+constexpr int64_t kMinErasuresBeforeRebuild = 10000;
+// Leaves a run is split in halves above, and merged into the run before it below a quarter of
+constexpr int kMaxRunLeaves = 128;
+
+// A run of consecutive leaves, from first up to the first leaf of the next run
+struct Run {
+	art_iterator first;
+	Version maxVersion;
+	int count = 0;
+	Run* prev = nullptr;
+	Run* next = nullptr;
+};
+
+struct Entry {
+	Version version;
+	Run* run;
+};
+
+Entry* entry(const art_iterator& it) {
+	return static_cast<Entry*>(it.value());
+}
+
+art_iterator end() {
+	return art_iterator();
+}
+
+// The leaves and runs of one tree, and the arena they are allocated from
+class Tree : NonCopyable {
+public:
+	Arena arena;
+	art_tree art{ arena };
+	// The leaf with the greatest key, which is where the range past every key starts
+	art_iterator last;
+	// Keys in the tree other than the empty key
+	int live = 0;
+	// Keys erased since the tree was built
+	int64_t erased = 0;
+
+	// Returns the leaf before it, where it is the first leaf with a key greater than some key
+	art_iterator floor(art_iterator it) const {
+		if (it == end()) {
+			return last;
+		}
+		return --it;
+	}
+
+	// Sets the version of [begin, endKey) to now. Unless keepEnd, the range from endKey on is left as it is without
+	// endKey being added, which is only right for a tree being copied into whose keys so far all come before endKey.
+	void write(KeyRef begin, KeyRef endKey, Version now, bool keepEnd) {
+		art_iterator it;
+		if (keepEnd) {
+			// The range starting at end keeps the version it had before this write
+			it = art.lower_bound(endKey);
+			if (it == end() || it.key() != endKey) {
+				insert(endKey, entry(floor(it))->version);
+			}
+		}
+
+		it = art.upper_bound(begin);
+		while (it != end() && it.key() < endKey) {
+			art_iterator next = it;
+			++next;
+			erase(it);
+			it = next;
+		}
+
+		art_iterator b = art.lower_bound(begin);
+		if (b != end() && b.key() == begin) {
+			Entry* e = entry(b);
+			e->version = now;
+			e->run->maxVersion = std::max(e->run->maxVersion, now);
+		} else {
+			insert(begin, now);
+		}
+	}
+
+	// Adds a key greater than every key in the tree, starting a new run when the last one is half full
+	void append(KeyRef key, Version version) {
+		Entry* e = newEntry(version);
+		Run* run = nullptr;
+		if (last != end()) {
+			// Only the first key, which is the empty key, is not counted
+			run = entry(last)->run;
+			live++;
+		}
+		last = art.insert(key, e);
+		if (!run || run->count == kMaxRunLeaves / 2) {
+			Run* next = new (arena) Run();
+			next->first = last;
+			next->maxVersion = version;
+			next->prev = run;
+			if (run) {
+				run->next = next;
+			}
+			run = next;
+		}
+		e->run = run;
+		run->maxVersion = std::max(run->maxVersion, version);
+		run->count++;
+	}
+
+	// Inserts a key which is not in the tree. It joins the run of the key before it, which always exists since the
+	// empty key is never erased.
+	void insert(KeyRef key, Version version) {
+		Entry* e = newEntry(version);
+		art_iterator it = art.insert(key, e);
+		if (last.key() < key) {
+			last = it;
+		}
+		art_iterator prev = it;
+		--prev;
+		Run* run = entry(prev)->run;
+		e->run = run;
+		run->maxVersion = std::max(run->maxVersion, version);
+		if (++run->count > kMaxRunLeaves) {
+			split(run);
+		}
+		live++;
+	}
+
+	void erase(art_iterator it) {
+		Run* run = entry(it)->run;
+		if (it == last) {
+			--last;
+		}
+		if (run->first == it) {
+			++run->first;
+		}
+		art.erase(it);
+		live--;
+		erased++;
+
+		if (--run->count == 0) {
+			unlink(run);
+		} else if (run->count < kMaxRunLeaves / 4 && run->prev) {
+			merge(run);
+		}
+	}
+
+private:
+	Entry* newEntry(Version version) {
+		Entry* e = new (arena) Entry();
+		e->version = version;
+		e->run = nullptr;
+		return e;
+	}
+
+	// Moves the upper half of run to a new run after it
+	void split(Run* run) {
+		Run* right = new (arena) Run();
+		art_iterator it = run->first;
+		run->maxVersion = entry(it)->version;
+		for (int i = 1; i < run->count / 2; i++) {
+			++it;
+			run->maxVersion = std::max(run->maxVersion, entry(it)->version);
+		}
+		++it;
+		right->first = it;
+		right->count = run->count - run->count / 2;
+		right->maxVersion = entry(it)->version;
+		for (int i = 0; i < right->count; i++, ++it) {
+			entry(it)->run = right;
+			right->maxVersion = std::max(right->maxVersion, entry(it)->version);
+		}
+		run->count /= 2;
+
+		right->prev = run;
+		right->next = run->next;
+		if (run->next) {
+			run->next->prev = right;
+		}
+		run->next = right;
+	}
+
+	// Moves the leaves of run into the run before it
+	void merge(Run* run) {
+		Run* left = run->prev;
+		art_iterator it = run->first;
+		for (int i = 0; i < run->count; i++, ++it) {
+			entry(it)->run = left;
+		}
+		left->count += run->count;
+		left->maxVersion = std::max(left->maxVersion, run->maxVersion);
+		unlink(run);
+		if (left->count > kMaxRunLeaves) {
+			split(left);
+		}
+	}
+
+	static void unlink(Run* run) {
+		ASSERT(run->prev);
+		run->prev->next = run->next;
+		if (run->next) {
+			run->next->prev = run->prev;
+		}
+	}
+};
+
+class ArtConflictHistory final : public IConflictHistory, NonCopyable {
+public:
+	explicit ArtConflictHistory(Version version) : tree(std::make_unique<Tree>()) {
+		// The empty key is the smallest key, so the range before every other key starts here. It is never erased,
+		// so its run is never empty either.
+		tree->append(KeyRef(), version);
+	}
+
+	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) override {
+		for (int r = 0; r < count; r++) {
+			const ReadConflictRange& range = ranges[r];
+			bool* result = &transactionConflictStatus[range.transaction];
+			if (*result && range.conflictingKeyRange == nullptr) {
+				continue;
+			}
+
+			// The range containing begin starts at the last key not greater than it
+			art_iterator it = tree->art.upper_bound(range.begin);
+			bool conflict = entry(tree->floor(it))->version > range.version;
+			while (!conflict && it != end() && it.key() < range.end) {
+				const Run* run = entry(it)->run;
+				if (run->maxVersion <= range.version) {
+					// Nothing in the rest of this run was written after the read
+					if (!run->next) {
+						break;
+					}
+					it = run->next->first;
+					continue;
+				}
+				conflict = entry(it)->version > range.version;
+				++it;
+			}
+
+			if (conflict) {
+				*result = true;
+				if (range.conflictingKeyRange != nullptr) {
+					range.conflictingKeyRange->push_back(*range.cKRArena, range.indexInTx);
+				}
+			}
+		}
+	}
+
+	void addConflictRanges(const std::pair<StringRef, StringRef>* ranges, int count, Version now) override {
+		for (int r = 0; r < count; r++) {
+			KeyRef begin = ranges[r].first, endKey = ranges[r].second;
+			tree->write(begin, endKey, now, true);
+			if (rebuilt && begin < copyFrom) {
+				rebuilt->write(begin, std::min(endKey, KeyRef(copyFrom)), now, endKey < copyFrom);
+			}
+		}
+	}
+
+	Key removeBefore(Version oldestVersion, KeyRef removalKey, int nodeCount) override {
+		art_iterator it = tree->art.lower_bound(removalKey);
+		bool wasAbove = true;
+		for (int n = nodeCount; it != end() && n > 0; n--) {
+			bool isAbove = entry(it)->version >= oldestVersion;
+			art_iterator next = it;
+			++next;
+			if (!isAbove && !wasAbove) {
+				if (rebuilt && it.key() < copyFrom) {
+					art_iterator copy = rebuilt->art.lower_bound(it.key());
+					ASSERT(copy != end() && copy.key() == it.key());
+					rebuilt->erase(copy);
+				}
+				tree->erase(it);
+			}
+			wasAbove = isAbove;
+			it = next;
+		}
+		Key resumeKey = it == end() ? Key() : Key(it.key());
+
+		if (!rebuilt && tree->erased >= kMinErasuresBeforeRebuild && tree->erased > tree->live) {
+			rebuilt = std::make_unique<Tree>();
+			copyFrom = Key();
+		}
+		if (rebuilt) {
+			copy(nodeCount);
+		}
+		return resumeKey;
+	}
+
+	int count() const override { return tree->live; }
+
+	void clear(Version version) override {
+		tree = std::make_unique<Tree>();
+		rebuilt.reset();
+		copyFrom = Key();
+		tree->append(KeyRef(), version);
+	}
+
+private:
+	std::unique_ptr<Tree> tree;
+	// The tree the live keys are being copied into, which holds exactly the keys of tree before copyFrom
+	std::unique_ptr<Tree> rebuilt;
+	Key copyFrom;
+
+	// Copies up to nodeCount more keys into rebuilt, and replaces tree with it once every key is copied
+	void copy(int nodeCount) {
+		art_iterator it = tree->art.lower_bound(copyFrom);
+		for (; it != end() && nodeCount > 0; ++it, nodeCount--) {
+			rebuilt->append(it.key(), entry(it)->version);
+		}
+		if (it == end()) {
+			tree = std::move(rebuilt);
+			copyFrom = Key();
+		} else {
+			copyFrom = Key(it.key());
+		}
+	}
+};
+
+} // namespace
+
+IConflictHistory* newArtConflictHistory(Version version) {
+	return new ArtConflictHistory(version);
+}
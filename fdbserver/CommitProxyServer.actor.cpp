@@ -481,6 +481,40 @@ ACTOR Future<Void> commitBatcher(ProxyCommitData* commitData,
 	}
 }
 
+// Decodes the compressed mutations of req in place. Replies with the error and returns false if they cannot be decoded.
+bool decompressCommit(ProxyCommitData* commitData, CommitTransactionRequest& req) {
+	double start = timer_monotonic();
+	try {
+		int64_t compressedBytes = decompressMutations(req);
+		++commitData->stats.compressedTxnCommitIn;
+		commitData->stats.compressedMutationBytesIn += compressedBytes;
+		commitData->stats.decompressedMutationBytes += req.transaction.mutations.expectedSize();
+		commitData->stats.decompressionLatencySample.addMeasurement(timer_monotonic() - start);
+		return true;
+	} catch (Error& e) {
+		++commitData->stats.txnCommitErrors;
+		TraceEvent(SevWarnAlways, "CommitDecompressionFailed", commitData->dbgid)
+		    .suppressFor(1.0)
+		    .error(e)
+		    .detail("Client", req.reply.getEndpoint().getPrimaryAddress());
+		req.reply.sendError(e);
+		return false;
+	}
+}
+
+// Commits sent with compressed mutations are decoded here, in the order they arrive, before reaching commitBatcher, so
+// that batching, memory accounting and everything after only ever see plain mutations.
+ACTOR Future<Void> decompressCommits(ProxyCommitData* commitData,
+                                     FutureStream<CommitTransactionRequest> in,
+                                     PromiseStream<CommitTransactionRequest> out) {
+	loop {
+		CommitTransactionRequest req = waitNext(in);
+		if (!req.hasCompressedMutations() || decompressCommit(commitData, req)) {
+			out.send(std::move(req));
+		}
+	}
+}
+
 void createWhitelistBinPathVec(const std::string& binPath, std::vector<Standalone<StringRef>>& binPathVec) {
 	TraceEvent(SevDebug, "BinPathConverter").detail("Input", binPath);
 	StringRef input(binPath);
@@ -2900,6 +2934,53 @@ void addTagMapping(GetKeyServerLocationsReply& reply, ProxyCommitData* commitDat
 			reply.resultsTagMapping.emplace_back(ssi.id(), iter->second->tag);
 		}
 	}
+	for (auto& ssi : reply.servers) {
+		auto iter = commitData->storageCache.find(ssi.id());
+		ASSERT_WE_THINK(iter != commitData->storageCache.end());
+		reply.resultsTagMapping.emplace_back(ssi.id(), iter->second->tag);
+	}
+}
+
+// Fills the compact form of the reply with up to req.limit shards starting at req.begin. Teams are numbered in the
+// order they are first seen, and so are the servers.
+void addCompactKeyServerLocations(GetKeyServerLocationsReply& reply,
+                                  const GetKeyServerLocationsRequest& req,
+                                  ProxyCommitData* commitData,
+                                  std::unordered_set<UID>& tssMappingsIncluded) {
+	std::map<std::vector<UID>, int> teamIndex;
+	std::unordered_map<UID, int> serverIndex;
+	std::vector<UID> team;
+	int count = 0;
+	for (auto r = commitData->keyInfo.rangeContaining(req.begin);
+	     r != commitData->keyInfo.ranges().end() && count < req.limit && r.begin() < req.end.get();
+	     ++r) {
+		KeyRangeRef range = TenantAPI::clampRangeToTenant(r.range(), req.tenant, reply.arena);
+		if (reply.boundaries.empty()) {
+			reply.boundaries.push_back(reply.arena, range.begin);
+		}
+		reply.boundaries.push_back(reply.arena, range.end);
+
+		team.clear();
+		for (auto& it : r.value().src_info) {
+			team.push_back(it->interf.id());
+		}
+		auto [t, newTeam] = teamIndex.try_emplace(team, reply.teams.size());
+		if (newTeam) {
+			std::vector<int> members;
+			members.reserve(r.value().src_info.size());
+			for (auto& it : r.value().src_info) {
+				auto [s, newServer] = serverIndex.try_emplace(it->interf.id(), reply.servers.size());
+				if (newServer) {
+					reply.servers.push_back(it->interf);
+					maybeAddTssMapping(reply, commitData, tssMappingsIncluded, it->interf.id());
+				}
+				members.push_back(s->second);
+			}
+			reply.teams.push_back(std::move(members));
+		}
+		reply.shardTeams.push_back(t->second);
+		count++;
+	}
 }
 
 ACTOR static Future<Void> doTenantIdRequest(GetTenantIdRequest req, ProxyCommitData* commitData) {
@@ -3017,6 +3098,8 @@ ACTOR static Future<Void> doKeyServerLocationRequest(GetKeyServerLocationsReques
 			maybeAddTssMapping(rep, commitData, tssMappingsIncluded, it->interf.id());
 		}
 		rep.results.emplace_back(TenantAPI::clampRangeToTenant(r.range(), req.tenant, req.arena), ssis);
+	} else if (!req.reverse && req.compactReply) {
+		addCompactKeyServerLocations(rep, req, commitData, tssMappingsIncluded);
 	} else if (!req.reverse) {
 		int count = 0;
 		for (auto r = commitData->keyInfo.rangeContaining(req.begin);
@@ -4055,8 +4138,10 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy,
 	                                               pow(commitData.db->get().client.commitProxies.size(),
 	                                                   SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_SCALE_POWER)));
 
-	commitBatcherActor = commitBatcher(
-	    &commitData, batchedCommits, proxy.commit.getFuture(), commitBatchByteLimit, commitBatchesMemoryLimit);
+	state PromiseStream<CommitTransactionRequest> commits;
+	addActor.send(decompressCommits(&commitData, proxy.commit.getFuture(), commits));
+	commitBatcherActor =
+	    commitBatcher(&commitData, batchedCommits, commits.getFuture(), commitBatchByteLimit, commitBatchesMemoryLimit);
 
 	// This has to be declared after the commitData.txnStateStore get initialized
 	state TransactionStateResolveContext transactionStateResolveContext(&commitData, &addActor);
@@ -194,6 +194,8 @@ void ILogSystem::ServerPeekCursor::advanceTo(LogMessageVersion n) {
 // in getMore helper functions.
 void updateCursorWithReply(ILogSystem::ServerPeekCursor* self, const TLogPeekReply& res) {
 	self->results = res;
+	// A reply from a TLog in this process may arrive without having been serialized
+	self->results.flattenMessages();
 	self->onlySpilled = res.onlySpilled;
 	if (res.popped.present())
 		self->poppedVersion = std::min(std::max(self->poppedVersion, res.popped.get()), self->end.version);
@@ -237,7 +239,7 @@ ACTOR Future<TLogPeekReply> recordRequestMetrics(ILogSystem::ServerPeekCursor* s
 		TLogPeekReply t = wait(in);
 		if (now() - self->lastReset > SERVER_KNOBS->PEEK_RESET_INTERVAL) {
 			if (now() - startTime > SERVER_KNOBS->PEEK_MAX_LATENCY) {
-				if (t.messages.size() >= SERVER_KNOBS->DESIRED_TOTAL_BYTES || SERVER_KNOBS->PEEK_COUNT_SMALL_MESSAGES) {
+				if (t.messageBytes() >= SERVER_KNOBS->DESIRED_TOTAL_BYTES || SERVER_KNOBS->PEEK_COUNT_SMALL_MESSAGES) {
 					if (self->resetCheck.isReady()) {
 						self->resetCheck = resetChecker(self, addr);
 					}
@@ -0,0 +1,690 @@
+/*
+ * PackedConflictHistory.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <memory.h>
+#include <algorithm>
+#include <limits>
+
+#include "flow/Platform.h"
+#include "flow/FastAlloc.h"
+#include "flow/SimdCount.h"
+#include "fdbserver/IConflictHistory.h"
+
+// A conflict history stored in a B+tree. Each node keeps eight bytes of each of its keys as integers in one
+// contiguous array, so choosing a child or a leaf slot is a handful of SIMD compares over a few cache lines and
+// full key comparisons are only needed among keys sharing those eight bytes. The eight bytes are taken after the
+// prefix shared by every key in the node, so keys under a common tenant or directory prefix still differ in them.
+// Each inner node entry also keeps the maximum version written anywhere in its child, so read conflict checks skip
+// whole subtrees that are old enough.
+
+namespace {
+
+// Entries per node. A node is exactly one FastAllocator<1024> block.
+constexpr int kNodeEntries = 24;
+
+// Prefix value of unused slots. It is never less than any search prefix, so slots past a node's count do not
+// affect the count of prefixes below a search key.
+constexpr int64_t kUnusedPrefix = std::numeric_limits<int64_t>::max();
+// Prefix value of the empty key, which is also the unused first key of every inner node
+constexpr int64_t kEmptyPrefix = std::numeric_limits<int64_t>::min();
+
+// Returns the first eight bytes of key, zero padded, as a big-endian integer with the sign bit flipped. Comparing
+// prefixes as signed integers orders keys correctly, except that keys sharing a prefix compare equal.
+force_inline int64_t keyPrefix(const uint8_t* key, int length) {
+	uint64_t p = 0;
+	if (length > 0) {
+		memcpy(&p, key, std::min(length, 8));
+	}
+	return int64_t(bigEndian64(p) ^ (uint64_t(1) << 63));
+}
+
+force_inline int compareKeys(const uint8_t* a, int aLength, const uint8_t* b, int bLength) {
+	int n = std::min(aLength, bLength);
+	int c = n > 0 ? memcmp(a, b, n) : 0;
+	if (c != 0) {
+		return c;
+	}
+	return (aLength > bLength) - (aLength < bLength);
+}
+
+int commonPrefixLength(const uint8_t* a, int aLength, const uint8_t* b, int bLength) {
+	int n = std::min(aLength, bLength);
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		uint64_t x, y;
+		memcpy(&x, a + i, 8);
+		memcpy(&y, b + i, 8);
+		if (x != y) {
+			break;
+		}
+	}
+	while (i < n && a[i] == b[i]) {
+		i++;
+	}
+	return i;
+}
+
+struct SearchKey {
+	const uint8_t* key;
+	int length;
+
+	explicit SearchKey(StringRef k) : key(k.begin()), length(k.size()) {}
+};
+
+// Memory layout: the arrays used while searching come first so that the prefix array starts on a cache line.
+// In a leaf, version[i] is the version at which [key[i], key[i + 1]) was last written. In an inner node, key[i]
+// is a lower bound of the keys under child[i] (key[0] is always empty and is not one of the node's keys) and
+// version[i] is the greatest version under child[i].
+struct Node {
+	int64_t prefix[kNodeEntries];
+	Version version[kNodeEntries];
+	uint8_t* key[kNodeEntries];
+	Node* child[kNodeEntries];
+	int keyLength[kNodeEntries];
+	Node* parent;
+	// Neighbouring leaves in key order. Unused in inner nodes.
+	Node* prev;
+	Node* next;
+	int count;
+	// The slot of this node in its parent
+	int parentSlot;
+	// The length of a prefix shared by all of the node's keys. prefix[i] holds the bytes of key[i] which follow it.
+	int prefixOffset;
+	bool leaf;
+
+	int firstKeySlot() const { return leaf ? 0 : 1; }
+	StringRef keyAt(int i) const { return StringRef(key[i], keyLength[i]); }
+	int compare(int i, const SearchKey& k) const { return compareKeys(key[i], keyLength[i], k.key, k.length); }
+	bool equals(int i, const SearchKey& k) const {
+		return keyLength[i] == k.length && (k.length == 0 || !memcmp(key[i], k.key, k.length));
+	}
+
+	// Returns the number of entries whose key is less than k, or less than or equal to k if orEqual
+	template <bool orEqual>
+	int bound(const SearchKey& k) const {
+		if (!orEqual && k.length == 0) {
+			return 0;
+		}
+		const int first = firstKeySlot();
+		if (count == first) {
+			return first;
+		}
+
+		// Either k shares the node's common prefix, or it is ordered before or after all of the node's keys
+		const int offset = prefixOffset;
+		if (offset > 0) {
+			int c = k.length > 0 ? memcmp(k.key, key[first], std::min(offset, k.length)) : 0;
+			if (c < 0 || (c == 0 && k.length < offset)) {
+				return first;
+			}
+			if (c > 0) {
+				return count;
+			}
+		}
+
+		int less, lessOrEqual;
+		countLessAndLessOrEqual<kNodeEntries>(prefix, keyPrefix(k.key + offset, k.length - offset), less, lessOrEqual);
+		int i = std::max(less, first);
+		int end = std::min(lessOrEqual, count);
+		while (i < end && (orEqual ? compare(i, k) <= 0 : compare(i, k) < 0)) {
+			i++;
+		}
+		return i;
+	}
+
+	int lowerBound(const SearchKey& k) const { return bound<false>(k); }
+	int upperBound(const SearchKey& k) const { return bound<true>(k); }
+
+	Version maxVersion() const {
+		Version v = version[0];
+		for (int i = 1; i < count; i++) {
+			v = std::max(v, version[i]);
+		}
+		return v;
+	}
+
+	int64_t slotPrefix(int i) const {
+		return keyPrefix(key[i] + prefixOffset, keyLength[i] - prefixOffset);
+	}
+
+	void setPrefixOffset(int offset) {
+		prefixOffset = offset;
+		for (int i = firstKeySlot(); i < count; i++) {
+			prefix[i] = slotPrefix(i);
+		}
+	}
+
+	// Recomputes the prefix offset and all prefixes after entries were moved in from another node
+	void resetPrefixes() {
+		const int first = firstKeySlot();
+		const int last = count - 1;
+		if (last < first) {
+			setPrefixOffset(0);
+		} else {
+			setPrefixOffset(commonPrefixLength(key[first], keyLength[first], key[last], keyLength[last]));
+		}
+	}
+
+	// Sets the prefix of a key just placed in slot i, shortening the prefix offset if the key does not share it
+	void keyAdded(int i) {
+		const int first = firstKeySlot();
+		if (count - first == 1) {
+			setPrefixOffset(keyLength[i]);
+			return;
+		}
+		const int other = i == first ? first + 1 : first;
+		const int shared = commonPrefixLength(key[i], keyLength[i], key[other], keyLength[other]);
+		if (shared < prefixOffset) {
+			setPrefixOffset(shared);
+		} else {
+			prefix[i] = slotPrefix(i);
+		}
+	}
+
+	void setEntry(int i, uint8_t* k, int length, int64_t p, Version v, Node* c) {
+		prefix[i] = p;
+		version[i] = v;
+		key[i] = k;
+		keyLength[i] = length;
+		child[i] = c;
+		if (c) {
+			c->parent = this;
+			c->parentSlot = i;
+		}
+	}
+
+	void moveEntry(int from, int to) {
+		setEntry(to, key[from], keyLength[from], prefix[from], version[from], child[from]);
+	}
+
+	void clearEntry(int i) {
+		prefix[i] = kUnusedPrefix;
+		key[i] = nullptr;
+		keyLength[i] = 0;
+		child[i] = nullptr;
+	}
+
+	// Removes entries [begin, end) without freeing their keys
+	void removeEntries(int begin, int end) {
+		int removed = end - begin;
+		for (int i = end; i < count; i++) {
+			moveEntry(i, i - removed);
+		}
+		for (int i = count - removed; i < count; i++) {
+			clearEntry(i);
+		}
+		count -= removed;
+	}
+
+	static Node* create(bool leaf) {
+		static_assert(sizeof(Node) <= 1024);
+		Node* n = (Node*)FastAllocator<1024>::allocate();
+		INSTRUMENT_ALLOCATE("PackedConflictHistoryNode");
+		n->parent = n->prev = n->next = nullptr;
+		n->count = 0;
+		n->parentSlot = 0;
+		n->prefixOffset = 0;
+		n->leaf = leaf;
+		for (int i = 0; i < kNodeEntries; i++) {
+			n->clearEntry(i);
+		}
+		return n;
+	}
+
+	void destroy() {
+		FastAllocator<1024>::release(this);
+		INSTRUMENT_RELEASE("PackedConflictHistoryNode");
+	}
+};
+
+uint8_t* copyKey(const SearchKey& k) {
+	if (k.length == 0) {
+		return nullptr;
+	}
+	uint8_t* copy = (uint8_t*)allocateFast(k.length);
+	memcpy(copy, k.key, k.length);
+	return copy;
+}
+
+void freeKey(uint8_t* key, int length) {
+	if (key) {
+		freeFast(length, key);
+	}
+}
+
+class PackedBTree final : public IConflictHistory, NonCopyable {
+public:
+	explicit PackedBTree(Version version) : root(Node::create(true)), entries(1) {
+		// The empty key is the smallest key, so the range before every other key starts here. It is never removed.
+		root->setEntry(0, nullptr, 0, kEmptyPrefix, version, nullptr);
+		root->count = 1;
+	}
+
+	~PackedBTree() override { destroy(root); }
+
+	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) override {
+		for (int r = 0; r < count; r++) {
+			const ReadConflictRange& range = ranges[r];
+			bool* result = &transactionConflictStatus[range.transaction];
+			if (*result && range.conflictingKeyRange == nullptr) {
+				continue;
+			}
+
+			const SearchKey begin(range.begin), end(range.end);
+			if (anyNewer(root, &begin, &end, range.version, std::numeric_limits<Version>::min())) {
+				*result = true;
+				if (range.conflictingKeyRange != nullptr) {
+					range.conflictingKeyRange->push_back(*range.cKRArena, range.indexInTx);
+				}
+			}
+		}
+	}
+
+	void addConflictRanges(const std::pair<StringRef, StringRef>* ranges, int count, Version now) override {
+		for (int r = 0; r < count; r++) {
+			const SearchKey begin(ranges[r].first), end(ranges[r].second);
+
+			// The range starting at end keeps the version it had before this write
+			Node* n = findLeaf(end);
+			int i = n->lowerBound(end);
+			if (i == n->count || !n->equals(i, end)) {
+				Version v = i > 0 ? n->version[i - 1] : n->prev->version[n->prev->count - 1];
+				std::tie(n, i) = insertEntry(n, i, copyKey(end), end.length, v, nullptr);
+				entries++;
+			}
+
+			if (n->compare(0, begin) > 0) {
+				eraseBetween(begin, end);
+				upsert(findLeaf(begin), begin, now);
+				continue;
+			}
+
+			// The whole range is in this leaf, as it is for point writes
+			int j = n->lowerBound(begin);
+			bool exists = n->equals(j, begin);
+			int eraseBegin = exists ? j + 1 : j;
+			for (int k = eraseBegin; k < i; k++) {
+				freeKey(n->key[k], n->keyLength[k]);
+			}
+			n->removeEntries(eraseBegin, i);
+			entries -= i - eraseBegin;
+			// If anything was erased there is room for begin, so n is not split before it is rebalanced. Otherwise
+			// inserting begin may split n, which insertEntry handles, and n needs no rebalancing.
+			const bool erased = eraseBegin < i;
+			ASSERT(!erased || n->count < kNodeEntries);
+			upsert(n, begin, now);
+			if (erased) {
+				removed(n);
+			}
+		}
+	}
+
+	Key removeBefore(Version oldestVersion, KeyRef removalKey, int nodeCount) override {
+		Key resumeKey;
+		SearchKey k(removalKey);
+		Node* n = findLeaf(k);
+		int i = n->lowerBound(k);
+		bool wasAbove = true;
+		while (true) {
+			if (i == n->count) {
+				n = n->next;
+				i = 0;
+				if (!n) {
+					return Key();
+				}
+			}
+			if (nodeCount <= 0) {
+				return Key(n->keyAt(i));
+			}
+
+			int kept = i;
+			int end = std::min(n->count, i + nodeCount);
+			nodeCount -= end - i;
+			for (; i < end; i++) {
+				bool isAbove = n->version[i] >= oldestVersion;
+				if (isAbove || wasAbove) {
+					n->moveEntry(i, kept++);
+				} else {
+					freeKey(n->key[i], n->keyLength[i]);
+					entries--;
+				}
+				wasAbove = isAbove;
+			}
+			if (kept == i) {
+				continue;
+			}
+
+			// Close the gap, then find our place again after the tree has been rebalanced
+			n->removeEntries(kept, i);
+			i = kept;
+			if (i < n->count) {
+				resumeKey = n->keyAt(i);
+			} else if (n->next) {
+				resumeKey = n->next->keyAt(0);
+			} else {
+				removed(n);
+				return Key();
+			}
+			removed(n);
+			k = SearchKey(resumeKey);
+			n = findLeaf(k);
+			i = n->lowerBound(k);
+		}
+	}
+
+	int count() const override { return entries - 1; }
+
+	void clear(Version version) override {
+		destroy(root);
+		root = Node::create(true);
+		root->setEntry(0, nullptr, 0, kEmptyPrefix, version, nullptr);
+		root->count = 1;
+		entries = 1;
+	}
+
+private:
+	Node* root;
+	int entries;
+
+	Node* findLeaf(const SearchKey& k) const {
+		Node* n = root;
+		while (!n->leaf) {
+			n = n->child[n->upperBound(k) - 1];
+		}
+		return n;
+	}
+
+	// Returns true if the range containing lo, or the range starting at any key under n which is greater than lo
+	// and less than hi, was written after v. Null bounds are unbounded. before is at least the version of the range
+	// which starts before the first key under n.
+	bool anyNewer(const Node* n, const SearchKey* lo, const SearchKey* hi, Version v, Version before) const {
+		if (n->leaf) {
+			int i = 0;
+			if (lo) {
+				i = n->upperBound(*lo);
+				// If every key in the leaf is greater than lo, its range starts at the end of the previous leaf
+				Version floor = i > 0 ? n->version[i - 1] : n->prev->version[n->prev->count - 1];
+				if (floor > v) {
+					return true;
+				}
+			}
+			int end = hi ? n->lowerBound(*hi) : n->count;
+			for (; i < end; i++) {
+				if (n->version[i] > v) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		int first = lo ? n->upperBound(*lo) - 1 : 0;
+		int last = hi ? n->lowerBound(*hi) - 1 : n->count - 1;
+		if (lo) {
+			// The range containing lo may start in an earlier child, so the child holding lo can only be skipped if
+			// the child before it is old enough too
+			Version childBefore = first > 0 ? n->version[first - 1] : before;
+			if ((n->version[first] > v || childBefore > v) &&
+			    anyNewer(n->child[first], lo, last <= first ? hi : nullptr, v, childBefore)) {
+				return true;
+			}
+			first++;
+		}
+		for (int i = first; i <= last; i++) {
+			if (n->version[i] <= v) {
+				continue;
+			}
+			if (i < last || !hi || anyNewer(n->child[i], nullptr, hi, v, before)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Sets the version of the range starting at k, which belongs in leaf n, to now
+	void upsert(Node* n, const SearchKey& k, Version now) {
+		int i = n->lowerBound(k);
+		if (i < n->count && n->equals(i, k)) {
+			n->version[i] = now;
+			raiseVersion(n, now);
+		} else {
+			insertEntry(n, i, copyKey(k), k.length, now, nullptr);
+			entries++;
+		}
+	}
+
+	// Propagates a version written under n to the ancestors of n
+	void raiseVersion(Node* n, Version v) {
+		for (Node* p = n->parent; p; n = p, p = p->parent) {
+			Version& pv = p->version[n->parentSlot];
+			if (pv >= v) {
+				break;
+			}
+			pv = v;
+		}
+	}
+
+	// Recomputes the versions of the ancestors of n after entries were removed from n
+	void refreshVersion(Node* n) {
+		for (Node* p = n->parent; p; n = p, p = p->parent) {
+			Version& pv = p->version[n->parentSlot];
+			Version v = n->maxVersion();
+			if (pv == v) {
+				break;
+			}
+			pv = v;
+		}
+	}
+
+	// Inserts an entry at slot i of n, splitting n if it is full. Returns the node and slot the entry ended up in.
+	std::pair<Node*, int> insertEntry(Node* n, int i, uint8_t* key, int keyLength, Version version, Node* child) {
+		if (n->count == kNodeEntries) {
+			Node* right = split(n);
+			if (i > n->count) {
+				i -= n->count;
+				n = right;
+			}
+		}
+		for (int j = n->count; j > i; j--) {
+			n->moveEntry(j - 1, j);
+		}
+		n->setEntry(i, key, keyLength, kUnusedPrefix, version, child);
+		n->count++;
+		n->keyAdded(i);
+		raiseVersion(n, version);
+		return { n, i };
+	}
+
+	// Moves the upper half of the full node n to a new right sibling, which is returned
+	Node* split(Node* n) {
+		Node* right = Node::create(n->leaf);
+		int half = n->count / 2;
+		for (int i = half; i < n->count; i++) {
+			right->setEntry(
+			    i - half, n->key[i], n->keyLength[i], n->prefix[i], n->version[i], n->leaf ? nullptr : n->child[i]);
+		}
+		right->count = n->count - half;
+		for (int i = half; i < n->count; i++) {
+			n->clearEntry(i);
+		}
+		n->count = half;
+
+		uint8_t* separator;
+		int separatorLength = right->keyLength[0];
+		if (n->leaf) {
+			separator = copyKey(SearchKey(right->keyAt(0)));
+			right->next = n->next;
+			right->prev = n;
+			if (n->next) {
+				n->next->prev = right;
+			}
+			n->next = right;
+		} else {
+			// The first key of an inner node is not used, so it moves up to the parent
+			separator = right->key[0];
+			right->key[0] = nullptr;
+			right->keyLength[0] = 0;
+			right->prefix[0] = kEmptyPrefix;
+		}
+		n->resetPrefixes();
+		right->resetPrefixes();
+
+		if (!n->parent) {
+			Node* newRoot = Node::create(false);
+			newRoot->setEntry(0, nullptr, 0, kEmptyPrefix, n->maxVersion(), n);
+			newRoot->count = 1;
+			root = newRoot;
+		}
+		Node* p = n->parent;
+		int i = n->parentSlot;
+		p->version[i] = n->maxVersion();
+		insertEntry(p, i + 1, separator, separatorLength, right->maxVersion(), right);
+		return right;
+	}
+
+	// Erases all keys greater than begin and less than end
+	void eraseBetween(const SearchKey& begin, const SearchKey& end) {
+		while (true) {
+			Node* n = findLeaf(begin);
+			int i = n->upperBound(begin);
+			if (i == n->count) {
+				n = n->next;
+				i = 0;
+				if (!n) {
+					return;
+				}
+			}
+			int j = std::max(i, n->lowerBound(end));
+			if (j == i) {
+				return;
+			}
+			for (int k = i; k < j; k++) {
+				freeKey(n->key[k], n->keyLength[k]);
+			}
+			n->removeEntries(i, j);
+			entries -= j - i;
+			removed(n);
+		}
+	}
+
+	// Restores the tree's invariants after entries were removed from n, which may be freed
+	void removed(Node* n) {
+		if (n == root) {
+			if (!n->leaf && n->count == 1) {
+				root = n->child[0];
+				root->parent = nullptr;
+				n->destroy();
+			}
+			return;
+		}
+
+		Node* p = n->parent;
+		int i = n->parentSlot;
+		if (n->count == 0) {
+			if (n->leaf) {
+				n->prev->next = n->next;
+				if (n->next) {
+					n->next->prev = n->prev;
+				}
+			}
+			n->destroy();
+			removeChild(p, i);
+			return;
+		}
+
+		p->version[i] = n->maxVersion();
+		if (n->count < kNodeEntries / 4) {
+			if (i + 1 < p->count && n->count + p->child[i + 1]->count <= kNodeEntries * 3 / 4) {
+				merge(p, i);
+				return;
+			}
+			if (i > 0 && n->count + p->child[i - 1]->count <= kNodeEntries * 3 / 4) {
+				merge(p, i - 1);
+				return;
+			}
+		}
+		refreshVersion(p);
+	}
+
+	// Removes the entry for an already freed child from inner node p
+	void removeChild(Node* p, int i) {
+		if (i == 0) {
+			// The next child becomes the first, and the first key of an inner node is always empty
+			if (p->count > 1) {
+				freeKey(p->key[1], p->keyLength[1]);
+				p->key[1] = nullptr;
+				p->keyLength[1] = 0;
+				p->prefix[1] = kEmptyPrefix;
+			}
+		} else {
+			freeKey(p->key[i], p->keyLength[i]);
+		}
+		p->removeEntries(i, i + 1);
+		removed(p);
+	}
+
+	// Moves the entries of p->child[i + 1] into p->child[i] and frees p->child[i + 1]
+	void merge(Node* p, int i) {
+		Node* left = p->child[i];
+		Node* right = p->child[i + 1];
+		int base = left->count;
+		for (int j = 0; j < right->count; j++) {
+			left->setEntry(base + j,
+			               right->key[j],
+			               right->keyLength[j],
+			               right->prefix[j],
+			               right->version[j],
+			               left->leaf ? nullptr : right->child[j]);
+		}
+		left->count += right->count;
+		if (left->leaf) {
+			left->next = right->next;
+			if (right->next) {
+				right->next->prev = left;
+			}
+		} else {
+			// The separator in the parent becomes the key of right's first child
+			left->key[base] = p->key[i + 1];
+			left->keyLength[base] = p->keyLength[i + 1];
+			p->key[i + 1] = nullptr;
+			p->keyLength[i + 1] = 0;
+		}
+		left->resetPrefixes();
+		right->destroy();
+		p->version[i] = left->maxVersion();
+		removeChild(p, i + 1);
+	}
+
+	void destroy(Node* n) {
+		for (int i = 0; i < n->count; i++) {
+			freeKey(n->key[i], n->keyLength[i]);
+			if (!n->leaf) {
+				destroy(n->child[i]);
+			}
+		}
+		n->destroy();
+	}
+};
+
+} // namespace
+
+IConflictHistory* newPackedConflictHistory(Version version) {
+	return new PackedBTree(version);
+}
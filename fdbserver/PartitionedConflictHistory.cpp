@@ -0,0 +1,502 @@
+/*
+ * PartitionedConflictHistory.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "flow/UnitTest.h"
+#include "fdbserver/ConflictSet.h"
+#include "fdbserver/IConflictHistory.h"
+#include "fdbserver/Knobs.h"
+
+// A conflict history whose key space is split into partitions that are checked and updated in parallel. Ranges
+// which span partitions are clipped to each partition they overlap, and the partitions' verdicts are combined in
+// range order on the calling thread, so results do not depend on thread scheduling.
+//
+// Partition boundaries are chosen from a sample of recently written keys. When the writes in a window are spread
+// too unevenly over the partitions, a new set of partitions is started from the latest sample. The old partitions
+// take no more writes, but reads are checked against them until the oldest readable version passes the last
+// version written to them, at which point they are dropped. History is never moved between partitions.
+
+namespace {
+
+// Runs batches of independent jobs on a fixed set of threads, with the calling thread taking part. run() returns
+// once every job in its batch is done. In simulation all jobs run on the calling thread.
+class ConflictWorkerPool : NonCopyable {
+public:
+	explicit ConflictWorkerPool(int threads) {
+		if (g_network && g_network->isSimulated()) {
+			return;
+		}
+		for (int i = 1; i < threads; i++) {
+			workers.emplace_back([this] { work(); });
+		}
+	}
+
+	~ConflictWorkerPool() {
+		{
+			std::lock_guard<std::mutex> g(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& t : workers) {
+			t.join();
+		}
+	}
+
+	template <class F>
+	void run(int jobs, const F& f) {
+		if (workers.empty() || jobs <= 1) {
+			for (int i = 0; i < jobs; i++) {
+				f(i);
+			}
+			return;
+		}
+
+		const std::function<void(int)> job = f;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			// A worker which woke after the previous batch ended may still be passing through
+			idle.wait(lock, [this] { return active == 0; });
+			currentJob = &job;
+			jobCount = jobs;
+			nextJob = 0;
+			finished = 0;
+			generation++;
+		}
+		wake.notify_all();
+
+		int ran = runJobs(job, jobs);
+		std::unique_lock<std::mutex> lock(mutex);
+		finished += ran;
+		// Workers which took up the batch still hold job until they leave it, even once every job is done
+		idle.wait(lock, [this] { return finished == jobCount && active == 0; });
+		currentJob = nullptr;
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, idle;
+	// The batch being run. All but nextJob are guarded by mutex.
+	const std::function<void(int)>* currentJob = nullptr;
+	int jobCount = 0;
+	std::atomic<int> nextJob = 0;
+	int finished = 0;
+	int active = 0;
+	uint64_t generation = 0;
+	bool stopping = false;
+
+	int runJobs(const std::function<void(int)>& job, int jobs) {
+		int ran = 0;
+		for (int i = nextJob++; i < jobs; i = nextJob++) {
+			job(i);
+			ran++;
+		}
+		return ran;
+	}
+
+	void work() {
+		uint64_t seen = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+			const std::function<void(int)>* job = currentJob;
+			int jobs = currentJob ? jobCount : 0;
+			active++;
+			lock.unlock();
+
+			int ran = job ? runJobs(*job, jobs) : 0;
+
+			lock.lock();
+			finished += ran;
+			active--;
+			idle.notify_all();
+		}
+	}
+};
+
+// The number of written keys kept for choosing partition boundaries
+constexpr int kSampledKeys = 1024;
+
+class PartitionedConflictHistory final : public IConflictHistory, NonCopyable {
+public:
+	PartitionedConflictHistory(std::function<IConflictHistory*(Version)> newPartition,
+	                           int threads,
+	                           int rebalanceWrites,
+	                           double maxImbalance,
+	                           Version version)
+	  : newPartition(newPartition), threads(threads), initialVersion(version),
+	    rebalanceWrites(std::max(1, rebalanceWrites)), maxImbalance(maxImbalance), pool(threads) {
+		// Until there are written keys to choose boundaries from, everything is in one partition
+		current = newLayout({});
+	}
+
+	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) override {
+		// Each job reports conflicts by range, with the range's index standing in for its transaction
+		jobs.clear();
+		addReadJobs(*current, ranges, count, transactionConflictStatus, MAX_VERSION);
+		if (retired) {
+			addReadJobs(*retired, ranges, count, transactionConflictStatus, retiredVersion);
+		}
+		for (auto& job : jobs) {
+			job.conflicts.reset(new bool[count]());
+		}
+
+		pool.run(jobs.size(), [&](int j) {
+			ReadJob& job = jobs[j];
+			job.history->detectConflicts(job.ranges.data(), job.ranges.size(), job.conflicts.get());
+		});
+
+		for (int r = 0; r < count; r++) {
+			bool conflict = false;
+			for (const auto& job : jobs) {
+				conflict = conflict || job.conflicts[r];
+			}
+			if (conflict) {
+				const ReadConflictRange& range = ranges[r];
+				transactionConflictStatus[range.transaction] = true;
+				if (range.conflictingKeyRange != nullptr) {
+					range.conflictingKeyRange->push_back(*range.cKRArena, range.indexInTx);
+				}
+			}
+		}
+	}
+
+	void addConflictRanges(const std::pair<StringRef, StringRef>* ranges, int count, Version now) override {
+		const int partitions = current->partitions.size();
+		writes.resize(partitions);
+		for (auto& w : writes) {
+			w.clear();
+		}
+		for (int r = 0; r < count; r++) {
+			current->forEachPartition(ranges[r].first, ranges[r].second, [&](int p, StringRef begin, StringRef end) {
+				writes[p].emplace_back(begin, end);
+			});
+			sampleWrite(ranges[r].first);
+		}
+
+		pool.run(partitions, [&](int p) {
+			if (!writes[p].empty()) {
+				current->partitions[p]->addConflictRanges(writes[p].data(), writes[p].size(), now);
+			}
+		});
+
+		for (int p = 0; p < partitions; p++) {
+			windowWrites[p] += writes[p].size();
+		}
+		windowTotal += count;
+		if (windowTotal >= rebalanceWrites) {
+			maybeRepartition(now);
+			windowWrites.assign(current->partitions.size(), 0);
+			windowTotal = 0;
+		}
+	}
+
+	// Each partition keeps its own position, so removalKey is not used and the returned key is always empty
+	Key removeBefore(Version oldestVersion, KeyRef removalKey, int nodeCount) override {
+		if (retired && oldestVersion >= retiredVersion) {
+			// Reads which could still conflict with a write to the retired partitions are all too old now
+			retired.reset();
+		}
+		Layout& layout = *current;
+		pool.run(layout.partitions.size(), [&](int p) {
+			layout.removalKeys[p] = layout.partitions[p]->removeBefore(oldestVersion, layout.removalKeys[p], nodeCount);
+		});
+		return Key();
+	}
+
+	int count() const override { return current->count() + (retired ? retired->count() : 0); }
+
+	// The current boundaries are kept, as they still split the written keys as well as they did
+	void clear(Version version) override {
+		initialVersion = version;
+		retired.reset();
+		Layout& layout = *current;
+		pool.run(layout.partitions.size(), [&](int p) {
+			layout.partitions[p]->clear(version);
+			layout.removalKeys[p] = Key();
+		});
+	}
+
+private:
+	struct Layout {
+		// Partition i holds the keys in [boundaries[i - 1], boundaries[i])
+		std::vector<Key> boundaries;
+		std::vector<std::unique_ptr<IConflictHistory>> partitions;
+		std::vector<Key> removalKeys;
+
+		// Calls f(partition, begin, end) for the part of [begin, end) in each partition it overlaps
+		template <class F>
+		void forEachPartition(StringRef begin, StringRef end, const F& f) const {
+			int p = std::upper_bound(boundaries.begin(), boundaries.end(), begin) - boundaries.begin();
+			while (true) {
+				bool last = p == boundaries.size() || end <= boundaries[p];
+				f(p, p > 0 ? std::max(begin, StringRef(boundaries[p - 1])) : begin, last ? end : StringRef(boundaries[p]));
+				if (last) {
+					return;
+				}
+				p++;
+			}
+		}
+
+		int count() const {
+			int n = 0;
+			for (const auto& partition : partitions) {
+				n += partition->count();
+			}
+			return n;
+		}
+	};
+
+	struct ReadJob {
+		IConflictHistory* history;
+		std::vector<ReadConflictRange> ranges;
+		std::unique_ptr<bool[]> conflicts;
+	};
+
+	const std::function<IConflictHistory*(Version)> newPartition;
+	const int threads;
+	Version initialVersion;
+	const int rebalanceWrites;
+	const double maxImbalance;
+
+	std::unique_ptr<Layout> current;
+	// The previous partitions, which take no writes after retiredVersion
+	std::unique_ptr<Layout> retired;
+	Version retiredVersion = invalidVersion;
+
+	// Writes per partition since the last rebalance check
+	std::vector<int64_t> windowWrites;
+	int64_t windowTotal = 0;
+	std::vector<Key> sample;
+	int64_t sampled = 0;
+
+	ConflictWorkerPool pool;
+	std::vector<ReadJob> jobs;
+	std::vector<std::vector<std::pair<StringRef, StringRef>>> writes;
+
+	std::unique_ptr<Layout> newLayout(std::vector<Key> boundaries) {
+		auto layout = std::make_unique<Layout>();
+		layout->boundaries = std::move(boundaries);
+		for (int p = 0; p <= layout->boundaries.size(); p++) {
+			// A new partition has no writes of its own, and the history from before it started is kept by the
+			// partitions it replaces
+			layout->partitions.emplace_back(newPartition(initialVersion));
+			layout->removalKeys.emplace_back();
+		}
+		windowWrites.assign(layout->partitions.size(), 0);
+		return layout;
+	}
+
+	// Adds a job per partition of layout for the ranges which can conflict with writes at or before maxVersion
+	void addReadJobs(const Layout& layout,
+	                 ReadConflictRange* ranges,
+	                 int count,
+	                 const bool* transactionConflictStatus,
+	                 Version maxVersion) {
+		const int first = jobs.size();
+		for (const auto& partition : layout.partitions) {
+			jobs.push_back(ReadJob{ partition.get(), {}, nullptr });
+		}
+		for (int r = 0; r < count; r++) {
+			const ReadConflictRange& range = ranges[r];
+			if (range.version >= maxVersion ||
+			    (transactionConflictStatus[range.transaction] && range.conflictingKeyRange == nullptr)) {
+				continue;
+			}
+			layout.forEachPartition(range.begin, range.end, [&](int p, StringRef begin, StringRef end) {
+				jobs[first + p].ranges.emplace_back(begin, end, range.version, r, range.indexInTx);
+			});
+		}
+	}
+
+	// Keeps every so many written keys, so that the sample covers about one rebalance window
+	void sampleWrite(StringRef key) {
+		const int64_t interval = std::max(1, rebalanceWrites / kSampledKeys);
+		if (sampled++ % interval != 0) {
+			return;
+		}
+		if (sample.size() < kSampledKeys) {
+			sample.emplace_back(key);
+		} else {
+			sample[(sampled / interval) % kSampledKeys] = key;
+		}
+	}
+
+	void maybeRepartition(Version now) {
+		if (retired) {
+			// Reads are still being checked against the partitions before the current ones
+			return;
+		}
+		const int partitions = current->partitions.size();
+		const int64_t busiest = *std::max_element(windowWrites.begin(), windowWrites.end());
+		if (partitions == threads && busiest <= maxImbalance * windowTotal / partitions) {
+			return;
+		}
+
+		std::vector<Key> sorted = sample;
+		std::sort(sorted.begin(), sorted.end());
+		std::vector<Key> boundaries;
+		for (int i = 1; i < threads; i++) {
+			const Key& k = sorted[i * sorted.size() / threads];
+			if (k.size() > 0 && (boundaries.empty() || boundaries.back() < k)) {
+				boundaries.push_back(k);
+			}
+		}
+		if (boundaries == current->boundaries) {
+			return;
+		}
+
+		TraceEvent("ConflictSetRepartition")
+		    .detail("Version", now)
+		    .detail("Partitions", boundaries.size() + 1)
+		    .detail("PreviousPartitions", partitions)
+		    .detail("BusiestPartitionWrites", busiest)
+		    .detail("Writes", windowTotal);
+		retired = std::move(current);
+		retiredVersion = now;
+		current = newLayout(std::move(boundaries));
+	}
+};
+
+} // namespace
+
+IConflictHistory* newPartitionedConflictHistory(std::function<IConflictHistory*(Version)> newPartition,
+                                                int threads,
+                                                int rebalanceWrites,
+                                                double maxImbalance,
+                                                Version version) {
+	return new PartitionedConflictHistory(newPartition, threads, rebalanceWrites, maxImbalance, version);
+}
+
+namespace {
+
+// Keys are drawn from a window of the key space which moves partway through the test, so that the partitions
+// chosen from early writes become unbalanced
+StringRef randomPartitionTestKey(Arena& arena, int windowStart, int windowSize) {
+	int k = windowStart + deterministicRandom()->randomInt(0, windowSize);
+	std::string s = format("%08d", k);
+	if (deterministicRandom()->random01() < 0.1) {
+		s.append(deterministicRandom()->randomInt(1, 3), '\x00');
+	}
+	return StringRef(arena, s);
+}
+
+KeyRangeRef randomPartitionTestRange(Arena& arena, int windowStart, int windowSize) {
+	StringRef a = randomPartitionTestKey(arena, windowStart, windowSize);
+	if (deterministicRandom()->random01() < 0.7) {
+		return KeyRangeRef(a, keyAfter(a, arena));
+	}
+	StringRef b = randomPartitionTestKey(arena, windowStart, windowSize);
+	if (a == b) {
+		return KeyRangeRef(a, keyAfter(a, arena));
+	}
+	return a < b ? KeyRangeRef(a, b) : KeyRangeRef(b, a);
+}
+
+} // namespace
+
+// Runs the same randomized batches through a single skiplist and a partitioned history of a random engine, and checks
+// they agree
+TEST_CASE("/fdbserver/ConflictSet/Partitioned") {
+	const std::vector<ConflictSetEngine> engines = { ConflictSetEngine::SkipList,
+	                                                 ConflictSetEngine::PackedBTree,
+	                                                 ConflictSetEngine::ART };
+	const ConflictSetEngine engine = deterministicRandom()->randomChoice(engines);
+	const int threads = deterministicRandom()->randomInt(2, 5);
+	ConflictSet* single = newConflictSet(ConflictSetEngine::SkipList,
+	                                     1,
+	                                     SERVER_KNOBS->RESOLVER_PARTITION_REBALANCE_WRITES,
+	                                     SERVER_KNOBS->RESOLVER_PARTITION_MAX_IMBALANCE);
+	ConflictSet* partitioned = newConflictSet(engine,
+	                                          threads,
+	                                          deterministicRandom()->randomInt(50, 500),
+	                                          SERVER_KNOBS->RESOLVER_PARTITION_MAX_IMBALANCE);
+	const int keySpace = 100000;
+	const int batches = 400;
+	int windowStart = 0;
+	int windowSize = keySpace;
+	Version version = 100;
+	for (int b = 0; b < batches; b++) {
+		if (b == batches / 2) {
+			windowStart = deterministicRandom()->randomInt(0, keySpace - keySpace / 20);
+			windowSize = keySpace / 20;
+		}
+		if (b == batches * 3 / 4) {
+			// The partitioned history keeps its boundaries when cleared, which must not change its answers
+			clearConflictSet(single, version);
+			clearConflictSet(partitioned, version);
+		}
+
+		Arena arena;
+		std::vector<CommitTransactionRef> trs;
+		int transactions = deterministicRandom()->randomInt(1, 100);
+		for (int t = 0; t < transactions; t++) {
+			CommitTransactionRef tr;
+			tr.read_snapshot = version - deterministicRandom()->randomInt(0, 20);
+			tr.report_conflicting_keys = deterministicRandom()->coinflip();
+			int reads = deterministicRandom()->randomInt(0, 5);
+			for (int r = 0; r < reads; r++) {
+				tr.read_conflict_ranges.push_back(arena, randomPartitionTestRange(arena, windowStart, windowSize));
+			}
+			int writes = deterministicRandom()->randomInt(0, 5);
+			for (int w = 0; w < writes; w++) {
+				tr.write_conflict_ranges.push_back(arena, randomPartitionTestRange(arena, windowStart, windowSize));
+			}
+			trs.push_back(tr);
+		}
+
+		Version newOldestVersion = version - 10;
+		std::vector<int> expected, actual, expectedTooOld, actualTooOld;
+		std::map<int, VectorRef<int>> expectedKeys, actualKeys;
+		Arena keysArena;
+		ConflictBatch singleBatch(single, &expectedKeys, &keysArena);
+		ConflictBatch partitionedBatch(partitioned, &actualKeys, &keysArena);
+		for (const auto& tr : trs) {
+			singleBatch.addTransaction(tr, newOldestVersion);
+			partitionedBatch.addTransaction(tr, newOldestVersion);
+		}
+		singleBatch.detectConflicts(version, newOldestVersion, expected, &expectedTooOld);
+		partitionedBatch.detectConflicts(version, newOldestVersion, actual, &actualTooOld);
+		ASSERT(expected == actual);
+		ASSERT(expectedTooOld == actualTooOld);
+		ASSERT(expectedKeys.size() == actualKeys.size());
+		for (auto& [t, keys] : expectedKeys) {
+			// The skiplist reports conflicting ranges in the order its searches finish
+			std::sort(keys.begin(), keys.end());
+			ASSERT(actualKeys[t] == keys);
+		}
+		version += deterministicRandom()->randomInt(1, 3);
+	}
+
+	destroyConflictSet(single);
+	destroyConflictSet(partitioned);
+	return Void();
+}
@@ -33,6 +33,9 @@
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbclient/SystemData.h"
 #include "fdbserver/ConflictSet.h"
+#include "fdbserver/IConflictHistory.h"
+#include "fdbserver/Knobs.h"
+#include "flow/UnitTest.h"
 
 static std::vector<PerfDoubleCounter*> skc;
 
@@ -47,39 +50,6 @@ PerfDoubleCounter g_buildTest("Build", skc), g_add("Add", skc), g_detectConflict
     g_combine("D.Combine", skc), g_checkRead("D.CheckRead", skc), g_checkBatch("D.CheckIntraBatch", skc),
     g_merge("D.MergeWrite", skc), g_removeBefore("D.RemoveBefore", skc);
 
-static force_inline int compare(const StringRef& a, const StringRef& b) {
-	int c = memcmp(a.begin(), b.begin(), std::min(a.size(), b.size()));
-	if (c < 0)
-		return -1;
-	if (c > 0)
-		return +1;
-	if (a.size() < b.size())
-		return -1;
-	if (a.size() == b.size())
-		return 0;
-	return +1;
-}
-
-struct ReadConflictRange {
-	StringRef begin, end;
-	Version version;
-	int transaction;
-	int indexInTx;
-	VectorRef<int>* conflictingKeyRange;
-	Arena* cKRArena;
-
-	ReadConflictRange(StringRef begin,
-	                  StringRef end,
-	                  Version version,
-	                  int transaction,
-	                  int indexInTx,
-	                  VectorRef<int>* cKR = nullptr,
-	                  Arena* cKRArena = nullptr)
-	  : begin(begin), end(end), version(version), transaction(transaction), indexInTx(indexInTx),
-	    conflictingKeyRange(cKR), cKRArena(cKRArena) {}
-	bool operator<(const ReadConflictRange& rhs) const { return compare(begin, rhs.begin) < 0; }
-};
-
 struct KeyInfo {
 	StringRef key;
 	int* pIndex;
@@ -219,7 +189,7 @@ void sortPoints(std::vector<KeyInfo>& points) {
 	}
 }
 
-class SkipList : NonCopyable {
+class SkipList : public IConflictHistory, NonCopyable {
 private:
 	static constexpr int MaxLevels = 26;
 
@@ -401,7 +371,7 @@ public:
 	};
 
 	// Returns the total number of nodes in the list.
-	int count() const {
+	int count() const override {
 		int count = 0;
 		Node* x = header->getNext(0);
 		while (x) {
@@ -411,6 +381,8 @@ public:
 		return count;
 	}
 
+	void clear(Version version) override { *this = SkipList(version); }
+
 	explicit SkipList(Version version = 0) {
 		header = Node::create(StringRef(), MaxLevels - 1);
 		for (int l = 0; l < MaxLevels; l++) {
@@ -418,7 +390,7 @@ public:
 			header->setMaxVersion(l, version);
 		}
 	}
-	~SkipList() { destroy(); }
+	~SkipList() override { destroy(); }
 	SkipList(SkipList&& other) noexcept : header(other.header) { other.header = nullptr; }
 	void operator=(SkipList&& other) noexcept {
 		destroy();
@@ -440,7 +412,26 @@ public:
 		}
 	}
 
-	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) {
+	void addConflictRanges(const std::pair<StringRef, StringRef>* ranges, int count, Version now) override {
+		static_assert(sizeof(*ranges) == sizeof(StringRef) * 2,
+		              "Write Conflict Range type not convertible to two StringPtrs");
+		const StringRef* strings = reinterpret_cast<const StringRef*>(ranges);
+		const int stringCount = count * 2;
+
+		const int stripeSize = 16;
+		Finger fingers[stripeSize];
+		int temp[stripeSize];
+		int stripes = (stringCount + stripeSize - 1) / stripeSize;
+
+		int ss = stringCount - (stripes - 1) * stripeSize;
+		for (int s = stripes - 1; s >= 0; s--) {
+			find(&strings[s * stripeSize], fingers, temp, ss);
+			addConflictRanges(fingers, ss / 2, now);
+			ss = stripeSize;
+		}
+	}
+
+	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) override {
 		const int M = 16;
 		int nextJob[M];
 		CheckMax inProgress[M];
@@ -573,6 +564,14 @@ public:
 		}
 	}
 
+	Key removeBefore(Version v, KeyRef removalKey, int nodeCount) override {
+		Finger finger;
+		int temp;
+		find(&removalKey, &finger, &temp, 1);
+		removeBefore(v, finger, nodeCount);
+		return Key(finger.getValue());
+	}
+
 	int removeBefore(Version v, Finger& f, int nodeCount) {
 		// f.x, f.alreadyChecked?
 
@@ -782,20 +781,68 @@ private:
 	}
 };
 
+IConflictHistory* newSkipListConflictHistory(Version version) {
+	return new SkipList(version);
+}
+
+static IConflictHistory* newConflictHistory(ConflictSetEngine engine, Version version) {
+	switch (engine) {
+	case ConflictSetEngine::SkipList:
+		return newSkipListConflictHistory(version);
+	case ConflictSetEngine::PackedBTree:
+		return newPackedConflictHistory(version);
+	case ConflictSetEngine::ART:
+		return newArtConflictHistory(version);
+	default:
+		UNREACHABLE();
+	}
+}
+
 struct ConflictSet {
-	ConflictSet() : removalKey(makeString(0)), oldestVersion(0) {}
+	ConflictSet(ConflictSetEngine engine, int threads, int rebalanceWrites, double maxImbalance)
+	  : engine(engine), threads(threads), rebalanceWrites(rebalanceWrites), maxImbalance(maxImbalance),
+	    versionHistory(newHistory(0)), removalKey(makeString(0)), oldestVersion(0) {}
 	~ConflictSet() {}
 
-	SkipList versionHistory;
+	IConflictHistory* newHistory(Version version) const {
+		if (threads > 1) {
+			ConflictSetEngine e = engine;
+			return newPartitionedConflictHistory(
+			    [e](Version v) { return newConflictHistory(e, v); }, threads, rebalanceWrites, maxImbalance, version);
+		}
+		return newConflictHistory(engine, version);
+	}
+
+	ConflictSetEngine engine;
+	int threads;
+	int rebalanceWrites;
+	double maxImbalance;
+	std::unique_ptr<IConflictHistory> versionHistory;
 	Key removalKey;
 	Version oldestVersion;
 };
 
 ConflictSet* newConflictSet() {
-	return new ConflictSet;
+	const std::string& engine = SERVER_KNOBS->RESOLVER_CONFLICT_SET_ENGINE;
+	ConflictSetEngine e = ConflictSetEngine::SkipList;
+	if (engine == "packedbtree") {
+		e = ConflictSetEngine::PackedBTree;
+	} else if (engine == "art") {
+		e = ConflictSetEngine::ART;
+	} else if (engine != "skiplist") {
+		TraceEvent(SevWarnAlways, "UnknownConflictSetEngine").detail("Engine", engine);
+	}
+	return newConflictSet(e,
+	                      SERVER_KNOBS->RESOLVER_CONFLICT_SET_THREADS,
+	                      SERVER_KNOBS->RESOLVER_PARTITION_REBALANCE_WRITES,
+	                      SERVER_KNOBS->RESOLVER_PARTITION_MAX_IMBALANCE);
+}
+ConflictSet* newConflictSet(ConflictSetEngine engine, int threads, int rebalanceWrites, double maxImbalance) {
+	return new ConflictSet(engine, threads, rebalanceWrites, maxImbalance);
 }
 void clearConflictSet(ConflictSet* cs, Version v) {
-	SkipList(v).swap(cs->versionHistory);
+	// Clearing keeps the history itself, so a partitioned history keeps its threads
+	cs->versionHistory->clear(v);
 }
 void destroyConflictSet(ConflictSet* cs) {
 	delete cs;
@@ -971,11 +1018,8 @@ void ConflictBatch::detectConflicts(Version now,
 	t = timer();
 	if (newOldestVersion > cs->oldestVersion) {
 		cs->oldestVersion = newOldestVersion;
-		SkipList::Finger finger;
-		int temp;
-		cs->versionHistory.find(&cs->removalKey, &finger, &temp, 1);
-		cs->versionHistory.removeBefore(cs->oldestVersion, finger, combinedWriteConflictRanges.size() * 3 + 10);
-		cs->removalKey = finger.getValue();
+		cs->removalKey = cs->versionHistory->removeBefore(
+		    cs->oldestVersion, cs->removalKey, combinedWriteConflictRanges.size() * 3 + 10);
 	}
 	g_removeBefore += timer() - t;
 }
@@ -984,38 +1028,23 @@ void ConflictBatch::checkReadConflictRanges() {
 	if (combinedReadConflictRanges.empty())
 		return;
 
-	cs->versionHistory.detectConflicts(
+	cs->versionHistory->detectConflicts(
 	    &combinedReadConflictRanges[0], combinedReadConflictRanges.size(), transactionConflictStatus);
 }
 
 void ConflictBatch::addConflictRanges(Version now,
                                       std::vector<std::pair<StringRef, StringRef>>::iterator begin,
                                       std::vector<std::pair<StringRef, StringRef>>::iterator end,
-                                      SkipList* part) {
-	const int count = end - begin;
-	static_assert(sizeof(*begin) == sizeof(StringRef) * 2,
-	              "Write Conflict Range type not convertible to two StringPtrs");
-	const StringRef* strings = reinterpret_cast<const StringRef*>(&*begin);
-	const int stringCount = count * 2;
-
-	const int stripeSize = 16;
-	SkipList::Finger fingers[stripeSize];
-	int temp[stripeSize];
-	int stripes = (stringCount + stripeSize - 1) / stripeSize;
-
-	int ss = stringCount - (stripes - 1) * stripeSize;
-	for (int s = stripes - 1; s >= 0; s--) {
-		part->find(&strings[s * stripeSize], fingers, temp, ss);
-		part->addConflictRanges(fingers, ss / 2, now);
-		ss = stripeSize;
-	}
+                                      IConflictHistory* part) {
+	part->addConflictRanges(&*begin, end - begin, now);
 }
 
 void ConflictBatch::mergeWriteConflictRanges(Version now) {
 	if (combinedWriteConflictRanges.empty())
 		return;
 
-	addConflictRanges(now, combinedWriteConflictRanges.begin(), combinedWriteConflictRanges.end(), &cs->versionHistory);
+	addConflictRanges(
+	    now, combinedWriteConflictRanges.begin(), combinedWriteConflictRanges.end(), cs->versionHistory.get());
 }
 
 void ConflictBatch::combineWriteConflictRanges() {
@@ -1198,5 +1227,83 @@ void skipListTest() {
 		printf("%20s: %s\n", counter->getMetric().name().c_str(), counter->getMetric().formatted().c_str());
 	}
 
-	printf("%d entries in version history\n", cs->versionHistory.count());
+	printf("%d entries in version history\n", cs->versionHistory->count());
+}
+
+static StringRef randomConflictKey(Arena& arena, int keySpace) {
+	// A shared prefix longer than eight bytes makes many keys tie on their first eight bytes
+	static const StringRef prefix = "\x15\x02tenant\x00\x02" "dir\x00"_sr;
+	int k = deterministicRandom()->randomInt(0, keySpace);
+	std::string s = deterministicRandom()->coinflip() ? prefix.toString() : std::string();
+	s += std::to_string(k);
+	if (deterministicRandom()->random01() < 0.1) {
+		s.append(deterministicRandom()->randomInt(0, 3), '\x00');
+	}
+	return StringRef(arena, s);
+}
+
+static KeyRangeRef randomConflictRange(Arena& arena, int keySpace) {
+	StringRef a = randomConflictKey(arena, keySpace);
+	if (deterministicRandom()->coinflip()) {
+		return KeyRangeRef(a, keyAfter(a, arena));
+	}
+	StringRef b = randomConflictKey(arena, keySpace);
+	if (a == b) {
+		return KeyRangeRef(a, keyAfter(a, arena));
+	}
+	return a < b ? KeyRangeRef(a, b) : KeyRangeRef(b, a);
+}
+
+// Runs the same randomized batches through the skiplist and each other engine and checks they agree
+TEST_CASE("/fdbserver/ConflictSet/Engines") {
+	for (ConflictSetEngine engine : { ConflictSetEngine::PackedBTree, ConflictSetEngine::ART }) {
+		ConflictSet* skipList = newConflictSet(ConflictSetEngine::SkipList,
+		                                       1,
+		                                       SERVER_KNOBS->RESOLVER_PARTITION_REBALANCE_WRITES,
+		                                       SERVER_KNOBS->RESOLVER_PARTITION_MAX_IMBALANCE);
+		ConflictSet* other = newConflictSet(engine,
+		                                    1,
+		                                    SERVER_KNOBS->RESOLVER_PARTITION_REBALANCE_WRITES,
+		                                    SERVER_KNOBS->RESOLVER_PARTITION_MAX_IMBALANCE);
+		const int keySpace = deterministicRandom()->randomInt(10, 5000);
+		// Enough batches for the ART engine to rebuild its tree at least once
+		const int batches = 3000;
+		Version version = 100;
+		for (int b = 0; b < batches; b++) {
+			Arena arena;
+			std::vector<CommitTransactionRef> trs;
+			int transactions = deterministicRandom()->randomInt(1, 50);
+			for (int t = 0; t < transactions; t++) {
+				CommitTransactionRef tr;
+				tr.read_snapshot = version - deterministicRandom()->randomInt(0, 20);
+				int reads = deterministicRandom()->randomInt(0, 5);
+				for (int r = 0; r < reads; r++) {
+					tr.read_conflict_ranges.push_back(arena, randomConflictRange(arena, keySpace));
+				}
+				int writes = deterministicRandom()->randomInt(0, 5);
+				for (int w = 0; w < writes; w++) {
+					tr.write_conflict_ranges.push_back(arena, randomConflictRange(arena, keySpace));
+				}
+				trs.push_back(tr);
+			}
+
+			Version newOldestVersion = version - 10;
+			std::vector<int> expected, actual, expectedTooOld, actualTooOld;
+			ConflictBatch skipListBatch(skipList);
+			ConflictBatch otherBatch(other);
+			for (const auto& tr : trs) {
+				skipListBatch.addTransaction(tr, newOldestVersion);
+				otherBatch.addTransaction(tr, newOldestVersion);
+			}
+			skipListBatch.detectConflicts(version, newOldestVersion, expected, &expectedTooOld);
+			otherBatch.detectConflicts(version, newOldestVersion, actual, &actualTooOld);
+			ASSERT(expected == actual);
+			ASSERT(expectedTooOld == actualTooOld);
+			version += deterministicRandom()->randomInt(1, 3);
+		}
+
+		destroyConflictSet(skipList);
+		destroyConflictSet(other);
+	}
+	return Void();
 }
@@ -2264,6 +2264,11 @@ ACTOR Future<Void> storageCacheServer(StorageServerInterface ssi,
 			when(GetKeyValuesRequest req = waitNext(ssi.getKeyValues.getFuture())) {
 				actors.add(getKeyValues(&self, req));
 			}
+			when(GetValuesRequest req = waitNext(ssi.getValues.getFuture())) {
+				// Batched reads are only served by storage servers; simulate endpoint not found so that the
+				// requester will try another endpoint
+				req.reply.sendError(broken_promise());
+			}
 			when(GetShardStateRequest req = waitNext(ssi.getShardState.getFuture())) {
 				ASSERT(false);
 			}
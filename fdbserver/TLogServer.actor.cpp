@@ -571,6 +571,8 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 	Counter blockingPeekTimeouts;
 	Counter emptyPeeks;
 	Counter nonEmptyPeeks;
+	Counter peekBytesReferenced;
+	Counter peekBytesCopied;
 	std::map<Tag, LatencySample> blockingPeekLatencies;
 	std::map<Tag, LatencySample> peekVersionCounts;
 
@@ -660,7 +662,8 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 	    unpoppedRecoveredTagCount(0), cc("TLog", interf.id().toString()), bytesInput("BytesInput", cc),
 	    bytesDurable("BytesDurable", cc), blockingPeeks("BlockingPeeks", cc),
 	    blockingPeekTimeouts("BlockingPeekTimeouts", cc), emptyPeeks("EmptyPeeks", cc),
-	    nonEmptyPeeks("NonEmptyPeeks", cc), logId(interf.id()), protocolVersion(protocolVersion),
+	    nonEmptyPeeks("NonEmptyPeeks", cc), peekBytesReferenced("PeekBytesReferenced", cc),
+	    peekBytesCopied("PeekBytesCopied", cc), logId(interf.id()), protocolVersion(protocolVersion),
 	    newPersistentDataVersion(invalidVersion), tLogData(tLogData), unrecoveredBefore(1), recoveredAt(1),
 	    recoveryTxnVersion(1), logSystem(new AsyncVar<Reference<ILogSystem>>()), remoteTag(remoteTag),
 	    isPrimary(isPrimary), logRouterTags(logRouterTags), logRouterPoppedVersion(0), logRouterPopToVersion(0),
@@ -1660,14 +1663,19 @@ ACTOR Future<Void> waitForMessagesForTag(Reference<LogData> self, Tag reqTag, Ve
 	return Void();
 }
 
-void peekMessagesFromMemory(Reference<LogData> self,
-                            Tag tag,
-                            Version begin,
-                            BinaryWriter& messages,
-                            Version& endVersion) {
-	ASSERT(!messages.getLength());
+// Appends the in-memory messages for tag from version begin onwards to reply, stopping at a version boundary once
+// DESIRED_TOTAL_BYTES have been gathered. With TLOG_PEEK_REFERENCE_MESSAGE_BLOCKS, the reply refers to the message
+// blocks holding the messages rather than copying them. Returns the number of message bytes referenced.
+int64_t peekMessagesFromMemory(Reference<LogData> self,
+                               Tag tag,
+                               Version begin,
+                               TLogPeekReply& reply,
+                               Version& endVersion) {
+	ASSERT(!reply.messageBytes());
 
 	int versionCount = 0;
+	int64_t bytes = 0;
+	int64_t referencedBytes = 0;
 	auto& deque = getVersionMessages(self, tag);
 	//TraceEvent("TLogPeekMem", self->dbgid).detail("Tag", req.tag1).detail("PDS", self->persistentDataSequence).detail("PDDS", self->persistentDataDurableSequence).detail("Oldest", map1.empty() ? 0 : map1.begin()->key ).detail("OldestMsgCount", map1.empty() ? 0 : map1.begin()->value.size());
 
@@ -1677,27 +1685,69 @@ void peekMessagesFromMemory(Reference<LogData> self,
 	                           std::make_pair(begin, LengthPrefixedStringRef()),
 	                           [](const auto& l, const auto& r) -> bool { return l.first < r.first; });
 
+	// Every message committed at a version is in a message block added at that version. Find the first block at or
+	// after begin; blocks are then visited in step with the versions peeked.
+	const bool referenceBlocks = SERVER_KNOBS->TLOG_PEEK_REFERENCE_MESSAGE_BLOCKS;
+	const auto& blocks = self->messageBlocks;
+	const int blockCount = blocks.size();
+	int block = 0;
+	if (referenceBlocks) {
+		int hi = blockCount;
+		while (block < hi) {
+			int mid = block + (hi - block) / 2;
+			if (blocks[mid].first < begin) {
+				block = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+	}
+	const Arena* lastArena = nullptr;
+	bool versionReferenced = false;
+
 	Version currentVersion = -1;
 	for (; it != deque.end(); ++it) {
 		if (it->first != currentVersion) {
-			if (messages.getLength() >= SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
+			if (bytes >= SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
 				endVersion = currentVersion + 1;
 				//TraceEvent("TLogPeekMessagesReached2", self->dbgid);
 				break;
 			}
 
 			currentVersion = it->first;
-			messages << VERSION_HEADER << currentVersion;
+			uint8_t* header = new (reply.arena) uint8_t[sizeof(VERSION_HEADER) + sizeof(Version)];
+			memcpy(header, &VERSION_HEADER, sizeof(VERSION_HEADER));
+			memcpy(header + sizeof(VERSION_HEADER), &currentVersion, sizeof(Version));
+			reply.appendMessages(StringRef(header, sizeof(VERSION_HEADER) + sizeof(Version)));
+			bytes += sizeof(VERSION_HEADER) + sizeof(Version);
+
+			// The reply keeps this version's message blocks alive for as long as it refers to them
+			versionReferenced = false;
+			if (referenceBlocks) {
+				while (block < blockCount && blocks[block].first < currentVersion) {
+					block++;
+				}
+				for (; block < blockCount && blocks[block].first == currentVersion; block++) {
+					const Arena& arena = blocks[block].second.arena();
+					if (lastArena == nullptr || !lastArena->sameArena(arena)) {
+						reply.arena.dependsOn(arena);
+						lastArena = &arena;
+					}
+					versionReferenced = true;
+				}
+			}
 		}
 
-		// We need the 4 byte length prefix to be a TagsAndMessage format, but that prefix is added as part of StringRef
-		// serialization.
-		int offset = messages.getLength();
-		messages << it->second.toStringRef();
-		void* data = messages.getData();
-		DEBUG_TAGS_AND_MESSAGE(
-		    "TLogPeek", currentVersion, StringRef((uint8_t*)data + offset, messages.getLength() - offset), self->logId)
-		    .detail("PeekTag", tag);
+		// Messages are kept in the peek reply format, with their 4 byte length prefix
+		StringRef message((uint8_t*)it->second.getLengthPtr(), sizeof(uint32_t) + it->second.expectedSize());
+		if (versionReferenced) {
+			reply.appendMessages(message);
+			referencedBytes += message.size();
+		} else {
+			reply.appendMessages(StringRef(reply.arena, message));
+		}
+		bytes += message.size();
+		DEBUG_TAGS_AND_MESSAGE("TLogPeek", currentVersion, message, self->logId).detail("PeekTag", tag);
 		versionCount++;
 	}
 
@@ -1716,6 +1766,7 @@ void peekMessagesFromMemory(Reference<LogData> self,
 		LatencySample& sample = self->peekVersionCounts.at(tag);
 		sample.addMeasurement(versionCount);
 	}
+	return referencedBytes;
 }
 
 ACTOR Future<std::vector<StringRef>> parseMessagesForTag(StringRef commitBlob, Tag tag, int logRouters) {
@@ -1751,8 +1802,11 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
                               bool reqOnlySpilled = false,
                               Optional<std::pair<UID, int>> reqSequence = Optional<std::pair<UID, int>>(),
                               Optional<Version> reqEnd = Optional<Version>()) {
+	// Spilled messages read from disk, which are sent ahead of any messages from memory
 	state BinaryWriter messages(Unversioned());
-	state BinaryWriter messages2(Unversioned());
+	state TLogPeekReply memoryMessages;
+	state bool sendMemoryMessages;
+	state int64_t memoryBytesReferenced;
 	state int sequence = -1;
 	state UID peekId;
 	state double queueStart = now();
@@ -1894,6 +1948,9 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 	// Run the peek logic in a loop to account for the case where there is no data to return to the caller, and we may
 	// want to wait a little bit instead of just sending back an empty message. This feature is controlled by a knob.
 	loop {
+		memoryMessages = TLogPeekReply();
+		sendMemoryMessages = false;
+		memoryBytesReferenced = 0;
 		poppedVer = poppedVersion(logData, reqTag);
 
 		auto tagData = logData->getTagData(reqTag);
@@ -1979,7 +2036,8 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 			if (reqOnlySpilled) {
 				endVersion = logData->persistentDataDurableVersion + 1;
 			} else {
-				peekMessagesFromMemory(logData, reqTag, reqBegin, messages2, endVersion);
+				memoryBytesReferenced =
+				    peekMessagesFromMemory(logData, reqTag, reqBegin, memoryMessages, endVersion);
 			}
 
 			if (logData->shouldSpillByValue(reqTag)) {
@@ -2000,7 +2058,7 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 					endVersion = decodeTagMessagesKey(kvs.end()[-1].key) + 1;
 					onlySpilled = true;
 				} else {
-					messages.serializeBytes(messages2.toValue());
+					sendMemoryMessages = true;
 				}
 			} else {
 				// FIXME: Limit to approximately DESIRED_TOTATL_BYTES somehow.
@@ -2088,14 +2146,16 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 					endVersion = lastRefMessageVersion + 1;
 					onlySpilled = true;
 				} else {
-					messages.serializeBytes(messages2.toValue());
+					sendMemoryMessages = true;
 				}
 			}
 		} else {
 			if (reqOnlySpilled) {
 				endVersion = logData->persistentDataDurableVersion + 1;
 			} else {
-				peekMessagesFromMemory(logData, reqTag, reqBegin, messages, endVersion);
+				memoryBytesReferenced =
+				    peekMessagesFromMemory(logData, reqTag, reqBegin, memoryMessages, endVersion);
+				sendMemoryMessages = true;
 			}
 
 			//TraceEvent("TLogPeekResults", self->dbgid).detail("ForAddress", replyPromise.getEndpoint().getPrimaryAddress()).detail("MessageBytes", messages.getLength()).detail("NextEpoch", next_pos.epoch).detail("NextSeq", next_pos.sequence).detail("NowSeq", self->sequence.getNextSequence());
@@ -2105,7 +2165,8 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 		//   - Have data return to the caller, or
 		//   - Batching empty peek is disabled, or
 		//   - Batching empty peek interval has been reached.
-		if (messages.getLength() > 0 || !SERVER_KNOBS->PEEK_BATCHING_EMPTY_MSG ||
+		if (messages.getLength() > 0 || (sendMemoryMessages && memoryMessages.messageBytes() > 0) ||
+		    !SERVER_KNOBS->PEEK_BATCHING_EMPTY_MSG ||
 		    (now() - blockStart > SERVER_KNOBS->PEEK_BATCHING_EMPTY_MSG_INTERVAL)) {
 			break;
 		}
@@ -2127,7 +2188,20 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 	reply.minKnownCommittedVersion = logData->minKnownCommittedVersion;
 	auto messagesValue = messages.toValue();
 	reply.arena.dependsOn(messagesValue.arena());
-	reply.messages = messagesValue;
+	reply.appendMessages(messagesValue);
+	int64_t bytesCopied = messagesValue.size();
+	if (sendMemoryMessages) {
+		reply.arena.dependsOn(memoryMessages.arena);
+		for (const StringRef& fragment : memoryMessages.messageFragments) {
+			reply.appendMessages(fragment);
+		}
+		logData->peekBytesReferenced += memoryBytesReferenced;
+		bytesCopied += memoryMessages.messageBytes() - memoryBytesReferenced;
+	}
+	if (!SERVER_KNOBS->TLOG_PEEK_REFERENCE_MESSAGE_BLOCKS) {
+		reply.flattenMessages();
+	}
+	logData->peekBytesCopied += bytesCopied;
 	reply.end = endVersion;
 	if (replyWithRecoveryVersion.present()) {
 		reply.end = replyWithRecoveryVersion.get();
@@ -2139,7 +2213,7 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 	    .detail("Tag", reqTag.toString())
 	    .detail("ReqBegin", reqBegin)
 	    .detail("EndVer", reply.end)
-	    .detail("MsgBytes", reply.messages.expectedSize());
+	    .detail("MsgBytes", reply.messageBytes());
 
 	if (reqSequence.present()) {
 		auto& trackerData = logData->peekTracker[peekId];
@@ -2150,7 +2224,7 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 		double workT = now() - workStart;
 
 		trackerData.totalPeeks++;
-		trackerData.replyBytes += reply.messages.size();
+		trackerData.replyBytes += reply.messageBytes();
 
 		if (queueT > trackerData.queueMax)
 			trackerData.queueMax = queueT;
@@ -3941,3 +4015,42 @@ TEST_CASE("Lfdbserver/tlogserver/VersionMessagesOverheadFactor") {
 
 	return Void();
 }
+
+TEST_CASE("/fdbserver/tlogserver/PeekReplyFragments") {
+	Standalone<StringRef> data = makeString(deterministicRandom()->randomInt(1, 1000));
+	deterministicRandom()->randomBytes(mutateString(data), data.size());
+
+	// The same bytes split into fragments, some of which follow each other in memory
+	TLogPeekReply fragmented;
+	fragmented.arena.dependsOn(data.arena());
+	int offset = 0;
+	while (offset < data.size()) {
+		int length = deterministicRandom()->randomInt(1, data.size() - offset + 1);
+		StringRef fragment = data.substr(offset, length);
+		fragmented.appendMessages(deterministicRandom()->coinflip() ? fragment
+		                                                            : StringRef(fragmented.arena, fragment));
+		offset += length;
+	}
+	TLogPeekReply flat;
+	flat.messages = data;
+	for (TLogPeekReply* reply : { &fragmented, &flat }) {
+		reply->end = 7;
+		reply->maxKnownVersion = 8;
+		reply->minKnownCommittedVersion = 6;
+	}
+	ASSERT_EQ(fragmented.messageBytes(), data.size());
+
+	// Fragments are sent exactly as if the reply had one buffer of messages
+	Standalone<StringRef> sent = ObjectWriter::toValue(fragmented, Unversioned());
+	ASSERT(sent == ObjectWriter::toValue(flat, Unversioned()));
+	TLogPeekReply received = ObjectReader::fromStringRef<TLogPeekReply>(sent, Unversioned());
+	ASSERT(received.messageFragments.empty());
+	ASSERT(received.messages == data);
+	ASSERT_EQ(received.end, 7);
+
+	fragmented.flattenMessages();
+	ASSERT(fragmented.messageFragments.empty());
+	ASSERT(fragmented.messages == data);
+
+	return Void();
+}
@@ -278,7 +278,9 @@ ACTOR Future<Void> TLogTestContext::peekCommitMessages(TLogTestContext* pTLogTes
 		ASSERT_GE(reply.maxKnownVersion, i);
 
 		// deserialize package, first the version header
-		ArenaReader rd = ArenaReader(reply.arena, reply.messages, AssumeVersion(g_network->protocolVersion()));
+		TLogPeekReply peeked = reply;
+		peeked.flattenMessages();
+		ArenaReader rd = ArenaReader(peeked.arena, peeked.messages, AssumeVersion(g_network->protocolVersion()));
 		ASSERT_EQ(*(int32_t*)rd.peekBytes(4), VERSION_HEADER);
 		int32_t dummy; // skip past VERSION_HEADER
 		Version ver;
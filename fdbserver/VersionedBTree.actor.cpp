@@ -32,6 +32,7 @@
 #include "fdbserver/Knobs.h"
 #include "fdbserver/VersionedBTreeDebug.h"
 #include "fdbserver/WorkerInterface.actor.h"
+#include "fdbserver/art.h"
 #include "flow/ActorCollection.h"
 #include "flow/Error.h"
 #include "flow/FastRef.h"
@@ -1459,6 +1460,9 @@ struct RedwoodMetrics {
 		unsigned int pagerProbeMiss;
 		unsigned int pagerEvictUnhit;
 		unsigned int pagerEvictFail;
+		unsigned int pagerCacheAdmit;
+		unsigned int pagerCacheReject;
+		unsigned int pagerCachePromote;
 		unsigned int btreeLeafPreload;
 		unsigned int btreeLeafPreloadExt;
 		unsigned int readRequestDecryptTimeNS;
@@ -1618,6 +1622,87 @@ ACTOR Future<Void> redwoodMetricsLogger() {
 	}
 }
 
+// Approximate access frequencies of recently used objects, which ObjectCache::Evictor uses to decide whether an object
+// leaving its admission window is worth keeping in place of an older one.
+// This is a count-min sketch of 4-bit saturating counters.  Each increment only raises the counters holding the
+// current minimum, and every counter is halved after 10 increments per column so estimates reflect recent use.
+template <class IndexType>
+class FrequencySketch {
+public:
+	static constexpr int depth = 4;
+	static constexpr uint8_t maxCount = 15;
+	static constexpr int64_t minWidth = 1024;
+	static constexpr int64_t maxWidth = 1 << 22;
+
+	int64_t getWidth() const { return width; }
+
+	// Resize the sketch to track about count distinct objects, which discards all estimates if the width changes
+	void ensureCapacity(int64_t count) {
+		int64_t w = minWidth;
+		while (w < count && w < maxWidth) {
+			w <<= 1;
+		}
+		if (w != width) {
+			width = w;
+			counters.assign(depth * width, 0);
+			additions = 0;
+		}
+	}
+
+	int estimate(const IndexType& index) const {
+		if (width == 0) {
+			return 0;
+		}
+		uint64_t h = hash(index);
+		uint8_t count = maxCount;
+		for (int row = 0; row < depth; ++row) {
+			count = std::min(count, counters[slot(h, row)]);
+		}
+		return count;
+	}
+
+	void increment(const IndexType& index) {
+		if (width == 0) {
+			ensureCapacity(0);
+		}
+		uint64_t h = hash(index);
+		size_t slots[depth];
+		uint8_t count = maxCount;
+		for (int row = 0; row < depth; ++row) {
+			slots[row] = slot(h, row);
+			count = std::min(count, counters[slots[row]]);
+		}
+		if (count == maxCount) {
+			return;
+		}
+		for (int row = 0; row < depth; ++row) {
+			if (counters[slots[row]] == count) {
+				++counters[slots[row]];
+			}
+		}
+		if (++additions >= 10 * width) {
+			for (auto& c : counters) {
+				c >>= 1;
+			}
+			additions /= 2;
+		}
+	}
+
+private:
+	static uint64_t hash(const IndexType& index) { return std::hash<IndexType>()(index) * 0x9E3779B97F4A7C15ULL; }
+
+	// Row i uses h1 + i * h2, with h2 odd so the rows disagree about which objects collide
+	size_t slot(uint64_t h, int row) const {
+		uint32_t h1 = h >> 32;
+		uint32_t h2 = (uint32_t)h | 1;
+		return row * width + ((h1 + row * h2) & (width - 1));
+	}
+
+	int64_t width = 0;
+	int64_t additions = 0;
+	std::vector<uint8_t> counters;
+};
+
 // Holds an index of recently used objects.
 // ObjectType must have these methods
 //
@@ -1635,6 +1720,9 @@ class ObjectCache : NonCopyable {
 	struct Entry;
 	typedef std::unordered_map<IndexType, Entry> CacheT;
 
+	// The Evictor list holding an entry which it owns
+	enum Segment : uint8_t { Prioritized = 0, Window, Probation, Protected, SegmentCount };
+
 	struct Entry : public boost::intrusive::list_base_hook<> {
 		Entry() : hits(0), size(0) {}
 		IndexType index;
@@ -1642,6 +1730,7 @@ class ObjectCache : NonCopyable {
 		int hits;
 		int size;
 		bool ownedByEvictor;
+		uint8_t segment;
 		CacheT* pCache;
 	};
 
@@ -1649,9 +1738,20 @@ class ObjectCache : NonCopyable {
 
 public:
 	// Object evictor, manages the eviction order for one or more ObjectCaches
-	// Not all objects tracked by the Evictor are in its evictionOrder, as ObjectCaches
+	// Not all objects tracked by the Evictor are in its eviction orders, as ObjectCaches
 	// using this Evictor can temporarily remove entries to an external order but they
 	// must eventually give them back with moveIn() or remove them with reclaim().
+	//
+	// Eviction follows W-TinyLFU so that one pass over a large range does not flush the working set.
+	//   - New entries go to the back of a small LRU admission window.
+	//   - Entries pushed out of the window join the probation segment of the main cache.  When space is needed, the
+	//     newest probation entry is compared with the oldest by estimated access frequency and the less used one is
+	//     evicted.
+	//   - A probation entry that is hit again is promoted to the protected segment, whose oldest entries are
+	//     demoted back to probation when it outgrows its share.
+	//   - Entries given back with moveIn() are evicted before anything else.
+	// Background accesses (see ObjectCache::get()) are not counted as uses, so scanned objects pass through the
+	// window and probation without displacing anything that is used repeatedly.
 	class Evictor : NonCopyable {
 	public:
 		Evictor(int64_t sizeLimit = 0) : sizeLimit(sizeLimit) {}
@@ -1672,42 +1772,84 @@ public:
 		// but the entry size is still counted against the evictor
 		void moveOut(Entry& e, EvictionOrderT& dest) {
 			ASSERT(e.ownedByEvictor);
-			dest.splice(dest.end(), evictionOrder, EvictionOrderT::s_iterator_to(e));
+			segmentSizes[e.segment] -= e.size;
+			dest.splice(dest.end(), orders[e.segment], EvictionOrderT::s_iterator_to(e));
 			e.ownedByEvictor = false;
 			++movedOutCount;
 		}
 
-		// Move an entry to the back of the eviction order if it is in the eviction order
-		void moveToBack(Entry& e) {
+		// Record a cache hit on an entry owned by the Evictor.
+		// A background hit only refreshes an entry's position in the admission window.
+		void recordHit(Entry& e, bool background) {
 			ASSERT(e.ownedByEvictor);
-			evictionOrder.splice(evictionOrder.end(), evictionOrder, EvictionOrderT::s_iterator_to(e));
+			if (background) {
+				if (e.segment == Window) {
+					relink(e, Window);
+				}
+				return;
+			}
+
+			sketch.increment(e.index);
+			if (e.segment == Probation) {
+				relink(e, Protected);
+				++g_redwoodMetrics.metric.pagerCachePromote;
+				// Demote the least recently used protected entries if the segment is over its share
+				int64_t protectedLimit = (getCapacity() - getWindowLimit()) * protectedFraction;
+				while (segmentSizes[Protected] > protectedLimit && orders[Protected].size() > 1) {
+					relink(orders[Protected].front(), Probation);
+				}
+			} else if (e.segment == Prioritized) {
+				// A hit on an entry queued for eviction means it is in use again
+				relink(e, Window);
+			} else {
+				relink(e, (Segment)e.segment);
+			}
 		}
 
 		// Move entire contents of an external eviction order containing entries whose size is part of
-		// this Evictor to the front of its eviction order.
+		// this Evictor to its prioritized eviction order.
 		void moveIn(EvictionOrderT& otherOrder) {
 			for (auto& e : otherOrder) {
 				ASSERT(!e.ownedByEvictor);
 				e.ownedByEvictor = true;
+				e.segment = Prioritized;
+				segmentSizes[Prioritized] += e.size;
 				--movedOutCount;
 			}
-			evictionOrder.splice(evictionOrder.begin(), otherOrder);
+			orders[Prioritized].splice(orders[Prioritized].end(), otherOrder);
 		}
 
-		// Add a new item to the back of the eviction order
-		void addNew(Entry& e) {
+		// Add a new item to the back of the admission window.  If countUse is set the access counts towards the
+		// item's estimated frequency.
+		void addNew(Entry& e, bool countUse) {
 			sizeUsed += e.size;
-			evictionOrder.push_back(e);
 			e.ownedByEvictor = true;
+			e.segment = Window;
+			orders[Window].push_back(e);
+			segmentSizes[Window] += e.size;
+
+			int64_t count = getCountUsed();
+			if (count > sketch.getWidth()) {
+				sketch.ensureCapacity(2 * count);
+			}
+			if (countUse) {
+				sketch.increment(e.index);
+			}
+
+			// Move the oldest window entries to probation while the window is over its share
+			int64_t windowLimit = getWindowLimit();
+			while (segmentSizes[Window] > windowLimit && orders[Window].size() > 1) {
+				relink(orders[Window].front(), Probation);
+			}
 		}
 
 		// Claim ownership of an entry, removing its size from the current size and removing it
 		// from the eviction order if it exists there
 		void reclaim(Entry& e) {
 			sizeUsed -= e.size;
-			// If e is in evictionOrder then remove it
+			// If e is in one of our eviction orders then remove it
 			if (e.ownedByEvictor) {
-				evictionOrder.erase(EvictionOrderT::s_iterator_to(e));
+				unlink(e);
 				e.ownedByEvictor = false;
 			} else {
 				// Otherwise, it wasn't so it had to be a movedOut item so decrement the count
@@ -1717,46 +1859,87 @@ public:
 
 		void trim(int additionalSpaceNeeded = 0) {
 			int attemptsLeft = FLOW_KNOBS->MAX_EVICT_ATTEMPTS;
-			// While the cache is too big, evict the oldest entry until the oldest entry can't be evicted.
-			while (attemptsLeft-- > 0 && sizeUsed > (sizeLimit - reservedSize - additionalSpaceNeeded) &&
-			       !evictionOrder.empty()) {
-				Entry& toEvict = evictionOrder.front();
+			// While the cache is too big, evict the chosen victim until a victim can't be evicted.
+			while (attemptsLeft-- > 0 && sizeUsed > (sizeLimit - reservedSize - additionalSpaceNeeded)) {
+				Entry* toEvict = nullptr;
+				// Set if the victim was chosen by comparing the newest and oldest probation entries
+				bool admitted = false;
+				bool rejected = false;
+
+				auto& probation = orders[Probation];
+				if (!orders[Prioritized].empty()) {
+					toEvict = &orders[Prioritized].front();
+				} else if (probation.size() > 1) {
+					Entry& candidate = probation.back();
+					Entry& victim = probation.front();
+					if (sketch.estimate(candidate.index) > sketch.estimate(victim.index)) {
+						toEvict = &victim;
+						admitted = true;
+					} else {
+						toEvict = &candidate;
+						rejected = true;
+					}
+				} else if (!probation.empty()) {
+					toEvict = &probation.front();
+				} else if (!orders[Protected].empty()) {
+					toEvict = &orders[Protected].front();
+				} else if (!orders[Window].empty()) {
+					toEvict = &orders[Window].front();
+				} else {
+					break;
+				}
 
 				debug_printf("Evictor count=%d sizeUsed=%" PRId64 " sizeLimit=%" PRId64 " sizePenalty=%" PRId64
-				             " needed=%d  Trying to evict %s evictable %d\n",
-				             (int)evictionOrder.size(),
+				             " needed=%d  Trying to evict %s segment %d evictable %d\n",
+				             (int)getCountUsed(),
 				             sizeUsed,
 				             sizeLimit,
 				             reservedSize,
 				             additionalSpaceNeeded,
-				             ::toString(toEvict.index).c_str(),
-				             toEvict.item.evictable());
-
-				if (!toEvict.item.evictable()) {
-					// shift the front to the back
-					evictionOrder.shift_forward(1);
+				             ::toString(toEvict->index).c_str(),
+				             (int)toEvict->segment,
+				             toEvict->item.evictable());
+
+				if (!toEvict->item.evictable()) {
+					// Send it to the back of its order so the next trim tries something else.  Main cache entries
+					// go back through the window so that they are not chosen again right away.
+					relink(*toEvict, toEvict->segment == Probation ? Window : (Segment)toEvict->segment);
 					++g_redwoodMetrics.metric.pagerEvictFail;
 					break;
 				} else {
-					if (toEvict.hits == 0) {
+					if (toEvict->hits == 0) {
 						++g_redwoodMetrics.metric.pagerEvictUnhit;
 					}
-					sizeUsed -= toEvict.size;
-					debug_printf("Evicting %s\n", ::toString(toEvict.index).c_str());
-					evictionOrder.pop_front();
-					toEvict.pCache->erase(toEvict.index);
+					if (admitted) {
+						++g_redwoodMetrics.metric.pagerCacheAdmit;
+					} else if (rejected) {
+						++g_redwoodMetrics.metric.pagerCacheReject;
+					}
+					sizeUsed -= toEvict->size;
+					debug_printf("Evicting %s\n", ::toString(toEvict->index).c_str());
+					unlink(*toEvict);
+					toEvict->pCache->erase(toEvict->index);
 				}
 			}
 		}
 
-		int64_t getCountUsed() const { return evictionOrder.size() + movedOutCount; }
+		int64_t getCountUsed() const {
+			int64_t count = movedOutCount;
+			for (auto& order : orders) {
+				count += order.size();
+			}
+			return count;
+		}
 		int64_t getCountMoved() const { return movedOutCount; }
 		int64_t getSizeUsed() const { return sizeUsed + reservedSize; }
+		int64_t getWindowSize() const { return segmentSizes[Window]; }
+		int64_t getProtectedSize() const { return segmentSizes[Protected]; }
 
 		// Only to be used in tests at a point where all ObjectCache instances should be destroyed.
 		bool empty() const { return reservedSize == 0 && sizeUsed == 0 && getCountUsed() == 0; }
 
 		std::string toString() const {
+			static const char* segmentNames[] = { "Prioritized", "Window", "Probation", "Protected" };
 			std::string s = format("Evictor {sizeLimit=%" PRId64 " sizeUsed=%" PRId64 " countUsed=%" PRId64
 			                       " sizePenalty=%" PRId64 " movedOutCount=%" PRId64,
 			                       sizeLimit,
@@ -1764,11 +1947,15 @@ public:
 			                       getCountUsed(),
 			                       reservedSize,
 			                       movedOutCount);
-			for (auto& entry : evictionOrder) {
-				s += format("\n\tindex %s  size %d  evictable %d\n",
-				            ::toString(entry.index).c_str(),
-				            entry.size,
-				            entry.item.evictable());
+			for (int i = 0; i < SegmentCount; ++i) {
+				s += format("\n  %s size %" PRId64 "\n", segmentNames[i], segmentSizes[i]);
+				for (auto& entry : orders[i]) {
+					s += format("\n\tindex %s  size %d  evictable %d  frequency %d\n",
+					            ::toString(entry.index).c_str(),
+					            entry.size,
+					            entry.item.evictable(),
+					            sketch.estimate(entry.index));
+				}
 			}
 			s += "}\n";
 			return s;
@@ -1779,9 +1966,33 @@ public:
 		int64_t reservedSize = 0;
 		int64_t sizeLimit;
 
+		// Share of the cache capacity used by the admission window.  At 1.0 nothing ever leaves the window, so
+		// eviction is plain LRU.
+		double windowFraction = 0.01;
+		// Share of the capacity outside the window reserved for entries that were hit after leaving the window
+		double protectedFraction = 0.8;
+
 	private:
-		EvictionOrderT evictionOrder;
-		// Size of all entries in the eviction order or held in external eviction orders
+		int64_t getCapacity() const { return std::max<int64_t>(0, sizeLimit - reservedSize); }
+		int64_t getWindowLimit() const { return getCapacity() * windowFraction; }
+
+		void unlink(Entry& e) {
+			orders[e.segment].erase(EvictionOrderT::s_iterator_to(e));
+			segmentSizes[e.segment] -= e.size;
+		}
+
+		// Move an owned entry to the back of the given segment, which may be the one it is already in
+		void relink(Entry& e, Segment dest) {
+			segmentSizes[e.segment] -= e.size;
+			orders[dest].splice(orders[dest].end(), orders[e.segment], EvictionOrderT::s_iterator_to(e));
+			segmentSizes[dest] += e.size;
+			e.segment = dest;
+		}
+
+		EvictionOrderT orders[SegmentCount];
+		int64_t segmentSizes[SegmentCount] = {};
+		FrequencySketch<IndexType> sketch;
+		// Size of all entries in the eviction orders or held in external eviction orders
 		int64_t sizeUsed = 0;
 		// Number of items that have been moveOut()'d to other evictionOrders and aren't back yet
 		int64_t movedOutCount = 0;
@@ -1819,10 +2030,11 @@ public:
 	}
 
 	// Get the object for i or create a new one.
-	// After a get(), the object for i is the last in evictionOrder.
+	// After a get(), the object for i is the most recently used in its eviction order.
 	// If noHit is set, do not consider this access to be cache hit if the object is present
-	// If noMiss is set, do not consider this access to be a cache miss if the object is not present
-	ObjectType& get(const IndexType& index, int size, bool noHit = false) {
+	// If background is set, the access is part of a scan or other bulk read which should not make the object look
+	// frequently used, so it cannot promote the object within the main cache.
+	ObjectType& get(const IndexType& index, int size, bool noHit = false, bool background = false) {
 		Entry& entry = cache[index];
 
 		// If entry is linked into an evictionOrder
@@ -1830,9 +2042,9 @@ public:
 			// If this access is meant to be a hit
 			if (!noHit) {
 				++entry.hits;
-				// If item eviction is not prioritized, move to end of eviction order
+				// If item eviction is not prioritized externally, update its position
 				if (entry.ownedByEvictor) {
-					pEvictor->moveToBack(entry);
+					pEvictor->recordHit(entry, background);
 				}
 			}
 		} else {
@@ -1845,7 +2057,7 @@ public:
 			entry.size = size;
 
 			pEvictor->trim(entry.size);
-			pEvictor->addNew(entry);
+			pEvictor->addNew(entry, !background);
 		}
 
 		return entry.item;
@@ -2026,8 +2238,10 @@ public:
 	    filename(filename), memoryOnly(memoryOnly), remapCleanupWindowBytes(remapCleanupWindowBytes),
 	    concurrentExtentReads(new FlowLock(concurrentExtentReads)) {
 
-		// This sets the page cache size for all PageCacheT instances using the same evictor
+		// This sets the page cache size and eviction policy for all PageCacheT instances using the same evictor
 		pageCache.evictor().sizeLimit = pageCacheBytes;
+		pageCache.evictor().windowFraction = SERVER_KNOBS->REDWOOD_PAGE_CACHE_WINDOW_FRACTION;
+		pageCache.evictor().protectedFraction = SERVER_KNOBS->REDWOOD_PAGE_CACHE_PROTECTED_FRACTION;
 
 		g_redwoodMetrics.ioLock = ioLock.getPtr();
 		if (!g_redwoodMetricsActor.isValid()) {
@@ -2959,7 +3173,14 @@ public:
 
 	static bool isReadRequest(PagerEventReasons reason) {
 		return reason == PagerEventReasons::PointRead || reason == PagerEventReasons::FetchRange ||
-		       reason == PagerEventReasons::RangeRead || reason == PagerEventReasons::RangePrefetch;
+		       reason == PagerEventReasons::RangeRead || reason == PagerEventReasons::RangePrefetch ||
+		       reason == PagerEventReasons::LowPriorityRead;
+	}
+
+	// Reads which touch many pages once, so their cache accesses should not make pages look frequently used
+	static bool isBackgroundRead(PagerEventReasons reason) {
+		return reason == PagerEventReasons::FetchRange || reason == PagerEventReasons::LowPriorityRead ||
+		       reason == PagerEventReasons::LazyClear;
 	}
 
 	// Reads the most recent version of pageID, either previously committed or written using updatePage()
@@ -2991,7 +3212,7 @@ public:
 			debug_printf("DWALPager(%s) op=readUncachedMiss %s\n", filename.c_str(), toString(pageID).c_str());
 			return forwardError(readPhysicalPage(this, pageID, priority, false, reason), errorPromise);
 		}
-		PageCacheEntry& cacheEntry = pageCache.get(pageID, physicalPageSize, noHit);
+		PageCacheEntry& cacheEntry = pageCache.get(pageID, physicalPageSize, noHit, isBackgroundRead(reason));
 		debug_printf("DWALPager(%s) op=read %s cached=%d reading=%d writing=%d noHit=%d\n",
 		             filename.c_str(),
 		             toString(pageID).c_str(),
@@ -3041,7 +3262,8 @@ public:
 			return forwardError(readPhysicalMultiPage(this, pageIDs, priority, reason), errorPromise);
 		}
 
-		PageCacheEntry& cacheEntry = pageCache.get(pageIDs.front(), pageIDs.size() * physicalPageSize, noHit);
+		PageCacheEntry& cacheEntry =
+		    pageCache.get(pageIDs.front(), pageIDs.size() * physicalPageSize, noHit, isBackgroundRead(reason));
 		debug_printf("DWALPager(%s) op=read %s cached=%d reading=%d writing=%d noHit=%d\n",
 		             filename.c_str(),
 		             toString(pageIDs).c_str(),
@@ -4186,6 +4408,15 @@ struct RedwoodRecordRef {
 		return skipLen + commonPrefixLength(key, other.key, skipLen);
 	}
 
+	// Returns key bytes [skip, skip + 8), zero padded, as a big-endian integer for DeltaTree2's SearchIndex
+	uint64_t getSearchPrefix(int skip) const {
+		uint64_t p = 0;
+		if (key.size() > skip) {
+			memcpy(&p, key.begin() + skip, std::min(key.size() - skip, 8));
+		}
+		return bigEndian64(p);
+	}
+
 	// Compares and orders by key, version, chunk.total, chunk.start, value
 	// This is the same order that delta compression uses for prefix borrowing
 	int compare(const RedwoodRecordRef& rhs, int skip = 0) const {
@@ -6353,6 +6584,11 @@ private:
 			// Store decode cache into page based on height
 			if (((BTreePage*)page->data())->height >= SERVER_KNOBS->REDWOOD_DECODECACHE_REUSE_MIN_HEIGHT) {
 				page->extra = cache;
+
+				// The cache lives as long as the page stays in the page cache, so it is worth indexing for seeks
+				if (SERVER_KNOBS->REDWOOD_SEARCH_INDEX) {
+					BTreePage::BinaryTree::Cursor(cache, ((BTreePage*)page->mutateData())->tree()).buildSearchIndex();
+				}
 			}
 		}
 
@@ -7791,6 +8027,11 @@ public:
 			btree = btree_in;
 			reason = reason_in;
 			options = options_in;
+			// Low priority reads are scans such as the consistency check, so report them and cache their pages
+			// separately from foreground reads
+			if (options.present() && options.get().type == ReadType::LOW && reason != PagerEventReasons::FetchRange) {
+				reason = PagerEventReasons::LowPriorityRead;
+			}
 			pager = pager_in;
 			path.clear();
 			path.reserve(6);
@@ -8009,8 +8250,6 @@ public:
 	}
 };
 
-#include "fdbserver/art_impl.h"
-
 RedwoodRecordRef VersionedBTree::dbBegin(""_sr);
 RedwoodRecordRef VersionedBTree::dbEnd("\xff\xff\xff\xff\xff"_sr);
 
@@ -8878,6 +9117,10 @@ void RedwoodMetrics::getFields(TraceEvent* e, std::string* s, bool skipZeroes) {
 		                                               { "PagerEvictUnhit", metric.pagerEvictUnhit },
 		                                               { "PagerEvictFail", metric.pagerEvictFail },
 		                                               { "", 0 },
+		                                               { "PagerCacheAdmit", metric.pagerCacheAdmit },
+		                                               { "PagerCacheReject", metric.pagerCacheReject },
+		                                               { "PagerCachePromote", metric.pagerCachePromote },
+		                                               { "", 0 },
 		                                               { "PagerRemapFree", metric.pagerRemapFree },
 		                                               { "PagerRemapCopy", metric.pagerRemapCopy },
 		                                               { "PagerRemapSkip", metric.pagerRemapSkip },
@@ -8916,18 +9159,25 @@ void RedwoodMetrics::getFields(TraceEvent* e, std::string* s, bool skipZeroes) {
 	std::pair<const char*, int64_t> cacheMetrics[] = { { "PageCacheCount", evictor->getCountUsed() },
 		                                               { "PageCacheMoved", evictor->getCountMoved() },
 		                                               { "PageCacheSize", evictor->getSizeUsed() },
+		                                               { "PageCacheWindow", evictor->getWindowSize() },
+		                                               { "PageCacheProtect", evictor->getProtectedSize() },
 		                                               { "DecodeCacheSize", evictor->reservedSize } };
 
+	unsigned int cacheLookups = metric.pagerCacheHit + metric.pagerCacheMiss;
+	double cacheHitRate = cacheLookups == 0 ? 0 : (double)metric.pagerCacheHit / cacheLookups;
+
 	if (e != nullptr) {
 		for (auto& m : cacheMetrics) {
 			e->detail(m.first, m.second);
 		}
+		e->detail("PagerCacheHitRate", cacheHitRate);
 	}
 
 	if (s != nullptr) {
 		for (auto& m : cacheMetrics) {
 			*s += format("%-15s %-14" PRId64 "       ", m.first, m.second);
 		}
+		*s += format("%-15s %-14.4f", "PagerCacheHitRate", cacheHitRate);
 		*s += "\n";
 	}
 
@@ -9016,6 +9266,62 @@ void RedwoodMetrics::getIOLockFields(TraceEvent* e, std::string* s) {
 	}
 }
 
+namespace {
+
+struct TestCacheObject {
+	bool evictable() const { return true; }
+	Future<Void> onEvictable() const { return Void(); }
+	Future<Void> cancel() const { return Void(); }
+};
+
+// Keeps a small hot set in use, then reads many other objects once in the background, and returns how many of the
+// hot objects are still cached afterwards
+int hotObjectsSurvivingScan(double windowFraction) {
+	typedef ObjectCache<LogicalPageID, TestCacheObject> CacheT;
+	constexpr int cacheSize = 100;
+	constexpr int hotCount = 20;
+	constexpr int scanCount = 50 * cacheSize;
+
+	CacheT::Evictor evictor(cacheSize);
+	evictor.windowFraction = windowFraction;
+	CacheT cache(&evictor);
+
+	for (int round = 0; round < 5; ++round) {
+		for (LogicalPageID id = 0; id < hotCount; ++id) {
+			cache.get(id, 1);
+		}
+	}
+	for (LogicalPageID id = hotCount; id < hotCount + scanCount; ++id) {
+		cache.get(id, 1, false, true);
+		ASSERT(evictor.getSizeUsed() <= cacheSize);
+	}
+
+	int survivors = 0;
+	for (LogicalPageID id = 0; id < hotCount; ++id) {
+		if (cache.getIfExists(id) != nullptr) {
+			++survivors;
+		}
+	}
+
+	Future<Void> cleared = cache.clear();
+	ASSERT(cleared.isReady());
+	ASSERT(evictor.empty());
+	return survivors;
+}
+
+} // namespace
+
+TEST_CASE("/redwood/correctness/unit/ObjectCache/scanResistance") {
+	// With a normal admission window the scan cannot displace anything that was used more than once
+	ASSERT(hotObjectsSurvivingScan(0.01) == 20);
+	ASSERT(hotObjectsSurvivingScan(0.5) == 20);
+
+	// With the whole cache as the window eviction is plain LRU, and the scan flushes the hot set
+	ASSERT(hotObjectsSurvivingScan(1.0) == 0);
+
+	return Void();
+}
+
 TEST_CASE("/redwood/correctness/unit/RedwoodRecordRef") {
 	ASSERT(RedwoodRecordRef::Delta::LengthFormatSizes[0] == 3);
 	ASSERT(RedwoodRecordRef::Delta::LengthFormatSizes[1] == 4);
@@ -9329,6 +9635,71 @@ TEST_CASE("Lredwood/correctness/unit/deltaTree/RedwoodRecordRef") {
 	return Void();
 }
 
+// Returns a random query near items: an item, a prefix or extension of an item's key, or a random key
+static RedwoodRecordRef randomSearchIndexQuery(Arena& arena, const std::vector<RedwoodRecordRef>& items) {
+	const RedwoodRecordRef& rec = items[deterministicRandom()->randomInt(0, items.size())];
+	switch (deterministicRandom()->randomInt(0, 5)) {
+	case 0:
+		return rec;
+	case 1:
+		return RedwoodRecordRef(rec.key.substr(0, deterministicRandom()->randomInt(0, rec.key.size() + 1)));
+	case 2:
+		return RedwoodRecordRef(rec.key.withSuffix(deterministicRandom()->coinflip() ? "\x00"_sr : "\xff"_sr, arena));
+	case 3:
+		return RedwoodRecordRef(rec.key, ValueRef());
+	default:
+		return RedwoodRecordRef(StringRef(arena, deterministicRandom()->randomAlphaNumeric(20)));
+	}
+}
+
+// Verifies that every kind of seek finds the same item with and without a SearchIndex
+static void verifySearchIndexSeeks(DeltaTree2<RedwoodRecordRef>* tree,
+                                   const RedwoodRecordRef& prev,
+                                   const RedwoodRecordRef& next,
+                                   const std::vector<RedwoodRecordRef>& items,
+                                   int count) {
+	auto indexedCache = makeReference<DeltaTree2<RedwoodRecordRef>::DecodeCache>(prev, next);
+	DeltaTree2<RedwoodRecordRef>::Cursor indexed(indexedCache, tree);
+	indexed.buildSearchIndex();
+	ASSERT(indexedCache->searchIndex);
+	DeltaTree2<RedwoodRecordRef>::Cursor plain(makeReference<DeltaTree2<RedwoodRecordRef>::DecodeCache>(prev, next),
+	                                           tree);
+
+	Arena arena;
+	for (int i = 0; i < count; ++i) {
+		RedwoodRecordRef query = randomSearchIndexQuery(arena, items);
+		for (int op = 0; op < 4; ++op) {
+			bool foundPlain, foundIndexed;
+			switch (op) {
+			case 0:
+				foundPlain = plain.seekLessThan(query);
+				foundIndexed = indexed.seekLessThan(query);
+				break;
+			case 1:
+				foundPlain = plain.seekLessThanOrEqual(query);
+				foundIndexed = indexed.seekLessThanOrEqual(query);
+				break;
+			case 2:
+				foundPlain = plain.seekGreaterThanOrEqual(query);
+				foundIndexed = indexed.seekGreaterThanOrEqual(query);
+				break;
+			default:
+				foundPlain = plain.seekGreaterThan(query);
+				foundIndexed = indexed.seekGreaterThan(query);
+				break;
+			}
+			if (foundPlain != foundIndexed || (foundPlain && plain.get() != indexed.get())) {
+				printf("Indexed seek %d mismatch!  query=%s  found=%s  expected=%s\n",
+				       op,
+				       query.toString().c_str(),
+				       foundIndexed ? indexed.get().toString().c_str() : "<none>",
+				       foundPlain ? plain.get().toString().c_str() : "<none>");
+				ASSERT(false);
+			}
+		}
+	}
+}
+
 TEST_CASE("Lredwood/correctness/unit/deltaTree/RedwoodRecordRef2") {
 	// Sanity check on delta tree node format
 	ASSERT(DeltaTree2<RedwoodRecordRef>::Node::headerSize(false) == 4);
@@ -9476,6 +9847,16 @@ TEST_CASE("Lredwood/correctness/unit/deltaTree/RedwoodRecordRef2") {
 		printf("Elapsed %f\n", elapsed);
 	}
 
+	printf("Verifying seeks using a search index\n");
+	verifySearchIndexSeeks(tree, prev, next, items, 100000);
+
+	// Erased items are not removed from the index and must still be hidden by indexed seeks
+	printf("Verifying seeks using a search index with erased items\n");
+	for (int i = 0; i < items.size() / 10; ++i) {
+		c.erase(items[deterministicRandom()->randomInt(0, items.size())]);
+	}
+	verifySearchIndexSeeks(tree, prev, next, items, 100000);
+
 	// {
 	// 	printf("Doing 5M random seeks using 10k random cursors, each from a different mirror.\n");
 	// 	double start = timer();
@@ -9507,6 +9888,106 @@ TEST_CASE("Lredwood/correctness/unit/deltaTree/RedwoodRecordRef2") {
 	return Void();
 }
 
+// Returns a tree of count records whose keys share a common prefix and, often, the 8 bytes after it as well
+static DeltaTree2<RedwoodRecordRef>* buildSearchIndexTestTree(Arena& arena,
+                                                              int count,
+                                                              int bufferSize,
+                                                              const RedwoodRecordRef& prev,
+                                                              const RedwoodRecordRef& next,
+                                                              std::vector<RedwoodRecordRef>& items) {
+	std::set<RedwoodRecordRef> uniqueItems;
+	while (uniqueItems.size() < count) {
+		std::string k = "\x01tenant/table/";
+		int suffixLen = deterministicRandom()->randomInt(0, 16);
+		for (int i = 0; i < suffixLen; ++i) {
+			k += "ab\x00\xff"[deterministicRandom()->randomInt(0, 4)];
+		}
+		RedwoodRecordRef rec;
+		rec.key = StringRef(arena, k);
+		if (deterministicRandom()->coinflip()) {
+			rec.value = StringRef(arena, deterministicRandom()->randomAlphaNumeric(4));
+		}
+		uniqueItems.insert(rec);
+	}
+	items = std::vector<RedwoodRecordRef>(uniqueItems.begin(), uniqueItems.end());
+
+	DeltaTree2<RedwoodRecordRef>* tree = (DeltaTree2<RedwoodRecordRef>*)new (arena) uint8_t[bufferSize];
+	tree->build(bufferSize, &items[0], &items[0] + items.size(), &prev, &next);
+	return tree;
+}
+
+TEST_CASE("Lredwood/correctness/unit/deltaTree/searchIndex") {
+	const int N = deterministicRandom()->randomInt(1, 1000);
+	RedwoodRecordRef prev("\x01"_sr);
+	RedwoodRecordRef next("\x02"_sr);
+	Arena arena;
+	std::vector<RedwoodRecordRef> items;
+	// Leave room for inserts
+	int bufferSize = N * 100;
+	DeltaTree2<RedwoodRecordRef>* tree = buildSearchIndexTestTree(arena, N, bufferSize, prev, next, items);
+	printf("Count=%d  Size=%d  InitialHeight=%d\n", (int)items.size(), (int)tree->size(), (int)tree->initialHeight);
+
+	verifySearchIndexSeeks(tree, prev, next, items, 100000);
+
+	// A tree with an inserted item no longer matches the index, so seeks must not use it
+	auto cache = makeReference<DeltaTree2<RedwoodRecordRef>::DecodeCache>(prev, next);
+	DeltaTree2<RedwoodRecordRef>::Cursor c(cache, tree);
+	c.buildSearchIndex();
+	RedwoodRecordRef added("\x01tenant/table/added"_sr);
+	ASSERT(c.insert(added));
+	ASSERT(c.seekGreaterThanOrEqual(added));
+	ASSERT(c.get() == added);
+	ASSERT(c.seekLessThan(added));
+	ASSERT(c.get() < added);
+
+	return Void();
+}
+
+TEST_CASE(":/redwood/performance/deltaTreeSearchIndex") {
+	int count = params.getInt("count").orDefault(300);
+	int seeks = params.getInt("seeks").orDefault(10e6);
+
+	RedwoodRecordRef prev("\x01"_sr);
+	RedwoodRecordRef next("\x02"_sr);
+	Arena arena;
+	std::vector<RedwoodRecordRef> items;
+	DeltaTree2<RedwoodRecordRef>* tree = buildSearchIndexTestTree(arena, count, count * 100, prev, next, items);
+	printf("Count=%d  Size=%d  InitialHeight=%d\n", (int)items.size(), (int)tree->size(), (int)tree->initialHeight);
+
+	std::vector<RedwoodRecordRef> queries;
+	for (int i = 0; i < 1000; ++i) {
+		queries.push_back(randomSearchIndexQuery(arena, items));
+	}
+
+	for (bool useIndex : { false, true }) {
+		DeltaTree2<RedwoodRecordRef>::Cursor c(makeReference<DeltaTree2<RedwoodRecordRef>::DecodeCache>(prev, next),
+		                                       tree);
+		if (useIndex) {
+			c.buildSearchIndex();
+		} else {
+			// Decode every node first, as a cache reused by many seeks would have
+			c.moveFirst();
+			while (c.moveNext()) {
+			}
+		}
+
+		int found = 0;
+		double start = timer();
+		for (int i = 0; i < seeks; ++i) {
+			found += c.seekLessThanOrEqual(queries[i % queries.size()]);
+		}
+		double elapsed = timer() - start;
+		printf("searchIndex=%d  seeks=%d  found=%d  elapsed=%f  seeks/s=%f\n",
+		       useIndex,
+		       seeks,
+		       found,
+		       elapsed,
+		       seeks / elapsed);
+	}
+
+	return Void();
+}
+
 TEST_CASE("Lredwood/correctness/unit/deltaTree/IntIntPair") {
 	const int N = 200;
 	IntIntPair lowerBound = { 0, 0 };
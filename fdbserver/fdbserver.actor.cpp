@@ -2211,6 +2211,7 @@ int main(int argc, char* argv[]) {
 		Error::init();
 		std::set_new_handler(&platform::outOfMemory);
 		Future<Void> memoryUsageMonitor = startMemoryUsageMonitor(opts.memLimit);
+		Future<Void> fastAllocatorTrimmer = startFastAllocatorTrimmer();
 		setMemoryQuota(opts.virtualMemLimit);
 
 		Future<Optional<Void>> f;
@@ -28,8 +28,22 @@
 #include "fdbclient/CommitTransaction.h"
 #include "fdbserver/ResolverBug.h"
 
+// The data structure used to hold a ConflictSet's version history
+enum class ConflictSetEngine {
+	SkipList,
+	// A B-tree whose nodes keep fixed-width key prefixes in a contiguous array which is searched with SIMD compares
+	PackedBTree,
+	// The adaptive radix tree also used by Redwood
+	ART,
+};
+
 struct ConflictSet;
+// Creates a ConflictSet using the engine named by SERVER_KNOBS->RESOLVER_CONFLICT_SET_ENGINE, partitioned across
+// SERVER_KNOBS->RESOLVER_CONFLICT_SET_THREADS threads
 ConflictSet* newConflictSet();
+// If threads is more than one, the key space is split into that many partitions which are checked in parallel. The
+// split is redone when the busiest partition takes more than maxImbalance times its share of rebalanceWrites writes.
+ConflictSet* newConflictSet(ConflictSetEngine engine, int threads, int rebalanceWrites, double maxImbalance);
 void clearConflictSet(ConflictSet*, Version);
 void destroyConflictSet(ConflictSet*);
 
@@ -79,7 +93,7 @@ private:
 	void addConflictRanges(Version now,
 	                       std::vector<std::pair<StringRef, StringRef>>::iterator begin,
 	                       std::vector<std::pair<StringRef, StringRef>>::iterator end,
-	                       class SkipList* part);
+	                       class IConflictHistory* part);
 };
 
 #endif
@@ -22,9 +22,12 @@
 
 #include "flow/flow.h"
 #include "flow/Arena.h"
+#include "flow/SimdCount.h"
 #include "fdbclient/FDBTypes.h"
 #include "fdbserver/Knobs.h"
 #include <string.h>
+#include <memory>
+#include <vector>
 
 #define DELTATREE_DEBUG 0
 
@@ -914,6 +917,11 @@ private:
 //    // For debugging, return a useful human-readable string representation of *this
 //    std::string toString() const;
 //
+//    // Optional, required by Cursor::buildSearchIndex().
+//    // Return the 8 bytes of *this starting at byte skip, zero padded, as a big-endian integer.  For T's which
+//    // share their first skip bytes, a lesser search prefix must mean a lesser T.
+//    uint64_t getSearchPrefix(int skip) const;
+//
 // DeltaT requirements
 //
 //    DeltaT can be variable sized, larger than sizeof(DeltaT), and implement the following:
@@ -1055,6 +1063,60 @@ public:
 	};
 #pragma pack(pop)
 
+	// SearchIndex is an optional accelerator for Cursor::seek() on a tree which will be searched many times, such as
+	// a BTree page kept in a page cache.  It lists every node of one tree in item order along with 8 bytes of the
+	// node's item, taken after the prefix shared by all items, as an integer in one contiguous array.  A seek finds
+	// the entries whose 8 bytes match the query's with a branchless binary search of that array which ends in a SIMD
+	// compare of one block, then decodes and compares items only among those entries.  A seek without the index
+	// decodes and compares every node on its path from the root, and the nodes are scattered across the page.
+	//
+	// The index is used only by Cursors on a tree with the same nodeBytesUsed as the tree it was built for.  Inserting
+	// a new item always increases nodeBytesUsed, so a modified copy of the tree sharing the same DecodeCache falls
+	// back to normal seeks.  Erasing or restoring an item does not change the tree's nodes, and like a normal seek an
+	// indexed seek can stop at an erased node.
+	struct SearchIndex : FastAllocated<SearchIndex> {
+		static constexpr bool Supported = requires(const T& t) { t.getSearchPrefix(0); };
+
+		// Entries counted by one SIMD compare at the end of a search
+		static constexpr int BlockSize = 8;
+
+		uint32_t nodeBytesUsed;
+		// Length of the prefix shared by all items
+		int skipLen;
+		// Copy of the first item, a query must share its first skipLen bytes to be searched with the index
+		Arena arena;
+		T first;
+		// Search prefixes in the order of a signed comparison, followed by BlockSize entries of padding
+		std::vector<int64_t> prefixes;
+		std::vector<int16_t> nodeIndexes;
+
+		// Flips the sign bit so that prefixes order correctly as signed integers
+		static int64_t toOrdered(uint64_t prefix) { return int64_t(prefix ^ (uint64_t(1) << 63)); }
+
+		int size() const { return nodeIndexes.size(); }
+
+		int memoryUsed() const {
+			return sizeof(SearchIndex) + arena.getSize(FastInaccurateEstimate::True) +
+			       prefixes.capacity() * sizeof(int64_t) + nodeIndexes.capacity() * sizeof(int16_t);
+		}
+
+		// Returns the number of entries with a prefix less than x, or less than or equal to x if orEqual is true
+		template <bool orEqual>
+		int rank(int64_t x) const {
+			const int64_t* base = prefixes.data();
+			int n = size();
+			// Every entry before base is counted and every entry at or after base + n is not
+			while (n > BlockSize) {
+				int half = n / 2;
+				base = (orEqual ? base[half] <= x : base[half] < x) ? base + half : base;
+				n -= half;
+			}
+
+			// Entries after base + n, including padding, are only counted when x is the greatest possible prefix
+			return (base - prefixes.data()) + std::min(countLess<BlockSize, orEqual>(base, x), n);
+		}
+	};
+
 	// The DecodeCache is a reference counted structure that stores DecodedNodes by an integer index
 	// and can be shared across a series of updated copies of a DeltaTree.
 	//
@@ -1093,11 +1155,15 @@ public:
 		// Index 0 is always the root
 		std::vector<DecodedNode> decodedNodes;
 
+		// Built by Cursor::buildSearchIndex(), refers to decodedNodes by index
+		std::unique_ptr<SearchIndex> searchIndex;
+
 		DecodedNode& get(int index) { return decodedNodes[index]; }
 
 		void updateUsedMemory() {
 			int usedNow = sizeof(DeltaTree2) + arena.getSize(FastInaccurateEstimate::True) +
-			              (decodedNodes.capacity() * sizeof(DecodedNode));
+			              (decodedNodes.capacity() * sizeof(DecodedNode)) +
+			              (searchIndex ? searchIndex->memoryUsed() : 0);
 			if (pMemoryTracker != nullptr) {
 				*pMemoryTracker += (usedNow - lastKnownUsedMemory);
 			}
@@ -1115,6 +1181,7 @@ public:
 
 		void clear() {
 			decodedNodes.clear();
+			searchIndex.reset();
 			Arena a;
 			lowerBound = T(a, lowerBound);
 			upperBound = T(a, upperBound);
@@ -1354,9 +1421,18 @@ public:
 			nodeIndex = -1;
 			item.reset();
 			deltatree_printf("seek(%s) start %s\n", s.toString().c_str(), toString().c_str());
-			int nIndex = rootIndex();
 			int cmp = 0;
 
+			if constexpr (SearchIndex::Supported) {
+				const SearchIndex* index = cache->searchIndex.get();
+				if (index != nullptr && index->nodeBytesUsed == tree->nodeBytesUsed &&
+				    seekIndexed(*index, s, skipLen, cmp)) {
+					return cmp;
+				}
+			}
+
+			int nIndex = rootIndex();
+
 			while (nIndex != -1) {
 				nodeIndex = nIndex;
 				item.reset();
@@ -1376,6 +1452,87 @@ public:
 			return cmp;
 		}
 
+		// Same as seek(), using index.  Returns false without moving the cursor if s does not share the prefix common
+		// to all items in the index, otherwise sets cmp to s.compare(item at cursor) and returns true.  The cursor
+		// moves to s if it exists or else to the item before or after s, which need not be where seek() would stop.
+		bool seekIndexed(const SearchIndex& index, const T& s, int skipLen, int& cmp) {
+			if (s.getCommonPrefixLen(index.first, skipLen) < index.skipLen) {
+				return false;
+			}
+
+			int64_t x = SearchIndex::toOrdered(s.getSearchPrefix(index.skipLen));
+			int lo = index.template rank<false>(x);
+			int hi = index.template rank<true>(x);
+			skipLen = std::max(skipLen, index.skipLen);
+
+			// Only entries in [lo, hi) can be equal to s
+			while (lo < hi) {
+				int mid = (lo + hi) / 2;
+				int c = s.compare(get(cache->get(index.nodeIndexes[mid])), skipLen);
+				if (c == 0) {
+					nodeIndex = index.nodeIndexes[mid];
+					cmp = 0;
+					return true;
+				}
+				if (c > 0) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+
+			// There are lo items less than s
+			if (lo < index.size()) {
+				nodeIndex = index.nodeIndexes[lo];
+				cmp = -1;
+			} else {
+				nodeIndex = index.nodeIndexes[lo - 1];
+				cmp = 1;
+			}
+			deltatree_printf("seekIndexed(%s) cmp=%d %s\n", s.toString().c_str(), cmp, toString().c_str());
+			return true;
+		}
+
+		// Builds a SearchIndex of this cursor's tree for the DecodeCache, replacing any existing one.
+		// This decodes every node of the tree, so it is only worthwhile for a DecodeCache that will serve many seeks.
+		void buildSearchIndex() {
+			static_assert(SearchIndex::Supported, "T does not implement getSearchPrefix()");
+			cache->searchIndex.reset();
+
+			// Visit every node in order, including erased ones, which creates all of the tree's DecodedNodes
+			std::vector<int16_t> nodeIndexes;
+			Cursor c(cache, tree);
+			int nIndex = c.rootIndex();
+			while (nIndex != -1) {
+				c.nodeIndex = nIndex;
+				nIndex = c.getLeftChildIndex(nIndex);
+			}
+			while (c.nodeIndex != -1) {
+				nodeIndexes.push_back(c.nodeIndex);
+				c._moveNext();
+			}
+
+			if (nodeIndexes.empty()) {
+				cache->updateUsedMemory();
+				return;
+			}
+
+			auto index = std::make_unique<SearchIndex>();
+			index->nodeBytesUsed = tree->nodeBytesUsed;
+			index->first = T(index->arena, get(cache->get(nodeIndexes.front())));
+			index->skipLen = index->first.getCommonPrefixLen(get(cache->get(nodeIndexes.back())), 0);
+			index->prefixes.reserve(nodeIndexes.size() + SearchIndex::BlockSize);
+			for (int i : nodeIndexes) {
+				index->prefixes.push_back(
+				    SearchIndex::toOrdered(get(cache->get(i)).getSearchPrefix(index->skipLen)));
+			}
+			index->prefixes.resize(nodeIndexes.size() + SearchIndex::BlockSize, std::numeric_limits<int64_t>::max());
+			index->nodeIndexes = std::move(nodeIndexes);
+
+			cache->searchIndex = std::move(index);
+			cache->updateUsedMemory();
+		}
+
 		bool moveFirst() {
 			nodeIndex = -1;
 			item.reset();
@@ -0,0 +1,87 @@
+/*
+ * IConflictHistory.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_ICONFLICTHISTORY_H
+#define FDBSERVER_ICONFLICTHISTORY_H
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include "fdbclient/FDBTypes.h"
+
+struct ReadConflictRange {
+	StringRef begin, end;
+	Version version;
+	int transaction;
+	int indexInTx;
+	VectorRef<int>* conflictingKeyRange;
+	Arena* cKRArena;
+
+	ReadConflictRange(StringRef begin,
+	                  StringRef end,
+	                  Version version,
+	                  int transaction,
+	                  int indexInTx,
+	                  VectorRef<int>* cKR = nullptr,
+	                  Arena* cKRArena = nullptr)
+	  : begin(begin), end(end), version(version), transaction(transaction), indexInTx(indexInTx),
+	    conflictingKeyRange(cKR), cKRArena(cKRArena) {}
+	bool operator<(const ReadConflictRange& rhs) const { return begin < rhs.begin; }
+};
+
+// The version history kept by a ConflictSet. Conceptually it is an ordered map from keys to versions, where the
+// version stored at a key is the last version at which the range [key, next key) was written. The range before
+// the first key was last written at the version the history was created with.
+class IConflictHistory {
+public:
+	virtual ~IConflictHistory() = default;
+
+	// For each range r, sets transactionConflictStatus[r.transaction] if any part of [r.begin, r.end) was written
+	// after r.version, and records r.indexInTx in r.conflictingKeyRange if that is set.
+	virtual void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) = 0;
+
+	// Records that each of the given sorted, non-overlapping ranges was written at version now.
+	virtual void addConflictRanges(const std::pair<StringRef, StringRef>* ranges, int count, Version now) = 0;
+
+	// Forgets the distinction between adjacent ranges last written before oldestVersion, visiting at most
+	// nodeCount keys starting from removalKey. Returns the key from which the next call should continue.
+	virtual Key removeBefore(Version oldestVersion, KeyRef removalKey, int nodeCount) = 0;
+
+	// Returns the number of keys in the history.
+	virtual int count() const = 0;
+
+	// Forgets everything written, leaving the history as it was when created, but with the given version.
+	virtual void clear(Version version) = 0;
+};
+
+IConflictHistory* newSkipListConflictHistory(Version version);
+IConflictHistory* newPackedConflictHistory(Version version);
+IConflictHistory* newArtConflictHistory(Version version);
+// Splits the key space into partitions created by newPartition, and checks and updates them on up to threads threads
+// at once. Every rebalanceWrites write ranges, the key space is split again if the busiest partition took more than
+// maxImbalance times its share of them.
+IConflictHistory* newPartitionedConflictHistory(std::function<IConflictHistory*(Version)> newPartition,
+                                                int threads,
+                                                int rebalanceWrites,
+                                                double maxImbalance,
+                                                Version version);
+
+#endif
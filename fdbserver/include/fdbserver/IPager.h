@@ -62,10 +62,12 @@ enum class PagerEventReasons {
 	Commit,
 	LazyClear,
 	MetaData,
+	// Point or range read issued with ReadType::LOW, such as the consistency scan
+	LowPriorityRead,
 	MAXEVENTREASONS
 };
-static const char* const PagerEventReasonsStrings[] = { "Get",    "FetchR",  "GetR", "GetRPF",
-	                                                    "Commit", "LazyClr", "Meta", "Unknown" };
+static const char* const PagerEventReasonsStrings[] = { "Get",     "FetchR", "GetR",  "GetRPF", "Commit",
+	                                                    "LazyClr", "Meta",   "GetLo", "Unknown" };
 
 static const unsigned int nonBtreeLevel = 0;
 static const std::vector<std::pair<PagerEvents, PagerEventReasons>> possibleEventReasonPairs = {
@@ -74,16 +76,19 @@ static const std::vector<std::pair<PagerEvents, PagerEventReasons>> possibleEven
 	{ PagerEvents::CacheLookup, PagerEventReasons::PointRead },
 	{ PagerEvents::CacheLookup, PagerEventReasons::RangeRead },
 	{ PagerEvents::CacheLookup, PagerEventReasons::FetchRange },
+	{ PagerEvents::CacheLookup, PagerEventReasons::LowPriorityRead },
 	{ PagerEvents::CacheHit, PagerEventReasons::Commit },
 	{ PagerEvents::CacheHit, PagerEventReasons::LazyClear },
 	{ PagerEvents::CacheHit, PagerEventReasons::PointRead },
 	{ PagerEvents::CacheHit, PagerEventReasons::RangeRead },
 	{ PagerEvents::CacheHit, PagerEventReasons::FetchRange },
+	{ PagerEvents::CacheHit, PagerEventReasons::LowPriorityRead },
 	{ PagerEvents::CacheMiss, PagerEventReasons::Commit },
 	{ PagerEvents::CacheMiss, PagerEventReasons::LazyClear },
 	{ PagerEvents::CacheMiss, PagerEventReasons::PointRead },
 	{ PagerEvents::CacheMiss, PagerEventReasons::RangeRead },
 	{ PagerEvents::CacheMiss, PagerEventReasons::FetchRange },
+	{ PagerEvents::CacheMiss, PagerEventReasons::LowPriorityRead },
 	{ PagerEvents::PageWrite, PagerEventReasons::Commit },
 	{ PagerEvents::PageWrite, PagerEventReasons::LazyClear },
 };
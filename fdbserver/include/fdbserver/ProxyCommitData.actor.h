@@ -70,10 +70,13 @@ struct ProxyStats {
 	Counter tenantIdRequestErrors;
 	Counter blobGranuleLocationIn, blobGranuleLocationOut, blobGranuleLocationErrors;
 	Counter txnExpensiveClearCostEstCount;
+	// Commits received with compressed mutations, their compressed size and their size once decompressed
+	Counter compressedTxnCommitIn, compressedMutationBytesIn, decompressedMutationBytes;
 	Version lastCommitVersionAssigned;
 
 	LatencySample commitLatencySample;
 	LatencySample encryptionLatencySample;
+	LatencySample decompressionLatencySample;
 	LatencyBands commitLatencyBands;
 
 	// Ratio of tlogs receiving empty commit messages.
@@ -138,7 +141,9 @@ struct ProxyStats {
 	    tenantIdRequestOut("TenantIdRequestOut", cc), tenantIdRequestErrors("TenantIdRequestErrors", cc),
 	    blobGranuleLocationIn("BlobGranuleLocationIn", cc), blobGranuleLocationOut("BlobGranuleLocationOut", cc),
 	    blobGranuleLocationErrors("BlobGranuleLocationErrors", cc),
-	    txnExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc), lastCommitVersionAssigned(0),
+	    txnExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc),
+	    compressedTxnCommitIn("CompressedTxnCommitIn", cc), compressedMutationBytesIn("CompressedMutationBytesIn", cc),
+	    decompressedMutationBytes("DecompressedMutationBytes", cc), lastCommitVersionAssigned(0),
 	    commitLatencySample("CommitLatencyMetrics",
 	                        id,
 	                        SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL,
@@ -147,6 +152,10 @@ struct ProxyStats {
 	                            id,
 	                            SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL,
 	                            SERVER_KNOBS->LATENCY_SKETCH_ACCURACY),
+	    decompressionLatencySample("CommitDecompressionLatencyMetrics",
+	                               id,
+	                               SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL,
+	                               SERVER_KNOBS->LATENCY_SKETCH_ACCURACY),
 	    commitLatencyBands("CommitLatencyBands", id, SERVER_KNOBS->STORAGE_LOGGING_DELAY),
 	    commitBatchingEmptyMessageRatio("CommitBatchingEmptyMessageRatio",
 	                                    id,
@@ -196,10 +196,31 @@ struct VerUpdateRef {
 	}
 };
 
+struct TLogPeekReply;
+
+namespace detail {
+// Serializes a TLogPeekReply's messages exactly as a StringRef, gathering its message fragments straight into the
+// output buffer.
+class TLogPeekMessagesSerdesWrapper {
+	TLogPeekReply* reply;
+
+public:
+	TLogPeekMessagesSerdesWrapper() noexcept : reply(nullptr) {}
+	explicit TLogPeekMessagesSerdesWrapper(TLogPeekReply& reply) noexcept : reply(&reply) {}
+
+	TLogPeekReply& get() const noexcept { return *reply; }
+};
+} // namespace detail
+
 struct TLogPeekReply {
 	constexpr static FileIdentifier file_identifier = 11365689;
 	Arena arena;
 	StringRef messages;
+	// Set only by a TLog building a reply. When it is not empty, the reply's messages are the concatenation of these
+	// fragments, which refer to the TLog's in-memory message blocks and are copied only once, into the reply packet.
+	// Fragments are not sent, and a reply handed over without being serialized must call flattenMessages() before
+	// its messages are read.
+	VectorRef<StringRef> messageFragments;
 	Version end;
 	Optional<Version> popped;
 	Version maxKnownVersion;
@@ -207,9 +228,80 @@ struct TLogPeekReply {
 	Optional<Version> begin;
 	bool onlySpilled = false;
 
+	int64_t messageBytes() const {
+		int64_t bytes = messages.size();
+		for (const StringRef& fragment : messageFragments) {
+			bytes += fragment.size();
+		}
+		return bytes;
+	}
+
+	// Appends bytes which must live as long as arena does, extending the last fragment if they follow it in memory
+	void appendMessages(StringRef bytes) {
+		ASSERT(messages.empty());
+		if (bytes.empty()) {
+			return;
+		}
+		if (!messageFragments.empty() && messageFragments.back().end() == bytes.begin()) {
+			StringRef& last = messageFragments.back();
+			last = StringRef(last.begin(), last.size() + bytes.size());
+		} else {
+			messageFragments.push_back(arena, bytes);
+		}
+	}
+
+	// Gathers the message fragments into messages
+	void flattenMessages() {
+		if (messageFragments.empty()) {
+			return;
+		}
+		if (messageFragments.size() == 1) {
+			messages = messageFragments[0];
+		} else {
+			uint8_t* buf = new (arena) uint8_t[messageBytes()];
+			uint8_t* out = buf;
+			for (const StringRef& fragment : messageFragments) {
+				out = std::copy(fragment.begin(), fragment.end(), out);
+			}
+			messages = StringRef(buf, out - buf);
+		}
+		messageFragments = VectorRef<StringRef>();
+	}
+
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, messages, end, popped, maxKnownVersion, minKnownCommittedVersion, begin, onlySpilled, arena);
+		if constexpr (is_fb_function<Ar>) {
+			auto m = detail::TLogPeekMessagesSerdesWrapper(*this);
+			serializer(ar, m, end, popped, maxKnownVersion, minKnownCommittedVersion, begin, onlySpilled, arena);
+		} else {
+			if constexpr (!Ar::isDeserializing) {
+				flattenMessages();
+			}
+			serializer(ar, messages, end, popped, maxKnownVersion, minKnownCommittedVersion, begin, onlySpilled, arena);
+		}
+	}
+};
+
+template <>
+struct dynamic_size_traits<detail::TLogPeekMessagesSerdesWrapper> : std::true_type {
+	template <class Context>
+	static size_t size(const detail::TLogPeekMessagesSerdesWrapper& t, Context&) {
+		return t.get().messageBytes();
+	}
+
+	template <class Context>
+	static void save(uint8_t* out, const detail::TLogPeekMessagesSerdesWrapper& t, Context&) {
+		const TLogPeekReply& reply = t.get();
+		out = std::copy(reply.messages.begin(), reply.messages.end(), out);
+		for (const StringRef& fragment : reply.messageFragments) {
+			out = std::copy(fragment.begin(), fragment.end(), out);
+		}
+	}
+
+	template <class Context>
+	static void load(const uint8_t* ptr, size_t sz, detail::TLogPeekMessagesSerdesWrapper& t, Context& context) {
+		dynamic_size_traits<StringRef>::load(ptr, sz, t.get().messages, context);
+		t.get().messageFragments = VectorRef<StringRef>();
 	}
 };
 
@@ -246,7 +338,7 @@ struct TLogPeekStreamReply : public ReplyPromiseStreamReply {
 	TLogPeekStreamReply() = default;
 	explicit TLogPeekStreamReply(const TLogPeekReply& rep) : rep(rep) {}
 
-	int expectedSize() const { return rep.messages.expectedSize() + sizeof(TLogPeekStreamReply); }
+	int expectedSize() const { return rep.messageBytes() + sizeof(TLogPeekStreamReply); }
 
 	template <class Ar>
 	void serialize(Ar& ar) {
@@ -64,7 +64,7 @@ struct art_tree {
 #define ART_FAT_NODE_LEAF(node_ptr) (*((art_leaf**)(((char*)(node_ptr)) + ART_LEAF_DISPL(node_ptr))))
 
 // In Bytes
-// This is needed so that we can pre-allocate a static stack to perform efficient backtracking in iterative_bound
+// This is needed so that we can pre-allocate a per-thread stack to perform efficient backtracking in iterative_bound
 #define ART_MAX_KEY_LEN 10000
 
 #define _mm_cmpge_epu8(a, b) _mm_cmpeq_epi8(_mm_max_epu8(a, b), a)
@@ -21,7 +21,10 @@
 #ifndef ART_IMPL_H
 #define ART_IMPL_H
 
-using art_tree = VersionedBTree::art_tree;
+#include <memory>
+
+#include "fdbserver/art.h"
+
 using art_leaf = art_tree::art_leaf;
 #define art_node art_tree::art_node
 
@@ -38,7 +41,7 @@ int art_tree::node_sizes[] = { 0,
 	                           sizeof(art_node48_kv),
 	                           sizeof(art_node256_kv) };
 
-VersionedBTree::art_iterator art_tree::insert(KeyRef& k, void* value) {
+art_iterator art_tree::insert(KeyRef& k, void* value) {
 #define INIT_DEPTH 0
 #define REPLACE 1
 	int old_val = 0;
@@ -46,19 +49,19 @@ VersionedBTree::art_iterator art_tree::insert(KeyRef& k, void* value) {
 
 	if (!old_val)
 		this->size++;
-	return VersionedBTree::art_iterator(l);
+	return art_iterator(l);
 }
 
-VersionedBTree::art_iterator art_tree::insert_if_absent(KeyRef& k, void* value, int* existing) {
+art_iterator art_tree::insert_if_absent(KeyRef& k, void* value, int* existing) {
 #define INIT_DEPTH 0
 #define DONTREPLACE 0
 	art_leaf* l = iterative_insert(this->root, &this->root, k, value, INIT_DEPTH, existing, DONTREPLACE);
-	if (!existing)
+	if (!*existing)
 		this->size++;
-	return VersionedBTree::art_iterator(l);
+	return art_iterator(l);
 }
 
-VersionedBTree::art_iterator art_tree::lower_bound(const KeyRef& key) {
+art_iterator art_tree::lower_bound(const KeyRef& key) {
 	if (!size)
 		return art_iterator(nullptr);
 	art_node* n = root;
@@ -70,7 +73,7 @@ VersionedBTree::art_iterator art_tree::lower_bound(const KeyRef& key) {
 	return art_iterator(res);
 }
 
-VersionedBTree::art_iterator art_tree::upper_bound(const KeyRef& key) {
+art_iterator art_tree::upper_bound(const KeyRef& key) {
 	if (!size)
 		return art_iterator(nullptr);
 	art_node* n = root;
@@ -164,9 +167,14 @@ art_leaf* art_tree::maximum(art_node* n) {
 
 void art_tree::art_bound_iterative(art_node* n, const KeyRef& k, int depth, art_leaf** result, bool strict) {
 
-	static stack_entry arena[ART_MAX_KEY_LEN]; // Single threaded implementation.
+	// Each thread has its own stack, so that trees used on different threads can be searched at once. It is allocated
+	// on a thread's first search, rather than being a thread_local array that every thread would carry.
+	static thread_local std::unique_ptr<stack_entry[]> arena;
+	if (!arena) {
+		arena.reset(new stack_entry[ART_MAX_KEY_LEN]);
+	}
 
-	stack_entry *head = nullptr, *curr_arena = arena;
+	stack_entry *head = nullptr, *curr_arena = arena.get();
 	int ret;
 	art_node** child;
 	unsigned char* key = (unsigned char*)k.begin();
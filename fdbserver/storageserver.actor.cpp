@@ -66,6 +66,7 @@
 #include "fdbclient/Tenant.h"
 #include "fdbclient/TransactionLineage.h"
 #include "fdbclient/Tuple.h"
+#include "fdbclient/VersionedBTreeMap.h"
 #include "fdbclient/VersionedMap.h"
 #include "fdbrpc/sim_validation.h"
 #include "fdbrpc/Smoother.h"
@@ -989,7 +990,7 @@ struct TenantSSInfo {
 };
 
 struct StorageServer : public IStorageMetricsService {
-	typedef VersionedMap<KeyRef, ValueOrClearToRef> VersionedData;
+	typedef SelectableVersionedMap<KeyRef, ValueOrClearToRef> VersionedData;
 
 private:
 	// versionedData contains sets and clears.
@@ -1167,6 +1168,19 @@ public:
 	VersionedData const& data() const { return versionedData; }
 	VersionedData& mutableData() { return versionedData; }
 
+	// While update() applies mutations without waiting, sets to increasing keys are queued here and inserted into
+	// versionedData together, which copies the tree's path above a run of neighbouring keys once. The queue is flushed
+	// before anything else reads or writes the latest version of versionedData, and before update() waits.
+	bool batchingSets = false;
+	std::vector<std::pair<KeyRef, ValueOrClearToRef>> pendingSets;
+
+	void flushPendingSets() {
+		if (!pendingSets.empty()) {
+			versionedData.insertSorted(pendingSets.begin(), pendingSets.end());
+			pendingSets.clear();
+		}
+	}
+
 	mutable double old_rate = 1.0;
 	double currentRate() const {
 		auto versionLag = version.get() - durableVersion.get();
@@ -1434,8 +1448,8 @@ public:
 
 	struct Counters : CommonStorageCounters {
 
-		Counter allQueries, systemKeyQueries, getKeyQueries, getValueQueries, getRangeQueries, getRangeSystemKeyQueries,
-		    getRangeStreamQueries, lowPriorityQueries, rowsQueried, watchQueries, emptyQueries, feedRowsQueried,
+		Counter allQueries, systemKeyQueries, getKeyQueries, getValueQueries, getValuesQueries, getRangeQueries,
+		    getRangeSystemKeyQueries, getRangeStreamQueries, lowPriorityQueries, rowsQueried, watchQueries, emptyQueries, feedRowsQueried,
 		    feedBytesQueried, feedStreamQueries, rejectedFeedStreamQueries, feedVersionQueries;
 
 		// counters related to getMappedRange queries
@@ -1524,7 +1538,8 @@ public:
 		explicit Counters(StorageServer* self)
 		  : CommonStorageCounters("StorageServer", self->thisServerID.toString(), &self->metrics),
 		    allQueries("QueryQueue", cc), systemKeyQueries("SystemKeyQueries", cc), getKeyQueries("GetKeyQueries", cc),
-		    getValueQueries("GetValueQueries", cc), getRangeQueries("GetRangeQueries", cc),
+		    getValueQueries("GetValueQueries", cc), getValuesQueries("GetValuesQueries", cc),
+		    getRangeQueries("GetRangeQueries", cc),
 		    getRangeSystemKeyQueries("GetRangeSystemKeyQueries", cc),
 		    getMappedRangeQueries("GetMappedRangeQueries", cc), getRangeStreamQueries("GetRangeStreamQueries", cc),
 		    lowPriorityQueries("LowPriorityQueries", cc), rowsQueried("RowsQueried", cc),
@@ -1657,7 +1672,9 @@ public:
 	              Reference<AsyncVar<ServerDBInfo> const> const& db,
 	              StorageServerInterface const& ssi,
 	              Reference<GetEncryptCipherKeysMonitor> encryptionMonitor)
-	  : shardAware(false), tlogCursorReadsLatencyHistogram(Histogram::getHistogram(STORAGESERVER_HISTOGRAM_GROUP,
+	  : versionedData(SERVER_KNOBS->STORAGE_VERSIONED_MAP_TYPE == "btree" ? VersionedMapType::BTree
+	                                                                     : VersionedMapType::PTree),
+	    shardAware(false), tlogCursorReadsLatencyHistogram(Histogram::getHistogram(STORAGESERVER_HISTOGRAM_GROUP,
 	                                                                               TLOG_CURSOR_READS_LATENCY_HISTOGRAM,
 	                                                                               Histogram::Unit::milliseconds)),
 	    ssVersionLockLatencyHistogram(Histogram::getHistogram(STORAGESERVER_HISTOGRAM_GROUP,
@@ -2592,6 +2609,134 @@ ACTOR Future<Void> getValueQ(StorageServer* data, GetValueRequest req) {
 	return Void();
 }
 
+// Serves a batch of point reads at one version. Keys found in the versioned data are answered from memory and the rest
+// are read from the storage engine in parallel, so the whole batch costs one queue wait and one version wait.
+ACTOR Future<Void> getValuesQ(StorageServer* data, GetValuesRequest req) {
+	state int64_t resultSize = 0;
+	state int64_t keyBytes = 0;
+	Span span("SS:getValues"_loc, req.spanContext);
+
+	try {
+		++data->counters.getValuesQueries;
+		++data->counters.allQueries;
+		data->maxQueryQueue = std::max<int>(
+		    data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+		// Active load balancing runs at a very high priority (to obtain accurate queue lengths)
+		// so we need to downgrade here
+		wait(data->getQueryDelay());
+		state PriorityMultiLock::Lock readLock = wait(data->getReadLock(req.options));
+
+		// Track time from requestTime through now as read queueing wait time
+		state double queueWaitEnd = g_network->timer();
+		data->counters.readQueueWaitSample.addMeasurement(queueWaitEnd - req.requestTime());
+
+		if (req.options.present() && req.options.get().debugID.present())
+			g_traceBatch.addEvent("GetValuesDebug", req.options.get().debugID.get().first(), "getValuesQ.DoRead");
+
+		Version commitVersion = getLatestCommitVersion(req.ssLatestCommitVersions, data->tag);
+		state Version version = wait(waitForVersion(data, commitVersion, req.version, req.spanContext));
+		data->counters.readVersionWaitSample.addMeasurement(g_network->timer() - queueWaitEnd);
+
+		data->checkTenantEntry(version, req.tenantInfo, req.options.present() ? req.options.get().lockAware : false);
+
+		// Keys as stored, i.e. with the tenant prefix applied
+		state Arena arena;
+		state VectorRef<KeyRef> keys;
+		keys.reserve(arena, req.keys.size());
+		for (const KeyRef& key : req.keys) {
+			keys.push_back(arena, req.tenantInfo.hasTenant() ? key.withPrefix(req.tenantInfo.prefix.get(), arena) : key);
+			if (!data->shards[keys.back()]->isReadable()) {
+				throw wrong_shard_server();
+			}
+			if (key.startsWith(systemKeys.begin)) {
+				++data->counters.systemKeyQueries;
+			}
+			keyBytes += key.size();
+		}
+		state uint64_t changeCounter = data->shardChangeCounter;
+
+		state std::vector<Optional<Value>> values(keys.size());
+		state std::vector<int> misses;
+		state std::vector<Future<Optional<Value>>> reads;
+		for (int k = 0; k < keys.size(); k++) {
+			auto i = data->data().at(version).lastLessOrEqual(keys[k]);
+			if (i && i->isValue() && i.key() == keys[k]) {
+				values[k] = (Value)i->getValue();
+			} else if (!i || !i->isClearTo() || i->getEndKey() <= keys[k]) {
+				misses.push_back(k);
+				reads.push_back(data->storage.readValue(keys[k], req.options));
+			}
+		}
+
+		if (!reads.empty()) {
+			wait(waitForAll(reads));
+			// Validate that while we were reading the data we didn't lose the version or shard
+			if (version < data->storageVersion()) {
+				CODE_PROBE(true, "transaction_too_old after getValues readValue");
+				throw transaction_too_old();
+			}
+			for (int m = 0; m < misses.size(); m++) {
+				data->checkChangeCounter(changeCounter, keys[misses[m]]);
+				data->counters.kvGetBytes += reads[m].get().expectedSize();
+				values[misses[m]] = reads[m].get();
+			}
+		}
+
+		if (req.options.present() && req.options.get().debugID.present())
+			g_traceBatch.addEvent("GetValuesDebug", req.options.get().debugID.get().first(), "getValuesQ.AfterRead");
+
+		GetValuesReply reply;
+		reply.data.reserve(reply.arena, keys.size());
+		for (int k = 0; k < keys.size(); k++) {
+			const Optional<Value>& v = values[k];
+			if (v.present()) {
+				++data->counters.rowsQueried;
+				resultSize += v.get().size();
+				data->counters.bytesQueried += v.get().size();
+				reply.data.push_back_deep(reply.arena, KeyValueRef(req.keys[k], v.get()));
+			} else {
+				++data->counters.emptyQueries;
+			}
+
+			if (SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+				// If the read yields no value, randomly sample the empty read.
+				int64_t bytesReadPerKSecond =
+				    v.present() ? std::max((int64_t)(keys[k].size() + v.get().size()), SERVER_KNOBS->EMPTY_READ_PENALTY)
+				                : SERVER_KNOBS->EMPTY_READ_PENALTY;
+				data->metrics.notifyBytesReadPerKSecond(keys[k], bytesReadPerKSecond);
+			}
+
+			// Check if any of the keys might be cached
+			reply.cached = reply.cached || data->cachedRangeMap[keys[k]];
+		}
+
+		reply.penalty = data->getPenalty();
+		req.reply.send(reply);
+	} catch (Error& e) {
+		if (!canReplyWith(e))
+			throw;
+		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+	}
+
+	// Key size is not included in "BytesQueried", but still contributes to cost,
+	// so it must be accounted for here.
+	data->transactionTagCounter.addRequest(req.tags, keyBytes + resultSize);
+
+	++data->counters.finishedQueries;
+
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySample.addMeasurement(duration);
+	data->counters.readValueLatencySample.addMeasurement(duration);
+	if (data->latencyBandConfig.present()) {
+		int maxReadBytes =
+		    data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
+		data->counters.readLatencyBands.addMeasurement(duration, 1, Filtered(resultSize > maxReadBytes));
+	}
+
+	return Void();
+}
+
 // Pessimistic estimate the number of overhead bytes used by each
 // watch. Watch key references are stored in an AsyncMap<Key,bool>, and actors
 // must be kept alive until the watch is finished.
@@ -2613,7 +2758,7 @@ ACTOR Future<Version> watchWaitForValueChange(StorageServer* data, SpanContext p
 		                      metadata->debugID.get().first(),
 		                      "watchValueSendReply.AfterVersion"); //.detail("TaskID", g_network->getCurrentTask());
 
-	state Version minVersion = data->data().latestVersion;
+	state Version minVersion = data->data().getLatestVersion();
 	state Future<Void> watchFuture = data->watches.onChange(metadata->key);
 	if (tenantId != TenantInfo::INVALID_TENANT) {
 		watchFuture = watchFuture || data->tenantWatches.onChange(tenantId);
@@ -2632,7 +2777,7 @@ ACTOR Future<Version> watchWaitForValueChange(StorageServer* data, SpanContext p
 			state Version latest = data->version.get();
 			options.debugID = metadata->debugID;
 
-			CODE_PROBE(latest >= minVersion && latest < data->data().latestVersion,
+			CODE_PROBE(latest >= minVersion && latest < data->data().getLatestVersion(),
 			           "Starting watch loop with latestVersion > data->version",
 			           probe::decoration::rare);
 			GetValueRequest getReq(
@@ -2722,7 +2867,7 @@ ACTOR Future<Version> watchWaitForValueChange(StorageServer* data, SpanContext p
 			watchFuture = watchFuture || data->tenantWatches.onChange(tenantId);
 		}
 
-		wait(data->version.whenAtLeast(data->data().latestVersion));
+		wait(data->version.whenAtLeast(data->data().getLatestVersion()));
 	}
 }
 
@@ -4195,6 +4340,33 @@ ACTOR Future<GetValueReqAndResultRef> quickGetValue(StorageServer* data,
 	}
 }
 
+// Copies the sets from vCurrent onwards (backwards if !forward) into resultCache, stopping at a clear, at the edge of
+// range or once vCount reaches maxCount or limitBytes bytes are read.
+void readVersionedSets(StorageServer::VersionedData::iterator& vCurrent,
+                       KeyRangeRef range,
+                       bool forward,
+                       int& vCount,
+                       int maxCount,
+                       int limitBytes,
+                       int prefixSize,
+                       Arena& arena,
+                       VectorRef<KeyValueRef>& resultCache) {
+	int vSize = 0;
+	vCurrent.visit([&](auto& i) {
+		while (i && (forward ? i.key() < range.end : i.key() >= range.begin) && !i->isClearTo() && vCount < maxCount &&
+		       vSize < limitBytes) {
+			// Store the versionedData results in resultCache
+			resultCache.emplace_back(arena, i.key(), i->getValue());
+			vSize += sizeof(KeyValueRef) + resultCache.cback().expectedSize() - prefixSize;
+			++vCount;
+			if (forward)
+				++i;
+			else
+				--i;
+		}
+	});
+}
+
 // If limit>=0, it returns the first rows in the range (sorted ascending), otherwise the last rows (sorted descending).
 // readRange has O(|result|) + O(log |data|) cost
 ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
@@ -4269,16 +4441,15 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 				}
 
 				// Read up to limit items from the view, stopping at the next clear (or the end of the range)
-				int vSize = 0;
-				while (vCurrent && vCurrent.key() < range.end && !vCurrent->isClearTo() && vCount < limit &&
-				       vSize < *pLimitBytes) {
-					// Store the versionedData results in resultCache
-					resultCache.emplace_back(result.arena, vCurrent.key(), vCurrent->getValue());
-					vSize += sizeof(KeyValueRef) + resultCache.cback().expectedSize() -
-					         (tenantPrefix.present() ? tenantPrefix.get().size() : 0);
-					++vCount;
-					++vCurrent;
-				}
+				readVersionedSets(vCurrent,
+				                  range,
+				                  true,
+				                  vCount,
+				                  limit,
+				                  *pLimitBytes,
+				                  tenantPrefix.present() ? tenantPrefix.get().size() : 0,
+				                  result.arena,
+				                  resultCache);
 			}
 
 			// Read the data on disk up to vCurrent (or the end of the range)
@@ -4371,16 +4542,15 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 				}
 
 				vCount = 0;
-				int vSize = 0;
-				while (vCurrent && vCurrent.key() >= range.begin && !vCurrent->isClearTo() && vCount < -limit &&
-				       vSize < *pLimitBytes) {
-					// Store the versionedData results in resultCache
-					resultCache.emplace_back(result.arena, vCurrent.key(), vCurrent->getValue());
-					vSize += sizeof(KeyValueRef) + resultCache.cback().expectedSize() -
-					         (tenantPrefix.present() ? tenantPrefix.get().size() : 0);
-					++vCount;
-					--vCurrent;
-				}
+				readVersionedSets(vCurrent,
+				                  range,
+				                  false,
+				                  vCount,
+				                  -limit,
+				                  *pLimitBytes,
+				                  tenantPrefix.present() ? tenantPrefix.get().size() : 0,
+				                  result.arena,
+				                  resultCache);
 			}
 
 			readBegin = vCurrent ? std::max(vCurrent->isClearTo() ? vCurrent->getEndKey() : vCurrent.key(), range.begin)
@@ -4953,11 +5123,11 @@ ACTOR Future<GetRangeReqAndResultRef> quickGetKeyValues(
 	}
 }
 
-void unpackKeyTuple(Tuple** referenceTuple, Optional<Tuple>& keyTuple, KeyValueRef* keyValue) {
+void unpackKeyTuple(TupleView** referenceTuple, Optional<TupleView>& keyTuple, KeyValueRef* keyValue) {
 	if (!keyTuple.present()) {
 		// May throw exception if the key is not parsable as a tuple.
 		try {
-			keyTuple = Tuple::unpack(keyValue->key);
+			keyTuple = TupleView::unpack(keyValue->key);
 		} catch (Error& e) {
 			TraceEvent("KeyNotTuple").error(e).detail("Key", keyValue->key.printable());
 			throw key_not_tuple();
@@ -4966,11 +5136,11 @@ void unpackKeyTuple(Tuple** referenceTuple, Optional<Tuple>& keyTuple, KeyValueR
 	*referenceTuple = &keyTuple.get();
 }
 
-void unpackValueTuple(Tuple** referenceTuple, Optional<Tuple>& valueTuple, KeyValueRef* keyValue) {
+void unpackValueTuple(TupleView** referenceTuple, Optional<TupleView>& valueTuple, KeyValueRef* keyValue) {
 	if (!valueTuple.present()) {
 		// May throw exception if the value is not parsable as a tuple.
 		try {
-			valueTuple = Tuple::unpack(keyValue->value);
+			valueTuple = TupleView::unpack(keyValue->value);
 		} catch (Error& e) {
 			TraceEvent("ValueNotTuple").error(e).detail("Value", keyValue->value.printable());
 			throw value_not_tuple();
@@ -5045,8 +5215,9 @@ void preprocessMappedKey(Tuple& mappedKeyFormatTuple, std::vector<Optional<Tuple
 
 Key constructMappedKey(KeyValueRef* keyValue, std::vector<Optional<Tuple>>& vec, Tuple& mappedKeyFormatTuple) {
 	// Lazily parse key and/or value to tuple because they may not need to be a tuple if not used.
-	Optional<Tuple> keyTuple;
-	Optional<Tuple> valueTuple;
+	// Views into keyValue, which outlives them
+	Optional<TupleView> keyTuple;
+	Optional<TupleView> valueTuple;
 	Tuple mappedKeyTuple;
 
 	mappedKeyTuple.reserve(vec.size());
@@ -5063,7 +5234,7 @@ Key constructMappedKey(KeyValueRef* keyValue, std::vector<Optional<Tuple>>& vec,
 			std::string s = mappedKeyFormatTuple.getString(i).toString();
 			auto sz = s.size();
 			int idx;
-			Tuple* referenceTuple;
+			TupleView* referenceTuple;
 			try {
 				idx = std::stoi(s.substr(3, sz - 5));
 			} catch (std::exception& e) {
@@ -6960,26 +7131,28 @@ bool changeDurableVersion(StorageServer* data, Version desiredDurableVersion) {
 			verData.createNewVersion(data->version.get() + 1);
 
 		int64_t bytesDurable = VERSION_OVERHEAD;
-		for (const auto& m : v.mutations) {
-			bytesDurable += mvccStorageBytes(m);
-			auto i = verData.atLatest().find(m.param1);
-			if (i) {
-				ASSERT(i.key() == m.param1);
-				ASSERT(i.insertVersion() >= nextDurableVersion);
-				if (i.insertVersion() == nextDurableVersion)
-					verData.erase(i);
-			}
-			if (m.type == MutationRef::SetValue) {
-				// A set can split a clear, so there might be another entry immediately after this one that should also
-				// be cleaned up
-				i = verData.atLatest().upper_bound(m.param1);
+		verData.visit([&](auto& map) {
+			for (const auto& m : v.mutations) {
+				bytesDurable += mvccStorageBytes(m);
+				auto i = map.atLatest().find(m.param1);
 				if (i) {
+					ASSERT(i.key() == m.param1);
 					ASSERT(i.insertVersion() >= nextDurableVersion);
 					if (i.insertVersion() == nextDurableVersion)
-						verData.erase(i);
+						map.erase(i);
+				}
+				if (m.type == MutationRef::SetValue) {
+					// A set can split a clear, so there might be another entry immediately after this one that should
+					// also be cleaned up
+					i = map.atLatest().upper_bound(m.param1);
+					if (i) {
+						ASSERT(i.insertVersion() >= nextDurableVersion);
+						if (i.insertVersion() == nextDurableVersion)
+							map.erase(i);
+					}
 				}
 			}
-		}
+		});
 		data->counters.bytesDurable += bytesDurable;
 	}
 
@@ -7030,7 +7203,10 @@ Optional<MutationRef> clipMutation(MutationRef const& m, KeyRangeRef range) {
 	return Optional<MutationRef>();
 }
 
-bool convertAtomicOp(MutationRef& m, StorageServer::VersionedData const& data, UpdateEagerReadInfo* eager, Arena& ar) {
+// convertAtomicOp, expandClear and applyMutation take the map that StorageServer::VersionedData holds, so that they
+// make their tree operations directly on it
+template <class Map>
+bool convertAtomicOp(MutationRef& m, Map const& data, UpdateEagerReadInfo* eager, Arena& ar) {
 	// After this function call, m should be copied into an arena immediately (before modifying data, shards, or eager)
 	if (m.type != MutationRef::ClearRange && m.type != MutationRef::SetValue) {
 		Optional<StringRef> oldVal;
@@ -7092,8 +7268,9 @@ bool convertAtomicOp(MutationRef& m, StorageServer::VersionedData const& data, U
 	return true;
 }
 
+template <class Map>
 void expandClear(MutationRef& m,
-                 StorageServer::VersionedData const& data,
+                 Map const& data,
                  UpdateEagerReadInfo* eager,
                  KeyRef eagerTrustedEnd) {
 	// After this function call, m should be copied into an arena immediately (before modifying data, shards, or eager)
@@ -7140,10 +7317,11 @@ void expandClear(MutationRef& m,
 	}
 }
 
+template <class Map>
 void applyMutation(StorageServer* self,
                    MutationRef const& m,
                    Arena& arena,
-                   StorageServer::VersionedData& data,
+                   Map& data,
                    Version version) {
 	// m is expected to be in arena already
 	// Clear split keys are added to arena
@@ -7154,6 +7332,12 @@ void applyMutation(StorageServer* self,
 	self->metrics.notify(m.param1, metrics);
 
 	if (m.type == MutationRef::SetValue) {
+		// Queued sets must stay in increasing key order. Since sets never start or end a clear, the clears found
+		// below are the same whether or not the queued sets are in the tree yet.
+		if (!self->pendingSets.empty() && !(self->pendingSets.back().first < m.param1)) {
+			self->flushPendingSets();
+		}
+
 		// VersionedMap (data) is bookkeeping all empty ranges. If the key to be set is new, it is supposed to be in a
 		// range what was empty. Break the empty range into halves.
 		auto prev = data.atLatest().lastLessOrEqual(m.param1);
@@ -7177,10 +7361,15 @@ void applyMutation(StorageServer* self,
 			}
 			++self->counters.pTreeClearSplits;
 		}
-		data.insert(m.param1, ValueOrClearToRef::value(m.param2));
+		if (self->batchingSets) {
+			self->pendingSets.emplace_back(m.param1, ValueOrClearToRef::value(m.param2));
+		} else {
+			data.insert(m.param1, ValueOrClearToRef::value(m.param2));
+		}
 		self->watches.trigger(m.param1);
 		++self->counters.pTreeSets;
 	} else if (m.type == MutationRef::ClearRange) {
+		self->flushPendingSets();
 		data.erase(m.param1, m.param2);
 		ASSERT(m.param2 > m.param1);
 		if (EXPENSIVE_VALIDATION) {
@@ -10712,32 +10901,39 @@ void StorageServer::addMutation(Version version,
 	    nonExpanded; // need to keep non-expanded but atomic converted version of clear mutations for change feeds
 	auto& mLog = addVersionToMutationLog(version);
 
-	if (!convertAtomicOp(expanded, data(), eagerReads, mLog.arena())) {
-		return;
+	// Atomic operations and clears read the latest version of the data
+	if (mutation.type != MutationRef::SetValue) {
+		flushPendingSets();
 	}
-	if (expanded.type == MutationRef::ClearRange) {
-		nonExpanded = expanded;
-		expandClear(expanded, data(), eagerReads, shard.end);
-	}
-	expanded = addMutationToMutationLog(mLog, expanded);
-	DEBUG_MUTATION("applyMutation", version, expanded, thisServerID)
-	    .detail("ShardBegin", shard.begin)
-	    .detail("ShardEnd", shard.end);
-
-	if (!fromFetch) {
-		// have to do change feed before applyMutation because nonExpanded wasn't copied into the mutation log
-		// arena, and thus would go out of scope if it wasn't copied into the change feed arena
 
-		MutationRefAndCipherKeys encrypt = encryptedMutation;
-		if (encrypt.mutation.isEncrypted() && mutation.type != MutationRef::SetValue &&
-		    mutation.type != MutationRef::ClearRange) {
-			encrypt.mutation = expanded.encrypt(encrypt.cipherKeys, mLog.arena(), BlobCipherMetrics::TLOG);
+	mutableData().visit([&](auto& map) {
+		if (!convertAtomicOp(expanded, map, eagerReads, mLog.arena())) {
+			return;
 		}
+		if (expanded.type == MutationRef::ClearRange) {
+			nonExpanded = expanded;
+			expandClear(expanded, map, eagerReads, shard.end);
+		}
+		expanded = addMutationToMutationLog(mLog, expanded);
+		DEBUG_MUTATION("applyMutation", version, expanded, thisServerID)
+		    .detail("ShardBegin", shard.begin)
+		    .detail("ShardEnd", shard.end);
 
-		applyChangeFeedMutation(
-		    this, expanded.type == MutationRef::ClearRange ? nonExpanded : expanded, encrypt, version, shard);
-	}
-	applyMutation(this, expanded, mLog.arena(), mutableData(), version);
+		if (!fromFetch) {
+			// have to do change feed before applyMutation because nonExpanded wasn't copied into the mutation log
+			// arena, and thus would go out of scope if it wasn't copied into the change feed arena
+
+			MutationRefAndCipherKeys encrypt = encryptedMutation;
+			if (encrypt.mutation.isEncrypted() && mutation.type != MutationRef::SetValue &&
+			    mutation.type != MutationRef::ClearRange) {
+				encrypt.mutation = expanded.encrypt(encrypt.cipherKeys, mLog.arena(), BlobCipherMetrics::TLOG);
+			}
+
+			applyChangeFeedMutation(
+			    this, expanded.type == MutationRef::ClearRange ? nonExpanded : expanded, encrypt, version, shard);
+		}
+		applyMutation(this, expanded, mLog.arena(), map, version);
+	});
 
 	// printf("\nSSUpdate: Printing versioned tree after applying mutation\n");
 	// mutableData().printTree(version);
@@ -10770,12 +10966,14 @@ public:
 		//TraceEvent("SSNewVersion", data->thisServerID).detail("VerWas", data->mutableData().latestVersion).detail("ChVer", ver);
 
 		if (currentVersion != ver) {
+			data->flushPendingSets();
 			fromVersion = currentVersion;
 			currentVersion = ver;
 			data->mutableData().createNewVersion(ver);
 		}
 
 		if (m.param1.startsWith(systemKeys.end)) {
+			data->flushPendingSets();
 			if ((m.type == MutationRef::SetValue) && m.param1.substr(1).startsWith(storageCachePrefix)) {
 				applyPrivateCacheData(data, m);
 			} else if ((m.type == MutationRef::SetValue) && m.param1.substr(1).startsWith(checkpointPrefix)) {
@@ -11593,6 +11791,7 @@ ACTOR Future<Void> update(StorageServer* data, bool* pReceivedUpdate) {
 
 		data->updateEagerReads = &eager;
 		data->debug_inApplyUpdate = true;
+		data->batchingSets = SERVER_KNOBS->STORAGE_BATCH_PTREE_SETS;
 
 		state StorageUpdater updater(data->lastVersionWithData, data->restoredVersion);
 
@@ -11616,6 +11815,7 @@ ACTOR Future<Void> update(StorageServer* data, bool* pReceivedUpdate) {
 				injectedChanges = true;
 				if (mutationBytes > SERVER_KNOBS->DESIRED_UPDATE_BYTES) {
 					mutationBytes = 0;
+					data->flushPendingSets();
 					wait(delay(SERVER_KNOBS->UPDATE_DELAY));
 				}
 			}
@@ -11630,6 +11830,7 @@ ACTOR Future<Void> update(StorageServer* data, bool* pReceivedUpdate) {
 		for (; cloneCursor2->hasMessage(); cloneCursor2->nextMessage()) {
 			if (mutationBytes > SERVER_KNOBS->DESIRED_UPDATE_BYTES) {
 				mutationBytes = 0;
+				data->flushPendingSets();
 				// Instead of just yielding, leave time for the storage server to respond to reads
 				wait(delay(SERVER_KNOBS->UPDATE_DELAY));
 			}
@@ -11800,6 +12001,8 @@ ACTOR Future<Void> update(StorageServer* data, bool* pReceivedUpdate) {
 		if (injectedChanges)
 			data->lastVersionWithData = ver;
 
+		data->flushPendingSets();
+		data->batchingSets = false;
 		data->updateEagerReads = nullptr;
 		data->debug_inApplyUpdate = false;
 
@@ -13632,6 +13835,16 @@ ACTOR Future<Void> serveGetValueRequests(StorageServer* self, FutureStream<GetVa
 	}
 }
 
+ACTOR Future<Void> serveGetValuesRequests(StorageServer* self, FutureStream<GetValuesRequest> getValues) {
+	getCurrentLineage()->modify(&TransactionLineage::operation) = TransactionLineage::Operation::GetValue;
+	loop {
+		GetValuesRequest req = waitNext(getValues);
+		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so
+		// downgrade before doing real work
+		self->actors.add(self->readGuard(req, getValuesQ));
+	}
+}
+
 ACTOR Future<Void> serveGetKeyValuesRequests(StorageServer* self, FutureStream<GetKeyValuesRequest> getKeyValues) {
 	getCurrentLineage()->modify(&TransactionLineage::operation) = TransactionLineage::Operation::GetKeyValues;
 	loop {
@@ -13965,6 +14178,7 @@ ACTOR Future<Void> storageServerCore(StorageServer* self, StorageServerInterface
 	self->actors.add(logLongByteSampleRecovery(self->byteSampleRecovery));
 	self->actors.add(checkBehind(self));
 	self->actors.add(serveGetValueRequests(self, ssi.getValue.getFuture()));
+	self->actors.add(serveGetValuesRequests(self, ssi.getValues.getFuture()));
 	self->actors.add(serveGetKeyValuesRequests(self, ssi.getKeyValues.getFuture()));
 	self->actors.add(serveGetMappedKeyValuesRequests(self, ssi.getMappedKeyValues.getFuture()));
 	self->actors.add(serveGetKeyValuesStreamRequests(self, ssi.getKeyValuesStream.getFuture()));
@@ -14759,7 +14973,7 @@ Possibilities:
 void versionedMapTest() {
 	VersionedMap<int, int> vm;
 
-	printf("SS Ptree node is %zu bytes\n", sizeof(StorageServer::VersionedData::PTreeT));
+	printf("SS Ptree node is %zu bytes\n", sizeof(VersionedMap<KeyRef, ValueOrClearToRef>::PTreeT));
 
 	const int NSIZE = sizeof(VersionedMap<int, int>::PTreeT);
 	const int ASIZE = NSIZE <= 64 ? 64 : nextFastAllocatedSize(NSIZE);
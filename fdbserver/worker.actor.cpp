@@ -27,6 +27,7 @@
 #include "fdbserver/BlobMigratorInterface.h"
 #include "flow/ApiVersion.h"
 #include "flow/CodeProbe.h"
+#include "flow/CompressionUtils.h"
 #include "flow/IAsyncFile.h"
 #include "fdbrpc/Locality.h"
 #include "fdbclient/GetEncryptCipherKeys_impl.actor.h"
@@ -3248,6 +3249,8 @@ ACTOR Future<Void> workerServer(Reference<IClusterConnectionRecord> connRecord,
 				CommitProxyInterface recruited;
 				recruited.processId = locality.processId();
 				recruited.provisional = false;
+				recruited.acceptsCompressedMutations =
+				    CompressionUtils::supportedFilters.contains(CompressionFilter::ZSTD);
 				recruited.initEndpoints();
 
 				std::map<std::string, std::string> details;
@@ -0,0 +1,254 @@
+/*
+ * GetMulti.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbclient/ReadYourWrites.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+/*
+ * Compares getMulti() against reading the same keys one get() at a time. Setup writes every key but one in four,
+ * spread over the test keyspace so that data distribution (and RandomMoveKeys, when it runs alongside) puts them in
+ * different shards. Each round reads a random set of keys through two transactions at the same read version which
+ * hold the same uncommitted sets, clears and range clears: one calls getMulti(), the other get() on each key. The
+ * results must agree, and keys nothing wrote to in the round must match what setup wrote. The time each way took is
+ * reported as a metric.
+ */
+
+struct GetMultiWorkload : TestWorkload {
+	static constexpr auto NAME = "GetMulti";
+
+	struct LocalWrite {
+		KeyRange range;
+		Optional<Value> value; // Absent for a clear
+	};
+
+	int nodeCount, keysPerRead;
+	double testDuration, transactionsPerSecond;
+
+	Future<Void> client;
+	PerfIntCounter reads, keysRead, mismatches;
+	PerfDoubleCounter getMultiTime, getsTime;
+
+	GetMultiWorkload(WorkloadContext const& wcx)
+	  : TestWorkload(wcx), reads("Reads"), keysRead("KeysRead"), mismatches("Mismatches"),
+	    getMultiTime("GetMultiTime"), getsTime("IndividualGetsTime") {
+		nodeCount = getOption(options, "nodeCount"_sr, 1000);
+		keysPerRead = getOption(options, "keysPerRead"_sr, 50);
+		testDuration = getOption(options, "testDuration"_sr, 30.0);
+		transactionsPerSecond = getOption(options, "transactionsPerSecond"_sr, 20.0);
+	}
+
+	Key keyForIndex(int n) const { return doubleToTestKey((double)n / nodeCount); }
+	Value valueForIndex(int n) const { return StringRef(format("value%d", n)); }
+	bool presentAfterSetup(int n) const { return n % 4 != 0; }
+
+	Future<Void> setup(Database const& cx) override {
+		if (clientId != 0)
+			return Void();
+		return writeKeys(this, cx);
+	}
+
+	Future<Void> start(Database const& cx) override {
+		if (clientId != 0)
+			return Void();
+		client = timeout(compareReads(this, cx), testDuration, Void());
+		return delay(testDuration);
+	}
+
+	Future<bool> check(Database const& cx) override {
+		if (clientId != 0)
+			return true;
+		bool ok = !client.isError() && !mismatches.getValue();
+		if (client.isError()) {
+			TraceEvent(SevError, "TestFailure").error(client.getError()).detail("Reason", "Client failed");
+		}
+		client = Void();
+		return ok;
+	}
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		m.push_back(reads.getMetric());
+		m.push_back(keysRead.getMetric());
+		m.push_back(mismatches.getMetric());
+		if (reads.getValue()) {
+			m.emplace_back(
+			    "Mean GetMulti Latency (ms)", 1000 * getMultiTime.getValue() / reads.getValue(), Averaged::True);
+			m.emplace_back(
+			    "Mean Individual Gets Latency (ms)", 1000 * getsTime.getValue() / reads.getValue(), Averaged::True);
+		}
+	}
+
+	ACTOR static Future<Void> writeKeys(GetMultiWorkload* self, Database cx) {
+		state int begin = 0;
+		state Transaction tr(cx);
+		while (begin < self->nodeCount) {
+			try {
+				for (int i = begin; i < std::min(begin + 100, self->nodeCount); i++) {
+					if (self->presentAfterSetup(i)) {
+						tr.set(self->keyForIndex(i), self->valueForIndex(i));
+					}
+				}
+				wait(tr.commit());
+				begin += 100;
+				tr.reset();
+			} catch (Error& e) {
+				wait(tr.onError(e));
+			}
+		}
+		return Void();
+	}
+
+	static void applyWrites(ReadYourWritesTransaction& tr, const std::vector<LocalWrite>& writes) {
+		for (const auto& w : writes) {
+			if (w.value.present()) {
+				tr.set(w.range.begin, w.value.get());
+			} else {
+				tr.clear(w.range);
+			}
+		}
+	}
+
+	// Picks distinct keys in random order, and the uncommitted writes to make before reading them
+	void chooseRound(Standalone<VectorRef<KeyRef>>& keys, std::vector<int>& indexes, std::vector<LocalWrite>& writes) {
+		std::set<int> chosen;
+		int count = deterministicRandom()->randomInt(1, keysPerRead + 1);
+		while (chosen.size() < std::min<size_t>(count, nodeCount)) {
+			chosen.insert(deterministicRandom()->randomInt(0, nodeCount));
+		}
+		indexes.assign(chosen.begin(), chosen.end());
+		deterministicRandom()->randomShuffle(indexes);
+		for (int i : indexes) {
+			keys.push_back_deep(keys.arena(), keyForIndex(i));
+			double r = deterministicRandom()->random01();
+			if (r < 0.1) {
+				writes.push_back({ singleKeyRange(keyForIndex(i)), Optional<Value>() });
+			} else if (r < 0.2) {
+				writes.push_back({ singleKeyRange(keyForIndex(i)), Value("local"_sr) });
+			}
+		}
+		if (deterministicRandom()->random01() < 0.2) {
+			int a = deterministicRandom()->randomInt(0, nodeCount);
+			int b = std::min(nodeCount, a + deterministicRandom()->randomInt(1, 10));
+			writes.push_back({ KeyRangeRef(keyForIndex(a), keyForIndex(b)), Optional<Value>() });
+		}
+	}
+
+	static bool writtenInRound(const KeyRef& key, const std::vector<LocalWrite>& writes) {
+		return std::any_of(
+		    writes.begin(), writes.end(), [&key](const LocalWrite& w) { return w.range.contains(key); });
+	}
+
+	ACTOR static Future<Void> compareReads(GetMultiWorkload* self, Database cx) {
+		state double lastTime = now();
+		state ReadYourWritesTransaction trMulti(cx);
+		state ReadYourWritesTransaction trGets(cx);
+		state Standalone<VectorRef<KeyRef>> keys;
+		state std::vector<int> indexes;
+		state std::vector<LocalWrite> writes;
+		state bool rywDisabled = false;
+		state Version readVersion;
+		state RangeResult multi;
+		state std::vector<Future<Optional<Value>>> gets;
+		state double startTime;
+		state double multiTime;
+
+		loop {
+			wait(poisson(&lastTime, 1.0 / self->transactionsPerSecond));
+
+			keys = Standalone<VectorRef<KeyRef>>();
+			indexes.clear();
+			writes.clear();
+			self->chooseRound(keys, indexes, writes);
+			rywDisabled = deterministicRandom()->random01() < 0.2;
+			trMulti.reset();
+			trGets.reset();
+
+			loop {
+				try {
+					if (rywDisabled) {
+						trMulti.setOption(FDBTransactionOptions::READ_YOUR_WRITES_DISABLE);
+						trGets.setOption(FDBTransactionOptions::READ_YOUR_WRITES_DISABLE);
+					}
+					wait(store(readVersion, trMulti.getReadVersion()));
+					trGets.setVersion(readVersion);
+					applyWrites(trMulti, writes);
+					applyWrites(trGets, writes);
+
+					startTime = now();
+					wait(store(multi, trMulti.getMulti(keys)));
+					multiTime = now() - startTime;
+
+					startTime = now();
+					gets.clear();
+					for (const auto& key : keys) {
+						gets.push_back(trGets.get(key));
+					}
+					wait(waitForAll(gets));
+					self->getsTime += now() - startTime;
+					self->getMultiTime += multiTime;
+					break;
+				} catch (Error& e) {
+					wait(trMulti.onError(e));
+					trGets.reset();
+				}
+			}
+
+			// getMulti() returns the keys which are present, in the order they were asked for
+			int next = 0;
+			for (int i = 0; i < keys.size(); i++) {
+				const Optional<Value>& value = gets[i].get();
+				bool matches = value.present()
+				                   ? next < multi.size() && multi[next].key == keys[i] && multi[next].value == value.get()
+				                   : next >= multi.size() || multi[next].key != keys[i];
+				if (value.present() && next < multi.size() && multi[next].key == keys[i]) {
+					++next;
+				}
+				// With read-your-writes disabled the reads do not see this round's writes
+				bool matchesSetup = (!rywDisabled && writtenInRound(keys[i], writes)) ||
+				                    (self->presentAfterSetup(indexes[i])
+				                         ? value.present() && value.get() == self->valueForIndex(indexes[i])
+				                         : !value.present());
+				if (!matches || !matchesSetup) {
+					TraceEvent(SevError, "GetMultiMismatch")
+					    .detail("Key", keys[i])
+					    .detail("GetValue", value.present() ? value.get() : "<absent>"_sr)
+					    .detail("GetMultiKey", next < multi.size() ? multi[next].key : ""_sr)
+					    .detail("MatchesSetup", matchesSetup)
+					    .detail("ReadYourWritesDisabled", rywDisabled)
+					    .detail("ReadVersion", readVersion);
+					++self->mismatches;
+				}
+			}
+			if (next != multi.size()) {
+				TraceEvent(SevError, "GetMultiExtraKeys")
+				    .detail("Returned", multi.size())
+				    .detail("Expected", next)
+				    .detail("ReadVersion", readVersion);
+				++self->mismatches;
+			}
+			++self->reads;
+			self->keysRead += keys.size();
+		}
+	}
+};
+
+WorkloadFactory<GetMultiWorkload> GetMultiWorkloadFactory;
@@ -0,0 +1,147 @@
+/*
+ * ReadVersionStaleness.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/DatabaseContext.h"
+#include "fdbclient/Knobs.h"
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+/*
+ * Checks the max_read_version_staleness transaction option. A writer commits through one database and a reader
+ * then starts transactions with the option through another, so the reader's read version cache only ever holds
+ * versions it got from the GRV proxies. Once the bound has passed since a commit was acknowledged, a transaction
+ * with the option must read at or after that commit, whether or not its read version came from the cache. Between
+ * rounds the reader sometimes stops using the option for longer than VERSION_CACHE_LAG_WINDOW, after which the
+ * background updater must be back to refreshing the cache every MAX_VERSION_CACHE_LAG.
+ */
+
+struct ReadVersionStalenessWorkload : TestWorkload {
+	static constexpr auto NAME = "ReadVersionStaleness";
+
+	double testDuration, operationsPerSecond;
+	int64_t maxReadVersionStalenessMs;
+
+	Future<Void> client;
+	PerfIntCounter checks, staleReadVersions, lagNotRestored;
+
+	ReadVersionStalenessWorkload(WorkloadContext const& wcx)
+	  : TestWorkload(wcx), checks("Checks"), staleReadVersions("StaleReadVersions"),
+	    lagNotRestored("CacheLagNotRestored") {
+		testDuration = getOption(options, "testDuration"_sr, 30.0);
+		operationsPerSecond = getOption(options, "operationsPerSecond"_sr, 20.0);
+		maxReadVersionStalenessMs =
+		    getOption(options, "maxReadVersionStalenessMs"_sr, (int64_t)deterministicRandom()->randomInt(1, 200));
+	}
+
+	Future<Void> setup(Database const& cx) override { return Void(); }
+
+	Future<Void> start(Database const& cx) override {
+		if (clientId != 0)
+			return Void();
+		client = timeout(reader(this, cx->clone(), cx->clone()), testDuration, Void());
+		return delay(testDuration);
+	}
+
+	Future<bool> check(Database const& cx) override {
+		if (clientId != 0)
+			return true;
+		bool ok = !client.isError() && !staleReadVersions.getValue() && !lagNotRestored.getValue();
+		if (client.isError()) {
+			TraceEvent(SevError, "TestFailure").error(client.getError()).detail("Reason", "Client failed");
+		}
+		client = Void();
+		return ok;
+	}
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		m.push_back(checks.getMetric());
+		m.push_back(staleReadVersions.getMetric());
+		m.push_back(lagNotRestored.getMetric());
+	}
+
+	ACTOR static Future<Version> commitWrite(Database writer, Key key) {
+		state Transaction tr(writer);
+		loop {
+			try {
+				tr.set(key, "value"_sr);
+				wait(tr.commit());
+				return tr.getCommittedVersion();
+			} catch (Error& e) {
+				wait(tr.onError(e));
+			}
+		}
+	}
+
+	ACTOR static Future<Void> reader(ReadVersionStalenessWorkload* self, Database writer, Database cx) {
+		state double lastTime = now();
+		state double staleness = self->maxReadVersionStalenessMs / 1000.0;
+		loop {
+			wait(poisson(&lastTime, 1.0 / self->operationsPerSecond));
+
+			if (deterministicRandom()->random01() < 0.05) {
+				// Stop asking for the bound, and the updater must fall back to its usual cadence
+				wait(delay(CLIENT_KNOBS->VERSION_CACHE_LAG_WINDOW + 0.1));
+				if (cx->getGrvCacheLag() != CLIENT_KNOBS->MAX_VERSION_CACHE_LAG) {
+					TraceEvent(SevError, "ReadVersionCacheLagNotRestored")
+					    .detail("Lag", cx->getGrvCacheLag())
+					    .detail("MaxLag", CLIENT_KNOBS->MAX_VERSION_CACHE_LAG);
+					++self->lagNotRestored;
+				}
+				lastTime = now();
+			}
+
+			state Key key(
+			    format("ReadVersionStaleness/%s", deterministicRandom()->randomUniqueID().toString().c_str()));
+			state Version commitVersion = wait(commitWrite(writer, key));
+			state double committedTime = now();
+
+			// Reading within the bound may or may not see the commit, but reading after it must
+			state bool pastBound = deterministicRandom()->coinflip();
+			wait(delay(pastBound ? staleness * (1 + deterministicRandom()->random01()) + 0.001
+			                     : staleness * deterministicRandom()->random01()));
+			pastBound = now() - committedTime > staleness;
+
+			state Transaction tr(cx);
+			loop {
+				try {
+					tr.setOption(FDBTransactionOptions::MAX_READ_VERSION_STALENESS,
+					             StringRef((uint8_t*)&self->maxReadVersionStalenessMs, sizeof(int64_t)));
+					state Version readVersion = wait(tr.getReadVersion());
+					if (pastBound && readVersion < commitVersion) {
+						TraceEvent(SevError, "ReadVersionTooStale")
+						    .detail("ReadVersion", readVersion)
+						    .detail("CommitVersion", commitVersion)
+						    .detail("SinceCommit", now() - committedTime)
+						    .detail("Staleness", staleness);
+						++self->staleReadVersions;
+					}
+					++self->checks;
+					break;
+				} catch (Error& e) {
+					wait(tr.onError(e));
+				}
+			}
+		}
+	}
+};
+
+WorkloadFactory<ReadVersionStalenessWorkload> ReadVersionStalenessWorkloadFactory;
@@ -20,6 +20,7 @@
 
 #include "fdbclient/FDBOptions.g.h"
 #include "fdbclient/NativeAPI.actor.h"
+#include "fdbserver/Knobs.h"
 #include "fdbserver/TesterInterface.actor.h"
 #include "fdbserver/workloads/workloads.actor.h"
 #include "fdbserver/workloads/BulkSetup.actor.h"
@@ -80,11 +81,14 @@ ACTOR Future<Void> convertStream(PromiseStream<RangeResult> input, PromiseStream
 struct StreamingRangeReadWorkload : KVWorkload {
 	static constexpr auto NAME = "StreamingRangeRead";
 	double testDuration;
+	bool streamModeCommits;
 	std::string valueString;
 	Future<Void> client;
+	Future<Void> streamModeClient;
 
 	StreamingRangeReadWorkload(WorkloadContext const& wcx) : KVWorkload(wcx) {
 		testDuration = getOption(options, "testDuration"_sr, 60.0);
+		streamModeCommits = getOption(options, "streamModeCommits"_sr, true);
 		valueString = std::string(maxValueBytes, '.');
 	}
 
@@ -98,11 +102,15 @@ struct StreamingRangeReadWorkload : KVWorkload {
 	Future<Void> setup(Database const& cx) override { return bulkSetup(cx, this, nodeCount, Promise<double>()); }
 	Future<Void> start(Database const& cx) override {
 		client = timeout(streamingClient(cx->clone(), this), testDuration, Void());
+		if (streamModeCommits && clientId == 0) {
+			streamModeClient = timeout(streamModeCommitClient(cx->clone(), this), testDuration, Void());
+		}
 		return delay(testDuration);
 	}
 
 	Future<bool> check(Database const& cx) override {
 		client = Void();
+		streamModeClient = Void();
 		return true;
 	}
 
@@ -166,6 +174,56 @@ struct StreamingRangeReadWorkload : KVWorkload {
 			rateLimit = delay(0.01);
 		}
 	}
+
+	// Reads the database in batches served from a range stream, as STREAM mode does, and keeps reading after the read
+	// version has expired so that the stream fails part way through. Then commits a write, which must fail or succeed
+	// like any other commit after a failed read rather than with broken_promise.
+	ACTOR Future<Void> streamModeCommitClient(Database cx, StreamingRangeReadWorkload* self) {
+		state Transaction tr(cx);
+		loop {
+			state Key next;
+			state int batches = 0;
+			state bool streamFailed = false;
+			try {
+				loop {
+					state RangeResult batch =
+					    wait(tr.getRangeStreamBatch(KeySelector(firstGreaterOrEqual(next), next.arena()),
+					                                KeySelector(firstGreaterOrEqual(normalKeys.end)),
+					                                GetRangeLimits(10),
+					                                Snapshot::False,
+					                                Reverse::False));
+					if (!batch.more) {
+						break;
+					}
+					next = keyAfter(batch.back().key);
+					if (++batches == 1) {
+						wait(delay(2.0 * SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS /
+						           SERVER_KNOBS->VERSIONS_PER_SECOND));
+					}
+				}
+			} catch (Error& e) {
+				if (e.code() == error_code_actor_cancelled) {
+					throw;
+				}
+				CODE_PROBE(batches > 0, "Range stream batch failed after earlier batches were returned");
+				streamFailed = true;
+			}
+
+			try {
+				tr.set(self->keyForIndex(deterministicRandom()->randomInt(0, self->nodeCount), false),
+				       self->randomValue());
+				wait(tr.commit());
+				tr.reset();
+			} catch (Error& e) {
+				if (e.code() == error_code_broken_promise) {
+					TraceEvent(SevError, "StreamModeCommitBrokenPromise").detail("StreamFailed", streamFailed);
+					ASSERT(false);
+				}
+				wait(tr.onError(e));
+			}
+			wait(delay(0.1));
+		}
+	}
 };
 
 WorkloadFactory<StreamingRangeReadWorkload> StreamingRangeReadWorkloadFactory;
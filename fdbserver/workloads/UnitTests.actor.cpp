@@ -43,6 +43,7 @@ void forceLinkRESTClientTests();
 void forceLinkRESTUtilsTests();
 void forceLinkRESTKmsConnectorTest();
 void forceLinkCompressionUtilsTest();
+void forceLinkCommitProxyInterfaceTests();
 void forceLinkAtomicTests();
 void forceLinkIdempotencyIdTests();
 void forceLinkBlobConnectionProviderTests();
@@ -55,6 +56,8 @@ void forceLinkRandomKeyValueUtilsTests();
 void forceLinkSimKmsVaultTests();
 void forceLinkRESTSimKmsVaultTest();
 void forceLinkActorFuzzUnitTests();
+void forceLinkSharedLocationCacheTests();
+void forceLinkGrvBatchControllerTests();
 
 struct UnitTestWorkload : TestWorkload {
 	static constexpr auto NAME = "UnitTests";
@@ -114,6 +117,7 @@ struct UnitTestWorkload : TestWorkload {
 		forceLinkRESTUtilsTests();
 		forceLinkRESTKmsConnectorTest();
 		forceLinkCompressionUtilsTest();
+		forceLinkCommitProxyInterfaceTests();
 		forceLinkAtomicTests();
 		forceLinkIdempotencyIdTests();
 		forceLinkBlobConnectionProviderTests();
@@ -125,6 +129,8 @@ struct UnitTestWorkload : TestWorkload {
 		forceLinkSimKmsVaultTests();
 		forceLinkRESTSimKmsVaultTest();
 		forceLinkActorFuzzUnitTests();
+		forceLinkSharedLocationCacheTests();
+		forceLinkGrvBatchControllerTests();
 	}
 
 	Future<Void> setup(Database const& cx) override {
@@ -408,14 +408,30 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 			}
 			b->totalSizeEstimate = b->bigSize;
 			b->tinySize = b->tinyUsed = NOT_TINY;
+			b->hugePages = false;
 			b->bigUsed = sizeof(ArenaBlock);
 			b->secure = 0;
 		} else {
+			void* hugePages = nullptr;
+			// Blocks of at least a huge page are rounded up by less than half their size
+			if (FLOW_KNOBS && FLOW_KNOBS->HUGE_PAGES &&
+			    reqSize >= std::max<int64_t>(FLOW_KNOBS->HUGE_PAGE_ARENA_BLOCK_BYTES, kHugePageBytes) &&
+			    reqSize <= std::numeric_limits<int>::max() - kHugePageBytes && !keepalive_allocator::isActive()) {
+				// The rest of the last huge page is left for later allocations from the arena
+				reqSize = (reqSize + kHugePageBytes - 1) / kHugePageBytes * kHugePageBytes;
+				hugePages = allocateHugePages(reqSize, FLOW_KNOBS->HUGE_PAGES == 2);
+			}
 #ifdef ALLOC_INSTRUMENTATION
 			allocInstr["ArenaHugeKB"].alloc((reqSize + 1023) >> 10);
 #endif
-			b = (ArenaBlock*)allocateAndMaybeKeepalive(reqSize);
+			if (hugePages) {
+				b = (ArenaBlock*)hugePages;
+				g_hugePageMemory.fetch_add(reqSize);
+			} else {
+				b = (ArenaBlock*)allocateAndMaybeKeepalive(reqSize);
+			}
 			b->tinySize = b->tinyUsed = NOT_TINY;
+			b->hugePages = hugePages != nullptr;
 			b->bigSize = reqSize;
 			b->totalSizeEstimate = b->bigSize;
 			b->bigUsed = sizeof(ArenaBlock);
@@ -525,7 +541,12 @@ void ArenaBlock::destroyLeaf() {
 			allocInstr["ArenaHugeKB"].dealloc((bigSize + 1023) >> 10);
 #endif
 			g_hugeArenaMemory.fetch_sub(bigSize);
-			freeOrMaybeKeepalive(this);
+			if (hugePages) {
+				g_hugePageMemory.fetch_sub(bigSize);
+				freeHugePages(this, bigSize);
+			} else {
+				freeOrMaybeKeepalive(this);
+			}
 		}
 	}
 }
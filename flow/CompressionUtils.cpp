@@ -25,6 +25,8 @@
 #include "flow/IRandom.h"
 #include "flow/UnitTest.h"
 
+#include <limits>
+
 #ifdef ZSTD_LIB_SUPPORTED
 #define ZSTD_STATIC_LINKING_ONLY
 #include <zstd.h>
@@ -103,6 +105,30 @@ StringRef CompressionUtils::decompress(const CompressionFilter filter, const Str
 	throw internal_error(); // We should never get here
 }
 
+Optional<int64_t> CompressionUtils::decompressedSize(const CompressionFilter filter, const StringRef& data) {
+	checkFilterSupported(filter);
+
+	if (filter == CompressionFilter::NONE) {
+		return data.size();
+	}
+#ifdef ZSTD_LIB_SUPPORTED
+	if (filter == CompressionFilter::ZSTD) {
+		const char* src = reinterpret_cast<const char*>(data.begin());
+		size_t frameSize = ZSTD_findFrameCompressedSize(src, data.size());
+		if (ZSTD_isError(frameSize) || frameSize != data.size()) {
+			return Optional<int64_t>();
+		}
+		unsigned long long size = ZSTD_getFrameContentSize(src, data.size());
+		if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR ||
+		    size > std::numeric_limits<int64_t>::max()) {
+			return Optional<int64_t>();
+		}
+		return int64_t(size);
+	}
+#endif
+	throw internal_error(); // We should never get here
+}
+
 int CompressionUtils::getDefaultCompressionLevel(CompressionFilter filter) {
 	checkFilterSupported(filter);
 
@@ -152,6 +178,8 @@ void testCompression(CompressionFilter filter) {
 
 	Standalone<StringRef> compressed = CompressionUtils::compress(filter, uncompressed, arena);
 	ASSERT_NE(compressed.compare(uncompressed), 0);
+	ASSERT_EQ(CompressionUtils::decompressedSize(filter, compressed).get(), size);
+	ASSERT(!CompressionUtils::decompressedSize(filter, compressed.substr(0, compressed.size() - 1)).present());
 
 	StringRef verify = CompressionUtils::decompress(filter, compressed, arena);
 	ASSERT_EQ(verify.compare(uncompressed), 0);
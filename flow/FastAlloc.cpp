@@ -28,6 +28,7 @@
 #include "crc32/crc32c.h"
 #include "flow/flow.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <unordered_map>
@@ -43,7 +44,7 @@
 #include <linux/mman.h>
 #endif
 
-#ifdef __FreeBSD__
+#if defined(__FreeBSD__) || defined(__APPLE__)
 #include <sys/mman.h>
 #endif
 
@@ -113,6 +114,7 @@ template <int Size>
 void* FastAllocator<Size>::freelist = nullptr;
 
 std::atomic<int64_t> g_hugeArenaMemory(0);
+std::atomic<int64_t> g_hugePageMemory(0);
 
 double hugeArenaLastLogged = 0;
 std::map<std::string, std::pair<int, int64_t>> hugeArenaTraces;
@@ -245,17 +247,27 @@ struct FastAllocator<Size>::GlobalData {
 	std::vector<void*> magazines; // These magazines are always exactly magazine_size ("full")
 	std::vector<std::pair<int, void*>>
 	    partial_magazines; // Magazines that are not "full" and their counts.  Only created by releaseThreadMagazines().
+	// Runs of adjacent free objects whose pages were returned to the OS by trimUnused(), as (first object, count).
+	// getMagazine() hands these out after the magazines above, and their pages are faulted back in as they are used.
+	std::vector<std::pair<void*, int>> returned_runs;
 	std::atomic<long long> totalMemory;
 	long long partialMagazineUnallocatedMemory;
+	std::atomic<long long> returnedMemory;
 	std::atomic<long long> activeThreads;
-	GlobalData() : totalMemory(0), partialMagazineUnallocatedMemory(0), activeThreads(0) {
+	GlobalData() : totalMemory(0), partialMagazineUnallocatedMemory(0), returnedMemory(0), activeThreads(0) {
 		InitializeCriticalSection(&mutex);
 	}
 };
 
+// This does not include memory returned to the OS by trimUnused()
 template <int Size>
 long long FastAllocator<Size>::getTotalMemory() {
-	return globalData()->totalMemory.load();
+	return globalData()->totalMemory.load() - globalData()->returnedMemory.load();
+}
+
+template <int Size>
+long long FastAllocator<Size>::getReturnedMemory() {
+	return globalData()->returnedMemory.load();
 }
 
 // This does not include memory held by various threads that's available for allocation
@@ -527,6 +539,18 @@ FastAllocator<Size>::ThreadData::ThreadData() {
 	count = 0;
 }
 
+template <int Size>
+void FastAllocator<Size>::formatMagazine(void** block) {
+	// void** block = new void*[ magazine_size * PSize ];
+	for (int i = 0; i < magazine_size - 1; i++) {
+		block[i * PSize + 1] = block[i * PSize] = &block[(i + 1) * PSize];
+		check(&block[i * PSize], false);
+	}
+
+	block[(magazine_size - 1) * PSize + 1] = block[(magazine_size - 1) * PSize] = nullptr;
+	check(&block[(magazine_size - 1) * PSize], false);
+}
+
 template <int Size>
 void FastAllocator<Size>::getMagazine() {
 	ThreadData& thr = threadData();
@@ -548,6 +572,23 @@ void FastAllocator<Size>::getMagazine() {
 		thr.freelist = p.second;
 		thr.count = p.first;
 		return;
+	} else if (globalData()->returned_runs.size()) {
+		auto& run = globalData()->returned_runs.back();
+		int count = std::min(run.second, magazine_size);
+		run.second -= count;
+		uint8_t* first = (uint8_t*)run.first + run.second * Size;
+		if (run.second == 0) {
+			globalData()->returned_runs.pop_back();
+		}
+		globalData()->returnedMemory.fetch_add(-count * Size);
+		LeaveCriticalSection(&globalData()->mutex);
+		for (int i = 0; i < count - 1; i++) {
+			*(void**)(first + i * Size) = first + (i + 1) * Size;
+		}
+		*(void**)(first + (count - 1) * Size) = nullptr;
+		thr.freelist = first;
+		thr.count = count;
+		return;
 	}
 	globalData()->totalMemory.fetch_add(magazine_size * Size);
 	LeaveCriticalSection(&globalData()->mutex);
@@ -592,17 +633,28 @@ void FastAllocator<Size>::getMagazine() {
 #else
 	const bool includeGuardPages = true;
 #endif
-	block = (void**)::allocate(magazine_size * Size, /*allowLargePages*/ false, includeGuardPages);
-#endif
-
-	// void** block = new void*[ magazine_size * PSize ];
-	for (int i = 0; i < magazine_size - 1; i++) {
-		block[i * PSize + 1] = block[i * PSize] = &block[(i + 1) * PSize];
-		check(&block[i * PSize], false);
+	if (FLOW_KNOBS && FLOW_KNOBS->HUGE_PAGES) {
+		// Magazines are smaller than a huge page, so carve a whole huge page into them
+		block = (void**)allocateHugePages(kHugePageBytes, FLOW_KNOBS->HUGE_PAGES == 2);
 	}
+	if (block) {
+		g_hugePageMemory.fetch_add(kHugePageBytes);
+		const int magazines = kHugePageBytes / (magazine_size * Size);
+		for (int m = 1; m < magazines; m++) {
+			formatMagazine(&block[m * magazine_size * PSize]);
+		}
+		EnterCriticalSection(&globalData()->mutex);
+		globalData()->totalMemory.fetch_add((magazines - 1) * magazine_size * Size);
+		for (int m = 1; m < magazines; m++) {
+			globalData()->magazines.push_back(&block[m * magazine_size * PSize]);
+		}
+		LeaveCriticalSection(&globalData()->mutex);
+	} else {
+		block = (void**)::allocate(magazine_size * Size, /*allowLargePages*/ false, includeGuardPages);
+	}
+#endif
 
-	block[(magazine_size - 1) * PSize + 1] = block[(magazine_size - 1) * PSize] = nullptr;
-	check(&block[(magazine_size - 1) * PSize], false);
+	formatMagazine(block);
 	thr.freelist = block;
 	thr.count = magazine_size;
 }
@@ -612,6 +664,131 @@ void FastAllocator<Size>::releaseMagazine(void* mag) {
 	globalData()->magazines.push_back(mag);
 	LeaveCriticalSection(&globalData()->mutex);
 }
+// Returns the whole pages covered by runs of adjacent objects in the given free objects, and gives the rest back to
+// the pool as magazines. Objects never record whether they are free, so this is the only point at which it is known
+// that nothing else is using a page. With HUGE_PAGES, magazines are carved from huge pages, and returning 4KB of one
+// would split it back into small pages, so only whole huge pages are returned.
+template <int Size>
+long long FastAllocator<Size>::trimObjects(std::vector<void*>& objects) {
+	const uintptr_t pageSize = FLOW_KNOBS && FLOW_KNOBS->HUGE_PAGES ? kHugePageBytes : 4096;
+	std::vector<void*> kept;
+	std::vector<std::pair<void*, int>> runs;
+	long long returned = 0;
+#if defined(__linux__)
+	const int advice = MADV_DONTNEED;
+#else
+	const int advice = MADV_FREE;
+#endif
+
+	std::sort(objects.begin(), objects.end());
+	size_t i = 0;
+	while (i < objects.size()) {
+		size_t j = i + 1;
+		while (j < objects.size() && (uint8_t*)objects[j] == (uint8_t*)objects[j - 1] + Size) {
+			++j;
+		}
+
+		// objects[i, j) are adjacent, so every page between the first and last page boundary they cover is free. An
+		// object which crosses one of those boundaries stays in the pool, so the pages returned are narrowed until
+		// both ends fall between objects. Otherwise the kept object's next pointer, or its next user, would fault the
+		// page back in while it is counted as returned.
+		uintptr_t begin = (uintptr_t)objects[i];
+		uintptr_t end = (uintptr_t)objects[j - 1] + Size;
+		uintptr_t pagesBegin = (begin + pageSize - 1) & ~(pageSize - 1);
+		uintptr_t pagesEnd = end & ~(pageSize - 1);
+		while (pagesBegin < pagesEnd && (pagesBegin - begin) % Size != 0) {
+			pagesBegin = (begin + ((pagesBegin - begin) / Size + 1) * Size + pageSize - 1) & ~(pageSize - 1);
+		}
+		while (pagesBegin < pagesEnd && (pagesEnd - begin) % Size != 0) {
+			pagesEnd = (begin + (pagesEnd - begin) / Size * Size) & ~(pageSize - 1);
+		}
+		size_t first = j, last = j;
+		if (pagesBegin < pagesEnd) {
+			// Objects making up those pages
+			first = i + (pagesBegin - begin) / Size;
+			last = i + (pagesEnd - begin) / Size;
+		}
+		// Fails for parts of explicit huge pages, which can only be returned whole. HUGE_PAGES may have been turned
+		// off since they were allocated.
+		if (first < last && madvise((void*)pagesBegin, pagesEnd - pagesBegin, advice) == 0) {
+			runs.emplace_back(objects[first], last - first);
+			returned += (last - first) * Size;
+		} else {
+			first = last = j;
+		}
+		kept.insert(kept.end(), objects.begin() + i, objects.begin() + first);
+		kept.insert(kept.end(), objects.begin() + last, objects.begin() + j);
+		i = j;
+	}
+
+	std::vector<std::pair<int, void*>> magazines;
+	for (size_t k = 0; k < kept.size(); k += magazine_size) {
+		int count = std::min<size_t>(magazine_size, kept.size() - k);
+		for (int m = 0; m < count - 1; m++) {
+			*(void**)kept[k + m] = kept[k + m + 1];
+		}
+		*(void**)kept[k + count - 1] = nullptr;
+		magazines.emplace_back(count, kept[k]);
+	}
+
+	EnterCriticalSection(&globalData()->mutex);
+	for (auto& [count, mag] : magazines) {
+		if (count == magazine_size) {
+			globalData()->magazines.push_back(mag);
+		} else {
+			globalData()->partial_magazines.emplace_back(count, mag);
+			globalData()->partialMagazineUnallocatedMemory += count * Size;
+		}
+	}
+	globalData()->returned_runs.insert(globalData()->returned_runs.end(), runs.begin(), runs.end());
+	globalData()->returnedMemory.fetch_add(returned);
+	LeaveCriticalSection(&globalData()->mutex);
+	return returned;
+}
+
+template <int Size>
+long long FastAllocator<Size>::trimUnused(long long keepUnusedBytes, long long maxTrimBytes) {
+#if defined(_WIN32) || defined(USE_GPERFTOOLS) || defined(ADDRESS_SANITIZER) || VALGRIND
+	return 0;
+#else
+	// Partial magazines first, since threads only leave them behind when they exit
+	std::vector<std::pair<int, void*>> taken;
+	long long takenBytes = 0;
+	EnterCriticalSection(&globalData()->mutex);
+	long long unused = globalData()->magazines.size() * magazine_size * Size +
+	                   globalData()->partialMagazineUnallocatedMemory;
+	while (unused > keepUnusedBytes && takenBytes < maxTrimBytes) {
+		std::pair<int, void*> p;
+		if (globalData()->partial_magazines.size()) {
+			p = globalData()->partial_magazines.back();
+			globalData()->partial_magazines.pop_back();
+			globalData()->partialMagazineUnallocatedMemory -= p.first * Size;
+		} else if (globalData()->magazines.size()) {
+			p = std::make_pair(magazine_size, globalData()->magazines.back());
+			globalData()->magazines.pop_back();
+		} else {
+			break;
+		}
+		taken.push_back(p);
+		takenBytes += p.first * Size;
+		unused -= p.first * Size;
+	}
+	LeaveCriticalSection(&globalData()->mutex);
+
+	if (taken.empty()) {
+		return 0;
+	}
+	std::vector<void*> objects;
+	objects.reserve(takenBytes / Size);
+	for (auto& [count, mag] : taken) {
+		for (void* p = mag; p; p = *(void**)p) {
+			objects.push_back(p);
+		}
+	}
+	return trimObjects(objects);
+#endif
+}
+
 template <int Size>
 FastAllocator<Size>::ThreadData::~ThreadData() {
 	EnterCriticalSection(&globalData()->mutex);
@@ -650,6 +827,52 @@ int64_t getTotalUnusedAllocatedMemory() {
 	return unusedMemory;
 }
 
+int64_t getTotalReturnedAllocatedMemory() {
+	int64_t returnedMemory = 0;
+
+	returnedMemory += FastAllocator<16>::getReturnedMemory();
+	returnedMemory += FastAllocator<32>::getReturnedMemory();
+	returnedMemory += FastAllocator<64>::getReturnedMemory();
+	returnedMemory += FastAllocator<96>::getReturnedMemory();
+	returnedMemory += FastAllocator<128>::getReturnedMemory();
+	returnedMemory += FastAllocator<256>::getReturnedMemory();
+	returnedMemory += FastAllocator<512>::getReturnedMemory();
+	returnedMemory += FastAllocator<1024>::getReturnedMemory();
+	returnedMemory += FastAllocator<2048>::getReturnedMemory();
+	returnedMemory += FastAllocator<4096>::getReturnedMemory();
+	returnedMemory += FastAllocator<8192>::getReturnedMemory();
+	returnedMemory += FastAllocator<16384>::getReturnedMemory();
+
+	return returnedMemory;
+}
+
+template <int Size>
+static int64_t trimIfUnused(int64_t keepUnusedBytes, int64_t maxTrimBytes) {
+	if (FastAllocator<Size>::getApproximateMemoryUnused() <= keepUnusedBytes) {
+		return 0;
+	}
+	return FastAllocator<Size>::trimUnused(keepUnusedBytes, maxTrimBytes);
+}
+
+int64_t trimUnusedAllocatedMemory(int64_t keepUnusedBytes, int64_t maxTrimBytes) {
+	int64_t returnedMemory = 0;
+
+	returnedMemory += trimIfUnused<16>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<32>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<64>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<96>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<128>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<256>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<512>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<1024>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<2048>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<4096>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<8192>(keepUnusedBytes, maxTrimBytes);
+	returnedMemory += trimIfUnused<16384>(keepUnusedBytes, maxTrimBytes);
+
+	return returnedMemory;
+}
+
 template class FastAllocator<16>;
 template class FastAllocator<32>;
 template class FastAllocator<64>;
@@ -663,6 +886,74 @@ template class FastAllocator<4096>;
 template class FastAllocator<8192>;
 template class FastAllocator<16384>;
 
+TEST_CASE("/flow/FastAllocator/trimUnused") {
+#if !defined(_WIN32) && !defined(USE_GPERFTOOLS) && !defined(ADDRESS_SANITIZER) && !VALGRIND
+	// More objects than a thread keeps to itself, so that most of them are freed to the global pool
+	constexpr int objects = 16 * kFastAllocMagazineBytes / 4096;
+	std::vector<uint8_t*> ptrs;
+	for (int i = 0; i < objects; i++) {
+		ptrs.push_back((uint8_t*)FastAllocator<4096>::allocate());
+		memset(ptrs.back(), 0xab, 4096);
+	}
+	for (auto p : ptrs) {
+		FastAllocator<4096>::release(p);
+	}
+
+	long long unused = FastAllocator<4096>::getApproximateMemoryUnused();
+	long long returned = FastAllocator<4096>::getReturnedMemory();
+	ASSERT(unused >= 8 * kFastAllocMagazineBytes);
+	long long trimmed = FastAllocator<4096>::trimUnused(kFastAllocMagazineBytes, 2 * kFastAllocMagazineBytes);
+	if (FLOW_KNOBS->HUGE_PAGES) {
+		// Only huge pages none of whose objects are in use are returned
+		ASSERT(trimmed % kHugePageBytes == 0 && trimmed < unused);
+		trimmed += FastAllocator<4096>::trimUnused(kFastAllocMagazineBytes, std::numeric_limits<long long>::max());
+		ASSERT(trimmed % kHugePageBytes == 0);
+	} else {
+		// Every 4096 byte object is a whole page of its own, so all of them are returned
+		ASSERT(trimmed >= 2 * kFastAllocMagazineBytes && trimmed < unused);
+		trimmed += FastAllocator<4096>::trimUnused(kFastAllocMagazineBytes, std::numeric_limits<long long>::max());
+		ASSERT(FastAllocator<4096>::getApproximateMemoryUnused() <= kFastAllocMagazineBytes);
+	}
+	ASSERT_EQ(FastAllocator<4096>::getReturnedMemory(), returned + trimmed);
+
+	// Returned objects are handed out again once the magazines run out
+	ptrs.clear();
+	for (int i = 0; i < objects; i++) {
+		ptrs.push_back((uint8_t*)FastAllocator<4096>::allocate());
+		memset(ptrs.back(), 0xcd, 4096);
+	}
+	ASSERT(!trimmed || FastAllocator<4096>::getReturnedMemory() < returned + trimmed);
+	for (auto p : ptrs) {
+		ASSERT(p[0] == 0xcd && p[4095] == 0xcd);
+		FastAllocator<4096>::release(p);
+	}
+
+	// Objects smaller than a page are returned only where they cover whole pages
+	ptrs.clear();
+	for (int i = 0; i < 4 * kFastAllocMagazineBytes / 96; i++) {
+		ptrs.push_back((uint8_t*)FastAllocator<96>::allocate());
+	}
+	for (auto p : ptrs) {
+		FastAllocator<96>::release(p);
+	}
+	trimmed = FastAllocator<96>::trimUnused(0, std::numeric_limits<long long>::max());
+	// No object left in the pool may share a returned page, so what is returned is whole objects and whole pages
+	ASSERT(trimmed % 96 == 0);
+	ASSERT(trimmed % (FLOW_KNOBS->HUGE_PAGES ? kHugePageBytes : 4096) == 0);
+	ASSERT(FastAllocator<96>::getApproximateMemoryUnused() + trimmed >= 2 * kFastAllocMagazineBytes / 96 * 96);
+	ptrs.clear();
+	for (int i = 0; i < 4 * kFastAllocMagazineBytes / 96; i++) {
+		ptrs.push_back((uint8_t*)FastAllocator<96>::allocate());
+		memset(ptrs.back(), 0xef, 96);
+	}
+	for (auto p : ptrs) {
+		ASSERT(p[0] == 0xef && p[95] == 0xef);
+		FastAllocator<96>::release(p);
+	}
+#endif
+	return Void();
+}
+
 #ifdef USE_JEMALLOC
 #include <jemalloc/jemalloc.h>
 TEST_CASE("/jemalloc/4k_aligned_usable_size") {
@@ -0,0 +1,731 @@
+/*
+ * IOUringReactor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/IOUringReactor.h"
+
+#if defined(__linux__) && defined(WITH_LIBURING)
+
+#include <deque>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <liburing.h>
+
+#include "flow/Knobs.h"
+#include "flow/Platform.h"
+#include "flow/TDMetric.actor.h"
+#include "flow/UnitTest.h"
+#include "flow/serialize.h"
+
+namespace N2 {
+
+class IOUringConnection;
+
+// Identifies what a completion belongs to. conn is cleared when the connection goes away before the request finishes;
+// the request itself is freed by its last completion.
+struct IOUringOp : FastAllocated<IOUringOp> {
+	enum Kind : uint8_t { Recv, PollOut, Cancel };
+	Kind kind;
+	IOUringConnection* conn;
+
+	IOUringOp(Kind kind, IOUringConnection* conn) : kind(kind), conn(conn) {}
+};
+
+struct IOUringReactor::Impl {
+	static constexpr int bufferGroup = 0;
+
+	boost::asio::io_service& ios;
+	io_uring ring;
+	bool multishot = true;
+
+	io_uring_buf_ring* bufRing = nullptr;
+	int bufCount;
+	int bufSize;
+	int maxBuffersPerConnection;
+	uint8_t* bufMemory = nullptr;
+	int buffersToPublish = 0;
+
+	int evfd = -1;
+	boost::asio::posix::stream_descriptor evsd;
+	uint64_t evVal;
+
+	// Connections whose receive ended because every provided buffer was in use
+	std::vector<IOUringConnection*> starved;
+
+	Int64MetricHandle countSubmit;
+	Int64MetricHandle countCompletions;
+	Int64MetricHandle countReads;
+	Int64MetricHandle countWrites;
+	Int64MetricHandle countWouldBlock;
+	Int64MetricHandle countRecvBufferStarved;
+	Int64MetricHandle countRecvCapped;
+	Int64MetricHandle bytesReceived;
+
+	explicit Impl(boost::asio::io_service& ios);
+	~Impl();
+
+	uint8_t* buffer(uint16_t bid) { return bufMemory + size_t(bid) * bufSize; }
+
+	void returnBuffer(uint16_t bid) {
+		io_uring_buf_ring_add(bufRing, buffer(bid), bufSize, bid, io_uring_buf_ring_mask(bufCount), buffersToPublish++);
+	}
+
+	io_uring_sqe* getSqe() {
+		io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+		if (sqe == nullptr) {
+			// The submission queue is full, so send what is there now rather than waiting for the run loop
+			submitQueued();
+			sqe = io_uring_get_sqe(&ring);
+			ASSERT(sqe != nullptr);
+		}
+		return sqe;
+	}
+
+	void submitQueued() {
+		if (io_uring_sq_ready(&ring) == 0) {
+			return;
+		}
+		int rc;
+		do {
+			rc = io_uring_submit(&ring);
+		} while (rc == -EINTR);
+		if (rc < 0 && rc != -EAGAIN && rc != -EBUSY) {
+			TraceEvent(SevError, "N2_IOUringSubmitError").detail("Error", strerror(-rc));
+			throw platform_error();
+		}
+		++countSubmit;
+	}
+
+	void submit();
+	void armEventFD();
+	void reap();
+	void complete(IOUringOp* op, int res, uint32_t flags);
+};
+
+class IOUringConnection final : public IConnection, ReferenceCounted<IOUringConnection> {
+public:
+	IOUringConnection(IOUringReactor::Impl* reactor,
+	                  boost::asio::io_service& ios,
+	                  int fd,
+	                  bool isV6,
+	                  NetworkAddress peerAddress)
+	  : reactor(reactor), fd(fd), isV6(isV6), id(nondeterministicRandom()->randomUniqueID()), peer_address(peerAddress),
+	    socket(ios) {
+		armRecv();
+	}
+
+	~IOUringConnection() { closeSocket(); }
+
+	void addref() override { ReferenceCounted<IOUringConnection>::addref(); }
+	void delref() override { ReferenceCounted<IOUringConnection>::delref(); }
+
+	void close() override { closeSocket(); }
+
+	Future<Void> acceptHandshake() override { return Void(); }
+	Future<Void> connectHandshake() override { return Void(); }
+
+	// returns when write() can write at least one byte
+	Future<Void> onWritable() override {
+		if (fd < 0) {
+			return connection_failed();
+		}
+		if (pollOutOp == nullptr) {
+			writable = Promise<Void>();
+			pollOutOp = new IOUringOp(IOUringOp::PollOut, this);
+			io_uring_sqe* sqe = reactor->getSqe();
+			io_uring_prep_poll_add(sqe, fd, POLLOUT);
+			io_uring_sqe_set_data(sqe, pollOutOp);
+		}
+		return writable.getFuture();
+	}
+
+	// returns when read() can read at least one byte, or will throw
+	Future<Void> onReadable() override {
+		if (!received.empty() || readError.present()) {
+			return Void();
+		}
+		if (!readWaiting) {
+			readable = Promise<Void>();
+			readWaiting = true;
+		}
+		return readable.getFuture();
+	}
+
+	// Copies as much received data as fits into [begin,end) and returns the number of bytes copied (might be 0)
+	int read(uint8_t* begin, uint8_t* end) override {
+		++reactor->countReads;
+		uint8_t* p = begin;
+		while (p < end && !received.empty()) {
+			Chunk& c = received.front();
+			int n = std::min<int>(end - p, c.length - c.offset);
+			memcpy(p, reactor->buffer(c.bid) + c.offset, n);
+			p += n;
+			c.offset += n;
+			if (c.offset == c.length) {
+				reactor->returnBuffer(c.bid);
+				received.pop_front();
+			}
+		}
+		if (recvCapped && (int)received.size() <= reactor->maxBuffersPerConnection / 2) {
+			recvCapped = false;
+			armRecv();
+		}
+
+		if (p == begin) {
+			if (readError.present()) {
+				onReadError(readError.get());
+				throw connection_failed();
+			}
+			++reactor->countWouldBlock;
+		}
+		return p - begin;
+	}
+
+	// Writes as many bytes as possible from the given SendBuffer chain into the socket and returns the number of
+	// bytes written (might be 0)
+	int write(SendBuffer const* data, int limit) override {
+		ASSERT(limit > 0);
+		if (fd < 0) {
+			throw connection_failed();
+		}
+		++reactor->countWrites;
+
+		iovec iov[64];
+		int iovCount = 0;
+		for (auto p = data; p && limit > 0 && iovCount < 64; p = p->next) {
+			int len = std::min(limit, p->bytes_unsent());
+			if (len > 0) {
+				iov[iovCount].iov_base = (void*)(p->data() + p->bytes_sent);
+				iov[iovCount].iov_len = len;
+				++iovCount;
+				limit -= len;
+			}
+		}
+		ASSERT(iovCount > 0);
+
+		msghdr msg = {};
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovCount;
+		ssize_t sent;
+		do {
+			sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+		} while (sent < 0 && errno == EINTR);
+
+		if (sent < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				++reactor->countWouldBlock;
+				return 0;
+			}
+			onWriteError(errno);
+			throw connection_failed();
+		}
+		ASSERT(sent > 0);
+		return sent;
+	}
+
+	NetworkAddress getPeerAddress() const override { return peer_address; }
+
+	bool hasTrustedPeer() const override { return true; }
+
+	UID getDebugID() const override { return id; }
+
+	// Hands the descriptor back to asio, e.g. to start TLS over a proxied connection. The receive is cancelled first
+	// so no later completion can take bytes meant for the new owner.
+	boost::asio::ip::tcp::socket& getSocket() override {
+		if (fd >= 0) {
+			cancel(recvOp);
+			reactor->submitQueued();
+			if (!received.empty()) {
+				TraceEvent(SevWarn, "N2_IOUringSocketDetachedWithData", id).detail("PeerAddress", peer_address);
+			}
+			dropReceived();
+			socket.assign(isV6 ? boost::asio::ip::tcp::v6() : boost::asio::ip::tcp::v4(), fd);
+			fd = -1;
+			removeStarved();
+		}
+		return socket;
+	}
+
+	void onReceived(uint16_t bid, int bytes) {
+		reactor->bytesReceived += bytes;
+		received.push_back(Chunk{ bid, 0, bytes });
+		if ((int)received.size() >= reactor->maxBuffersPerConnection) {
+			stopRecv();
+		}
+		wakeReader();
+	}
+
+	// Called with the last completion of the receive
+	void onRecvEnded() {
+		recvOp = nullptr;
+		recvStopping = false;
+	}
+
+	int buffersHeld() const { return received.size(); }
+
+	void onRecvError(int err) {
+		if (!readError.present()) {
+			readError = err;
+		}
+		wakeReader();
+	}
+
+	void onWritableCompleted(int res) {
+		pollOutOp = nullptr;
+		Promise<Void> p = writable;
+		writable = Promise<Void>();
+		if (res < 0 && res != -ECANCELED) {
+			p.sendError(connection_failed());
+		} else {
+			// Errors and hangups are reported by the next write()
+			p.send(Void());
+		}
+	}
+
+	void armRecv() {
+		if (fd < 0 || recvOp != nullptr || readError.present()) {
+			return;
+		}
+		if ((int)received.size() >= reactor->maxBuffersPerConnection) {
+			// read() re-arms once the reader has returned half of them
+			if (!recvCapped) {
+				++reactor->countRecvCapped;
+				recvCapped = true;
+			}
+			return;
+		}
+		recvOp = new IOUringOp(IOUringOp::Recv, this);
+		io_uring_sqe* sqe = reactor->getSqe();
+		if (reactor->multishot) {
+			io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, 0);
+		} else {
+			io_uring_prep_recv(sqe, fd, nullptr, reactor->bufSize, 0);
+		}
+		sqe->flags |= IOSQE_BUFFER_SELECT;
+		sqe->buf_group = IOUringReactor::Impl::bufferGroup;
+		io_uring_sqe_set_data(sqe, recvOp);
+	}
+
+	IOUringOp* recvOp = nullptr;
+	IOUringOp* pollOutOp = nullptr;
+
+private:
+	struct Chunk {
+		uint16_t bid;
+		int offset;
+		int length;
+	};
+
+	IOUringReactor::Impl* reactor;
+	int fd;
+	bool isV6;
+	UID id;
+	NetworkAddress peer_address;
+	boost::asio::ip::tcp::socket socket; // Only opened by getSocket()
+
+	std::deque<Chunk> received;
+	Optional<int> readError; // An errno, or 0 for end of stream
+	Promise<Void> readable;
+	bool readWaiting = false;
+	bool recvStopping = false; // A cancel has been requested for recvOp, which still delivers what it received
+	bool recvCapped = false; // No receive is armed because the connection holds its share of the buffers
+	Promise<Void> writable;
+
+	void wakeReader() {
+		if (readWaiting) {
+			readWaiting = false;
+			Promise<Void> p = readable;
+			readable = Promise<Void>();
+			p.send(Void());
+		}
+	}
+
+	// Asks the kernel to end a multishot receive without detaching it from the connection, so data in completions
+	// already posted is still delivered. Until that happens the receive can take more buffers, up to what the
+	// socket has buffered.
+	void stopRecv() {
+		if (recvOp == nullptr || recvStopping || !reactor->multishot) {
+			return;
+		}
+		recvStopping = true;
+		io_uring_sqe* sqe = reactor->getSqe();
+		io_uring_prep_cancel(sqe, recvOp, 0);
+		io_uring_sqe_set_data(sqe, new IOUringOp(IOUringOp::Cancel, nullptr));
+	}
+
+	void cancel(IOUringOp*& op) {
+		if (op == nullptr) {
+			return;
+		}
+		op->conn = nullptr;
+		io_uring_sqe* sqe = reactor->getSqe();
+		io_uring_prep_cancel(sqe, op, 0);
+		io_uring_sqe_set_data(sqe, new IOUringOp(IOUringOp::Cancel, nullptr));
+		op = nullptr;
+	}
+
+	void dropReceived() {
+		for (auto& c : received) {
+			reactor->returnBuffer(c.bid);
+		}
+		received.clear();
+	}
+
+	void removeStarved() {
+		auto& s = reactor->starved;
+		s.erase(std::remove(s.begin(), s.end(), this), s.end());
+	}
+
+	void closeSocket() {
+		if (fd < 0) {
+			return;
+		}
+		cancel(recvOp);
+		cancel(pollOutOp);
+		// A queued request names the descriptor and only takes its own reference to the file when submitted. Submit
+		// them, with their cancellations, before closing, or one could arm against a new socket given the same number.
+		reactor->submitQueued();
+		dropReceived();
+		removeStarved();
+		::close(fd);
+		fd = -1;
+		if (!readError.present()) {
+			readError = ECANCELED;
+		}
+		wakeReader();
+		if (writable.canBeSet()) {
+			Promise<Void> p = writable;
+			writable = Promise<Void>();
+			p.sendError(connection_failed());
+		}
+	}
+
+	void onReadError(int err) {
+		TraceEvent(SevWarn, "N2_ReadError", id)
+		    .suppressFor(1.0)
+		    .detail("PeerAddr", peer_address)
+		    .detail("PeerAddress", peer_address)
+		    .detail("ErrorCode", err)
+		    .detail("Message", err ? strerror(err) : "End of file");
+		closeSocket();
+	}
+
+	void onWriteError(int err) {
+		TraceEvent(SevWarn, "N2_WriteError", id)
+		    .suppressFor(1.0)
+		    .detail("PeerAddr", peer_address)
+		    .detail("PeerAddress", peer_address)
+		    .detail("ErrorCode", err)
+		    .detail("Message", strerror(err));
+		closeSocket();
+	}
+};
+
+IOUringReactor::Impl::Impl(boost::asio::io_service& ios)
+  : ios(ios), bufCount(FLOW_KNOBS->NETWORK_IO_URING_RECV_BUFFERS),
+    bufSize(FLOW_KNOBS->NETWORK_IO_URING_RECV_BUFFER_SIZE),
+    maxBuffersPerConnection(std::max(1, FLOW_KNOBS->NETWORK_IO_URING_RECV_BUFFERS_PER_CONNECTION)), evsd(ios) {
+	ASSERT(bufCount > 0 && (bufCount & (bufCount - 1)) == 0 && bufCount <= 32768);
+
+	// Multishot receives can post many completions per request, so the completion queue is made larger than usual
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = 4 * FLOW_KNOBS->NETWORK_IO_URING_QUEUE_DEPTH;
+	int rc = io_uring_queue_init_params(FLOW_KNOBS->NETWORK_IO_URING_QUEUE_DEPTH, &ring, &params);
+	if (rc < 0) {
+		TraceEvent(SevWarnAlways, "N2_IOUringSetupError").detail("Error", strerror(-rc));
+		throw platform_error();
+	}
+
+	bufRing = io_uring_setup_buf_ring(&ring, bufCount, bufferGroup, 0, &rc);
+	if (bufRing == nullptr) {
+		TraceEvent(SevWarnAlways, "N2_IOUringBufRingError").detail("Error", strerror(-rc));
+		io_uring_queue_exit(&ring);
+		throw platform_error();
+	}
+	bufMemory = (uint8_t*)allocate(size_t(bufCount) * bufSize, /*allowLargePages*/ true, /*includeGuardPages*/ false);
+	for (int i = 0; i < bufCount; ++i) {
+		returnBuffer(i);
+	}
+	io_uring_buf_ring_advance(bufRing, buffersToPublish);
+	buffersToPublish = 0;
+
+	evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (evfd < 0 || io_uring_register_eventfd(&ring, evfd) < 0) {
+		TraceEvent(SevWarnAlways, "N2_IOUringEventFDError").GetLastError();
+		io_uring_free_buf_ring(&ring, bufRing, bufCount, bufferGroup);
+		io_uring_queue_exit(&ring);
+		throw platform_error();
+	}
+	evsd.assign(evfd);
+	armEventFD();
+
+	countSubmit.init("Net2.IOUringSubmit"_sr);
+	countCompletions.init("Net2.IOUringCompletions"_sr);
+	countReads.init("Net2.IOUringReads"_sr);
+	countWrites.init("Net2.IOUringWrites"_sr);
+	countWouldBlock.init("Net2.IOUringWouldBlock"_sr);
+	countRecvBufferStarved.init("Net2.IOUringRecvBufferStarved"_sr);
+	countRecvCapped.init("Net2.IOUringRecvCapped"_sr);
+	bytesReceived.init("Net2.IOUringBytesReceived"_sr);
+
+	TraceEvent("N2_IOUringReactorStarted")
+	    .detail("QueueDepth", params.sq_entries)
+	    .detail("CompletionQueueDepth", params.cq_entries)
+	    .detail("RecvBuffers", bufCount)
+	    .detail("RecvBufferSize", bufSize)
+	    .detail("RecvBuffersPerConnection", maxBuffersPerConnection);
+}
+
+IOUringReactor::Impl::~Impl() {
+	boost::system::error_code ec;
+	evsd.close(ec);
+	io_uring_free_buf_ring(&ring, bufRing, bufCount, bufferGroup);
+	io_uring_queue_exit(&ring);
+}
+
+void IOUringReactor::Impl::armEventFD() {
+	evsd.async_read_some(boost::asio::mutable_buffers_1(&evVal, sizeof(evVal)),
+	                     [this](const boost::system::error_code& ec, std::size_t) {
+		                     if (ec)
+			                     return; // The reactor is being destroyed
+		                     reap();
+		                     armEventFD();
+	                     });
+}
+
+void IOUringReactor::Impl::submit() {
+	if (buffersToPublish) {
+		io_uring_buf_ring_advance(bufRing, buffersToPublish);
+		buffersToPublish = 0;
+
+		// Buffers are available again, so restart the receives that ran out
+		std::vector<IOUringConnection*> toRearm;
+		toRearm.swap(starved);
+		for (auto conn : toRearm) {
+			conn->armRecv();
+		}
+	}
+	submitQueued();
+}
+
+void IOUringReactor::Impl::reap() {
+	if (io_uring_cq_has_overflow(&ring)) {
+		io_uring_get_events(&ring);
+	}
+
+	// Completions are copied out before any are handled, because handling them runs actor code that may queue new
+	// requests or close connections.
+	struct Completion {
+		IOUringOp* op;
+		int res;
+		uint32_t flags;
+	};
+	std::vector<Completion> completions;
+	unsigned head;
+	io_uring_cqe* cqe;
+	io_uring_for_each_cqe(&ring, head, cqe) {
+		completions.push_back(Completion{ (IOUringOp*)io_uring_cqe_get_data(cqe), cqe->res, cqe->flags });
+	}
+	io_uring_cq_advance(&ring, completions.size());
+	countCompletions += completions.size();
+
+	for (auto const& c : completions) {
+		complete(c.op, c.res, c.flags);
+	}
+}
+
+void IOUringReactor::Impl::complete(IOUringOp* op, int res, uint32_t flags) {
+	IOUringConnection* conn = op->conn;
+	// Handling a completion can release the last other reference to the connection
+	Reference<IOUringConnection> hold;
+	if (conn) {
+		hold = Reference<IOUringConnection>::addRef(conn);
+	}
+
+	switch (op->kind) {
+	case IOUringOp::Cancel:
+		delete op;
+		return;
+
+	case IOUringOp::PollOut:
+		delete op;
+		if (conn) {
+			conn->onWritableCompleted(res);
+		}
+		return;
+
+	case IOUringOp::Recv: {
+		bool more = flags & IORING_CQE_F_MORE;
+		if (!more) {
+			if (conn && conn->recvOp == op) {
+				conn->onRecvEnded();
+			}
+			delete op;
+		}
+
+		if (res > 0) {
+			ASSERT(flags & IORING_CQE_F_BUFFER);
+			uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+			if (conn) {
+				conn->onReceived(bid, res);
+			} else {
+				returnBuffer(bid);
+			}
+		}
+		if (!conn) {
+			return;
+		}
+
+		if (res == 0) {
+			conn->onRecvError(0);
+		} else if (res == -ENOBUFS) {
+			++countRecvBufferStarved;
+			if (!more) {
+				starved.push_back(conn);
+			}
+		} else if (res == -EINVAL && multishot && !more) {
+			TraceEvent(SevWarnAlways, "N2_IOUringMultishotRecvUnsupported").log();
+			multishot = false;
+			conn->armRecv();
+		} else if (res < 0 && res != -ECANCELED) {
+			conn->onRecvError(-res);
+		} else if (!more) {
+			conn->armRecv();
+		}
+		return;
+	}
+	}
+}
+
+IOUringReactor::IOUringReactor(boost::asio::io_service& ios) : impl(new Impl(ios)) {}
+
+IOUringReactor::~IOUringReactor() = default;
+
+Reference<IConnection> IOUringReactor::adopt(boost::asio::ip::tcp::socket&& socket, NetworkAddress peerAddress) {
+	bool isV6 = socket.local_endpoint().address().is_v6();
+	int fd = socket.release();
+	return Reference<IConnection>(new IOUringConnection(impl.get(), impl->ios, fd, isV6, peerAddress));
+}
+
+void IOUringReactor::submit() {
+	impl->submit();
+}
+
+} // namespace N2
+
+namespace {
+
+struct TestSendBuffer : SendBuffer {
+	TestSendBuffer(uint8_t* data, int size) {
+		_data = data;
+		next = nullptr;
+		bytes_written = size;
+		bytes_sent = 0;
+	}
+};
+
+uint8_t testByte(int64_t offset) {
+	return uint8_t((offset * 2654435761u) >> 24);
+}
+
+} // namespace
+
+// Runs a reactor on its own io_service, outside of Net2. A receiver that does not read must stop taking buffers at
+// its cap while the sender fills the socket, and once it reads, every byte must arrive intact and in order.
+TEST_CASE("noSim/flow/IOUringReactor/RecvBufferCap") {
+	using namespace N2;
+	boost::asio::io_service ios;
+	std::unique_ptr<IOUringReactor> reactor;
+	try {
+		reactor = std::make_unique<IOUringReactor>(ios);
+	} catch (Error& e) {
+		// The kernel lacks io_uring or provided buffer rings
+		TraceEvent(SevWarnAlways, "IOUringReactorTestSkipped").error(e);
+		return Void();
+	}
+
+	boost::asio::ip::tcp::acceptor acceptor(
+	    ios, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+	boost::asio::ip::tcp::socket clientSocket(ios);
+	boost::asio::ip::tcp::socket serverSocket(ios);
+	clientSocket.connect(acceptor.local_endpoint());
+	acceptor.accept(serverSocket);
+	NetworkAddress address = NetworkAddress::parse("127.0.0.1:" + std::to_string(acceptor.local_endpoint().port()));
+	Reference<IConnection> sender = reactor->adopt(std::move(clientSocket), address);
+	Reference<IConnection> receiver = reactor->adopt(std::move(serverSocket), address);
+	IOUringConnection* conn = static_cast<IOUringConnection*>(receiver.getPtr());
+
+	// Submits queued requests and handles any completions the eventfd has signalled
+	auto pump = [&]() {
+		for (int i = 0; i < 4; i++) {
+			reactor->submit();
+			ios.poll();
+			ios.restart();
+			threadSleep(0.0001);
+		}
+	};
+
+	const int cap = std::max(1, FLOW_KNOBS->NETWORK_IO_URING_RECV_BUFFERS_PER_CONNECTION);
+	std::vector<uint8_t> chunk(65536);
+	int64_t sent = 0;
+	int idle = 0;
+	while (idle < 100) {
+		for (int i = 0; i < chunk.size(); i++) {
+			chunk[i] = testByte(sent + i);
+		}
+		TestSendBuffer buffer(chunk.data(), chunk.size());
+		int n = sender->write(&buffer, chunk.size());
+		sent += n;
+		idle = n ? 0 : idle + 1;
+		pump();
+	}
+	// The sender only stalls once the receiver stops receiving, which it does at its cap
+	const int held = conn->buffersHeld();
+	ASSERT(held >= cap);
+	for (int i = 0; i < 100; i++) {
+		pump();
+	}
+	ASSERT_EQ(conn->buffersHeld(), held);
+
+	// Reading returns buffers and receives resume until everything sent has been read
+	int64_t received = 0;
+	idle = 0;
+	while (received < sent && idle < 10000) {
+		int n = receiver->read(chunk.data(), chunk.data() + chunk.size());
+		for (int i = 0; i < n; i++) {
+			ASSERT(chunk[i] == testByte(received + i));
+		}
+		received += n;
+		idle = n ? 0 : idle + 1;
+		pump();
+	}
+	ASSERT_EQ(received, sent);
+
+	// Let the cancellations complete so their requests are freed
+	sender->close();
+	receiver->close();
+	pump();
+	return Void();
+}
+
+#endif
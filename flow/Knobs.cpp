@@ -73,6 +73,11 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 
 	init( FAST_ALLOC_LOGGING_BYTES,                           10e6 );
 	init( FAST_ALLOC_ALLOW_GUARD_PAGES,                      false );
+	init( FAST_ALLOC_TRIM_INTERVAL,                            0.0 ); if( randomize && BUGGIFY ) FAST_ALLOC_TRIM_INTERVAL = 1.0; // 0 disables returning unused FastAllocator memory to the OS
+	init( FAST_ALLOC_TRIM_KEEP_BYTES,                         64e6 ); if( randomize && BUGGIFY ) FAST_ALLOC_TRIM_KEEP_BYTES = 0;
+	init( FAST_ALLOC_TRIM_BATCH_BYTES,                        16e6 ); if( randomize && BUGGIFY ) FAST_ALLOC_TRIM_BATCH_BYTES = 1e6;
+	init( HUGE_PAGES,                                            0 ); if( randomize && BUGGIFY ) HUGE_PAGES = 1; // 0: off, 1: transparent huge pages, 2: explicit huge pages, falling back to transparent ones
+	init( HUGE_PAGE_ARENA_BLOCK_BYTES,                     2 << 20 ); if( randomize && BUGGIFY ) HUGE_PAGE_ARENA_BLOCK_BYTES = 4 << 20;
 	init( HUGE_ARENA_LOGGING_BYTES,                          100e6 );
 	init( HUGE_ARENA_LOGGING_INTERVAL,                         5.0 );
 	init( ABORT_ON_FAILURE,                                  false );
@@ -186,6 +191,13 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 	init( PAGE_WRITE_CHECKSUM_HISTORY,                           0 ); if( randomize && BUGGIFY ) PAGE_WRITE_CHECKSUM_HISTORY = 10000000;
 	init( DISABLE_POSIX_KERNEL_AIO,                              0 );
 
+	//AsyncFileIOUring
+	init( USE_IO_URING_FOR_FILES,                            false );
+	init( IO_URING_QUEUE_DEPTH,                                256 );
+	init( IO_URING_FIXED_FILES,                                256 );
+	init( IO_URING_SQPOLL,                                   false );
+	init( IO_URING_SQPOLL_IDLE_MS,                            2000 );
+
 	//AsyncFileNonDurable
 	init( NON_DURABLE_MAX_WRITE_DELAY,                         2.0 ); if( randomize && BUGGIFY ) NON_DURABLE_MAX_WRITE_DELAY = 5.0;
 	init( MAX_PRIOR_MODIFICATION_DELAY,                        1.0 ); if( randomize && BUGGIFY ) MAX_PRIOR_MODIFICATION_DELAY = 10.0;
@@ -220,14 +232,21 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 	init( CERT_FILE_MAX_SIZE,                      5 * 1024 * 1024 );
 	init( READY_QUEUE_RESERVED_SIZE,                          8192 );
 	init( TASKS_PER_REACTOR_CHECK,                             100 );
+	init( NETWORK_IO_URING,                                  false );
+	init( NETWORK_IO_URING_QUEUE_DEPTH,                       4096 );
+	init( NETWORK_IO_URING_RECV_BUFFERS,                      4096 ); // Must be a power of 2
+	init( NETWORK_IO_URING_RECV_BUFFER_SIZE,                 16384 );
+	init( NETWORK_IO_URING_RECV_BUFFERS_PER_CONNECTION,         64 ); if( randomize && BUGGIFY ) NETWORK_IO_URING_RECV_BUFFERS_PER_CONNECTION = 2;
 
 	//Network
 	init( PACKET_LIMIT,                                  100LL<<20 );
 	init( PACKET_WARNING,                                  2LL<<20 );  // 2MB packet warning quietly allows for 1MB system messages
 	init( TIME_OFFSET_LOGGING_INTERVAL,                       60.0 );
 	init( MAX_PACKET_SEND_BYTES,                        128 * 1024 );
+	init( NETWORK_SEND_BURST_BYTES,                              0 ); if( randomize && BUGGIFY ) NETWORK_SEND_BURST_BYTES = 4 << 20; // 0 writes at most MAX_PACKET_SEND_BYTES per call through asio
 	init( MIN_PACKET_BUFFER_BYTES,                        4 * 1024 );
 	init( MIN_PACKET_BUFFER_FREE_BYTES,                        256 );
+	init( PACKET_CHECKSUM_CRC32C,                            false ); if( randomize && BUGGIFY ) PACKET_CHECKSUM_CRC32C = true; // Checksum packets to non-TLS peers with CRC32C rather than XXH3 when they can verify it
 	init( FLOW_TCP_NODELAY,                                      1 );
 	init( FLOW_TCP_QUICKACK,                                     0 );
 	init( RESOLVE_PREFER_IPV4_ADDR,                          false );  // Default to prefer IPv6 addresses. Set to true to prefer IPv4 addresses.
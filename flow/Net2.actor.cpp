@@ -53,6 +53,7 @@
 #include "flow/ChaosMetrics.h"
 #include "flow/TDMetric.actor.h"
 #include "flow/AsioReactor.h"
+#include "flow/IOUringReactor.h"
 #include "flow/Profiler.h"
 #include "flow/ProtocolVersion.h"
 #include "flow/SendBufferIterator.h"
@@ -71,6 +72,10 @@
 
 #ifdef WIN32
 #include <mmsystem.h>
+#else
+#include <climits>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -226,6 +231,12 @@ public:
 	// private:
 
 	ASIOReactor reactor;
+#ifdef WITH_LIBURING
+	// Created when the first plain TCP connection or listener is made with NETWORK_IO_URING set
+	std::unique_ptr<IOUringReactor> ioUringReactor;
+	bool ioUringUnavailable = false;
+	IOUringReactor* getIOUringReactor();
+#endif
 	AsyncVar<Reference<ReferencedObject<boost::asio::ssl::context>>> sslContextVar;
 	Reference<IThreadPool> sslHandshakerPool;
 	int sslHandshakerThreadsStarted;
@@ -260,7 +271,7 @@ public:
 
 	NetworkMetrics::PriorityStats* lastPriorityStats;
 
-	struct PromiseTask final : public FastAllocated<PromiseTask> {
+	struct PromiseTask final : public ThreadReadyTask, FastAllocated<PromiseTask> {
 		Promise<Void> promise;
 		swift::Job* _Nullable swiftJob = nullptr;
 		PromiseTask() {}
@@ -493,6 +504,12 @@ public:
 		boost::system::error_code err;
 		++g_net2->countWrites;
 
+#ifndef _WIN32
+		if (FLOW_KNOBS->NETWORK_SEND_BURST_BYTES > 0) {
+			return writeVectored(data, limit);
+		}
+#endif
+
 		size_t sent = socket.write_some(
 		    boost::iterator_range<SendBufferIterator>(SendBufferIterator(data, limit), SendBufferIterator()), err);
 
@@ -580,6 +597,51 @@ private:
 		    .detail("Message", error.message());
 		closeSocket();
 	}
+
+#ifndef _WIN32
+	// asio gathers at most 64 buffers into one sendmsg, which is 256KB of minimum sized packet buffers, so a burst
+	// larger than that goes straight to sendmsg with up to IOV_MAX buffers instead
+	static constexpr int maxSendBuffers = IOV_MAX < 1024 ? IOV_MAX : 1024;
+
+	int writeVectored(SendBuffer const* data, int limit) {
+		ASSERT(limit > 0);
+		iovec iov[maxSendBuffers];
+		int iovCount = 0;
+		for (auto p = data; p && limit > 0 && iovCount < maxSendBuffers; p = p->next) {
+			int len = std::min(limit, p->bytes_unsent());
+			if (len > 0) {
+				iov[iovCount].iov_base = (void*)(p->data() + p->bytes_sent);
+				iov[iovCount].iov_len = len;
+				++iovCount;
+				limit -= len;
+			}
+		}
+		ASSERT(iovCount > 0);
+
+		msghdr msg = {};
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovCount;
+		int flags = 0;
+#ifdef MSG_NOSIGNAL
+		flags |= MSG_NOSIGNAL;
+#endif
+		ssize_t sent;
+		do {
+			sent = ::sendmsg(socket.native_handle(), &msg, flags);
+		} while (sent < 0 && errno == EINTR);
+
+		if (sent < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				++g_net2->countWouldBlock;
+				return 0;
+			}
+			onWriteError(boost::system::error_code(errno, boost::system::system_category()));
+			throw connection_failed();
+		}
+		ASSERT(sent > 0);
+		return sent;
+	}
+#endif
 };
 
 class ReadPromise {
@@ -799,6 +861,11 @@ private:
 			                                                    : IPAddress(peer_endpoint.address().to_v4().to_ulong());
 			conn->accept(NetworkAddress(peer_address, peer_endpoint.port()));
 
+#ifdef WITH_LIBURING
+			if (FLOW_KNOBS->NETWORK_IO_URING && g_net2->getIOUringReactor()) {
+				return g_net2->ioUringReactor->adopt(std::move(conn->getSocket()), conn->getPeerAddress());
+			}
+#endif
 			return conn;
 		} catch (...) {
 			conn->close();
@@ -1836,6 +1903,26 @@ THREAD_HANDLE Net2::startThread(THREAD_FUNC_RETURN (*func)(void*), void* arg, in
 	return ::startThread(func, arg, stackSize, name);
 }
 
+#ifdef WITH_LIBURING
+IOUringReactor* Net2::getIOUringReactor() {
+	if (!ioUringReactor && !ioUringUnavailable) {
+		try {
+			ioUringReactor = std::make_unique<IOUringReactor>(reactor.ios);
+		} catch (Error& e) {
+			TraceEvent(SevWarnAlways, "N2_IOUringReactorUnavailable").error(e);
+			ioUringUnavailable = true;
+		}
+	}
+	return ioUringReactor.get();
+}
+
+// Connects with asio, then moves the socket to the io_uring reactor
+ACTOR static Future<Reference<IConnection>> connectIOUring(Net2* self, NetworkAddress toAddr) {
+	Reference<IConnection> conn = wait(Connection::connect(&self->reactor.ios, toAddr));
+	return self->ioUringReactor->adopt(std::move(conn->getSocket()), toAddr);
+}
+#endif
+
 Future<Reference<IConnection>> Net2::connect(NetworkAddress toAddr, tcp::socket* existingSocket) {
 	if (toAddr.isTLS()) {
 		initTLS(ETLSInitState::CONNECT);
@@ -1847,6 +1934,11 @@ Future<Reference<IConnection>> Net2::connect(NetworkAddress toAddr, tcp::socket*
 		throw connection_failed();
 	}
 
+#ifdef WITH_LIBURING
+	if (FLOW_KNOBS->NETWORK_IO_URING && getIOUringReactor()) {
+		return connectIOUring(this, toAddr);
+	}
+#endif
 	return Connection::connect(&this->reactor.ios, toAddr);
 }
 
@@ -2059,6 +2151,11 @@ ASIOReactor::ASIOReactor(Net2* net) : do_not_stop(ios), network(net), firstTimer
 }
 
 void ASIOReactor::sleep(double sleepTime) {
+#ifdef WITH_LIBURING
+	// Requests queued by this run loop iteration must reach the kernel before we wait for their completions
+	if (network->ioUringReactor)
+		network->ioUringReactor->submit();
+#endif
 	if (sleepTime > FLOW_KNOBS->BUSY_WAIT_THRESHOLD) {
 		if (FLOW_KNOBS->REACTOR_FLAGS & 4) {
 #ifdef __linux
@@ -2086,6 +2183,10 @@ void ASIOReactor::sleep(double sleepTime) {
 }
 
 void ASIOReactor::react() {
+#ifdef WITH_LIBURING
+	if (network->ioUringReactor)
+		network->ioUringReactor->submit();
+#endif
 	while (ios.poll_one())
 		++network->countASIOEvents; // Make this a task?
 }
@@ -2177,6 +2278,28 @@ TEST_CASE("flow/Net2/ThreadSafeQueue/Interface") {
 	return Void();
 }
 
+TEST_CASE("flow/Net2/IntrusiveThreadSafeQueue/Interface") {
+	struct Element : ThreadSafeQueueNode {
+		int value;
+		explicit Element(int value) : value(value) {}
+	};
+	Element one(1), two(2);
+	IntrusiveThreadSafeQueue<Element> tq;
+	ASSERT(tq.pop() == nullptr);
+	ASSERT(tq.canSleep());
+
+	ASSERT(tq.push(&one) == true);
+	ASSERT(tq.push(&two) == false);
+	ASSERT(tq.pop() == &one);
+	// An element can be pushed again once it has been popped
+	ASSERT(tq.push(&one) == false);
+	ASSERT(tq.pop() == &two);
+	ASSERT(tq.pop() == &one);
+	ASSERT(tq.pop() == nullptr);
+	ASSERT(tq.canSleep());
+	return Void();
+}
+
 // A helper struct used by queueing tests which use multiple threads.
 struct QueueTestThreadState {
 	QueueTestThreadState(int threadId, int toProduce) : threadId(threadId), toProduce(toProduce) {}
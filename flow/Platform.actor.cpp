@@ -126,6 +126,8 @@ static_assert(std::is_same<boost::asio::ip::address_v6::bytes_type, std::array<u
 #include <signal.h>
 /* Needed for gnu_dev_{major,minor} */
 #include <sys/sysmacros.h>
+/* Needed for getDataTLBMisses */
+#include <linux/perf_event.h>
 #endif // __linux__
 
 #ifdef __FreeBSD__
@@ -295,6 +297,52 @@ double getProcessorTimeProcess() {
 #endif
 }
 
+int64_t getHugePageResidentMemoryUsage() {
+#if defined(__linux__)
+	std::ifstream smaps("/proc/self/smaps_rollup", std::ifstream::in);
+	if (!smaps.good()) {
+		return -1;
+	}
+
+	int64_t hugePageKB = 0;
+	std::string line;
+	while (std::getline(smaps, line)) {
+		// Transparent huge pages are reported as AnonHugePages, explicit ones as Shared_ or Private_Hugetlb
+		if (line.starts_with("AnonHugePages:") || line.starts_with("Shared_Hugetlb:") ||
+		    line.starts_with("Private_Hugetlb:")) {
+			hugePageKB += std::strtoll(line.c_str() + line.find(':') + 1, nullptr, 10);
+		}
+	}
+	return hugePageKB * 1024;
+#else
+	return -1;
+#endif
+}
+
+int64_t getDataTLBMisses() {
+#if defined(__linux__)
+	static thread_local int fd = [] {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// Fails without a PMU or when perf_event_paranoid forbids it, as in many containers
+		return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}();
+	int64_t misses;
+	if (fd < 0 || read(fd, &misses, sizeof(misses)) != sizeof(misses)) {
+		return -1;
+	}
+	return misses;
+#else
+	return -1;
+#endif
+}
+
 uint64_t getResidentMemoryUsage() {
 #if defined(__linux__)
 	uint64_t rssize = 0;
@@ -2181,6 +2229,42 @@ static void* allocateInternal(size_t length, bool largePages, bool guardPages) {
 #endif
 }
 
+void* allocateHugePages(size_t length, bool allowExplicit) {
+	ASSERT(length % kHugePageBytes == 0);
+#if defined(__linux__)
+	if (allowExplicit) {
+		void* block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (block != MAP_FAILED) {
+			return block;
+		}
+	}
+
+	// Map an extra huge page so that an aligned region can be cut out of the mapping, since the kernel only backs
+	// aligned regions with transparent huge pages
+	size_t mapped = length + kHugePageBytes;
+	uint8_t* block = (uint8_t*)mmapSafe(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	uint8_t* aligned = (uint8_t*)(((uintptr_t)block + kHugePageBytes - 1) & ~(uintptr_t)(kHugePageBytes - 1));
+	if (aligned > block) {
+		munmap(block, aligned - block);
+	}
+	if (aligned + length < block + mapped) {
+		munmap(aligned + length, block + mapped - (aligned + length));
+	}
+	madvise(aligned, length, MADV_HUGEPAGE);
+	return aligned;
+#else
+	return nullptr;
+#endif
+}
+
+void freeHugePages(void* p, size_t length) {
+#if defined(__linux__)
+	munmap(p, length);
+#else
+	UNREACHABLE();
+#endif
+}
+
 static bool largeBlockFail = false;
 void* allocate(size_t length, bool allowLargePages, bool includeGuardPages) {
 	if (allowLargePages)
@@ -4095,6 +4179,21 @@ void stopRunLoopProfiler() {
 #endif
 }
 
+#ifdef __linux__
+TEST_CASE("/flow/Platform/allocateHugePages") {
+	for (bool allowExplicit : { false, true }) {
+		size_t length = deterministicRandom()->randomInt(1, 4) * kHugePageBytes;
+		uint8_t* p = (uint8_t*)allocateHugePages(length, allowExplicit);
+		ASSERT(p != nullptr);
+		ASSERT((uintptr_t)p % kHugePageBytes == 0);
+		memset(p, 0x5a, length);
+		ASSERT(p[0] == 0x5a && p[length - 1] == 0x5a);
+		freeHugePages(p, length);
+	}
+	return Void();
+}
+#endif
+
 // UnitTest for getMemoryInfo
 #ifdef __linux__
 TEST_CASE("/flow/Platform/getMemoryInfo") {
@@ -108,8 +108,10 @@ SystemStatistics customSystemMonitor(std::string const& eventName, StatisticsSta
 	    machineState.folder.present() ? machineState.folder.get() : "", &ipAddr, &statState->systemState, true);
 	NetworkData netData;
 	netData.init();
+	int64_t dataTLBMisses = -1;
 	if (!g_network->isSimulated() && currentStats.initialized) {
 		{
+			dataTLBMisses = getDataTLBMisses();
 			TraceEvent(eventName.c_str())
 			    .detail("Elapsed", currentStats.elapsed)
 			    .detail("CPUSeconds", currentStats.processCPUSeconds)
@@ -198,6 +200,11 @@ SystemStatistics customSystemMonitor(std::string const& eventName, StatisticsSta
 			    .DETAILALLOCATORMEMUSAGE(8192)
 			    .DETAILALLOCATORMEMUSAGE(16384)
 			    .detail("HugeArenaMemory", g_hugeArenaMemory.load())
+			    .detail("HugePageMemory", g_hugePageMemory.load())
+			    .detail("HugePageResidentMemory", getHugePageResidentMemoryUsage())
+			    .detail("MainThreadDataTLBMisses",
+			            dataTLBMisses >= 0 && statState->dataTLBMisses >= 0 ? dataTLBMisses - statState->dataTLBMisses
+			                                                                 : -1)
 			    .detail("DCID", machineState.dcId)
 			    .detail("ZoneID", machineState.zoneId)
 			    .detail("MachineID", machineState.machineId);
@@ -234,6 +241,7 @@ SystemStatistics customSystemMonitor(std::string const& eventName, StatisticsSta
 				TraceEvent("FastAllocMemoryUsage")
 				    .detail("TotalMemory", total_memory)
 				    .detail("UnusedMemory", unused_memory)
+				    .detail("ReturnedMemory", getTotalReturnedAllocatedMemory())
 				    .detail("Utilization", format("%f%%", (total_memory - unused_memory) * 100.0 / total_memory));
 			}
 
@@ -455,6 +463,7 @@ SystemStatistics customSystemMonitor(std::string const& eventName, StatisticsSta
 #endif
 	statState->networkMetricsState = g_network->networkInfo.metrics;
 	statState->networkState = netData;
+	statState->dataTLBMisses = dataTLBMisses;
 	return currentStats;
 }
 
@@ -472,3 +481,24 @@ Future<Void> startMemoryUsageMonitor(uint64_t memLimit) {
 	};
 	return recurring(checkMemoryUsage, FLOW_KNOBS->MEMORY_USAGE_CHECK_INTERVAL);
 }
+
+// Periodically returns FastAllocator memory that has gone unused, e.g. after a burst of allocations, to the OS
+Future<Void> startFastAllocatorTrimmer() {
+	if (FLOW_KNOBS->FAST_ALLOC_TRIM_INTERVAL <= 0) {
+		return Void();
+	}
+	auto trim = []() {
+		int64_t unused = getTotalUnusedAllocatedMemory();
+		double start = timer_monotonic();
+		int64_t returned =
+		    trimUnusedAllocatedMemory(FLOW_KNOBS->FAST_ALLOC_TRIM_KEEP_BYTES, FLOW_KNOBS->FAST_ALLOC_TRIM_BATCH_BYTES);
+		if (returned > 0) {
+			TraceEvent("FastAllocTrim")
+			    .detail("UnusedMemory", unused)
+			    .detail("Returned", returned)
+			    .detail("TotalReturned", getTotalReturnedAllocatedMemory())
+			    .detail("Elapsed", timer_monotonic() - start);
+		}
+	};
+	return recurring(trim, FLOW_KNOBS->FAST_ALLOC_TRIM_INTERVAL);
+}
@@ -31,4 +31,5 @@
 # cmakedefine DTRACE_PROBES
 # cmakedefine HAS_ALIGNED_ALLOC
 # cmakedefine USE_JEMALLOC
+# cmakedefine WITH_LIBURING
 #endif // WIN32
@@ -178,6 +178,7 @@ struct ArenaBlock : NonCopyable, ThreadSafeReferenceCounted<ArenaBlock> {
 	bool secure : 1; // If this is set, block is zero-ed out after use
 	uint8_t tinySize : 7, tinyUsed; // If these == NOT_TINY, use bigSize, bigUsed instead
 	// if tinySize != NOT_TINY, following variables aren't used
+	bool hugePages; // Allocated with allocateHugePages()
 	uint32_t bigSize, bigUsed; // include block header
 	uint32_t nextBlockOffset;
 	mutable size_t totalSizeEstimate; // Estimate of the minimum total size of arena blocks this one reaches
@@ -36,6 +36,9 @@ struct CompressionUtils {
 	static StringRef compress(const CompressionFilter filter, const StringRef& data, Arena& arena);
 	static StringRef compress(const CompressionFilter filter, const StringRef& data, int level, Arena& arena);
 	static StringRef decompress(const CompressionFilter filter, const StringRef& data, Arena& arena);
+	// Returns the size data decompresses to, read from its header without decompressing it, or an empty Optional if
+	// data is not a single frame which records its size
+	static Optional<int64_t> decompressedSize(const CompressionFilter filter, const StringRef& data);
 
 	static int getDefaultCompressionLevel(CompressionFilter filter);
 	static CompressionFilter getRandomFilter();
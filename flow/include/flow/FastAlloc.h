@@ -118,6 +118,11 @@ public:
 	static long long getTotalMemory();
 	static long long getApproximateMemoryUnused();
 	static long long getActiveThreads();
+	static long long getReturnedMemory();
+
+	// Returns the pages of free objects in the global pool to the OS until at most keepUnusedBytes remain unused,
+	// looking at no more than maxTrimBytes of them. Returns the bytes of objects whose pages were returned.
+	static long long trimUnused(long long keepUnusedBytes, long long maxTrimBytes);
 
 #ifdef ALLOC_INSTRUMENTATION
 	static volatile int32_t pageCount;
@@ -172,13 +177,19 @@ private:
 	static void* freelist;
 
 	static void getMagazine();
+	static void formatMagazine(void** block);
 	static void releaseMagazine(void*);
+	static long long trimObjects(std::vector<void*>& objects);
 };
 
 extern std::atomic<int64_t> g_hugeArenaMemory;
+extern std::atomic<int64_t> g_hugePageMemory; // Allocated with allocateHugePages() by FastAllocator and ArenaBlock
 void hugeArenaSample(int size);
 void releaseAllThreadMagazines();
 int64_t getTotalUnusedAllocatedMemory();
+int64_t getTotalReturnedAllocatedMemory();
+// Trims each FastAllocator size class with more than keepUnusedBytes unused, and returns the bytes returned to the OS
+int64_t trimUnusedAllocatedMemory(int64_t keepUnusedBytes, int64_t maxTrimBytes);
 
 // Allow temporary overriding of default allocators used by arena to let memory survive deallocation and test
 // correctness of memory policy (e.g. zeroing out sensitive contents after use)
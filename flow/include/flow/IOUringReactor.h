@@ -0,0 +1,71 @@
+/*
+ * IOUringReactor.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_IOURINGREACTOR_H
+#define FLOW_IOURINGREACTOR_H
+#pragma once
+
+#include "flow/config.h"
+#if defined(__linux__) && defined(WITH_LIBURING)
+
+#include <memory>
+#include <boost/asio.hpp>
+
+#include "flow/flow.h"
+#include "flow/IConnection.h"
+
+namespace N2 { // No indent, it's the whole file
+
+// Drives plain TCP connections through one io_uring instead of through boost::asio's epoll reactor.
+//
+// Connections are still established by asio; the connected socket is then handed to adopt(), which takes its
+// descriptor away from asio so epoll no longer watches it. From then on:
+//   - Each connection keeps one multishot receive armed. The kernel picks a buffer from a ring of provided buffers for
+//     each chunk it receives, and read() copies out of those buffers without a syscall.
+//   - A connection whose reader falls behind stops receiving once it holds NETWORK_IO_URING_RECV_BUFFERS_PER_CONNECTION
+//     buffers, leaving the rest of the shared ring to other connections, and receives again once read() has returned
+//     half of them.
+//   - onWritable() is a one-shot poll request on the ring. write() itself is still a nonblocking sendmsg(), because
+//     callers expect to learn how many bytes were taken before they release their buffers.
+//   - Requests are queued as submission entries and sent to the kernel together by submit(), which the run loop
+//     calls once per iteration and before it sleeps.
+//   - The ring signals an eventfd that asio watches, so completions wake the run loop like any other asio event.
+class IOUringReactor {
+public:
+	// Throws if the kernel lacks io_uring or provided buffer rings (Linux 5.19)
+	explicit IOUringReactor(boost::asio::io_service& ios);
+	~IOUringReactor();
+
+	// Takes over a connected socket
+	Reference<IConnection> adopt(boost::asio::ip::tcp::socket&& socket, NetworkAddress peerAddress);
+
+	// Submits every request queued since the last call with a single io_uring_enter()
+	void submit();
+
+	struct Impl;
+
+private:
+	std::unique_ptr<Impl> impl;
+};
+
+} // namespace N2
+
+#endif
+#endif
@@ -131,6 +131,11 @@ public:
 
 	double FAST_ALLOC_LOGGING_BYTES;
 	bool FAST_ALLOC_ALLOW_GUARD_PAGES;
+	double FAST_ALLOC_TRIM_INTERVAL;
+	int64_t FAST_ALLOC_TRIM_KEEP_BYTES; // Unused bytes each size class keeps for reuse rather than returning to the OS
+	int64_t FAST_ALLOC_TRIM_BATCH_BYTES; // Most unused bytes of a size class examined by each trim
+	int HUGE_PAGES; // Back FastAllocator magazines and arena blocks of HUGE_PAGE_ARENA_BLOCK_BYTES or more with huge pages
+	int HUGE_PAGE_ARENA_BLOCK_BYTES; // No less than a huge page, since blocks are rounded up to whole huge pages
 	double HUGE_ARENA_LOGGING_BYTES;
 	double HUGE_ARENA_LOGGING_INTERVAL;
 	// This setting allows to let the fdbserver abort instead of exit to generate coredumps
@@ -251,6 +256,13 @@ public:
 	int PAGE_WRITE_CHECKSUM_HISTORY;
 	int DISABLE_POSIX_KERNEL_AIO;
 
+	// AsyncFileIOUring
+	bool USE_IO_URING_FOR_FILES;
+	int IO_URING_QUEUE_DEPTH;
+	int IO_URING_FIXED_FILES;
+	bool IO_URING_SQPOLL;
+	int IO_URING_SQPOLL_IDLE_MS;
+
 	// AsyncFileNonDurable
 	double NON_DURABLE_MAX_WRITE_DELAY;
 	double MAX_PRIOR_MODIFICATION_DELAY;
@@ -286,14 +298,21 @@ public:
 	int CERT_FILE_MAX_SIZE;
 	int READY_QUEUE_RESERVED_SIZE;
 	int TASKS_PER_REACTOR_CHECK;
+	bool NETWORK_IO_URING;
+	int NETWORK_IO_URING_QUEUE_DEPTH;
+	int NETWORK_IO_URING_RECV_BUFFERS;
+	int NETWORK_IO_URING_RECV_BUFFER_SIZE;
+	int NETWORK_IO_URING_RECV_BUFFERS_PER_CONNECTION; // Receives stop while a connection holds this many unread buffers
 
 	// Network
 	int64_t PACKET_LIMIT;
 	int64_t PACKET_WARNING; // 2MB packet warning quietly allows for 1MB system messages
 	double TIME_OFFSET_LOGGING_INTERVAL;
 	int MAX_PACKET_SEND_BYTES;
+	int NETWORK_SEND_BURST_BYTES; // If positive, the bytes a peer writes per sendmsg of up to IOV_MAX packet buffers
 	int MIN_PACKET_BUFFER_BYTES;
 	int MIN_PACKET_BUFFER_FREE_BYTES;
+	bool PACKET_CHECKSUM_CRC32C;
 	int FLOW_TCP_NODELAY;
 	int FLOW_TCP_QUICKACK;
 	bool RESOLVE_PREFER_IPV4_ADDR;
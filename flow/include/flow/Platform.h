@@ -264,6 +264,12 @@ uint64_t getMemoryUsage();
 
 uint64_t getResidentMemoryUsage();
 
+// Resident memory backed by transparent or explicit huge pages, or -1 where that is not known
+int64_t getHugePageResidentMemoryUsage();
+
+// Data TLB read misses of the calling thread since it first called this, or -1 if they cannot be counted
+int64_t getDataTLBMisses();
+
 struct MachineRAMInfo {
 	int64_t total;
 	int64_t committed;
@@ -313,6 +319,14 @@ void setMemoryQuota(size_t limit);
 
 void* allocate(size_t length, bool allowLargePages, bool includeGuardPages);
 
+constexpr size_t kHugePageBytes = 2 << 20;
+
+// Allocates length bytes, a multiple of kHugePageBytes, aligned to kHugePageBytes. The memory is backed by explicit
+// huge pages if allowExplicit and any are reserved, and otherwise asks for transparent huge pages. Returns nullptr on
+// platforms without huge pages. Free with freeHugePages().
+void* allocateHugePages(size_t length, bool allowExplicit);
+void freeHugePages(void* p, size_t length);
+
 void setAffinity(int proc);
 
 void threadSleep(double seconds);
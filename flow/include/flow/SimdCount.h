@@ -0,0 +1,71 @@
+/*
+ * SimdCount.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_SIMD_COUNT_H
+#define FLOW_SIMD_COUNT_H
+#pragma once
+
+#include <cstdint>
+
+#include "flow/Platform.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+// Counts the N integers at p which are less than x, and those which are less than or equal to x. N must be even.
+// Searches over sorted arrays of key prefixes end here, so it compares two lanes at a time without branching.
+template <int N>
+force_inline void countLessAndLessOrEqual(const int64_t* p, int64_t x, int& less, int& lessOrEqual) {
+	static_assert(N % 2 == 0);
+#if defined(__SSE4_2__) || defined(__aarch64__)
+	const __m128i v = _mm_set1_epi64x(x);
+	__m128i below = _mm_setzero_si128();
+	__m128i above = _mm_setzero_si128();
+	for (int i = 0; i < N; i += 2) {
+		// Each lane of a comparison is -1 where it holds
+		const __m128i lanes = _mm_loadu_si128((const __m128i*)(p + i));
+		below = _mm_sub_epi64(below, _mm_cmpgt_epi64(v, lanes));
+		above = _mm_sub_epi64(above, _mm_cmpgt_epi64(lanes, v));
+	}
+	int64_t sums[4];
+	_mm_storeu_si128((__m128i*)sums, below);
+	_mm_storeu_si128((__m128i*)(sums + 2), above);
+	less = int(sums[0] + sums[1]);
+	lessOrEqual = N - int(sums[2] + sums[3]);
+#else
+	less = lessOrEqual = 0;
+	for (int i = 0; i < N; i++) {
+		less += p[i] < x;
+		lessOrEqual += p[i] <= x;
+	}
+#endif
+}
+
+// Returns how many of the N integers at p are less than x, or less than or equal to x if orEqual is true. The count
+// not asked for is dropped by the compiler.
+template <int N, bool orEqual>
+force_inline int countLess(const int64_t* p, int64_t x) {
+	int less, lessOrEqual;
+	countLessAndLessOrEqual<N>(p, x, less, lessOrEqual);
+	return orEqual ? lessOrEqual : less;
+}
+
+#endif /*FLOW_SIMD_COUNT_H*/
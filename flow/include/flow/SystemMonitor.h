@@ -144,8 +144,9 @@ struct StatisticsState {
 	SystemStatisticsState* systemState;
 	NetworkData networkState;
 	NetworkMetrics networkMetricsState;
+	int64_t dataTLBMisses;
 
-	StatisticsState() : systemState(nullptr) {}
+	StatisticsState() : systemState(nullptr), dataTLBMisses(-1) {}
 };
 
 void systemMonitor();
@@ -155,5 +156,6 @@ SystemStatistics customSystemMonitor(std::string const& eventName,
 SystemStatistics getSystemStatistics();
 
 Future<Void> startMemoryUsageMonitor(uint64_t memLimit);
+Future<Void> startFastAllocatorTrimmer();
 
 #endif /* FLOW_SYSTEM_MONITOR_H */
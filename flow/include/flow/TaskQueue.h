@@ -28,6 +28,12 @@
 #include "flow/network.h"
 #include "flow/ThreadSafeQueue.h"
 
+// Base of the tasks a TaskQueue runs. A task added from another thread is linked into the queue's intake through it,
+// rather than through a node allocated on that thread and freed on the main thread.
+struct ThreadReadyTask : ThreadSafeQueueNode {
+	TaskPriority threadReadyTaskID = TaskPriority::Min;
+};
+
 template <typename Task>
 // A queue of ordered tasks, both ready to execute, and delayed for later execution.
 // All functions must be called on the main thread, except for addReadyThreadSafe() which can be called from any thread.
@@ -48,7 +54,8 @@ public:
 			processThreadReady();
 			addReady(taskID, t);
 		} else {
-			if (threadReady.push(std::make_pair(taskID, t)))
+			t->threadReadyTaskID = taskID;
+			if (threadReady.push(t))
 				return true;
 		}
 		return false;
@@ -87,12 +94,8 @@ public:
 	// Moves all tasks scheduled from a different thread to the ready queue.
 	void processThreadReady() {
 		[[maybe_unused]] int numReady = 0;
-		while (true) {
-			Optional<std::pair<TaskPriority, Task*>> t = threadReady.pop();
-			if (!t.present())
-				break;
-			ASSERT(t.get().second != nullptr);
-			addReady(t.get().first, t.get().second);
+		while (Task* t = threadReady.pop()) {
+			addReady(t->threadReadyTaskID, t);
 			++numReady;
 		}
 		FDB_TRACE_PROBE(run_loop_thread_ready, numReady);
@@ -149,7 +152,7 @@ private:
 	uint64_t tasksIssued;
 
 	ReadyQueue<OrderedTask> ready;
-	ThreadSafeQueue<std::pair<TaskPriority, Task*>> threadReady;
+	IntrusiveThreadSafeQueue<Task> threadReady;
 
 	std::priority_queue<DelayedTask, std::vector<DelayedTask>> timers;
 
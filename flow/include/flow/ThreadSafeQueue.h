@@ -44,18 +44,19 @@ interpreted as representing official policies, either expressed or implied, of D
 #include <drd.h>
 #endif
 
+// Link embedded in each element of an IntrusiveThreadSafeQueue
+struct ThreadSafeQueueNode {
+	std::atomic<ThreadSafeQueueNode*> next;
+	ThreadSafeQueueNode() : next(nullptr) {}
+};
+
+// The queue behind ThreadSafeQueue<T>, over elements which derive from ThreadSafeQueueNode and so are linked in place
+// rather than copied into a node allocated for them. push() therefore never allocates, and an element must not be
+// pushed again until it has been popped.
 template <class T>
-class ThreadSafeQueue : NonCopyable {
-	struct BaseNode {
-		std::atomic<BaseNode*> next;
-		BaseNode() : next(nullptr) {}
-	};
+class IntrusiveThreadSafeQueue : NonCopyable {
+	using BaseNode = ThreadSafeQueueNode;
 
-	struct Node : BaseNode, FastAllocated<Node> {
-		T data;
-		Node(T const& data) : data(data) {}
-		Node(T&& data) : data(std::move(data)) {}
-	};
 	std::atomic<BaseNode*> head;
 	BaseNode* tail;
 	BaseNode stub, sleeping;
@@ -120,7 +121,7 @@ class ThreadSafeQueue : NonCopyable {
 	}
 
 public:
-	ThreadSafeQueue() {
+	IntrusiveThreadSafeQueue() {
 #if VALGRIND
 		ANNOTATE_HAPPENS_AFTER(&this->head);
 #endif
@@ -128,15 +129,11 @@ public:
 		this->tail = &this->stub;
 		this->sleepy = false;
 	}
-	~ThreadSafeQueue() {
-		while (pop().present())
-			;
-	}
 
 	// If push() returns true, the consumer may be sleeping and should be woken
-	template <class U>
-	bool push(U&& data) {
-		Node* n = new Node(std::forward<U>(data));
+	bool push(T* t) {
+		BaseNode* n = t;
+		n->next.store(nullptr, std::memory_order_relaxed);
 		return pushNode(n) == &sleeping;
 	}
 
@@ -166,7 +163,8 @@ public:
 		return ok;
 	}
 
-	Optional<T> pop() {
+	// Returns the element at the front of the queue, or nullptr if there is none
+	T* pop() {
 		BaseNode* b = popNode();
 		if (b == &sleeping) {
 			sleepy = false;
@@ -176,10 +174,41 @@ public:
 			ASSERT(false);
 		if (b == &stub)
 			ASSERT(false);
-		if (!b)
+		return static_cast<T*>(b);
+	}
+};
+
+template <class T>
+class ThreadSafeQueue : NonCopyable {
+	struct Node : ThreadSafeQueueNode, FastAllocated<Node> {
+		T data;
+		Node(T const& data) : data(data) {}
+		Node(T&& data) : data(std::move(data)) {}
+	};
+	IntrusiveThreadSafeQueue<Node> queue;
+
+public:
+	~ThreadSafeQueue() {
+		while (pop().present())
+			;
+	}
+
+	// If push() returns true, the consumer may be sleeping and should be woken
+	template <class U>
+	bool push(U&& data) {
+		return queue.push(new Node(std::forward<U>(data)));
+	}
+
+	///////////// The below functions may only be called by a single, consumer thread //////////////////
+
+	// If canSleep returns true, then the queue is empty and the next push() will return true
+	bool canSleep() { return queue.canSleep(); }
+
+	Optional<T> pop() {
+		Node* n = queue.pop();
+		if (!n)
 			return Optional<T>();
 
-		Node* n = (Node*)b;
 		T data = std::move(n->data);
 		delete n;
 		return Optional<T>(std::move(data));
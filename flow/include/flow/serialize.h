@@ -690,7 +690,8 @@ public:
 	const void* readBytes(int bytes) {
 		const char* b = begin;
 		const char* e = b + bytes;
-		ASSERT(e <= end);
+		// A length of 2^31 or more read from the input arrives here negative
+		ASSERT(bytes >= 0 && e <= end);
 		begin = e;
 		return b;
 	}
@@ -20,6 +20,7 @@
 
 #include "benchmark/benchmark.h"
 
+#include <thread>
 #include <vector>
 
 #include "fdbclient/FDBTypes.h"
@@ -66,3 +67,42 @@ static void bench_callback(benchmark::State& benchState) {
 BENCHMARK_TEMPLATE(bench_callback, 1)->Range(1, 1 << 8)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_callback, 32)->Range(1, 1 << 8)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_callback, 1024)->Range(1, 1 << 8)->ReportAggregatesOnly(true);
+
+// Completes promises on the network thread from range(0) other threads, the way IThreadPool threads hand back the
+// results of file and RocksDB operations
+ACTOR static Future<Void> benchCrossThreadCallbackActor(benchmark::State* benchState) {
+	state int threads = benchState->range(0);
+	state int perThread = (1 << 16) / threads;
+	state std::vector<Promise<Void>> promises;
+	state std::vector<Future<Void>> futures;
+	state std::vector<std::thread> producers;
+	while (benchState->KeepRunning()) {
+		promises = std::vector<Promise<Void>>(threads * perThread);
+		futures.clear();
+		for (auto& p : promises) {
+			futures.push_back(p.getFuture());
+		}
+		for (int t = 0; t < threads; ++t) {
+			Promise<Void>* first = &promises[t * perThread];
+			int count = perThread;
+			producers.emplace_back([first, count]() {
+				for (int i = 0; i < count; ++i) {
+					g_network->onMainThread(std::move(first[i]), TaskPriority::DefaultOnMainThread);
+				}
+			});
+		}
+		wait(waitForAll(futures));
+		for (auto& producer : producers) {
+			producer.join();
+		}
+		producers.clear();
+	}
+	benchState->SetItemsProcessed(threads * perThread * static_cast<long>(benchState->iterations()));
+	return Void();
+}
+
+static void bench_cross_thread_callback(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchCrossThreadCallbackActor(&benchState); }).blockUntilReady();
+}
+
+BENCHMARK(bench_cross_thread_callback)->RangeMultiplier(2)->Range(1, 8)->ReportAggregatesOnly(true)->UseRealTime();
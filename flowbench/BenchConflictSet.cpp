@@ -0,0 +1,169 @@
+/*
+ * BenchConflictSet.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "fdbclient/CommitTransaction.h"
+#include "fdbserver/ConflictSet.h"
+#include "fdbserver/Knobs.h"
+#include "flow/IRandom.h"
+
+#include <vector>
+
+// Shapes of the conflict ranges in a resolver batch
+enum class ConflictKeyShape {
+	// Point reads and writes of uniformly random 16 byte keys
+	Uniform = 0,
+	// Point reads and writes of tuple encoded keys which share a 20 byte tenant/directory prefix
+	TuplePrefix = 1,
+	// Short range reads with point writes
+	ShortRange = 2,
+	// Range reads spanning thousands of keys with point writes, which the ART history answers by skipping runs of
+	// keys that were all written before the read
+	LongRange = 3,
+};
+
+static constexpr int conflictKeySpace = 1 << 20;
+static constexpr int readsPerTransaction = 5;
+static constexpr int writesPerTransaction = 2;
+// Number of batches of history a resolver keeps, at one batch per version
+static constexpr int historyBatches = 100;
+// How many versions behind the batch being resolved transactions read, so that reads check recent writes
+static constexpr int readLag = 5;
+
+static StringRef conflictKey(Arena& arena, ConflictKeyShape shape, int k) {
+	uint64_t id = bigEndian64(uint64_t(k));
+	if (shape == ConflictKeyShape::TuplePrefix) {
+		Standalone<StringRef> key = "\x15\x01tenant\x00\x02orders\x00\x02idx\x00\x01"_sr.withSuffix(
+		    StringRef(reinterpret_cast<const uint8_t*>(&id), sizeof(id)));
+		return StringRef(arena, key);
+	}
+	Standalone<StringRef> key =
+	    "\x01user/k"_sr.withSuffix(StringRef(reinterpret_cast<const uint8_t*>(&id), sizeof(id)));
+	return StringRef(arena, key);
+}
+
+static KeyRangeRef pointRange(Arena& arena, ConflictKeyShape shape) {
+	StringRef key = conflictKey(arena, shape, deterministicRandom()->randomInt(0, conflictKeySpace));
+	return KeyRangeRef(key, keyAfter(key, arena));
+}
+
+static Standalone<VectorRef<CommitTransactionRef>> makeConflictBatch(ConflictKeyShape shape,
+                                                                     int transactions,
+                                                                     Version readVersion) {
+	Standalone<VectorRef<CommitTransactionRef>> batch;
+	Arena& arena = batch.arena();
+	for (int t = 0; t < transactions; t++) {
+		CommitTransactionRef tr;
+		tr.read_snapshot = readVersion;
+		for (int r = 0; r < readsPerTransaction; r++) {
+			if (shape == ConflictKeyShape::ShortRange || shape == ConflictKeyShape::LongRange) {
+				const int maxLength = shape == ConflictKeyShape::ShortRange ? 100 : 20000;
+				int k = deterministicRandom()->randomInt(0, conflictKeySpace - maxLength);
+				tr.read_conflict_ranges.push_back(
+				    arena,
+				    KeyRangeRef(conflictKey(arena, shape, k),
+				                conflictKey(arena, shape, k + deterministicRandom()->randomInt(2, maxLength))));
+			} else {
+				tr.read_conflict_ranges.push_back(arena, pointRange(arena, shape));
+			}
+		}
+		for (int w = 0; w < writesPerTransaction; w++) {
+			tr.write_conflict_ranges.push_back(arena, pointRange(arena, shape));
+		}
+		batch.push_back(arena, tr);
+	}
+	return batch;
+}
+
+// Measures ConflictBatch::detectConflicts on a conflict set holding historyBatches batches of writes, partitioned
+// across the given number of threads
+template <ConflictSetEngine engine>
+static void bench_conflict_set(benchmark::State& state) {
+	const ConflictKeyShape shape = static_cast<ConflictKeyShape>(state.range(0));
+	const int transactions = state.range(1);
+	const int threads = state.range(2);
+
+	// Batches are pre-generated and reused with increasing versions
+	std::vector<Standalone<VectorRef<CommitTransactionRef>>> batches;
+	for (int i = 0; i < historyBatches; i++) {
+		batches.push_back(makeConflictBatch(shape, transactions, 0));
+	}
+
+	ConflictSet* cs = newConflictSet(engine,
+	                                 threads,
+	                                 SERVER_KNOBS->RESOLVER_PARTITION_REBALANCE_WRITES,
+	                                 SERVER_KNOBS->RESOLVER_PARTITION_MAX_IMBALANCE);
+	Version version = 1;
+	auto resolve = [&](Standalone<VectorRef<CommitTransactionRef>>& batch) {
+		Version oldestVersion = std::max<Version>(0, version - historyBatches);
+		ConflictBatch conflictBatch(cs);
+		for (auto& tr : batch) {
+			tr.read_snapshot = std::max<Version>(0, version - readLag);
+			conflictBatch.addTransaction(tr, oldestVersion);
+		}
+		std::vector<int> committed;
+		conflictBatch.detectConflicts(version, oldestVersion, committed);
+		benchmark::DoNotOptimize(committed);
+		version++;
+	};
+
+	for (auto& batch : batches) {
+		resolve(batch);
+	}
+	int next = 0;
+	for (auto _ : state) {
+		resolve(batches[next]);
+		next = (next + 1) % batches.size();
+	}
+	destroyConflictSet(cs);
+
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * transactions);
+	state.counters["Keys"] = benchmark::Counter(
+	    static_cast<double>(state.iterations()) * transactions * (readsPerTransaction + writesPerTransaction) * 2,
+	    benchmark::Counter::kIsRate);
+}
+
+static void conflictSetArguments(benchmark::internal::Benchmark* b, std::initializer_list<int> threadCounts) {
+	for (int shape = 0; shape <= static_cast<int>(ConflictKeyShape::LongRange); shape++) {
+		for (int transactions : { 100, 1000, 5000 }) {
+			for (int threads : threadCounts) {
+				b->Args({ shape, transactions, threads });
+			}
+		}
+	}
+	b->ArgNames({ "shape", "txns", "threads" });
+}
+
+static void partitionedConflictSetArguments(benchmark::internal::Benchmark* b) {
+	conflictSetArguments(b, { 1, 4 });
+}
+
+BENCHMARK_TEMPLATE(bench_conflict_set, ConflictSetEngine::SkipList)
+    ->Apply(partitionedConflictSetArguments)
+    ->UseRealTime()
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_conflict_set, ConflictSetEngine::PackedBTree)
+    ->Apply(partitionedConflictSetArguments)
+    ->UseRealTime()
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_conflict_set, ConflictSetEngine::ART)
+    ->Apply(partitionedConflictSetArguments)
+    ->UseRealTime()
+    ->ReportAggregatesOnly(true);
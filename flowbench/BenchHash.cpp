@@ -21,9 +21,12 @@
 #include "benchmark/benchmark.h"
 #include "crc32/crc32c.h"
 #include "flow/Hash3.h"
+#include "flow/Knobs.h"
+#define XXH_STATIC_LINKING_ONLY // For XXH3_state_t
 #include "flow/xxhash.h"
 #include "flowbench/GlobalData.h"
 
+#include <algorithm>
 #include <stdint.h>
 
 enum class HashType {
@@ -67,3 +70,51 @@ static void bench_hash(benchmark::State& state) {
 BENCHMARK_TEMPLATE(bench_hash, HashType::CRC32C)->DenseRange(2, 18)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_hash, HashType::HashLittle2)->DenseRange(2, 18)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_hash, HashType::XXHash3)->DenseRange(2, 18)->ReportAggregatesOnly(true);
+
+template <HashType hashType>
+inline uint64_t hashPacket(const uint8_t* data, int length, int bufferBytes) {
+	return 0;
+}
+
+template <>
+inline uint64_t hashPacket<HashType::CRC32C>(const uint8_t* data, int length, int bufferBytes) {
+	uint32_t crc = 0;
+	for (int offset = 0; offset < length; offset += bufferBytes) {
+		crc = crc32c_append(crc, data + offset, std::min(bufferBytes, length - offset));
+	}
+	return crc;
+}
+
+template <>
+inline uint64_t hashPacket<HashType::XXHash3>(const uint8_t* data, int length, int bufferBytes) {
+	if (length <= bufferBytes) {
+		return XXH3_64bits(data, length);
+	}
+	XXH3_state_t state;
+	XXH3_64bits_reset(&state);
+	for (int offset = 0; offset < length; offset += bufferBytes) {
+		XXH3_64bits_update(&state, data + offset, std::min(bufferBytes, length - offset));
+	}
+	return XXH3_64bits_digest(&state);
+}
+
+// Measures checksumming a range(0) byte packet the way FlowTransport does on send, a packet buffer at a time
+template <HashType hashType>
+static void bench_hash_packet(benchmark::State& state) {
+	const int length = state.range(0);
+	const int bufferBytes = FLOW_KNOBS->MIN_PACKET_BUFFER_BYTES;
+	auto packet = getKey(length);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(hashPacket<hashType>(packet.begin(), length, bufferBytes));
+	}
+	state.SetBytesProcessed(static_cast<long>(state.iterations()) * length);
+}
+
+BENCHMARK_TEMPLATE(bench_hash_packet, HashType::CRC32C)
+    ->RangeMultiplier(4)
+    ->Range(64, 1 << 20)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_hash_packet, HashType::XXHash3)
+    ->RangeMultiplier(4)
+    ->Range(64, 1 << 20)
+    ->ReportAggregatesOnly(true);
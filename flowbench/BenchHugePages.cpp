@@ -0,0 +1,98 @@
+/*
+ * BenchHugePages.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "flow/IRandom.h"
+#include "flow/Platform.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Memory a benchmark chases pointers through
+enum class PageType {
+	// Ordinary 4KB pages
+	Small = 0,
+	// Transparent huge pages
+	Transparent = 1,
+	// Explicit huge pages where any are reserved, and transparent ones otherwise
+	Explicit = 2,
+};
+
+// Measures dependent loads at random across range(0) MB, as traversals of large trees like VersionedMap and the Redwood
+// page cache make, counting data TLB misses where the platform allows it
+template <PageType type>
+static void bench_huge_pages_chase(benchmark::State& state) {
+	const size_t length = state.range(0) * kHugePageBytes / 2;
+	const size_t slots = length / 64;
+	void* memory;
+	if constexpr (type == PageType::Small) {
+		memory = aligned_alloc(4096, length);
+#ifdef __linux__
+		// Even if transparent huge pages are enabled for every mapping
+		madvise(memory, length, MADV_NOHUGEPAGE);
+#endif
+	} else {
+		memory = allocateHugePages(length, type == PageType::Explicit);
+		if (!memory) {
+			state.SkipWithError("Huge pages are not supported on this platform");
+			return;
+		}
+	}
+
+	// One pointer per cache line, linked in a single random cycle
+	std::vector<size_t> order(slots);
+	std::iota(order.begin(), order.end(), 0);
+	deterministicRandom()->randomShuffle(order);
+	void** lines = (void**)memory;
+	for (size_t i = 0; i < slots; i++) {
+		lines[order[i] * 8] = &lines[order[(i + 1) % slots] * 8];
+	}
+
+	constexpr int kLoads = 1 << 16;
+	void* p = lines[order[0] * 8];
+	int64_t tlbMisses = getDataTLBMisses();
+	for (auto _ : state) {
+		for (int i = 0; i < kLoads; i++) {
+			p = *(void**)p;
+		}
+		benchmark::DoNotOptimize(p);
+	}
+	if (tlbMisses >= 0) {
+		state.counters["DataTLBMissesPerLoad"] =
+		    double(getDataTLBMisses() - tlbMisses) / (static_cast<double>(state.iterations()) * kLoads);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * kLoads);
+
+	if constexpr (type == PageType::Small) {
+		aligned_free(memory);
+	} else {
+		freeHugePages(memory, length);
+	}
+}
+
+BENCHMARK_TEMPLATE(bench_huge_pages_chase, PageType::Small)->RangeMultiplier(8)->Range(2, 1024);
+BENCHMARK_TEMPLATE(bench_huge_pages_chase, PageType::Transparent)->RangeMultiplier(8)->Range(2, 1024);
+BENCHMARK_TEMPLATE(bench_huge_pages_chase, PageType::Explicit)->RangeMultiplier(8)->Range(2, 1024);
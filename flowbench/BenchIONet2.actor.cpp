@@ -27,6 +27,9 @@
 #include "flow/network.h"
 #include "flow/ThreadHelper.actor.h"
 #include "flow/IAsyncFile.h"
+#include "flow/IConnection.h"
+#include "flow/serialize.h"
+#include "fdbclient/IKnobCollection.h"
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -77,3 +80,116 @@ static void bench_ionet2(benchmark::State& benchState) {
 }
 
 BENCHMARK(bench_ionet2)->Range(1, 1 << 16)->ReportAggregatesOnly(true);
+
+// Wraps a plain byte range so it can be passed to IConnection::write
+struct BenchIOSendBuffer : SendBuffer {
+	BenchIOSendBuffer(uint8_t* data, int size) {
+		_data = data;
+		next = nullptr;
+		bytes_written = size;
+		bytes_sent = 0;
+	}
+};
+
+ACTOR static Future<Void> sendMessage(Reference<IConnection> conn, uint8_t* data, int size) {
+	state BenchIOSendBuffer buffer(data, size);
+	loop {
+		buffer.bytes_sent += conn->write(&buffer);
+		if (buffer.bytes_unsent() == 0) {
+			return Void();
+		}
+		wait(conn->onWritable());
+	}
+}
+
+ACTOR static Future<Void> receiveMessage(Reference<IConnection> conn, uint8_t* data, int size) {
+	state int received = 0;
+	loop {
+		received += conn->read(data + received, data + size);
+		if (received == size) {
+			return Void();
+		}
+		wait(conn->onReadable());
+	}
+}
+
+ACTOR static Future<Void> echoMessages(Reference<IConnection> conn, int size) {
+	state std::vector<uint8_t> data(size);
+	try {
+		loop {
+			wait(receiveMessage(conn, data.data(), size));
+			wait(sendMessage(conn, data.data(), size));
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_connection_failed) {
+			throw;
+		}
+	}
+	return Void();
+}
+
+ACTOR static Future<Void> roundTrip(Reference<IConnection> conn, uint8_t* data, int size) {
+	wait(sendMessage(conn, data, size));
+	wait(receiveMessage(conn, data, size));
+	return Void();
+}
+
+ACTOR static Future<Void> benchIONet2ConnectionsActor(benchmark::State* benchState) {
+	state bool useIOUring = benchState->range(0);
+	state int connections = benchState->range(1);
+	state int size = 64;
+	state std::vector<std::vector<uint8_t>> data(connections, std::vector<uint8_t>(size, 'x'));
+	state std::vector<Reference<IConnection>> clients;
+	state std::vector<Reference<IConnection>> servers;
+	state std::vector<Future<Void>> echoers;
+	state Reference<IListener> listener;
+	state Future<Reference<IConnection>> accepted;
+	state Reference<IConnection> client;
+	state Reference<IConnection> server;
+	state int i;
+
+	// The reactor is chosen when a connection is made, so both ends of every connection use the same reactor
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_io_uring",
+	                                                           KnobValueRef::create(bool{ useIOUring }));
+	listener = INetworkConnections::net()->listen(NetworkAddress::parse("127.0.0.1:0"));
+	for (i = 0; i < connections; i++) {
+		accepted = listener->accept();
+		wait(store(client, INetworkConnections::net()->connect(listener->getListenAddress())));
+		wait(store(server, accepted));
+		clients.push_back(client);
+		servers.push_back(server);
+		echoers.push_back(echoMessages(server, size));
+	}
+
+	while (benchState->KeepRunning()) {
+		std::vector<Future<Void>> trips;
+		trips.reserve(connections);
+		for (int c = 0; c < connections; c++) {
+			trips.push_back(roundTrip(clients[c], data[c].data(), size));
+		}
+		wait(waitForAll(trips));
+	}
+	benchState->SetItemsProcessed(connections * static_cast<long>(benchState->iterations()));
+
+	for (auto& f : echoers) {
+		f.cancel();
+	}
+	for (i = 0; i < connections; i++) {
+		clients[i]->close();
+		servers[i]->close();
+	}
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_io_uring", KnobValueRef::create(bool{ false }));
+	return Void();
+}
+
+// Every one of many loopback connections makes a 64 byte round trip per iteration, as a proxy or storage server
+// serving many clients does. The first argument selects the reactor (0 is asio, 1 is io_uring) and the second is the
+// number of connections; items are round trips.
+static void bench_ionet2_connections(benchmark::State& benchState) {
+	onMainThread([&benchState] { return benchIONet2ConnectionsActor(&benchState); }).blockUntilReady();
+}
+
+BENCHMARK(bench_ionet2_connections)
+    ->ArgsProduct({ { 0, 1 }, { 1, 64, 1024 } })
+    ->ReportAggregatesOnly(true)
+    ->UseRealTime();
@@ -23,6 +23,10 @@
 
 #include "benchmark/benchmark.h"
 
+#include "flow/FastAlloc.h"
+
+#include <vector>
+
 static void bench_memcmp(benchmark::State& state) {
 	constexpr int kLength = 10000;
 	std::unique_ptr<char[]> b1{ new char[kLength] };
@@ -47,5 +51,43 @@ static void bench_memcpy(benchmark::State& state) {
 	}
 }
 
+// Measures the FastAllocator fast path: one object allocated and released from the thread's magazine
+template <int Size>
+static void bench_fast_allocator(benchmark::State& state) {
+	for (auto _ : state) {
+		void* p = FastAllocator<Size>::allocate();
+		benchmark::DoNotOptimize(p);
+		FastAllocator<Size>::release(p);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+// Measures a burst of range(0) objects allocated, written and released, optionally returning the freed memory to the
+// OS after each burst so that the next one faults it back in
+template <int Size, bool trim>
+static void bench_fast_allocator_burst(benchmark::State& state) {
+	const int count = state.range(0);
+	std::vector<void*> ptrs(count);
+	for (auto _ : state) {
+		for (int i = 0; i < count; i++) {
+			ptrs[i] = FastAllocator<Size>::allocate();
+			memset(ptrs[i], 0, Size);
+		}
+		for (int i = 0; i < count; i++) {
+			FastAllocator<Size>::release(ptrs[i]);
+		}
+		if constexpr (trim) {
+			FastAllocator<Size>::trimUnused(0, std::numeric_limits<long long>::max());
+		}
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * count);
+}
+
 BENCHMARK(bench_memcmp);
 BENCHMARK(bench_memcpy);
+BENCHMARK_TEMPLATE(bench_fast_allocator, 64);
+BENCHMARK_TEMPLATE(bench_fast_allocator, 4096);
+BENCHMARK_TEMPLATE(bench_fast_allocator_burst, 64, false)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(bench_fast_allocator_burst, 64, true)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(bench_fast_allocator_burst, 4096, false)->Arg(1 << 10)->Arg(1 << 14);
+BENCHMARK_TEMPLATE(bench_fast_allocator_burst, 4096, true)->Arg(1 << 10)->Arg(1 << 14);
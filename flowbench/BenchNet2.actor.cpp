@@ -25,6 +25,9 @@
 #include "flow/DeterministicRandom.h"
 #include "flow/network.h"
 #include "flow/ThreadHelper.actor.h"
+#include "flow/IConnection.h"
+#include "fdbclient/IKnobCollection.h"
+#include "flow/serialize.h"
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -91,3 +94,189 @@ static void bench_delay(benchmark::State& benchState) {
 
 BENCHMARK_TEMPLATE(bench_delay, DELAY)->Range(0, 1 << 16)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_delay, YIELD)->Range(0, 1 << 16)->ReportAggregatesOnly(true);
+
+// Wraps a plain byte range so it can be passed to IConnection::write
+struct BenchSendBuffer : SendBuffer {
+	BenchSendBuffer(uint8_t* data, int size) {
+		_data = data;
+		next = nullptr;
+		bytes_written = size;
+		bytes_sent = 0;
+	}
+};
+
+ACTOR static Future<Void> writeAll(Reference<IConnection> conn, uint8_t* data, int size) {
+	state BenchSendBuffer buffer(data, size);
+	loop {
+		buffer.bytes_sent += conn->write(&buffer);
+		if (buffer.bytes_unsent() == 0) {
+			return Void();
+		}
+		wait(conn->onWritable());
+	}
+}
+
+ACTOR static Future<Void> readAll(Reference<IConnection> conn, uint8_t* data, int size) {
+	state int received = 0;
+	loop {
+		received += conn->read(data + received, data + size);
+		if (received == size) {
+			return Void();
+		}
+		wait(conn->onReadable());
+	}
+}
+
+ACTOR static Future<Void> echo(Reference<IConnection> conn, int size) {
+	state std::vector<uint8_t> data(size);
+	try {
+		loop {
+			wait(readAll(conn, data.data(), size));
+			wait(writeAll(conn, data.data(), size));
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_connection_failed) {
+			throw;
+		}
+	}
+	return Void();
+}
+
+ACTOR static Future<Void> benchNet2LoopbackActor(benchmark::State* benchState) {
+	state bool useIOUring = benchState->range(0);
+	state int size = benchState->range(1);
+	state std::vector<uint8_t> data(size, 'x');
+	state Reference<IListener> listener;
+	state Reference<IConnection> client;
+	state Reference<IConnection> server;
+	state Future<Void> echoer;
+
+	// The reactor is chosen when a connection is made, so both ends of this one use the same reactor
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_io_uring",
+	                                                           KnobValueRef::create(bool{ useIOUring }));
+	listener = INetworkConnections::net()->listen(NetworkAddress::parse("127.0.0.1:0"));
+	state Future<Reference<IConnection>> accepted = listener->accept();
+	wait(store(client, INetworkConnections::net()->connect(listener->getListenAddress())));
+	wait(store(server, accepted));
+	echoer = echo(server, size);
+
+	while (benchState->KeepRunning()) {
+		wait(writeAll(client, data.data(), size));
+		wait(readAll(client, data.data(), size));
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	benchState->SetBytesProcessed(2 * size * static_cast<long>(benchState->iterations()));
+
+	echoer.cancel();
+	client->close();
+	server->close();
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_io_uring", KnobValueRef::create(bool{ false }));
+	return Void();
+}
+
+// Round trips over a loopback TCP connection. The first argument selects the reactor (0 is asio, 1 is io_uring) and
+// the second is the message size.
+static void bench_net2_loopback(benchmark::State& benchState) {
+	onMainThread([&benchState] { return benchNet2LoopbackActor(&benchState); }).blockUntilReady();
+}
+
+BENCHMARK(bench_net2_loopback)
+    ->ArgsProduct({ { 0, 1 }, { 64, 4096, 65536 } })
+    ->ReportAggregatesOnly(true)
+    ->UseRealTime();
+
+// Writes a chain of packet buffers the way connectionWriter writes a peer's queued packets, counting the calls made
+ACTOR static Future<Void> writeBurst(Reference<IConnection> conn,
+                                     std::vector<BenchSendBuffer>* buffers,
+                                     int64_t* writes) {
+	state int limit = FLOW_KNOBS->NETWORK_SEND_BURST_BYTES > 0 ? FLOW_KNOBS->NETWORK_SEND_BURST_BYTES
+	                                                           : FLOW_KNOBS->MAX_PACKET_SEND_BYTES;
+	state int first = 0;
+	for (auto& b : *buffers) {
+		b.bytes_sent = 0;
+	}
+	loop {
+		int sent = conn->write(&(*buffers)[first], limit);
+		++*writes;
+		while (sent > 0) {
+			BenchSendBuffer& b = (*buffers)[first];
+			int n = std::min(sent, b.bytes_unsent());
+			b.bytes_sent += n;
+			sent -= n;
+			if (b.bytes_unsent() == 0) {
+				++first;
+			}
+		}
+		if (first == (int)buffers->size()) {
+			return Void();
+		}
+		wait(conn->onWritable());
+	}
+}
+
+ACTOR static Future<Void> drain(Reference<IConnection> conn, int size) {
+	state std::vector<uint8_t> data(64 * 1024);
+	state int received = 0;
+	loop {
+		received += conn->read(data.data(), data.data() + std::min<int>(data.size(), size - received));
+		if (received == size) {
+			return Void();
+		}
+		wait(conn->onReadable());
+	}
+}
+
+ACTOR static Future<Void> benchNet2BurstActor(benchmark::State* benchState) {
+	state int burstBytes = benchState->range(0);
+	state int size = benchState->range(1);
+	state std::vector<uint8_t> data(size, 'x');
+	state std::vector<BenchSendBuffer> buffers;
+	state int64_t writes = 0;
+	state Reference<IListener> listener;
+	state Reference<IConnection> client;
+	state Reference<IConnection> server;
+	state Future<Void> drained;
+
+	// Packets are serialized into buffers of MIN_PACKET_BUFFER_BYTES
+	const int bufferBytes = FLOW_KNOBS->MIN_PACKET_BUFFER_BYTES;
+	buffers.reserve(size / bufferBytes);
+	for (int offset = 0; offset < size; offset += bufferBytes) {
+		buffers.emplace_back(data.data() + offset, std::min(bufferBytes, size - offset));
+	}
+	for (int i = 0; i + 1 < (int)buffers.size(); i++) {
+		buffers[i].next = &buffers[i + 1];
+	}
+
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_send_burst_bytes",
+	                                                           KnobValueRef::create(int{ burstBytes }));
+	listener = INetworkConnections::net()->listen(NetworkAddress::parse("127.0.0.1:0"));
+	state Future<Reference<IConnection>> accepted = listener->accept();
+	wait(store(client, INetworkConnections::net()->connect(listener->getListenAddress())));
+	wait(store(server, accepted));
+
+	while (benchState->KeepRunning()) {
+		drained = drain(server, size);
+		wait(writeBurst(client, &buffers, &writes));
+		wait(drained);
+	}
+	benchState->SetBytesProcessed(size * static_cast<long>(benchState->iterations()));
+	benchState->counters["WritesPerMB"] =
+	    writes / (static_cast<double>(size) * benchState->iterations() / (1 << 20));
+
+	client->close();
+	server->close();
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_send_burst_bytes",
+	                                                           KnobValueRef::create(int{ 0 }));
+	return Void();
+}
+
+// One-way bursts of 4KB packet buffers over a loopback TCP connection. The first argument is NETWORK_SEND_BURST_BYTES
+// (0 writes MAX_PACKET_SEND_BYTES per call) and the second is the burst size.
+static void bench_net2_burst(benchmark::State& benchState) {
+	onMainThread([&benchState] { return benchNet2BurstActor(&benchState); }).blockUntilReady();
+}
+
+BENCHMARK(bench_net2_burst)
+    ->ArgsProduct({ { 0, 4 << 20 }, { 1 << 20, 16 << 20 } })
+    ->ReportAggregatesOnly(true)
+    ->UseRealTime();
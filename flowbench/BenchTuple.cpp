@@ -0,0 +1,94 @@
+/*
+ * BenchTuple.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/Tuple.h"
+#include "flow/Arena.h"
+#include "flow/IRandom.h"
+
+#include <string>
+
+// Returns a string of the given length which has a \x00 byte, and so needs escaping, every zeroInterval bytes, or
+// none if zeroInterval is 0
+static std::string tupleString(int length, int zeroInterval) {
+	std::string str(length, 'a');
+	for (int i = 0; i < length; i++) {
+		bool zero = zeroInterval && i % zeroInterval == zeroInterval - 1;
+		str[i] = zero ? '\x00' : 'a' + deterministicRandom()->randomInt(0, 26);
+	}
+	return str;
+}
+
+// Measures packing a tuple of one range(0) byte string
+template <int zeroInterval>
+static void bench_tuple_pack(benchmark::State& state) {
+	const std::string str = tupleString(state.range(0), zeroInterval);
+
+	for (auto _ : state) {
+		Tuple t;
+		t.append(StringRef(str));
+		benchmark::DoNotOptimize(t.pack());
+	}
+
+	state.SetBytesProcessed(static_cast<long>(state.iterations()) * state.range(0));
+}
+
+// Measures unpacking a tuple of one range(0) byte string and reading the string back
+template <int zeroInterval>
+static void bench_tuple_get_string(benchmark::State& state) {
+	const Standalone<StringRef> packed = Tuple::makeTuple(StringRef(tupleString(state.range(0), zeroInterval))).pack();
+
+	for (auto _ : state) {
+		Tuple t = Tuple::unpack(packed);
+		benchmark::DoNotOptimize(t.getString(0));
+	}
+
+	state.SetBytesProcessed(static_cast<long>(state.iterations()) * state.range(0));
+}
+
+// Measures finding the elements of a key of range(0) strings, as mapped range reads do for each key they map
+template <bool view>
+static void bench_tuple_unpack(benchmark::State& state) {
+	Tuple t;
+	for (int i = 0; i < state.range(0); i++) {
+		t.append(StringRef(tupleString(16, 0)));
+	}
+	const Standalone<StringRef> packed = t.pack();
+
+	for (auto _ : state) {
+		if constexpr (view) {
+			TupleView v = TupleView::unpack(packed);
+			benchmark::DoNotOptimize(v.subTupleRawString(v.size() - 1));
+		} else {
+			Tuple u = Tuple::unpack(packed);
+			benchmark::DoNotOptimize(u.subTupleRawString(u.size() - 1));
+		}
+	}
+
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(bench_tuple_pack, 0)->RangeMultiplier(16)->Range(16, 1 << 16)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_tuple_pack, 64)->RangeMultiplier(16)->Range(16, 1 << 16)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_tuple_get_string, 0)->RangeMultiplier(16)->Range(16, 1 << 16)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_tuple_get_string, 64)->RangeMultiplier(16)->Range(16, 1 << 16)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_tuple_unpack, false)->RangeMultiplier(4)->Range(1, 64)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_tuple_unpack, true)->RangeMultiplier(4)->Range(1, 64)->ReportAggregatesOnly(true);
@@ -0,0 +1,312 @@
+/*
+ * BenchVersionedMap.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/VersionedBTreeMap.h"
+#include "fdbclient/VersionedMap.h"
+#include "flow/Arena.h"
+#include "flow/IRandom.h"
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// How sets are applied to the map
+enum class ApplyMode {
+	// One insert() per key
+	Single = 0,
+	// One insertSorted() per run of keys
+	Sorted = 1,
+};
+
+using PTreeMap = VersionedMap<KeyRef, ValueOrClearToRef>;
+using BTreeMap = VersionedBTreeMap<KeyRef, ValueOrClearToRef>;
+// The storage server's map in its default mode, which forwards every call to a PTreeMap
+using SelectablePTreeMap = SelectableVersionedMap<KeyRef, ValueOrClearToRef>;
+
+// Keys already in the map when measuring starts. Runs write new keys in between these.
+static constexpr int versionedMapKeys = 1 << 18;
+// Number of versions the map keeps, as a storage server keeps the versions which are not yet durable
+static constexpr int versionedMapVersions = 100;
+
+static KeyRef versionedMapKey(Arena& arena, int k) {
+	uint64_t id = bigEndian64(uint64_t(k));
+	return StringRef(arena, "\x01user/k"_sr.withSuffix(StringRef(reinterpret_cast<const uint8_t*>(&id), sizeof(id))));
+}
+
+// Measures applying runs of sorted sets, as a bulk load writes them at each version, to a map of versionedMapKeys keys
+template <ApplyMode mode>
+static void bench_versioned_map_apply(benchmark::State& state) {
+	const int runSize = state.range(0);
+	const ValueRef value = "value"_sr;
+
+	Arena arena;
+	PTreeMap map;
+	Version version = 1;
+	map.createNewVersion(version);
+	for (int k = 0; k < versionedMapKeys; k++) {
+		map.insert(versionedMapKey(arena, 2 * k), ValueOrClearToRef::value(value));
+	}
+
+	// Each run writes the odd keys between runSize neighbouring keys at a random place in the map
+	std::vector<std::vector<std::pair<KeyRef, ValueOrClearToRef>>> runs(100);
+	for (auto& run : runs) {
+		int first = deterministicRandom()->randomInt(0, versionedMapKeys - runSize);
+		for (int k = first; k < first + runSize; k++) {
+			run.emplace_back(versionedMapKey(arena, 2 * k + 1), ValueOrClearToRef::value(value));
+		}
+	}
+
+	int next = 0;
+	for (auto _ : state) {
+		map.createNewVersion(++version);
+		const auto& run = runs[next];
+		if constexpr (mode == ApplyMode::Sorted) {
+			map.insertSorted(run.begin(), run.end());
+		} else {
+			for (const auto& [key, v] : run) {
+				map.insert(key, v);
+			}
+		}
+		if (version > versionedMapVersions) {
+			map.forgetVersionsBefore(version - versionedMapVersions);
+		}
+		next = (next + 1) % runs.size();
+	}
+
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * runSize);
+}
+
+BENCHMARK_TEMPLATE(bench_versioned_map_apply, ApplyMode::Single)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_apply, ApplyMode::Sorted)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12)
+    ->ReportAggregatesOnly(true);
+
+// Returns the bytes allocated for the nodes reachable from any version of the map
+static int64_t nodeBytes(PTreeMap const& map) {
+	std::unordered_set<PTreeMap::PTreeT const*> seen;
+	std::vector<PTreeMap::PTreeT const*> stack;
+	for (const auto& [v, root] : map.roots) {
+		stack.push_back(root.getPtr());
+	}
+	while (!stack.empty()) {
+		auto n = stack.back();
+		stack.pop_back();
+		if (n && seen.insert(n).second) {
+			for (const auto& p : n->pointer) {
+				stack.push_back(p.getPtr());
+			}
+		}
+	}
+	return seen.size() * nextFastAllocatedSize(sizeof(PTreeMap::PTreeT));
+}
+
+static int64_t nodeBytes(BTreeMap const& map) {
+	std::unordered_set<BTreeMap::Node const*> seen;
+	std::vector<BTreeMap::Node const*> stack;
+	int64_t bytes = 0;
+	for (const auto& [v, root] : map.roots) {
+		stack.push_back(root.getPtr());
+	}
+	while (!stack.empty()) {
+		auto n = stack.back();
+		stack.pop_back();
+		if (!n || !seen.insert(n).second) {
+			continue;
+		}
+		if (n->leaf) {
+			bytes += nextFastAllocatedSize(sizeof(BTreeMap::Leaf));
+		} else {
+			bytes += nextFastAllocatedSize(sizeof(BTreeMap::Internal));
+			for (int i = 0; i < n->count; i++) {
+				stack.push_back(BTreeMap::asInternal(n)->children[i].getPtr());
+			}
+		}
+	}
+	return bytes;
+}
+
+// The storage server makes its tree operations on SelectableVersionedMap inside visit(), once per mutation or per run
+// of entries it reads. The benchmarks below do the same through these.
+template <class Map, class F>
+static void visitMap(Map& map, F&& f) {
+	f(map);
+}
+template <class F>
+static void visitMap(SelectablePTreeMap& map, F&& f) {
+	map.visit(f);
+}
+template <class Iterator, class F>
+static void visitIterator(Iterator& i, F&& f) {
+	f(i);
+}
+template <class F>
+static void visitIterator(SelectablePTreeMap::iterator& i, F&& f) {
+	i.visit(f);
+}
+
+// Writes batch random keys of keySpace at each of versions versions, keeping versionedMapVersions of them
+template <class Map>
+static void writeVersions(Map& map, Arena& arena, Version& version, int versions, int batch, int keySpace) {
+	const ValueRef value = "value"_sr;
+	for (int i = 0; i < versions; i++) {
+		map.createNewVersion(++version);
+		for (int k = 0; k < batch; k++) {
+			visitMap(map, [&](auto& map) {
+				map.insert(versionedMapKey(arena, deterministicRandom()->randomInt(0, keySpace)),
+				           ValueOrClearToRef::value(value));
+			});
+		}
+		if (version > versionedMapVersions) {
+			map.forgetVersionsBefore(version - versionedMapVersions);
+		}
+	}
+}
+
+// Measures writing random keys as a storage server does, versionedMapVersions versions at a time. Reports the memory
+// the map's nodes take per key at the latest version.
+template <class Map>
+static void bench_versioned_map_memory(benchmark::State& state) {
+	const int keys = state.range(0);
+	const int batch = 100;
+	int64_t bytes = 0, entries = 0;
+	for (auto _ : state) {
+		Arena arena;
+		Map map;
+		Version version = 0;
+		writeVersions(map, arena, version, keys / batch, batch, keys * 4);
+		state.PauseTiming();
+		bytes += nodeBytes(map);
+		for (auto i = map.atLatest().begin(); i != map.atLatest().end(); ++i) {
+			entries++;
+		}
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * keys);
+	state.counters["BytesPerKey"] = double(bytes) / entries;
+}
+
+// Measures reading range(0) entries from a random key at a random retained version, after versionedMapKeys random
+// writes
+template <class Map>
+static void bench_versioned_map_scan(benchmark::State& state) {
+	const int rangeSize = state.range(0);
+	Arena arena;
+	Map map;
+	Version version = 0;
+	writeVersions(map, arena, version, 1, versionedMapKeys, versionedMapKeys * 2);
+	writeVersions(map, arena, version, versionedMapVersions, 100, versionedMapKeys * 2);
+
+	int64_t read = 0;
+	for (auto _ : state) {
+		auto view = map.at(version - deterministicRandom()->randomInt(0, versionedMapVersions));
+		auto i = view.lower_bound(versionedMapKey(arena, deterministicRandom()->randomInt(0, versionedMapKeys * 2)));
+		visitIterator(i, [&](auto& i) {
+			for (int n = 0; n < rangeSize && i; n++, ++i) {
+				benchmark::DoNotOptimize(i->isValue());
+				read++;
+			}
+		});
+	}
+	state.SetItemsProcessed(read);
+}
+
+// Measures reading range(0) entries the way the storage server's readRange() does, copying keys and values out until
+// the range ends or a clear is reached
+template <class Map>
+static void bench_versioned_map_read_range(benchmark::State& state) {
+	const int rangeSize = state.range(0);
+	Arena arena;
+	Map map;
+	Version version = 0;
+	writeVersions(map, arena, version, 1, versionedMapKeys, versionedMapKeys * 2);
+	writeVersions(map, arena, version, versionedMapVersions, 100, versionedMapKeys * 2);
+
+	int64_t read = 0;
+	for (auto _ : state) {
+		Arena resultArena;
+		VectorRef<KeyValueRef> result;
+		int begin = deterministicRandom()->randomInt(0, versionedMapKeys * 2);
+		KeyRef end = versionedMapKey(resultArena, begin + rangeSize * 4);
+		auto view = map.at(version - deterministicRandom()->randomInt(0, versionedMapVersions));
+		auto i = view.lower_bound(versionedMapKey(resultArena, begin));
+		visitIterator(i, [&](auto& i) {
+			while (i && i.key() < end && !i->isClearTo() && result.size() < rangeSize) {
+				result.emplace_back(resultArena, i.key(), i->getValue());
+				++i;
+			}
+		});
+		read += result.size();
+		benchmark::DoNotOptimize(result.begin());
+	}
+	state.SetItemsProcessed(read);
+}
+
+// Measures writing batches of range(0) random keys at successive versions to a map of versionedMapKeys keys
+template <class Map>
+static void bench_versioned_map_write(benchmark::State& state) {
+	const int batch = state.range(0);
+	Arena arena;
+	Map map;
+	Version version = 0;
+	writeVersions(map, arena, version, 1, versionedMapKeys, versionedMapKeys * 2);
+
+	for (auto _ : state) {
+		writeVersions(map, arena, version, 1, batch, versionedMapKeys * 2);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * batch);
+}
+
+BENCHMARK_TEMPLATE(bench_versioned_map_memory, PTreeMap)
+    ->RangeMultiplier(8)
+    ->Range(1 << 12, 1 << 18)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_memory, BTreeMap)
+    ->RangeMultiplier(8)
+    ->Range(1 << 12, 1 << 18)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_scan, PTreeMap)->RangeMultiplier(16)->Range(1, 1 << 12)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_scan, BTreeMap)->RangeMultiplier(16)->Range(1, 1 << 12)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_scan, SelectablePTreeMap)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_read_range, PTreeMap)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_read_range, SelectablePTreeMap)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_write, PTreeMap)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 8)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_versioned_map_write, SelectablePTreeMap)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 8)
+    ->ReportAggregatesOnly(true);
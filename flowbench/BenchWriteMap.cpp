@@ -0,0 +1,127 @@
+/*
+ * BenchWriteMap.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/RYWIterator.h"
+#include "fdbclient/SnapshotCache.h"
+#include "fdbclient/WriteMap.h"
+#include "flow/Arena.h"
+#include "flow/IRandom.h"
+
+#include <vector>
+
+// Order in which a transaction writes its keys
+enum class WriteOrder {
+	// Increasing keys, as a bulk load writes them
+	Ascending = 0,
+	// Keys in random order
+	Random = 1,
+};
+
+static KeyRef writeMapKey(Arena& arena, int k) {
+	uint64_t id = bigEndian64(uint64_t(k));
+	return StringRef(arena, "\x01user/k"_sr.withSuffix(StringRef(reinterpret_cast<const uint8_t*>(&id), sizeof(id))));
+}
+
+static std::vector<KeyRef> writeMapKeys(Arena& arena, int count, WriteOrder order) {
+	std::vector<KeyRef> keys;
+	keys.reserve(count);
+	for (int k = 0; k < count; k++) {
+		keys.push_back(writeMapKey(arena, k));
+	}
+	if (order == WriteOrder::Random) {
+		deterministicRandom()->randomShuffle(keys);
+	}
+	return keys;
+}
+
+// Measures a transaction setting range(0) keys, optionally into a range it cleared first
+template <WriteOrder order, bool cleared>
+static void bench_write_map_set(benchmark::State& state) {
+	const int count = state.range(0);
+	const ValueRef value = "value"_sr;
+	Arena keyArena;
+	std::vector<KeyRef> keys = writeMapKeys(keyArena, count, order);
+
+	for (auto _ : state) {
+		Arena arena;
+		WriteMap writes(&arena);
+		if constexpr (cleared) {
+			writes.clear(KeyRangeRef("\x01user/"_sr, "\x01user0"_sr), true);
+		}
+		for (const auto& key : keys) {
+			writes.mutate(key, MutationRef::SetValue, value, true);
+		}
+		// Reading the writes back is what makes them visible, so include the cost of that
+		WriteMap::iterator it(&writes);
+		benchmark::DoNotOptimize(it);
+	}
+
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * count);
+}
+
+// Measures reading back range(0) keys a transaction set, as getRange() merges them with an empty snapshot cache
+template <WriteOrder order>
+static void bench_write_map_scan(benchmark::State& state) {
+	const int count = state.range(0);
+	const ValueRef value = "value"_sr;
+	Arena arena;
+	std::vector<KeyRef> keys = writeMapKeys(arena, count, order);
+	WriteMap writes(&arena);
+	SnapshotCache cache(&arena);
+	for (const auto& key : keys) {
+		writes.mutate(key, MutationRef::SetValue, value, true);
+	}
+
+	int64_t read = 0;
+	for (auto _ : state) {
+		Arena readArena;
+		RYWIterator it(&cache, &writes);
+		it.skip(allKeys.begin);
+		while (it.beginKey() < allKeys.end) {
+			if (it.is_kv()) {
+				benchmark::DoNotOptimize(it.kv(readArena));
+				read++;
+			}
+			++it;
+		}
+	}
+
+	state.SetItemsProcessed(read);
+}
+
+BENCHMARK_TEMPLATE(bench_write_map_set, WriteOrder::Ascending, false)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_write_map_set, WriteOrder::Random, false)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_write_map_set, WriteOrder::Ascending, true)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16)
+    ->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_write_map_scan, WriteOrder::Ascending)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16)
+    ->ReportAggregatesOnly(true);